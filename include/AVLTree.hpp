@@ -2,9 +2,10 @@
 #define AVLTREE_HPP
 
 #include "Flight.hpp"
+#include "Metrics.hpp"
+#include "MemoryReport.hpp"
 #include <cstdlib>
 #include <iostream>
-#include <string>
 
 /**
  * @brief Nó de uma lista encadeada para armazenar voos com chaves duplicadas.
@@ -12,62 +13,374 @@
 struct FlightListNode {
     Flight* flight;           ///< Ponteiro para um voo.
     FlightListNode* next;     ///< Ponteiro para o próximo nó.
+    FlightListNode* prev;     ///< Ponteiro para o nó anterior (remoção em O(1)).
     
     /**
      * @brief Construtor.
      * @param flightPtr Ponteiro para o voo.
      */
-    FlightListNode(Flight* flightPtr) : flight(flightPtr), next(nullptr) {}
+    FlightListNode(Flight* flightPtr) : flight(flightPtr), next(nullptr), prev(nullptr) {}
 };
 
+/**
+ * @brief Valor numérico de uma chave, usado nas somas por subárvore.
+ *
+ * As chaves dos índices são numéricas (os aeroportos usam AirportCode).
+ */
 template<typename T>
+inline double numericKey(const T& key) {
+    return static_cast<double>(key);
+}
+
+/**
+ * @brief Comparador padrão: comparação de três vias pelo operador <.
+ *
+ * Os comparadores são functors (parâmetro Compare de AVLTree), de modo que a
+ * comparação é resolvida em tempo de compilação e pode ser expandida inline.
+ */
+template<typename T>
+struct ThreeWayCompare {
+    int operator()(const T& a, const T& b) const {
+        return a < b ? -1 : (b < a ? 1 : 0);
+    }
+};
+
+/**
+ * @brief Política de chave: cada nó guarda uma cópia da chave.
+ *
+ * Necessária quando a chave não pode ser lida do voo, por exemplo quando o
+ * campo muda enquanto o voo está indexado (assentos) ou quando a árvore não
+ * guarda voos.
+ */
+template<typename T>
+struct StoredKey {
+    T key;  ///< Cópia da chave.
+
+    explicit StoredKey(const T& value) : key(value) {}
+
+    /**
+     * @brief Retorna a chave do nó (a lista não é usada).
+     */
+    const T& get(const FlightListNode*) const { return key; }
+
+    /**
+     * @brief Troca a chave do nó (usada quando o nó recebe a lista de outro).
+     */
+    void set(const T& value) { key = value; }
+};
+
+/**
+ * @brief Política de chave: a chave é um campo do voo, lido do primeiro voo da lista do nó.
+ *
+ * O nó não guarda a chave. Exige que o campo não mude enquanto o voo está
+ * indexado. Compensa para chaves grandes; para chaves numéricas, os dois
+ * acessos a mais à memória por nó visitado (lista e voo) custam mais do que a
+ * cópia economiza.
+ *
+ * @tparam T Tipo do campo.
+ * @tparam Member Campo de Flight usado como chave.
+ */
+template<typename T, T Flight::*Member>
+struct FlightFieldKey {
+    explicit FlightFieldKey(const T&) {}
+
+    /**
+     * @brief Lê a chave do primeiro voo da lista (todos têm a mesma chave).
+     */
+    T get(const FlightListNode* list) const { return list->flight->*Member; }
+
+    /**
+     * @brief Nada a fazer: a chave acompanha a lista de voos.
+     */
+    void set(const T&) {}
+};
+
 /**
  * @brief Nó da árvore AVL.
+ *
+ * Herda da política de chave (KeyOf): com FlightFieldKey a classe base é
+ * vazia e o nó não ocupa espaço com a chave.
  */
-struct AVLTreeNode {
-    T key;                        ///< Valor da chave.
-    FlightListNode* flightList;   ///< Lista encadeada de voos com a mesma chave.
+template<typename T, typename KeyOf>
+struct AVLTreeNode : KeyOf {
+    FlightListNode* flightList;   ///< Lista encadeada de voos com a mesma chave (nunca vazia).
     AVLTreeNode* left;            ///< Ponteiro para o filho esquerdo.
     AVLTreeNode* right;           ///< Ponteiro para o filho direito.
     int height;                   ///< Altura do nó.
-    
+    int listSize;                 ///< Número de voos na lista do nó.
+    int subtreeSize;              ///< Número de voos na subárvore (incluindo o nó).
+    double subtreeSum;            ///< Soma das chaves de todos os voos da subárvore (numericKey).
+
     /**
      * @brief Construtor.
      * @param keyValue Valor da chave.
      * @param flightPtr Ponteiro para o voo associado.
      */
     AVLTreeNode(const T& keyValue, Flight* flightPtr)
-        : key(keyValue), left(nullptr), right(nullptr), height(1) {
+        : KeyOf(keyValue), left(nullptr), right(nullptr), height(1), listSize(1), subtreeSize(1),
+          subtreeSum(numericKey(keyValue)) {
         flightList = new FlightListNode(flightPtr);
     }
+
+    /**
+     * @brief Retorna a chave do nó, conforme a política KeyOf.
+     */
+    auto key() const -> decltype(static_cast<const KeyOf*>(this)->get(flightList)) {
+        return KeyOf::get(flightList);
+    }
 };
 
-template<typename T>
+template<typename T, typename Compare = ThreeWayCompare<T>, typename KeyOf = StoredKey<T> >
+/**
+ * @brief Cursor que percorre em ordem as entradas de um intervalo da árvore AVL.
+ *
+ * Usa uma pilha explícita (sem recursão) e produz um voo por chamada de
+ * next(), sem array intermediário: quem chama pode filtrar, parar depois de k
+ * resultados ou escrever a saída diretamente. Voos com a mesma chave saem na
+ * ordem da lista de duplicatas.
+ *
+ * O cursor deixa de ser válido se a árvore for modificada durante o percurso.
+ */
+class AVLRangeCursor {
+public:
+    typedef AVLTreeNode<T, KeyOf> Node;  ///< Tipo dos nós da árvore.
+
+    static const int MAX_DEPTH = 64;  ///< Altura máxima suportada (uma AVL com 2^31 nós tem altura < 46).
+
+    /**
+     * @brief Construtor: posiciona o cursor na primeira chave do intervalo.
+     *
+     * Se os ponteiros para os limites forem nullptr, não há restrição
+     * inferior/superior. O limite superior é copiado; o inferior só é usado aqui.
+     *
+     * @param root Raiz da árvore.
+     * @param cmp Comparador da árvore.
+     * @param low Ponteiro para o limite inferior.
+     * @param lowInclusive True se o limite inferior é inclusivo.
+     * @param high Ponteiro para o limite superior.
+     * @param highInclusive True se o limite superior é inclusivo.
+     */
+    AVLRangeCursor(Node* root, const Compare& cmp,
+                   const T* low, bool lowInclusive, const T* high, bool highInclusive)
+        : compare(cmp), hasHigh(high != nullptr), highInclusive(highInclusive), depth(0), entry(nullptr) {
+        if (high)
+            highKey = *high;
+        // Desce até a menor chave >= low, empilhando os nós que ainda serão visitados.
+        Node* node = root;
+        while (node) {
+            if (low) {
+                int cmpLow = compare(node->key(), *low);
+                if (cmpLow < 0 || (!lowInclusive && cmpLow == 0)) {
+                    node = node->right;
+                    continue;
+                }
+            }
+            stack[depth++] = node;
+            node = node->left;
+        }
+    }
+
+    /**
+     * @brief Construtor: posiciona o cursor na entrada de posição rank (0 = menor chave).
+     *
+     * A descida usa os tamanhos das subárvores: O(log n) até o nó, mais o
+     * deslocamento dentro da lista de duplicatas desse nó.
+     *
+     * @param root Raiz da árvore.
+     * @param cmp Comparador da árvore.
+     * @param rank Posição da primeira entrada, na ordem das chaves.
+     * @param high Ponteiro para o limite superior (nullptr = sem limite).
+     * @param highInclusive True se o limite superior é inclusivo.
+     */
+    AVLRangeCursor(Node* root, const Compare& cmp,
+                   int rank, const T* high, bool highInclusive)
+        : compare(cmp), hasHigh(high != nullptr), highInclusive(highInclusive), depth(0), entry(nullptr) {
+        if (high)
+            highKey = *high;
+        Node* node = root;
+        while (node) {
+            int leftSize = node->left ? node->left->subtreeSize : 0;
+            if (rank < leftSize) {
+                stack[depth++] = node;
+                node = node->left;
+            } else if (rank < leftSize + node->listSize) {
+                if (pastHigh(node)) {
+                    depth = 0;
+                    return;
+                }
+                pushLeftPath(node->right);
+                entry = node->flightList;
+                for (rank -= leftSize; rank > 0; rank--)
+                    entry = entry->next;
+                return;
+            } else {
+                rank -= leftSize + node->listSize;
+                node = node->right;
+            }
+        }
+    }
+
+    /**
+     * @brief Avança para o próximo voo do intervalo.
+     * @return Ponteiro para o voo, ou nullptr quando o intervalo termina.
+     */
+    Flight* next() {
+        while (!entry) {
+            if (depth == 0)
+                return nullptr;
+            Node* node = stack[--depth];
+            if (pastHigh(node)) {
+                depth = 0;
+                return nullptr;
+            }
+            pushLeftPath(node->right);
+            entry = node->flightList;
+        }
+        Flight* flight = entry->flight;
+        entry = entry->next;
+        return flight;
+    }
+
+private:
+    Compare compare;                          ///< Comparador da árvore.
+    T highKey;                                ///< Limite superior (válido se hasHigh).
+    bool hasHigh;                             ///< True se há limite superior.
+    bool highInclusive;                       ///< True se o limite superior é inclusivo.
+    Node* stack[MAX_DEPTH];                   ///< Nós ainda não visitados, o menor no topo.
+    int depth;                                ///< Número de nós na pilha.
+    FlightListNode* entry;                    ///< Próxima entrada da lista do nó atual.
+
+    /**
+     * @brief Verifica se a chave do nó está além do limite superior.
+     */
+    bool pastHigh(const Node* node) const {
+        if (!hasHigh)
+            return false;
+        int cmpHigh = compare(node->key(), highKey);
+        return cmpHigh > 0 || (!highInclusive && cmpHigh == 0);
+    }
+
+    /**
+     * @brief Empilha node e seus descendentes à esquerda (próximos nós em ordem).
+     */
+    void pushLeftPath(Node* node) {
+        for (; node; node = node->left)
+            stack[depth++] = node;
+    }
+};
+
+template<typename T, typename Compare = ThreeWayCompare<T>, typename KeyOf = StoredKey<T> >
 /**
  * @brief Implementação da árvore AVL.
+ *
+ * @tparam T Tipo da chave.
+ * @tparam Compare Comparador de três vias (functor): negativo, zero ou positivo.
+ * @tparam KeyOf Política de chave: StoredKey (cópia no nó) ou FlightFieldKey (lida do voo).
  */
 class AVLTree {
 public:
-    AVLTreeNode<T>* root;                 ///< Nó raiz da árvore.
-    int (*compare)(const T&, const T&);    ///< Ponteiro para função de comparação.
+    typedef T KeyType;                                 ///< Tipo da chave.
+    typedef AVLTreeNode<T, KeyOf> Node;                ///< Tipo dos nós.
+    typedef AVLRangeCursor<T, Compare, KeyOf> Cursor;  ///< Cursor sobre intervalos da árvore.
+
+    Node* root;                           ///< Nó raiz da árvore.
+    Compare compare;                      ///< Comparador.
+    int entryCount;                       ///< Número de voos (entradas) na árvore.
+    int keyCount;                         ///< Número de chaves distintas (nós).
 
     /**
      * @brief Construtor.
-     * @param cmpFunc Ponteiro para a função de comparação.
+     * @param cmp Comparador (por padrão, construído sem argumentos).
      */
-    AVLTree(int (*cmpFunc)(const T&, const T&)) : root(nullptr), compare(cmpFunc) {}
+    explicit AVLTree(const Compare& cmp = Compare())
+        : root(nullptr), compare(cmp), entryCount(0), keyCount(0) {}
+
+    /**
+     * @brief Acrescenta a memória da árvore ao relatório: "<name>.nodes" (um bloco
+     * por chave, com a cópia da chave) e "<name>.lists" (um FlightListNode por voo).
+     */
+    void reportMemory(MemoryReport &report, const string &name) const {
+        report.addNodes(name + ".nodes", keyCount, sizeof(Node));
+        report.addNodes(name + ".lists", entryCount, sizeof(FlightListNode));
+    }
 
     /**
      * @brief Insere um voo na árvore usando a chave fornecida.
      * @param key Valor da chave.
      * @param flightPtr Ponteiro para o voo.
+     * @return Entrada criada na lista do nó (usada depois em remove()).
+     */
+    FlightListNode* insert(const T& key, Flight* flightPtr) {
+        FlightListNode* entry = nullptr;
+        root = insertRecursive(root, key, flightPtr, entry);
+        entryCount++;
+        return entry;
+    }
+
+    /**
+     * @brief Remove uma entrada da árvore.
+     *
+     * A entrada é desligada da lista de duplicatas em O(1) e as contagens do
+     * caminho até o nó são atualizadas; se a lista ficar vazia, o nó é
+     * removido e a árvore rebalanceada. Custo O(log n).
+     *
+     * @param key Chave com que a entrada foi inserida.
+     * @param entry Entrada retornada por insert().
+     * @return true se a entrada foi removida; false se a chave não existe.
      */
-    void insert(const T& key, Flight* flightPtr) {
-        root = insertRecursive(root, key, flightPtr);
+    bool remove(const T& key, FlightListNode* entry) {
+        if (entry->prev) {
+            // Não é a cabeça da lista: o nó continua com pelo menos uma entrada.
+            entry->prev->next = entry->next;
+            if (entry->next)
+                entry->next->prev = entry->prev;
+            delete entry;
+            entryCount--;
+            adjustCounts(key, -1);
+            return true;
+        }
+        Node* node = findNode(key);
+        if (!node || node->flightList != entry)
+            return false;
+        entryCount--;
+        if (!entry->next) {
+            // Última entrada: o nó sai da árvore. A entrada só é liberada depois,
+            // pois a chave do nó pode ser lida do seu voo durante a remoção.
+            node->listSize = 0;
+            root = removeNodeRecursive(root, key);
+            keyCount--;
+        } else {
+            node->flightList = entry->next;
+            entry->next->prev = nullptr;
+            adjustCounts(key, -1);
+        }
+        delete entry;
+        return true;
     }
 
     /**
-     * @brief Executa uma consulta por intervalo.
+     * @brief Conta as entradas com chave menor (ou menor ou igual) que key, em O(log n).
+     * @param key Chave de referência.
+     * @param inclusive Se true, conta também as entradas com chave igual a key.
+     * @return Número de entradas.
+     */
+    int countBelow(const T& key, bool inclusive) const {
+        int count = 0;
+        Node* node = root;
+        while (node) {
+            int cmpResult = compare(node->key(), key);
+            if (cmpResult < 0 || (inclusive && cmpResult == 0)) {
+                count += (node->left ? node->left->subtreeSize : 0) + node->listSize;
+                node = node->right;
+            } else {
+                node = node->left;
+            }
+        }
+        return count;
+    }
+
+    /**
+     * @brief Conta as entradas de um intervalo sem percorrê-lo, em O(log n).
      *
      * Se os ponteiros para os limites forem nullptr, não há restrição inferior/superior.
      *
@@ -75,15 +388,132 @@ public:
      * @param lowInclusive True se o limite inferior é inclusivo.
      * @param high Ponteiro para o limite superior.
      * @param highInclusive True se o limite superior é inclusivo.
+     * @return Número de entradas no intervalo.
+     */
+    int countRange(const T* low, bool lowInclusive, const T* high, bool highInclusive) const {
+        int upTo = high ? countBelow(*high, highInclusive) : entryCount;
+        int below = low ? countBelow(*low, !lowInclusive) : 0;
+        return upTo > below ? upTo - below : 0;
+    }
+
+    /**
+     * @brief Soma as chaves das entradas com chave menor (ou menor ou igual) que key, em O(log n).
+     * @param key Chave de referência.
+     * @param inclusive Se true, soma também as entradas com chave igual a key.
+     * @return Soma de numericKey() sobre as entradas (cada duplicata conta uma vez).
+     */
+    double sumBelow(const T& key, bool inclusive) const {
+        double sum = 0;
+        Node* node = root;
+        while (node) {
+            int cmpResult = compare(node->key(), key);
+            if (cmpResult < 0 || (inclusive && cmpResult == 0)) {
+                sum += (node->left ? node->left->subtreeSum : 0) + node->listSize * numericKey(node->key());
+                node = node->right;
+            } else {
+                node = node->left;
+            }
+        }
+        return sum;
+    }
+
+    /**
+     * @brief Soma as chaves das entradas de um intervalo sem percorrê-lo, em O(log n).
+     *
+     * Se os ponteiros para os limites forem nullptr, não há restrição inferior/superior.
+     *
+     * @param low Ponteiro para o limite inferior.
+     * @param lowInclusive True se o limite inferior é inclusivo.
+     * @param high Ponteiro para o limite superior.
+     * @param highInclusive True se o limite superior é inclusivo.
+     * @return Soma das chaves no intervalo (0 se o intervalo for vazio).
+     */
+    double sumRange(const T* low, bool lowInclusive, const T* high, bool highInclusive) const {
+        if (countRange(low, lowInclusive, high, highInclusive) == 0)
+            return 0;
+        double upTo = high ? sumBelow(*high, highInclusive) : (root ? root->subtreeSum : 0);
+        double below = low ? sumBelow(*low, !lowInclusive) : 0;
+        return upTo - below;
+    }
+
+    /**
+     * @brief Retorna o voo de posição rank na ordem das chaves (seleção por posição).
+     * @param rank Posição (0 = primeira entrada da menor chave).
+     * @return Ponteiro para o voo, ou nullptr se rank estiver fora de [0, entryCount).
+     */
+    Flight* selectEntry(int rank) const {
+        if (rank < 0 || rank >= entryCount)
+            return nullptr;
+        return Cursor(root, compare, rank, nullptr, false).next();
+    }
+
+    /**
+     * @brief Cria um cursor sobre as entradas de um intervalo (veja AVLRangeCursor).
+     * @param low Ponteiro para o limite inferior (nullptr = sem limite).
+     * @param lowInclusive True se o limite inferior é inclusivo.
+     * @param high Ponteiro para o limite superior (nullptr = sem limite).
+     * @param highInclusive True se o limite superior é inclusivo.
+     * @return Cursor posicionado na primeira entrada do intervalo.
+     */
+    Cursor rangeCursor(const T* low, bool lowInclusive, const T* high, bool highInclusive) const {
+        return Cursor(root, compare, low, lowInclusive, high, highInclusive);
+    }
+
+    /**
+     * @brief Cria um cursor sobre um intervalo pulando as primeiras offset entradas (paginação).
+     *
+     * O salto usa os tamanhos das subárvores, sem percorrer as entradas puladas
+     * (exceto dentro da lista de duplicatas da primeira chave devolvida).
+     *
+     * @param low Ponteiro para o limite inferior (nullptr = sem limite).
+     * @param lowInclusive True se o limite inferior é inclusivo.
+     * @param high Ponteiro para o limite superior (nullptr = sem limite).
+     * @param highInclusive True se o limite superior é inclusivo.
+     * @param offset Número de entradas do intervalo a pular.
+     * @return Cursor posicionado na entrada offset do intervalo.
+     */
+    Cursor rangeCursor(const T* low, bool lowInclusive, const T* high, bool highInclusive,
+                                  int offset) const {
+        if (offset <= 0)
+            return rangeCursor(low, lowInclusive, high, highInclusive);
+        int rank = (low ? countBelow(*low, !lowInclusive) : 0) + offset;
+        return Cursor(root, compare, rank, high, highInclusive);
+    }
+
+    /**
+     * @brief Executa uma consulta por intervalo, materializando o resultado.
+     *
+     * Se os ponteiros para os limites forem nullptr, não há restrição inferior/superior.
+     * Equivale a percorrer rangeCursor() copiando os voos para um array.
+     *
+     * @param low Ponteiro para o limite inferior.
+     * @param lowInclusive True se o limite inferior é inclusivo.
+     * @param high Ponteiro para o limite superior.
+     * @param highInclusive True se o limite superior é inclusivo.
      * @param count (Saída) Número de voos encontrados.
      * @return Array dinamicamente alocado de ponteiros para Flight (deve ser liberado pelo chamador).
      */
     Flight** rangeQuery(const T* low, bool lowInclusive,
                         const T* high, bool highInclusive, int &count) {
-        int capacity = 10;
+        Cursor cursor = rangeCursor(low, lowInclusive, high, highInclusive);
+        int capacity = countRange(low, lowInclusive, high, highInclusive);
+        if (capacity < 10)
+            capacity = 10;
         Flight** resultArray = new Flight*[capacity];
         count = 0;
-        rangeQueryRecursive(root, low, lowInclusive, high, highInclusive, resultArray, count, capacity);
+        while (Flight* flight = cursor.next()) {
+            if (count >= capacity) {
+                METRIC_INC(METRIC_RANGE_REGROWTHS);
+                int newCapacity = capacity * 2;
+                Flight** newArray = new Flight*[newCapacity];
+                for (int i = 0; i < count; i++)
+                    newArray[i] = resultArray[i];
+                delete[] resultArray;
+                resultArray = newArray;
+                capacity = newCapacity;
+            }
+            resultArray[count++] = flight;
+        }
         return resultArray;
     }
 
@@ -100,7 +530,7 @@ private:
      * @param node Ponteiro para o nó.
      * @return Altura do nó ou 0 se for nullptr.
      */
-    int getNodeHeight(AVLTreeNode<T>* node) {
+    int getNodeHeight(Node* node) {
         return node ? node->height : 0;
     }
 
@@ -109,19 +539,52 @@ private:
      * @param node Ponteiro para o nó.
      * @return Fator de equilíbrio.
      */
-    int getBalanceFactor(AVLTreeNode<T>* node) {
+    int getBalanceFactor(Node* node) {
         return node ? getNodeHeight(node->left) - getNodeHeight(node->right) : 0;
     }
 
     /**
-     * @brief Atualiza a altura de um nó.
+     * @brief Retorna o número de voos de uma subárvore.
      * @param node Ponteiro para o nó.
+     * @return Entradas da subárvore ou 0 se for nullptr.
      */
-    void updateNodeHeight(AVLTreeNode<T>* node) {
+    int getSubtreeSize(Node* node) {
+        return node ? node->subtreeSize : 0;
+    }
+
+    /**
+     * @brief Atualiza a altura, o número de voos e a soma das chaves da subárvore de um nó a partir dos filhos.
+     * @param node Ponteiro para o nó.
+     */
+    void updateNode(Node* node) {
         if (node) {
             int leftHeight = getNodeHeight(node->left);
             int rightHeight = getNodeHeight(node->right);
             node->height = 1 + (leftHeight > rightHeight ? leftHeight : rightHeight);
+            node->subtreeSize = node->listSize + getSubtreeSize(node->left) + getSubtreeSize(node->right);
+            node->subtreeSum = node->listSize * numericKey(node->key())
+                             + (node->left ? node->left->subtreeSum : 0)
+                             + (node->right ? node->right->subtreeSum : 0);
+        }
+    }
+
+    /**
+     * @brief Soma delta às contagens do caminho até o nó da chave (entrada inserida ou removida da lista).
+     * @param key Chave do nó (deve existir).
+     * @param delta Variação do número de voos.
+     */
+    void adjustCounts(const T& key, int delta) {
+        double keyDelta = delta * numericKey(key);
+        Node* node = root;
+        while (node) {
+            node->subtreeSize += delta;
+            node->subtreeSum += keyDelta;
+            int cmpResult = compare(key, node->key());
+            if (cmpResult == 0) {
+                node->listSize += delta;
+                return;
+            }
+            node = cmpResult < 0 ? node->left : node->right;
         }
     }
 
@@ -130,13 +593,13 @@ private:
      * @param y Nó a ser rotacionado.
      * @return Novo nó raiz após a rotação.
      */
-    AVLTreeNode<T>* rotateRight(AVLTreeNode<T>* y) {
-        AVLTreeNode<T>* x = y->left;
-        AVLTreeNode<T>* T2 = x->right;
+    Node* rotateRight(Node* y) {
+        Node* x = y->left;
+        Node* T2 = x->right;
         x->right = y;
         y->left = T2;
-        updateNodeHeight(y);
-        updateNodeHeight(x);
+        updateNode(y);
+        updateNode(x);
         return x;
     }
 
@@ -145,13 +608,13 @@ private:
      * @param x Nó a ser rotacionado.
      * @return Novo nó raiz após a rotação.
      */
-    AVLTreeNode<T>* rotateLeft(AVLTreeNode<T>* x) {
-        AVLTreeNode<T>* y = x->right;
-        AVLTreeNode<T>* T2 = y->left;
+    Node* rotateLeft(Node* x) {
+        Node* y = x->right;
+        Node* T2 = y->left;
         y->left = x;
         x->right = T2;
-        updateNodeHeight(x);
-        updateNodeHeight(y);
+        updateNode(x);
+        updateNode(y);
         return y;
     }
 
@@ -160,41 +623,51 @@ private:
      * @param node Nó atual.
      * @param key Valor da chave a inserir.
      * @param flightPtr Ponteiro para o voo.
+     * @param entry (Saída) Entrada criada para o voo.
      * @return Nó atualizado após a inserção.
      */
-    AVLTreeNode<T>* insertRecursive(AVLTreeNode<T>* node, const T& key, Flight* flightPtr) {
-        if (!node)
-            return new AVLTreeNode<T>(key, flightPtr);
+    Node* insertRecursive(Node* node, const T& key, Flight* flightPtr, FlightListNode* &entry) {
+        if (!node) {
+            Node* newNode = new Node(key, flightPtr);
+            entry = newNode->flightList;
+            keyCount++;
+            return newNode;
+        }
         
-        int cmpResult = compare(key, node->key);
+        int cmpResult = compare(key, node->key());
         if (cmpResult == 0) {
             // Chave duplicada: adiciona o voo à lista.
             FlightListNode* newFlightNode = new FlightListNode(flightPtr);
             newFlightNode->next = node->flightList;
+            node->flightList->prev = newFlightNode;
             node->flightList = newFlightNode;
+            node->listSize++;
+            node->subtreeSize++;
+            node->subtreeSum += numericKey(key);
+            entry = newFlightNode;
             return node;
         } else if (cmpResult < 0) {
-            node->left = insertRecursive(node->left, key, flightPtr);
+            node->left = insertRecursive(node->left, key, flightPtr, entry);
         } else {
-            node->right = insertRecursive(node->right, key, flightPtr);
+            node->right = insertRecursive(node->right, key, flightPtr, entry);
         }
         
-        updateNodeHeight(node);
+        updateNode(node);
         int balance = getBalanceFactor(node);
 
         // Caso Esquerda–Esquerda
-        if (balance > 1 && compare(key, node->left->key) < 0)
+        if (balance > 1 && compare(key, node->left->key()) < 0)
             return rotateRight(node);
         // Caso Direita–Direita
-        if (balance < -1 && compare(key, node->right->key) > 0)
+        if (balance < -1 && compare(key, node->right->key()) > 0)
             return rotateLeft(node);
         // Caso Esquerda–Direita
-        if (balance > 1 && compare(key, node->left->key) > 0) {
+        if (balance > 1 && compare(key, node->left->key()) > 0) {
             node->left = rotateLeft(node->left);
             return rotateRight(node);
         }
         // Caso Direita–Esquerda
-        if (balance < -1 && compare(key, node->right->key) < 0) {
+        if (balance < -1 && compare(key, node->right->key()) < 0) {
             node->right = rotateRight(node->right);
             return rotateLeft(node);
         }
@@ -202,61 +675,97 @@ private:
     }
 
     /**
-     * @brief Função recursiva para consulta por intervalo.
+     * @brief Procura o nó com a chave fornecida.
+     * @param key Valor da chave.
+     * @return Ponteiro para o nó ou nullptr se não existir.
+     */
+    Node* findNode(const T& key) {
+        Node* node = root;
+        while (node) {
+            int cmpResult = compare(key, node->key());
+            if (cmpResult == 0)
+                return node;
+            node = cmpResult < 0 ? node->left : node->right;
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Restaura o balanceamento de um nó após uma remoção.
+     * @param node Nó a ser rebalanceado.
+     * @return Nova raiz da subárvore.
+     */
+    Node* rebalance(Node* node) {
+        updateNode(node);
+        int balance = getBalanceFactor(node);
+        if (balance > 1) {
+            if (getBalanceFactor(node->left) < 0)
+                node->left = rotateLeft(node->left);
+            return rotateRight(node);
+        }
+        if (balance < -1) {
+            if (getBalanceFactor(node->right) > 0)
+                node->right = rotateRight(node->right);
+            return rotateLeft(node);
+        }
+        return node;
+    }
+
+    /**
+     * @brief Função recursiva de remoção de um nó cuja lista de voos ficou vazia.
      *
-     * Adiciona os voos que satisfazem o intervalo em resultArray.
+     * Quando o nó tem dois filhos, a chave e a lista do sucessor são movidas
+     * para ele e o sucessor é desligado sem comparações (removeMin); as
+     * entradas (FlightListNode) continuam válidas.
      *
      * @param node Nó atual.
-     * @param low Ponteiro para o limite inferior.
-     * @param lowInclusive Se true, o limite inferior é inclusivo.
-     * @param high Ponteiro para o limite superior.
-     * @param highInclusive Se true, o limite superior é inclusivo.
-     * @param resultArray Array para armazenar os resultados.
-     * @param count (Saída) Número de voos armazenados até o momento.
-     * @param capacity Capacidade atual do array.
-     */
-    void rangeQueryRecursive(AVLTreeNode<T>* node, const T* low, bool lowInclusive,
-                             const T* high, bool highInclusive,
-                             Flight** &resultArray, int &count, int &capacity) {
+     * @param key Chave do nó a remover.
+     * @return Nó atualizado após a remoção.
+     */
+    Node* removeNodeRecursive(Node* node, const T& key) {
         if (!node)
-            return;
-        if (low) {
-            int cmpLow = compare(node->key, *low);
-            if (cmpLow < 0 || (!lowInclusive && cmpLow == 0)) {
-                rangeQueryRecursive(node->right, low, lowInclusive, high, highInclusive, resultArray, count, capacity);
-                return;
-            }
-        }
-        if (high) {
-            int cmpHigh = compare(node->key, *high);
-            if (cmpHigh > 0 || (!highInclusive && cmpHigh == 0)) {
-                rangeQueryRecursive(node->left, low, lowInclusive, high, highInclusive, resultArray, count, capacity);
-                return;
-            }
+            return nullptr;
+        int cmpResult = compare(key, node->key());
+        if (cmpResult < 0) {
+            node->left = removeNodeRecursive(node->left, key);
+        } else if (cmpResult > 0) {
+            node->right = removeNodeRecursive(node->right, key);
+        } else if (!node->left || !node->right) {
+            Node* child = node->left ? node->left : node->right;
+            delete node;
+            return child;
+        } else {
+            Node* successor = node->right;
+            while (successor->left)
+                successor = successor->left;
+            node->set(successor->key());
+            node->flightList = successor->flightList;
+            node->listSize = successor->listSize;
+            node->right = removeMin(node->right);
         }
-        rangeQueryRecursive(node->left, low, lowInclusive, high, highInclusive, resultArray, count, capacity);
-        FlightListNode* flightNode = node->flightList;
-        while (flightNode) {
-            if (count >= capacity) {
-                int newCapacity = capacity * 2;
-                Flight** newArray = new Flight*[newCapacity];
-                for (int i = 0; i < count; i++)
-                    newArray[i] = resultArray[i];
-                delete[] resultArray;
-                resultArray = newArray;
-                capacity = newCapacity;
-            }
-            resultArray[count++] = flightNode->flight;
-            flightNode = flightNode->next;
+        return rebalance(node);
+    }
+
+    /**
+     * @brief Desliga e libera o nó de menor chave de uma subárvore (sem liberar a sua lista).
+     * @param node Raiz da subárvore.
+     * @return Nova raiz da subárvore.
+     */
+    Node* removeMin(Node* node) {
+        if (!node->left) {
+            Node* right = node->right;
+            delete node;
+            return right;
         }
-        rangeQueryRecursive(node->right, low, lowInclusive, high, highInclusive, resultArray, count, capacity);
+        node->left = removeMin(node->left);
+        return rebalance(node);
     }
 
     /**
      * @brief Libera recursivamente a memória da árvore.
      * @param node Nó atual.
      */
-    void destroyTree(AVLTreeNode<T>* node) {
+    void destroyTree(Node* node) {
         if (!node)
             return;
         destroyTree(node->left);
@@ -0,0 +1,113 @@
+#ifndef AGGREGATE_HPP
+#define AGGREGATE_HPP
+
+#include "Flight.hpp"
+#include <cstring>
+
+/**
+ * @brief Funções de agregação das consultas "count", "min", "max", "sum" e "avg".
+ */
+enum AggregateFunction {
+    AGG_COUNT,  ///< Número de voos.
+    AGG_MIN,    ///< Menor valor do campo.
+    AGG_MAX,    ///< Maior valor do campo.
+    AGG_SUM,    ///< Soma do campo.
+    AGG_AVG     ///< Média do campo.
+};
+
+/**
+ * @brief Converte o nome de uma função de agregação.
+ * @param name Nome ("count", "min", "max", "sum" ou "avg").
+ * @param function (Saída) Função correspondente.
+ * @return true se o nome é uma função de agregação; false caso contrário.
+ */
+inline bool aggregateFromName(const char* name, AggregateFunction &function) {
+    static const char* names[] = { "count", "min", "max", "sum", "avg" };
+    for (int i = 0; i <= AGG_AVG; i++) {
+        if (strcmp(name, names[i]) == 0) {
+            function = static_cast<AggregateFunction>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Retorna o valor numérico de um campo de um voo (origem e destino não são numéricos).
+ */
+inline double flightFieldValue(const Flight &flight, IndexField field) {
+    switch (field) {
+        case INDEX_PRICE: return flight.price;
+        case INDEX_DURATION: return flight.duration;
+        case INDEX_STOPS: return flight.stops;
+        case INDEX_SEATS: return __atomic_load_n(&flight.seats, __ATOMIC_RELAXED);
+        case INDEX_DEPARTURE: return static_cast<double>(flight.dep_time);
+        case INDEX_ARRIVAL: return static_cast<double>(flight.arr_time);
+        default: return 0;
+    }
+}
+
+/**
+ * @brief Resultado (parcial ou final) de uma consulta de agregação.
+ *
+ * Acumula contagem, soma e os voos com o menor e o maior valor do campo; a
+ * função pedida só decide o que é impresso. Os voos extremos também são
+ * guardados (por exemplo, o voo mais barato).
+ */
+struct AggregateResult {
+    AggregateFunction function;  ///< Função pedida.
+    IndexField field;            ///< Campo agregado (ignorado em AGG_COUNT).
+    long long count;             ///< Voos que satisfazem a expressão.
+    double sum;                  ///< Soma do campo.
+    const Flight* minFlight;     ///< Voo com o menor valor (nullptr se nenhum).
+    const Flight* maxFlight;     ///< Voo com o maior valor (nullptr se nenhum).
+    double minValue;             ///< Valor do campo em minFlight.
+    double maxValue;             ///< Valor do campo em maxFlight.
+    bool fromIndex;              ///< True se respondido só com as contagens e somas dos nós do índice.
+
+    /**
+     * @brief Construtor: resultado vazio.
+     */
+    AggregateResult(AggregateFunction aggregateFunction, IndexField aggregateField)
+        : function(aggregateFunction), field(aggregateField), count(0), sum(0),
+          minFlight(nullptr), maxFlight(nullptr), minValue(0), maxValue(0), fromIndex(false) {}
+
+    /**
+     * @brief Acumula um voo que satisfaz a expressão.
+     */
+    void add(const Flight* flight) {
+        count++;
+        if (function == AGG_COUNT)
+            return;
+        double value = flightFieldValue(*flight, field);
+        sum += value;
+        if (!minFlight || value < minValue) {
+            minFlight = flight;
+            minValue = value;
+        }
+        if (!maxFlight || value > maxValue) {
+            maxFlight = flight;
+            maxValue = value;
+        }
+    }
+
+    /**
+     * @brief Acumula o resultado parcial de outro conjunto de voos (ex.: outra partição).
+     *
+     * Em um empate de mínimo ou máximo, o voo já acumulado é mantido.
+     */
+    void merge(const AggregateResult &other) {
+        count += other.count;
+        sum += other.sum;
+        if (other.minFlight && (!minFlight || other.minValue < minValue)) {
+            minFlight = other.minFlight;
+            minValue = other.minValue;
+        }
+        if (other.maxFlight && (!maxFlight || other.maxValue > maxValue)) {
+            maxFlight = other.maxFlight;
+            maxValue = other.maxValue;
+        }
+    }
+};
+
+#endif // AGGREGATE_HPP
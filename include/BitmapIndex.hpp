@@ -0,0 +1,265 @@
+#ifndef BITMAPINDEX_HPP
+#define BITMAPINDEX_HPP
+
+#include "Expression.hpp"
+#include "MemoryReport.hpp"
+#include <stdint.h>
+
+/**
+ * @brief Conjunto de identificadores de voos comprimido no estilo roaring.
+ *
+ * Os identificadores são divididos em blocos de 65536 pelos 16 bits altos.
+ * Cada bloco não vazio é um contêiner: um array ordenado dos 16 bits baixos,
+ * enquanto tiver até ARRAY_LIMIT elementos, ou um mapa de 1024 palavras de 64
+ * bits, acima disso. Os contêineres ficam em um array ordenado pelo bloco.
+ *
+ * As operações de conjunto (andWith(), orWith(), andNotWith()) percorrem os
+ * contêineres dos dois lados em ordem; entre dois mapas, combinam palavra a
+ * palavra (laços simples, vetorizados pelo compilador), e a cardinalidade é
+ * recontada com popcount.
+ */
+class RoaringBitmap {
+public:
+    static const int ARRAY_LIMIT = 4096;    ///< Elementos acima dos quais um contêiner vira mapa de bits.
+    static const int BITMAP_WORDS = 1024;   ///< Palavras de 64 bits de um mapa (65536 bits).
+
+    /**
+     * @brief Construtor: conjunto vazio.
+     */
+    RoaringBitmap();
+
+    /**
+     * @brief Destrutor: libera os contêineres.
+     */
+    ~RoaringBitmap();
+
+    /**
+     * @brief Acrescenta um identificador.
+     *
+     * Identificadores crescentes entram no fim dos arrays, sem deslocamentos.
+     */
+    void add(int id);
+
+    /**
+     * @brief Remove um identificador.
+     * @return true se ele estava no conjunto; false caso contrário.
+     */
+    bool remove(int id);
+
+    /**
+     * @brief Verifica se um identificador está no conjunto.
+     */
+    bool contains(int id) const;
+
+    /**
+     * @brief Retorna o número de identificadores no conjunto.
+     */
+    int cardinality() const;
+
+    /**
+     * @brief Substitui o conteúdo por uma cópia de other.
+     */
+    void copyFrom(const RoaringBitmap &other);
+
+    /**
+     * @brief Interseção com other, no lugar.
+     */
+    void andWith(const RoaringBitmap &other);
+
+    /**
+     * @brief União com other, no lugar.
+     */
+    void orWith(const RoaringBitmap &other);
+
+    /**
+     * @brief Diferença (this AND NOT other), no lugar.
+     */
+    void andNotWith(const RoaringBitmap &other);
+
+    /**
+     * @brief Chama visitor(id) para cada identificador, em ordem crescente.
+     */
+    template<typename Visitor>
+    void forEach(Visitor &visitor) const;
+
+    /**
+     * @brief Acrescenta a memória do bitmap ao relatório (diretório e contêineres).
+     */
+    void reportMemory(MemoryReport &report, const string &name) const;
+
+private:
+    /**
+     * @brief Contêiner de um bloco de 65536 identificadores.
+     */
+    struct Container {
+        uint16_t block;      ///< 16 bits altos dos identificadores do contêiner.
+        int cardinality;     ///< Elementos no contêiner.
+        uint16_t* values;    ///< Array ordenado dos 16 bits baixos (nullptr em mapas).
+        int capacity;        ///< Capacidade de values.
+        uint64_t* words;     ///< Mapa de bits (nullptr em arrays).
+    };
+
+    Container* containers;  ///< Contêineres não vazios, ordenados pelo bloco.
+    int containerCount;     ///< Contêineres em uso.
+    int containerCapacity;  ///< Capacidade de containers.
+
+    /**
+     * @brief Retorna a posição do primeiro contêiner com bloco maior ou igual a block.
+     */
+    int findContainer(uint16_t block) const;
+
+    /**
+     * @brief Abre um contêiner vazio (array) na posição index.
+     */
+    void insertContainer(int index, uint16_t block);
+
+    /**
+     * @brief Remove os contêineres vazios.
+     */
+    void dropEmpty();
+
+    /**
+     * @brief Libera o conteúdo de um contêiner.
+     */
+    static void release(Container &container);
+
+    /**
+     * @brief Copia um contêiner (arrays e mapas são duplicados).
+     */
+    static void copyContainer(Container &target, const Container &source);
+
+    /**
+     * @brief Converte um array em mapa de bits.
+     */
+    static void toBitmap(Container &container);
+
+    /**
+     * @brief Converte um mapa de bits em array (cardinalidade até ARRAY_LIMIT).
+     */
+    static void toArray(Container &container);
+
+    /**
+     * @brief Escolhe a representação pela cardinalidade (mapa acima de ARRAY_LIMIT).
+     */
+    static void normalize(Container &container);
+
+    /**
+     * @brief Garante espaço para capacity elementos no array de um contêiner.
+     */
+    static void reserve(Container &container, int capacity);
+
+    /**
+     * @brief Interseção de dois contêineres do mesmo bloco, em target.
+     */
+    static void intersect(Container &target, const Container &other);
+
+    /**
+     * @brief União de dois contêineres do mesmo bloco, em target.
+     */
+    static void unite(Container &target, const Container &other);
+
+    /**
+     * @brief Diferença de dois contêineres do mesmo bloco, em target.
+     */
+    static void subtract(Container &target, const Container &other);
+
+    RoaringBitmap(const RoaringBitmap&);
+    RoaringBitmap& operator=(const RoaringBitmap&);
+};
+
+/**
+ * @brief Índice de bitmap de um campo: um RoaringBitmap de identificadores por chave.
+ *
+ * Serve a campos com poucas chaves distintas (paradas, assentos, aeroportos),
+ * em que cada chave cobre uma fração grande dos voos. Um predicado vira a
+ * união dos bitmaps das chaves que o satisfazem, em qualquer operador
+ * (inclusive NE), e predicados combinados viram operações de conjunto sobre
+ * os bitmaps, em vez de arrays de Flight*.
+ */
+class BitmapIndex {
+public:
+    /**
+     * @brief Construtor: índice vazio.
+     */
+    BitmapIndex();
+
+    /**
+     * @brief Destrutor: libera os bitmaps.
+     */
+    ~BitmapIndex();
+
+    /**
+     * @brief Acrescenta um voo à chave.
+     * @param key Chave do voo.
+     * @param id Identificador do voo.
+     */
+    void insert(long long key, int id);
+
+    /**
+     * @brief Remove um voo da chave (a chave some quando fica vazia).
+     * @param key Chave com que o voo foi inserido.
+     * @param id Identificador do voo.
+     * @return true se o voo estava na chave; false caso contrário.
+     */
+    bool remove(long long key, int id);
+
+    /**
+     * @brief Retorna o número de chaves distintas.
+     */
+    int getKeyCount() const { return keyCount; }
+
+    /**
+     * @brief Acrescenta a memória do índice ao relatório (chaves e bitmaps de todas as chaves).
+     */
+    void reportMemory(MemoryReport &report, const string &name) const;
+
+    /**
+     * @brief Retorna os voos com chave que satisfaz "chave op value".
+     * @param op Operador de comparação.
+     * @param value Valor comparado.
+     * @return Bitmap dinamicamente alocado (deve ser liberado pelo chamador).
+     */
+    RoaringBitmap* select(PredicateExpr::CompOp op, long long value) const;
+
+private:
+    long long* keys;          ///< Chaves distintas, ordenadas.
+    RoaringBitmap** bitmaps;  ///< Voos de cada chave.
+    int keyCount;             ///< Chaves em uso.
+    int keyCapacity;          ///< Capacidade de keys e bitmaps.
+
+    /**
+     * @brief Retorna a posição da primeira chave maior ou igual a key.
+     */
+    int findKey(long long key) const;
+
+    BitmapIndex(const BitmapIndex&);
+    BitmapIndex& operator=(const BitmapIndex&);
+};
+
+/**
+ * @brief Chama visitor(id) para cada identificador, em ordem crescente.
+ *
+ * Nos mapas, cada palavra não nula é consumida bit a bit com
+ * __builtin_ctzll, de modo que palavras vazias custam uma comparação.
+ */
+template<typename Visitor>
+void RoaringBitmap::forEach(Visitor &visitor) const {
+    for (int c = 0; c < containerCount; c++) {
+        const Container &container = containers[c];
+        int base = static_cast<int>(container.block) << 16;
+        if (container.words) {
+            for (int w = 0; w < BITMAP_WORDS; w++) {
+                uint64_t word = container.words[w];
+                while (word) {
+                    visitor(base + w * 64 + __builtin_ctzll(word));
+                    word &= word - 1;
+                }
+            }
+        } else {
+            for (int i = 0; i < container.cardinality; i++)
+                visitor(base + container.values[i]);
+        }
+    }
+}
+
+#endif // BITMAPINDEX_HPP
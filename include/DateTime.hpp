@@ -12,4 +12,39 @@
  */
 time_t parseDateTime(const char* dateTimeStr);
 
+static const int DATETIME_LENGTH = 19;  ///< Tamanho de "YYYY-MM-DDTHH:MM:SS".
+
+/**
+ * @brief Converte e valida uma data/hora "YYYY-MM-DDTHH:MM:SS".
+ *
+ * Aceita o que a entrada sempre aceitou: campos sem zeros à esquerda (ano
+ * com 1 a 4 dígitos, demais com 1 ou 2) e milissegundos ("...:SS.123"),
+ * que são descartados. Rejeita separadores ou dígitos ausentes, texto extra
+ * e campos fora do intervalo (mês 13, 2024-02-30, 24:00:00). Como só os
+ * segundos são guardados, a data é impressa depois na forma canônica de
+ * formatDateTime().
+ *
+ * @param text String terminada em '\0'.
+ * @param value (Saída) Tempo em UTC.
+ * @return true se a data é válida; false caso contrário.
+ */
+bool parseDateTimeChecked(const char* text, time_t &value);
+
+/**
+ * @brief Escreve um time_t (UTC) no formato "YYYY-MM-DDTHH:MM:SS".
+ *
+ * Forma canônica das datas aceitas por parseDateTimeChecked() (ano entre 0 e 9999).
+ *
+ * @param value Tempo em UTC.
+ * @param buffer (Saída) String terminada em '\0' (pelo menos DATETIME_LENGTH + 1 bytes).
+ */
+void formatDateTime(time_t value, char* buffer);
+
+/**
+ * @brief Retorna o mês (UTC) de um time_t como ano * 12 + mês - 1.
+ *
+ * Meses consecutivos têm índices consecutivos, inclusive na virada do ano.
+ */
+long long monthIndex(time_t value);
+
 #endif // DATETIME_HPP
\ No newline at end of file
@@ -0,0 +1,117 @@
+#ifndef EXPRARENA_HPP
+#define EXPRARENA_HPP
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+/**
+ * @brief Arena para os nós de uma árvore de expressão.
+ *
+ * Os nós são alocados em sequência dentro de blocos e nunca liberados
+ * individualmente: reset() descarta todos de uma vez, mantendo o primeiro
+ * bloco para a próxima consulta. Por isso os nós não podem ter destrutores
+ * com efeito (nada de std::string ou ponteiros próprios).
+ */
+class ExprArena {
+public:
+    static const size_t BLOCK_SIZE = 4096;  ///< Tamanho padrão de um bloco (bytes).
+
+    /**
+     * @brief Construtor: a arena começa vazia; o primeiro bloco é criado no primeiro uso.
+     */
+    ExprArena() : head(nullptr), cursor(nullptr), limit(nullptr) {}
+
+    /**
+     * @brief Destrutor: libera todos os blocos.
+     */
+    ~ExprArena() {
+        release(head);
+    }
+
+    /**
+     * @brief Cria um nó de tipo T (construtor padrão) dentro da arena.
+     */
+    template<typename T>
+    T* create() {
+        return new (allocate(sizeof(T))) T();
+    }
+
+    /**
+     * @brief Reserva um array de count elementos de tipo T (não inicializados) dentro da arena.
+     */
+    template<typename T>
+    T* createArray(int count) {
+        return static_cast<T*>(allocate(sizeof(T) * count));
+    }
+
+    /**
+     * @brief Descarta todos os nós, mantendo apenas o primeiro bloco.
+     */
+    void reset() {
+        if (!head)
+            return;
+        release(head->next);
+        head->next = nullptr;
+        cursor = reinterpret_cast<char*>(head + 1);
+        limit = reinterpret_cast<char*>(head) + head->size;
+    }
+
+private:
+    /**
+     * @brief Cabeçalho de um bloco; os dados vêm logo em seguida.
+     */
+    struct alignas(16) Block {
+        Block* next;  ///< Próximo bloco (mais antigo).
+        size_t size;  ///< Tamanho total do bloco, incluindo o cabeçalho.
+    };
+
+    static const size_t ALIGNMENT = 16;  ///< Alinhamento de cada nó (igual ao de Block).
+
+    Block* head;    ///< Primeiro bloco (mantido por reset()).
+    char* cursor;   ///< Próxima posição livre no bloco atual.
+    char* limit;    ///< Fim do bloco atual.
+
+    /**
+     * @brief Reserva size bytes alinhados, criando um bloco novo se necessário.
+     */
+    void* allocate(size_t size) {
+        size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        if (static_cast<size_t>(limit - cursor) < size || !cursor) {
+            size_t blockSize = sizeof(Block) + size > BLOCK_SIZE ? sizeof(Block) + size : BLOCK_SIZE;
+            Block* block = static_cast<Block*>(malloc(blockSize));
+            if (!block)
+                throw std::bad_alloc();
+            block->size = blockSize;
+            // O primeiro bloco continua sendo head; os demais ficam logo depois dele.
+            if (!head) {
+                block->next = nullptr;
+                head = block;
+            } else {
+                block->next = head->next;
+                head->next = block;
+            }
+            cursor = reinterpret_cast<char*>(block + 1);
+            limit = reinterpret_cast<char*>(block) + blockSize;
+        }
+        void* memory = cursor;
+        cursor += size;
+        return memory;
+    }
+
+    /**
+     * @brief Libera uma lista de blocos.
+     */
+    static void release(Block* block) {
+        while (block) {
+            Block* next = block->next;
+            free(block);
+            block = next;
+        }
+    }
+
+    ExprArena(const ExprArena&);
+    ExprArena& operator=(const ExprArena&);
+};
+
+#endif // EXPRARENA_HPP
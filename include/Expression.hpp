@@ -2,61 +2,76 @@
 #define EXPRESSION_HPP
 
 #include "Flight.hpp"
-#include <string>
 #include <cstring>
 #include <cstdlib>
-#include <iostream>
 
-using std::string;
+/**
+ * @brief Tipo de um nó da árvore de expressão.
+ *
+ * Usado para percorrer a árvore (static_cast pelo tipo) sem RTTI.
+ */
+enum ExprKind {
+    EXPR_LOGICAL,    ///< LogicalExpr (AND/OR n-ário).
+    EXPR_NOT,        ///< NotExpr.
+    EXPR_PREDICATE   ///< PredicateExpr.
+};
 
 /**
- * @brief Classe abstrata para expressões.
+ * @brief Classe base das expressões.
+ *
+ * Os nós são criados em uma ExprArena e descartados todos juntos; por isso não
+ * há destrutores virtuais nem nós que possuam memória própria. A avaliação é
+ * despachada pelo campo kind.
  */
 class Expr {
 public:
+    ExprKind kind;  ///< Tipo concreto do nó.
+
     /**
      * @brief Avalia a expressão para um dado voo.
      * @param flight Objeto Flight a ser avaliado.
      * @return true se a expressão for satisfeita; false caso contrário.
      */
-    virtual bool evaluate(const Flight &flight) = 0;
+    bool evaluate(const Flight &flight) const;
 
-    virtual ~Expr() {}
+protected:
+    /**
+     * @brief Construtor.
+     * @param nodeKind Tipo concreto do nó.
+     */
+    explicit Expr(ExprKind nodeKind) : kind(nodeKind) {}
 };
 
 /**
- * @brief Representa uma expressão lógica binária (AND, OR).
+ * @brief Representa uma cadeia de operandos ligados por AND ou por OR.
+ *
+ * Cadeias como "(a)&&(b)&&(c)", inclusive com parênteses aninhados do mesmo
+ * operador, viram um único nó. Como AND e OR são comutativos, a ordem dos
+ * filhos pode ser trocada (veja optimizeExpression()) sem mudar o resultado;
+ * a avaliação para no primeiro filho que decide a expressão.
  */
-class BinaryExpr : public Expr {
+class LogicalExpr : public Expr {
 public:
-    char op;     ///< '&' para AND, '|' para OR.
-    Expr *left;  ///< Subexpressão à esquerda.
-    Expr *right; ///< Subexpressão à direita.
+    char op;           ///< '&' para AND, '|' para OR.
+    Expr **children;   ///< Operandos, na ordem de avaliação (array na arena).
+    int childCount;    ///< Número de operandos.
 
     /**
      * @brief Construtor.
      */
-    BinaryExpr() : op(0), left(nullptr), right(nullptr) {}
+    LogicalExpr() : Expr(EXPR_LOGICAL), op(0), children(nullptr), childCount(0) {}
 
     /**
-     * @brief Avalia a expressão binária.
+     * @brief Avalia a expressão lógica com curto-circuito.
      * @param flight Objeto Flight.
      * @return Resultado da operação lógica.
      */
-    virtual bool evaluate(const Flight &flight) {
-        if (op == '&')
-            return left->evaluate(flight) && right->evaluate(flight);
-        else if (op == '|')
-            return left->evaluate(flight) || right->evaluate(flight);
-        return false;
-    }
-
-    /**
-     * @brief Destrutor.
-     */
-    virtual ~BinaryExpr() {
-        delete left;
-        delete right;
+    bool evaluate(const Flight &flight) const {
+        bool shortCircuit = op == '|';
+        for (int i = 0; i < childCount; i++)
+            if (children[i]->evaluate(flight) == shortCircuit)
+                return shortCircuit;
+        return !shortCircuit;
     }
 };
 
@@ -70,23 +85,16 @@ public:
     /**
      * @brief Construtor.
      */
-    NotExpr() : child(nullptr) {}
+    NotExpr() : Expr(EXPR_NOT), child(nullptr) {}
 
     /**
      * @brief Avalia a expressão NOT.
      * @param flight Objeto Flight.
      * @return Negação da avaliação da subexpressão.
      */
-    virtual bool evaluate(const Flight &flight) {
+    bool evaluate(const Flight &flight) const {
         return !child->evaluate(flight);
     }
-
-    /**
-     * @brief Destrutor.
-     */
-    virtual ~NotExpr() {
-        delete child;
-    }
 };
 
 /**
@@ -99,102 +107,92 @@ public:
      */
     enum CompOp { EQ, NE, LT, LE, GT, GE };
 
-    string field;     ///< Nome do campo (ex.: "org", "dst", "prc", etc.).
-    CompOp op;        ///< Operador de comparação.
-    bool isNumeric;   ///< True se o campo for numérico.
-    double numValue;  ///< Valor numérico para comparação (para campos como preço, duração, etc.).
-    string strValue;  ///< Valor em string para comparação (para campos como origem, destino).
+    IndexField field;    ///< Campo comparado.
+    CompOp op;           ///< Operador de comparação.
+    bool isNumeric;      ///< True se o campo for numérico.
+    double numValue;     ///< Valor numérico para comparação (para campos como preço, duração, etc.).
+    char strValue[4];    ///< Código do aeroporto para comparação (origem e destino).
+    AirportCode codeValue;  ///< strValue codificado (encodeAirportCode), comparado com os voos.
+    int parameterIndex;  ///< Índice do parâmetro "?" de um template preparado (-1 se o valor é constante).
+
+    /**
+     * @brief Construtor: predicado com valor constante.
+     */
+    PredicateExpr()
+        : Expr(EXPR_PREDICATE), field(INDEX_COUNT), op(EQ), isNumeric(false), numValue(0), codeValue(0), parameterIndex(-1) {
+        strValue[0] = '\0';
+    }
+
+    /**
+     * @brief Atribui o código de aeroporto comparado (até 3 caracteres).
+     * @return true se o código cabe em strValue; false caso contrário.
+     */
+    bool setString(const char* value, int length) {
+        if (length < 0 || length > 3)
+            return false;
+        memcpy(strValue, value, length);
+        strValue[length] = '\0';
+        codeValue = encodeAirportCode(value, length);
+        return true;
+    }
 
     /**
      * @brief Avalia o predicado para um dado voo.
      * @param flight Objeto Flight.
      * @return true se o voo satisfizer o predicado; false caso contrário.
      */
-    virtual bool evaluate(const Flight &flight) {
-        if (field == "org") {
-            int cmp = strcmp(flight.origin, strValue.c_str());
-            switch(op) {
-                case EQ: return cmp == 0;
-                case NE: return cmp != 0;
-                case LT: return cmp < 0;
-                case LE: return cmp <= 0;
-                case GT: return cmp > 0;
-                case GE: return cmp >= 0;
-            }
-        } else if (field == "dst") {
-            int cmp = strcmp(flight.destination, strValue.c_str());
-            switch(op) {
-                case EQ: return cmp == 0;
-                case NE: return cmp != 0;
-                case LT: return cmp < 0;
-                case LE: return cmp <= 0;
-                case GT: return cmp > 0;
-                case GE: return cmp >= 0;
-            }
-        } else if (field == "prc") {
-            switch(op) {
-                case EQ: return flight.price == numValue;
-                case NE: return flight.price != numValue;
-                case LT: return flight.price < numValue;
-                case LE: return flight.price <= numValue;
-                case GT: return flight.price > numValue;
-                case GE: return flight.price >= numValue;
-            }
-        } else if (field == "dur") {
-            int value = static_cast<int>(numValue);
-            switch(op) {
-                case EQ: return flight.duration == value;
-                case NE: return flight.duration != value;
-                case LT: return flight.duration < value;
-                case LE: return flight.duration <= value;
-                case GT: return flight.duration > value;
-                case GE: return flight.duration >= value;
-            }
-        } else if (field == "sto") {
-            int value = static_cast<int>(numValue);
-            switch(op) {
-                case EQ: return flight.stops == value;
-                case NE: return flight.stops != value;
-                case LT: return flight.stops < value;
-                case LE: return flight.stops <= value;
-                case GT: return flight.stops > value;
-                case GE: return flight.stops >= value;
-            }
-        } else if (field == "sea") {  // Assentos disponíveis
-            int value = static_cast<int>(numValue);
-            switch(op) {
-                case EQ: return flight.seats == value;
-                case NE: return flight.seats != value;
-                case LT: return flight.seats < value;
-                case LE: return flight.seats <= value;
-                case GT: return flight.seats > value;
-                case GE: return flight.seats >= value;
-            }
-        } else if (field == "dep") {  // Data/hora de partida
-            time_t value = static_cast<time_t>(numValue);
-            switch(op) {
-                case EQ: return flight.dep_time == value;
-                case NE: return flight.dep_time != value;
-                case LT: return flight.dep_time < value;
-                case LE: return flight.dep_time <= value;
-                case GT: return flight.dep_time > value;
-                case GE: return flight.dep_time >= value;
-            }
-        } else if (field == "arr") {  // Data/hora de chegada
-            time_t value = static_cast<time_t>(numValue);
-            switch(op) {
-                case EQ: return flight.arr_time == value;
-                case NE: return flight.arr_time != value;
-                case LT: return flight.arr_time < value;
-                case LE: return flight.arr_time <= value;
-                case GT: return flight.arr_time > value;
-                case GE: return flight.arr_time >= value;
-            }
+    bool evaluate(const Flight &flight) const {
+        switch (field) {
+            case INDEX_ORIGIN:
+                return compareValues(flight.origin, codeValue);
+            case INDEX_DESTINATION:
+                return compareValues(flight.destination, codeValue);
+            case INDEX_PRICE:
+                return compareValues(flight.price, numValue);
+            case INDEX_DURATION:
+                return compareValues(flight.duration, static_cast<int>(numValue));
+            case INDEX_STOPS:
+                return compareValues(flight.stops, static_cast<int>(numValue));
+            case INDEX_SEATS:
+                // Lido atomicamente: reservas podem alterar o campo em paralelo.
+                return compareValues(__atomic_load_n(&flight.seats, __ATOMIC_RELAXED), static_cast<int>(numValue));
+            case INDEX_DEPARTURE:
+                return compareValues(flight.dep_time, static_cast<time_t>(numValue));
+            case INDEX_ARRIVAL:
+                return compareValues(flight.arr_time, static_cast<time_t>(numValue));
+            default:
+                return false;
         }
-        return false;
     }
 
-    virtual ~PredicateExpr() { }
+private:
+    /**
+     * @brief Aplica o operador a um valor do voo e ao valor do predicado.
+     */
+    template<typename T>
+    bool compareValues(T value, T reference) const {
+        switch (op) {
+            case EQ: return value == reference;
+            case NE: return value != reference;
+            case LT: return value < reference;
+            case LE: return value <= reference;
+            case GT: return value > reference;
+            case GE: return value >= reference;
+        }
+        return false;
+    }
 };
 
-#endif // EXPRESSION_HPP
\ No newline at end of file
+/**
+ * @brief Avalia a expressão, despachando pelo tipo do nó.
+ */
+inline bool Expr::evaluate(const Flight &flight) const {
+    switch (kind) {
+        case EXPR_LOGICAL: return static_cast<const LogicalExpr*>(this)->evaluate(flight);
+        case EXPR_NOT: return static_cast<const NotExpr*>(this)->evaluate(flight);
+        case EXPR_PREDICATE: return static_cast<const PredicateExpr*>(this)->evaluate(flight);
+    }
+    return false;
+}
+
+#endif // EXPRESSION_HPP
@@ -2,23 +2,99 @@
 #define FLIGHT_HPP
 
 #include <ctime>
+#include <cstring>
+#include <stdint.h>
+
+/**
+ * @brief Código de aeroporto (até 3 caracteres) codificado em um inteiro.
+ *
+ * Os caracteres ficam em bytes, do mais para o menos significativo, e as
+ * posições vazias valem 0; assim a ordem dos inteiros é a mesma de strcmp()
+ * sobre os códigos.
+ */
+typedef uint32_t AirportCode;
+
+/**
+ * @brief Codifica um código de aeroporto.
+ * @param code Início do código (não precisa terminar em '\0').
+ * @param length Tamanho do código (são usados no máximo 3 caracteres).
+ * @return Código codificado.
+ */
+inline AirportCode encodeAirportCode(const char* code, int length) {
+    AirportCode encoded = 0;
+    for (int i = 0; i < 3; i++)
+        encoded = (encoded << 8) | (i < length ? static_cast<unsigned char>(code[i]) : 0);
+    return encoded;
+}
+
+/**
+ * @brief Decodifica um código de aeroporto.
+ * @param code Código codificado.
+ * @param buffer (Saída) Código terminado em '\0' (pelo menos 4 bytes).
+ */
+inline void decodeAirportCode(AirportCode code, char* buffer) {
+    buffer[0] = static_cast<char>((code >> 16) & 0xFF);
+    buffer[1] = static_cast<char>((code >> 8) & 0xFF);
+    buffer[2] = static_cast<char>(code & 0xFF);
+    buffer[3] = '\0';
+}
 
 /**
  * @brief Estrutura que representa um voo.
+ *
+ * Registro compacto (48 bytes): os campos lidos pelos filtros e pela ordenação
+ * vêm primeiro, os códigos de aeroporto são inteiros e as datas ficam apenas
+ * em segundos desde a época; as strings de data são refeitas na impressão
+ * (formatDateTime()).
  */
 struct Flight {
-    char origin[4];         ///< Código da origem.
-    char destination[4];    ///< Código do destino.
-    double price;           ///< Preço do voo.
-    int seats;              ///< Número de assentos disponíveis.
-    char departureStr[40];  ///< Data/hora de partida (string original).
-    char arrivalStr[40];    ///< Data/hora de chegada (string original).
-    int stops;              ///< Número de paradas.
-
-    // Campos calculados:
-    time_t dep_time;        ///< Data/hora de partida (numérico).
-    time_t arr_time;        ///< Data/hora de chegada (numérico).
-    int duration;           ///< Duração em segundos (arr_time - dep_time).
+    double price;             ///< Preço do voo.
+    time_t dep_time;          ///< Data/hora de partida (segundos desde a época, UTC).
+    time_t arr_time;          ///< Data/hora de chegada (segundos desde a época, UTC).
+    int duration;             ///< Duração em segundos (arr_time - dep_time).
+    int stops;                ///< Número de paradas.
+    int seats;                ///< Número de assentos disponíveis.
+    AirportCode origin;       ///< Código da origem.
+    AirportCode destination;  ///< Código do destino.
+    int id;                   ///< Identificador do voo (posição de inserção no armazenamento).
 };
 
+/**
+ * @brief Campos consultáveis de um voo, na ordem dos índices do FlightManager.
+ */
+enum IndexField {
+    INDEX_ORIGIN,
+    INDEX_DESTINATION,
+    INDEX_PRICE,
+    INDEX_DURATION,
+    INDEX_STOPS,
+    INDEX_SEATS,
+    INDEX_DEPARTURE,
+    INDEX_ARRIVAL,
+    INDEX_COUNT
+};
+
+/**
+ * @brief Retorna o nome de um campo nas consultas ("org", "dst", "prc", ...).
+ */
+inline const char* fieldName(IndexField field) {
+    static const char* names[INDEX_COUNT] = { "org", "dst", "prc", "dur", "sto", "sea", "dep", "arr" };
+    return names[field];
+}
+
+/**
+ * @brief Converte o nome de um campo nas consultas para IndexField.
+ * @param name Início do nome (não precisa terminar em '\0').
+ * @param length Tamanho do nome.
+ * @return Campo correspondente, ou INDEX_COUNT se o nome não for um campo.
+ */
+inline IndexField fieldFromName(const char* name, int length) {
+    if (length != 3)
+        return INDEX_COUNT;
+    for (int field = 0; field < INDEX_COUNT; field++)
+        if (memcmp(name, fieldName(static_cast<IndexField>(field)), 3) == 0)
+            return static_cast<IndexField>(field);
+    return INDEX_COUNT;
+}
+
 #endif // FLIGHT_HPP
\ No newline at end of file
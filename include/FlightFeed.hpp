@@ -0,0 +1,113 @@
+#ifndef FLIGHTFEED_HPP
+#define FLIGHTFEED_HPP
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include "PartitionedStore.hpp"
+
+using std::string;
+
+/**
+ * @brief Resultado de uma leitura do arquivo acompanhado (FlightFeed::poll()).
+ */
+struct IngestBatch {
+    int lines;               ///< Linhas completas processadas (as vazias não contam).
+    int inserted;            ///< Voos inseridos.
+    int errors;              ///< Linhas rejeitadas (formato ou chegada antes da partida).
+    long long bytes;         ///< Bytes consumidos do arquivo.
+    long long pendingBytes;  ///< Bytes já no arquivo e ainda não processados (lote cortado ou linha incompleta).
+    double insertUs;         ///< Tempo de parsing e inserção do lote.
+    double lagMs;            ///< Da última escrita no arquivo até os voos do lote ficarem visíveis às consultas.
+};
+
+/**
+ * @brief Acompanha um arquivo de voos que só cresce (append-only) e insere as linhas novas no armazenamento.
+ *
+ * Cada linha tem o formato da seção de voos da entrada, sem a contagem. O
+ * arquivo é lido a partir do último byte consumido (pread()), e só linhas
+ * completas, terminadas em '\n', são processadas: uma linha ainda sendo
+ * escrita fica no buffer até o próximo poll(). Os voos entram por
+ * PartitionedStore::insertFlight(), nos oito índices, na árvore k-d e nos
+ * bitmaps, como o comando "ins", e recebem os identificadores seguintes.
+ *
+ * O atraso (lagMs) é medido a partir da data de modificação do arquivo vista
+ * no poll(), ou seja, da escrita mais recente do lote; linhas escritas antes
+ * dela esperaram um pouco mais.
+ */
+class FlightFeed {
+public:
+    static const int READ_CHUNK = 1 << 16;  ///< Bytes lidos por chamada a pread().
+
+    /**
+     * @brief Construtor.
+     * @param path Arquivo acompanhado.
+     * @param intervalMs Intervalo mínimo entre verificações do arquivo (due()).
+     * @param maxBatchLines Linhas processadas no máximo por poll(), para não atrasar as consultas.
+     */
+    FlightFeed(const string &path, double intervalMs, int maxBatchLines);
+    ~FlightFeed();
+
+    /**
+     * @brief Abre o arquivo. O conteúdo já existente é lido no primeiro poll().
+     * @return false se o arquivo não pôde ser aberto.
+     */
+    bool open();
+
+    /**
+     * @brief Verifica, no máximo uma vez por intervalo, se há dados novos a processar.
+     */
+    bool due();
+
+    /**
+     * @brief Processa as linhas completas novas (até maxBatchLines) e as insere no armazenamento.
+     * @param store Armazenamento de voos (com os índices já construídos).
+     * @param batch (Saída) Contagens e tempos do lote.
+     * @return true se alguma linha foi processada.
+     */
+    bool poll(PartitionedStore &store, IngestBatch &batch);
+
+    /**
+     * @brief Escreve a linha "INGEST batch=..." de um lote.
+     */
+    void printBatch(FILE* out, const IngestBatch &batch) const;
+
+    /**
+     * @brief Escreve a linha de resumo: lotes, voos, erros e maior atraso.
+     */
+    void printSummary(FILE* out) const;
+
+private:
+    string path;                  ///< Arquivo acompanhado.
+    int fd;                       ///< Descritor do arquivo (-1 se fechado).
+    double intervalMs;            ///< Intervalo mínimo entre verificações.
+    int maxBatchLines;            ///< Linhas por lote.
+    long long readOffset;         ///< Bytes do arquivo já copiados para o buffer.
+    long long fileSize;           ///< Tamanho visto na última verificação.
+    long long fileModifiedNs;     ///< Data de modificação vista na última verificação (ns desde a época).
+    string buffer;                ///< Bytes lidos e ainda não processados (inclui a linha incompleta).
+    int lineNumber;               ///< Linhas do arquivo já processadas (para mensagens).
+    std::chrono::steady_clock::time_point lastCheck;  ///< Última verificação em due().
+    bool checked;                 ///< false até a primeira verificação.
+
+    int batchCount;               ///< Lotes processados.
+    long long insertedTotal;      ///< Voos inseridos no total.
+    long long errorTotal;         ///< Linhas rejeitadas no total.
+    double maxLagMs;              ///< Maior atraso de um lote.
+
+    /**
+     * @brief Atualiza tamanho e data de modificação; trata um arquivo truncado.
+     * @return false se fstat() falhou.
+     */
+    bool refresh();
+
+    /**
+     * @brief Retorna true se o buffer tem uma linha completa ou o arquivo tem bytes não lidos.
+     */
+    bool hasNewData() const;
+
+    FlightFeed(const FlightFeed&);
+    FlightFeed& operator=(const FlightFeed&);
+};
+
+#endif // FLIGHTFEED_HPP
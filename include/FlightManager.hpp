@@ -0,0 +1,456 @@
+#ifndef FLIGHTMANAGER_HPP
+#define FLIGHTMANAGER_HPP
+
+#include "Flight.hpp"
+#include "AVLTree.hpp"
+#include "TimeBucketIndex.hpp"
+#include "KDTree.hpp"
+#include "BitmapIndex.hpp"
+#include "Aggregate.hpp"
+#include "Expression.hpp"
+#include "RWLock.hpp"
+#include <atomic>
+#include <ctime>
+#include <istream>
+#include <string>
+
+using std::string;
+
+/*
+ * Tipos dos índices. Todos usam ThreeWayCompare (comparação expandida inline)
+ * e StoredKey: ler a chave do voo (FlightFieldKey) dispensaria a cópia nos
+ * nós, mas acrescenta dois acessos dependentes à memória (lista e voo) a cada
+ * nó visitado, o que dobrou o tempo de construção dos índices com 1M voos. O
+ * índice de assentos precisa da cópia de qualquer forma, pois as reservas
+ * mudam Flight::seats enquanto o voo está indexado.
+ *
+ * Partida e chegada usam baldes de horários (TimeBucketIndex): com chaves em
+ * segundos, a árvore teria praticamente um nó por voo. Além dos índices de um
+ * campo, uma árvore k-d (KDTree) cobre preço, duração e partida juntos.
+ *
+ * Campos com poucas chaves distintas (até MAX_BITMAP_KEYS na carga) ganham
+ * também um índice de bitmap (BitmapIndex), usado para combinar predicados
+ * com AND, OR e NOT. As árvores AVL desses campos continuam existindo: as
+ * estatísticas do planejador e as agregações pelos nós dependem delas.
+ */
+typedef AVLTree<AirportCode> OriginIndex;       ///< Índice por origem.
+typedef AVLTree<AirportCode> DestinationIndex;  ///< Índice por destino.
+typedef AVLTree<double> PriceIndex;             ///< Índice por preço.
+typedef AVLTree<int> DurationIndex;             ///< Índice por duração.
+typedef AVLTree<int> StopsIndex;                ///< Índice por paradas.
+typedef AVLTree<int> SeatIndex;                 ///< Índice por assentos (chave = assentos na última sincronização).
+typedef TimeBucketIndex DepartureIndex;         ///< Índice por partida.
+typedef TimeBucketIndex ArrivalIndex;           ///< Índice por chegada.
+typedef KDTree RangeBoxIndex;                   ///< Índice por (preço, duração, partida).
+
+/**
+ * @brief Metadados de uma posição do armazenamento de voos.
+ */
+struct FlightSlot {
+    FlightListNode* entries[INDEX_COUNT];  ///< Entrada do voo em cada índice AVL (nullptr em partida e chegada).
+    bool active;                           ///< False se o voo foi removido.
+    int indexedSeats;                      ///< Chave (versão) do voo no índice de assentos.
+    std::atomic<bool> seatIndexPending;    ///< True se o voo está na pilha de reindexação de assentos.
+    int nextPending;                       ///< Próximo identificador na pilha de reindexação.
+};
+
+/**
+ * @brief Lê um voo no formato da entrada e calcula os campos derivados.
+ *
+ * O identificador não é preenchido; ele é atribuído pelo FlightManager. As
+ * datas são guardadas em segundos (milissegundos descartados) e impressas na
+ * forma canônica "YYYY-MM-DDTHH:MM:SS" (veja parseDateTimeChecked()).
+ *
+ * @param in Stream de entrada.
+ * @param flight (Saída) Voo lido.
+ * @return true se todos os campos foram lidos e as datas são válidas; false caso
+ *         contrário. Com uma data inválida, a linha é consumida e o stream continua bom.
+ */
+bool readFlight(std::istream &in, Flight &flight);
+
+/**
+ * @brief Gerenciador de voos: armazena os registros e mantém os oito índices, a árvore k-d e os índices de bitmap.
+ *
+ * Os voos ficam em blocos de tamanho fixo, de modo que os ponteiros guardados
+ * nos índices continuam válidos quando novos voos são inseridos. O identificador
+ * de um voo é a sua posição de inserção e nunca é reutilizado.
+ */
+class FlightManager {
+public:
+    static const int BLOCK_SIZE = 4096;  ///< Voos por bloco do armazenamento.
+    static const int MAX_RANGE_PREDICATES = 8;  ///< Predicados de uma conjunção que aggregateFromIndex() combina.
+    static const int MAX_BITMAP_KEYS = 1024;    ///< Chaves distintas até as quais um campo ganha índice de bitmap.
+
+    OriginIndex* indexOrigin;            ///< Índice por origem.
+    DestinationIndex* indexDestination;  ///< Índice por destino.
+    PriceIndex* indexPrice;              ///< Índice por preço.
+    DurationIndex* indexDuration;        ///< Índice por duração.
+    StopsIndex* indexStops;              ///< Índice por paradas.
+    SeatIndex* indexSeats;               ///< Índice por assentos.
+    DepartureIndex* indexDeparture;      ///< Índice por partida.
+    ArrivalIndex* indexArrival;          ///< Índice por chegada.
+    RangeBoxIndex* indexRangeBox;        ///< Árvore k-d por (preço, duração, partida).
+    BitmapIndex* bitmapIndex[INDEX_COUNT];  ///< Índice de bitmap de cada campo (nullptr se o campo não tem).
+
+    /**
+     * @brief Construtor: cria um armazenamento vazio e sem índices.
+     */
+    FlightManager();
+
+    /**
+     * @brief Destrutor: libera os índices e os blocos de voos.
+     */
+    ~FlightManager();
+
+    /**
+     * @brief Adiciona um voo ao armazenamento sem indexá-lo.
+     *
+     * Usado na carga inicial, antes de buildIndices().
+     *
+     * @param flight Dados do voo.
+     * @return Identificador atribuído ao voo.
+     */
+    int addFlight(const Flight &flight);
+
+    /**
+     * @brief Constrói os índices (árvores AVL) para os voos armazenados.
+     */
+    void buildIndices();
+
+    /**
+     * @brief Insere um voo e o indexa em todos os índices.
+     * @param flight Dados do voo.
+     * @return Identificador atribuído ao voo.
+     */
+    int insertFlight(const Flight &flight);
+
+    /**
+     * @brief Remove um voo do armazenamento e de todos os índices.
+     * @param id Identificador do voo.
+     * @return true se o voo existia; false caso contrário.
+     */
+    bool removeFlight(int id);
+
+    /**
+     * @brief Atualiza os dados de um voo, reindexando apenas os campos alterados.
+     * @param id Identificador do voo.
+     * @param flight Novos dados do voo (o identificador é ignorado).
+     * @return true se o voo existia; false caso contrário.
+     */
+    bool updateFlight(int id, const Flight &flight);
+
+    /**
+     * @brief Reserva assentos de um voo.
+     *
+     * A reserva é uma operação compare-and-swap sobre Flight::seats, sem travas;
+     * várias threads podem reservar (inclusive no mesmo voo) e consultar ao mesmo
+     * tempo. A entrada do voo em indexSeats não é movida aqui: o voo entra em uma
+     * pilha sem travas e é reindexado por syncSeatIndex().
+     *
+     * @param id Identificador do voo.
+     * @param seatCount Número de assentos a reservar (maior que zero).
+     * @return true se havia assentos suficientes; false caso contrário.
+     */
+    bool reserveSeats(int id, int seatCount);
+
+    /**
+     * @brief Move no índice de assentos os voos com reservas pendentes.
+     *
+     * Chamada automaticamente pelas consultas que dependem de chaves atualizadas.
+     */
+    void syncSeatIndex();
+
+    /**
+     * @brief Retorna o voo com o identificador fornecido.
+     * @param id Identificador do voo.
+     * @return Ponteiro para o voo ou nullptr se não existir ou tiver sido removido.
+     */
+    Flight* getFlight(int id);
+
+    /**
+     * @brief Retorna o número de identificadores já atribuídos (inclui removidos).
+     */
+    int getSlotCount() const { return slotCount; }
+
+    /**
+     * @brief Retorna o número de voos ativos.
+     */
+    int getFlightCount() const { return activeCount; }
+
+    /**
+     * @brief Acrescenta ao relatório a memória do armazenamento e de cada índice.
+     *
+     * Entradas: "flights" e "flight_slots" (blocos de BLOCK_SIZE), "flight_blocks"
+     * (arrays de blocos), "avl.<campo>.nodes" e "avl.<campo>.lists",
+     * "buckets.dep" e "buckets.arr", "kdtree", "bitmap.<campo>" e "bitmap.active".
+     * Índices ainda não construídos não aparecem.
+     */
+    void reportMemory(MemoryReport &report) const;
+
+    /**
+     * @brief Retorna o número de inserções, remoções e atualizações de voos já feitas.
+     *
+     * Estruturas montadas a partir dos voos (ItinerarySearch) comparam a versão
+     * para saber se precisam ser remontadas. Reservas não mudam a versão.
+     */
+    int getVersion() const { return version; }
+
+    /**
+     * @brief Retorna candidatos usando o índice, conforme o predicado.
+     *
+     * Para "sea", as chaves do índice podem estar atrasadas em relação às
+     * reservas (nunca abaixo do valor atual, já que reservas só diminuem os
+     * assentos). Predicados GT/GE recebem, portanto, um superconjunto correto;
+     * EQ/LT/LE sincronizam o índice antes da busca.
+     *
+     * @param predicate Predicado indexável.
+     * @param candidateCount (Saída) Número de candidatos encontrados.
+     * @return Array dinamicamente alocado de ponteiros para Flight (deve ser liberado pelo chamador).
+     */
+    Flight** getCandidatesFromIndex(PredicateExpr* predicate, int &candidateCount);
+
+    /**
+     * @brief Percorre o intervalo do índice avaliando a expressão em cada voo.
+     *
+     * Equivale a getCandidatesFromIndex() seguido do filtro, mas os voos são
+     * avaliados durante o percurso (AVLRangeCursor), sem o array de candidatos.
+     * A ordem dos voos é a mesma do índice.
+     *
+     * @param predicate Predicado indexável.
+     * @param filter Expressão avaliada em cada candidato (nullptr = aceita todos).
+     * @param candidateCount (Saída) Número de candidatos percorridos no índice.
+     * @param matchCount (Saída) Número de voos que satisfazem o filtro.
+     * @return Array dinamicamente alocado com os voos aceitos (deve ser liberado pelo chamador).
+     */
+    Flight** findMatchesFromIndex(PredicateExpr* predicate, const Expr* filter,
+                                  int &candidateCount, int &matchCount);
+
+    /**
+     * @brief Percorre o intervalo do índice acumulando os voos que satisfazem a expressão.
+     *
+     * Mesmo percurso de findMatchesFromIndex(), mas os voos vão direto para o
+     * agregado, sem array de resultados.
+     *
+     * @param predicate Predicado indexável.
+     * @param filter Expressão avaliada em cada candidato (nullptr = aceita todos).
+     * @param result (Entrada/Saída) Agregado que recebe os voos aceitos.
+     * @param candidateCount (Saída) Número de candidatos percorridos no índice.
+     */
+    void accumulateMatchesFromIndex(PredicateExpr* predicate, const Expr* filter,
+                                    AggregateResult &result, int &candidateCount);
+
+    /**
+     * @brief Percorre os voos de uma caixa da árvore k-d avaliando a expressão em cada voo.
+     *
+     * Equivale a findMatchesFromIndex(), com a árvore k-d como caminho de
+     * acesso: os voos vêm na ordem dos pontos da árvore.
+     *
+     * @param box Caixa de preço, duração e partida (veja conjunctionBox()).
+     * @param filter Expressão avaliada em cada candidato (nullptr = aceita todos).
+     * @param candidateCount (Saída) Número de voos encontrados na caixa.
+     * @param matchCount (Saída) Número de voos que satisfazem o filtro.
+     * @return Array dinamicamente alocado com os voos aceitos (deve ser liberado pelo chamador).
+     */
+    Flight** findMatchesFromBox(const KDBox &box, const Expr* filter, int &candidateCount, int &matchCount);
+
+    /**
+     * @brief Percorre os voos de uma caixa da árvore k-d acumulando os que satisfazem a expressão.
+     * @param box Caixa de preço, duração e partida.
+     * @param filter Expressão avaliada em cada candidato (nullptr = aceita todos).
+     * @param result (Entrada/Saída) Agregado que recebe os voos aceitos.
+     * @param candidateCount (Saída) Número de voos encontrados na caixa.
+     */
+    void accumulateMatchesFromBox(const KDBox &box, const Expr* filter, AggregateResult &result, int &candidateCount);
+
+    /**
+     * @brief Verifica se um predicado pode ser respondido por um índice de bitmap.
+     */
+    bool hasBitmapIndex(const PredicateExpr* predicate) const {
+        return predicate->field < INDEX_COUNT && bitmapIndex[predicate->field] != nullptr;
+    }
+
+    /**
+     * @brief Percorre os voos do bitmap da conjunção principal avaliando a expressão em cada voo.
+     *
+     * Os operandos do AND no topo da expressão (ou a expressão inteira) que
+     * só envolvem campos com índice de bitmap, combinados por AND, OR e NOT,
+     * viram operações de conjunto sobre os bitmaps (veja candidateBitmap()).
+     * Os voos vêm em ordem de identificador. Se o bitmap responde à expressão
+     * inteira, ela não é avaliada nos voos.
+     *
+     * @param expression Expressão da consulta.
+     * @param candidateCount (Saída) Número de voos no bitmap.
+     * @param matchCount (Saída) Número de voos que satisfazem a expressão.
+     * @return Array dinamicamente alocado com os voos aceitos (deve ser liberado pelo chamador).
+     */
+    Flight** findMatchesFromBitmap(const Expr* expression, int &candidateCount, int &matchCount);
+
+    /**
+     * @brief Percorre os voos do bitmap da conjunção principal acumulando os que satisfazem a expressão.
+     *
+     * Uma contagem respondida inteiramente pelo bitmap é a sua cardinalidade,
+     * sem visitar os voos.
+     *
+     * @param expression Expressão da consulta.
+     * @param result (Entrada/Saída) Agregado que recebe os voos aceitos.
+     * @param candidateCount (Saída) Número de voos no bitmap.
+     */
+    void accumulateMatchesFromBitmap(const Expr* expression, AggregateResult &result, int &candidateCount);
+
+    /**
+     * @brief Responde a uma agregação só com as contagens e somas dos nós de um índice.
+     *
+     * Aplica-se quando a expressão é vazia (nullptr), um único predicado ou um
+     * AND de até MAX_RANGE_PREDICATES predicados, todos sobre o mesmo campo e
+     * sem NE: os limites são combinados em um intervalo do índice desse campo.
+     * A contagem vem de AVLTree::countRange(); soma e média, de
+     * AVLTree::sumRange(), e os extremos, de AVLTree::selectEntry(), o que
+     * exige que o campo agregado seja o próprio campo do índice. Custo O(log n).
+     *
+     * @param expression Expressão da consulta (nullptr = todos os voos).
+     * @param result (Saída) Agregado; result.fromIndex fica true se a consulta foi respondida.
+     * @return true se a consulta foi respondida; false se ela precisa percorrer os voos.
+     */
+    bool aggregateFromIndex(Expr* expression, AggregateResult &result);
+
+    /**
+     * @brief Estima quantos candidatos getCandidatesFromIndex() retornaria.
+     *
+     * A contagem é exata (AVLTree::countRange, pelos tamanhos das subárvores),
+     * sem percorrer o intervalo; para NE, retorna os voos com chave diferente.
+     * No índice de assentos as chaves podem estar atrasadas em relação às
+     * reservas. Custo O(log n).
+     *
+     * @param predicate Predicado indexável.
+     * @return Número estimado de candidatos.
+     */
+    double estimateCandidates(const PredicateExpr* predicate);
+
+    /**
+     * @brief Estima quantos voos estão em uma caixa da árvore k-d.
+     *
+     * A fração de cada dimensão vem da contagem exata do índice do campo
+     * (countRange); as dimensões são tratadas como independentes, então a
+     * estimativa é o produto das frações pelo número de voos. Custo O(log n).
+     *
+     * @param box Caixa de preço, duração e partida.
+     * @return Número estimado de voos na caixa.
+     */
+    double estimateBox(const KDBox &box);
+
+private:
+    Flight** flightBlocks;     ///< Blocos de voos.
+    FlightSlot** slotBlocks;   ///< Blocos de metadados, paralelos a flightBlocks.
+    int blockCount;            ///< Número de blocos alocados.
+    int blockCapacity;         ///< Capacidade do array de blocos.
+    int slotCount;             ///< Identificadores atribuídos.
+    int activeCount;           ///< Voos ativos.
+    int version;               ///< Alterações de voos (veja getVersion()).
+    std::atomic<int> pendingSeatHead;  ///< Topo da pilha de reindexação de assentos (-1 se vazia).
+    RWLock seatIndexLock;      ///< Protege indexSeats (e o seu bitmap) entre consultas e syncSeatIndex().
+    RoaringBitmap activeIds;   ///< Identificadores dos voos ativos (universo do NOT nos bitmaps).
+
+    /**
+     * @brief Retorna os metadados da posição de um voo.
+     */
+    FlightSlot& slotAt(int id) { return slotBlocks[id / BLOCK_SIZE][id % BLOCK_SIZE]; }
+
+    /**
+     * @brief Retorna o voo armazenado em uma posição.
+     */
+    Flight& flightAt(int id) { return flightBlocks[id / BLOCK_SIZE][id % BLOCK_SIZE]; }
+
+    /**
+     * @brief Insere o voo de uma posição em um índice.
+     */
+    void indexField(int field, Flight &flight, FlightSlot &slot);
+
+    /**
+     * @brief Remove o voo de uma posição de um índice.
+     */
+    void unindexField(int field, Flight &flight, FlightSlot &slot);
+
+    /**
+     * @brief Descarta os índices de bitmap cujo número de chaves passou de 2 * MAX_BITMAP_KEYS.
+     */
+    void dropCrowdedBitmaps();
+
+    /**
+     * @brief Calcula o bitmap exato de uma subexpressão só com campos de índice de bitmap.
+     * @return Bitmap dinamicamente alocado, ou nullptr se a subexpressão usa outros campos.
+     */
+    RoaringBitmap* bitmapOf(const Expr* expr);
+
+    /**
+     * @brief Calcula a interseção dos bitmaps dos operandos da conjunção principal que têm bitmap.
+     *
+     * Sincroniza o índice de assentos antes, como as buscas por EQ/LT/LE.
+     *
+     * @param expression Expressão da consulta.
+     * @param complete (Saída) True se o bitmap é exatamente o conjunto de voos que satisfazem a expressão.
+     * @return Bitmap dinamicamente alocado, ou nullptr se nenhum operando tem bitmap.
+     */
+    RoaringBitmap* candidateBitmap(const Expr* expression, bool &complete);
+
+    /**
+     * @brief Percorre o intervalo do índice do predicado, entregando a sink os voos que satisfazem o filtro.
+     *
+     * Sink precisa de um método add(Flight*). Base de findMatchesFromIndex() e
+     * de accumulateMatchesFromIndex().
+     */
+    template<typename Sink>
+    void walkIndex(PredicateExpr* predicate, const Expr* filter, Sink &sink, int &candidateCount);
+
+    /**
+     * @brief Percorre a caixa da árvore k-d, entregando a sink os voos que satisfazem o filtro.
+     */
+    template<typename Sink>
+    void walkBox(const KDBox &box, const Expr* filter, Sink &sink, int &candidateCount);
+
+    /**
+     * @brief Percorre os voos de um bitmap, entregando a sink os que satisfazem o filtro.
+     */
+    template<typename Sink>
+    void walkBitmap(const RoaringBitmap &bitmap, const Expr* filter, Sink &sink, int &candidateCount);
+
+    FlightManager(const FlightManager&);
+    FlightManager& operator=(const FlightManager&);
+};
+
+/**
+ * @brief Procura recursivamente um predicado indexável na árvore de expressão.
+ *
+ * Apenas predicados com operador diferente de NE e em campos indexáveis são considerados.
+ *
+ * @param expr Ponteiro para a expressão.
+ * @return Ponteiro para o PredicateExpr indexável, ou nullptr se não houver.
+ */
+PredicateExpr* findIndexablePredicate(Expr* expr);
+
+/**
+ * @brief Calcula a chave de um voo no índice de bitmap de um campo.
+ *
+ * Aeroportos usam o código; paradas e assentos, o próprio número (assentos
+ * pela chave da última sincronização, FlightSlot::indexedSeats).
+ */
+long long bitmapKey(int field, const Flight &flight, const FlightSlot &slot);
+
+/**
+ * @brief Calcula a chave com que um predicado é comparado no índice de bitmap do seu campo.
+ */
+long long bitmapKey(const PredicateExpr* predicate);
+
+/**
+ * @brief Monta a caixa de preço, duração e partida dos predicados da conjunção principal.
+ *
+ * Considera o predicado único ou os operandos de um AND no topo da expressão,
+ * sem NE. Limites estritos viram fechados: em duração e partida (inteiros),
+ * somando ou subtraindo 1; no preço, pelo double vizinho (std::nextafter).
+ *
+ * @param expr Ponteiro para a expressão.
+ * @param box (Saída) Caixa; dimensões sem predicado ficam sem limites.
+ * @return Número de dimensões restringidas (0 a KDBox::DIMENSIONS).
+ */
+int conjunctionBox(const Expr* expr, KDBox &box);
+
+#endif // FLIGHTMANAGER_HPP
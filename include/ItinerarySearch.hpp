@@ -0,0 +1,174 @@
+#ifndef ITINERARYSEARCH_HPP
+#define ITINERARYSEARCH_HPP
+
+#include "Flight.hpp"
+#include "Expression.hpp"
+#include "FlightManager.hpp"
+#include "PartitionedStore.hpp"
+#include <string>
+
+using std::string;
+
+/**
+ * @brief Itinerário de um a MAX_LEGS voos, com os totais usados na ordenação.
+ *
+ * total é um Flight sintético (origem e partida do primeiro trecho, destino e
+ * chegada do último, soma dos preços, duração da partida à chegada e paradas
+ * mais conexões), de modo que os itinerários são comparados com os mesmos
+ * critérios das consultas (compareFlightByCriteria).
+ */
+struct Itinerary {
+    static const int MAX_LEGS = 3;  ///< Trechos de um itinerário com duas conexões.
+
+    Flight* legs[MAX_LEGS];  ///< Voos, na ordem da viagem.
+    int legIds[MAX_LEGS];    ///< Identificador global de cada trecho (desempate).
+    int legCount;            ///< Número de trechos.
+    Flight total;            ///< Totais do itinerário.
+};
+
+/**
+ * @brief Parâmetros de uma busca de itinerários.
+ */
+struct ItineraryQuery {
+    AirportCode origin;       ///< Aeroporto de partida.
+    AirportCode destination;  ///< Aeroporto de chegada.
+    int maxConnections;       ///< Conexões permitidas (0 a Itinerary::MAX_LEGS - 1).
+    int minLayover;           ///< Espera mínima em cada conexão, em segundos.
+    int maxLayover;           ///< Espera máxima em cada conexão, em segundos.
+    const Expr* filter;       ///< Filtro do primeiro trecho (nullptr = todos os voos da origem).
+    string sortCriteria;      ///< Critérios de ordenação ('p', 'd', 's').
+    int maxResults;           ///< Itinerários pedidos.
+};
+
+/**
+ * @brief Busca de itinerários com conexões sobre os voos de um FlightManager.
+ *
+ * A busca usa duas listas de adjacência montadas a partir dos voos ativos,
+ * ambas em arrays contíguos ordenados pelo horário de partida: os voos de cada
+ * aeroporto e os voos de cada rota (origem, destino). Uma conexão em um
+ * aeroporto é a faixa de partidas [chegada + espera mínima, chegada + espera
+ * máxima], localizada por busca binária: o último trecho vem da rota até o
+ * destino e o trecho intermediário (duas conexões), dos voos do aeroporto.
+ *
+ * Os melhores itinerários ficam em um heap limitado a maxResults. Cada trecho
+ * inicial ou intermediário recebe um limite inferior dos totais (preço,
+ * duração e paradas mínimos de uma rota até o destino, calculados por rota na
+ * montagem); os trechos iniciais são visitados em ordem crescente desse
+ * limite e a busca para assim que o limite fica pior que o último itinerário
+ * do heap. Predicados de partida na conjunção principal do filtro restringem
+ * os trechos iniciais a uma faixa da lista da origem. Itinerários não repetem
+ * aeroportos.
+ *
+ * As listas são remontadas na primeira busca depois de uma inserção, remoção
+ * ou atualização de voo (FlightManager::getVersion()); reservas não as afetam.
+ * Com um armazenamento particionado (PartitionedStore), as listas juntam os
+ * voos de todas as partições, pois as conexões cruzam partições. Desempates
+ * (na montagem das listas e entre itinerários) usam o identificador global
+ * dos voos, não Flight::id, que é local à partição; assim o resultado não
+ * depende do número de partições.
+ */
+class ItinerarySearch {
+public:
+    /**
+     * @brief Construtor: as listas são montadas na primeira busca.
+     * @param flightManager Gerenciador com os voos.
+     */
+    explicit ItinerarySearch(FlightManager &flightManager);
+
+    /**
+     * @brief Construtor sobre um armazenamento particionado: as listas juntam os voos de todas as partições.
+     * @param store Armazenamento (deve continuar válido; as partições não mudam).
+     */
+    explicit ItinerarySearch(const PartitionedStore &store);
+
+    /**
+     * @brief Destrutor: libera as listas de adjacência.
+     */
+    ~ItinerarySearch();
+
+    /**
+     * @brief Busca os melhores itinerários entre dois aeroportos.
+     * @param query Parâmetros da busca.
+     * @param resultCount (Saída) Número de itinerários encontrados (no máximo query.maxResults).
+     * @param examinedCount (Saída, opcional) Trechos examinados.
+     * @return Array dinamicamente alocado com os itinerários, do melhor para o pior (deve ser liberado pelo chamador).
+     */
+    Itinerary* search(const ItineraryQuery &query, int &resultCount, int* examinedCount = nullptr);
+
+private:
+    /**
+     * @brief Rota (par origem, destino) com os seus voos e os mínimos usados nos limites inferiores.
+     */
+    struct Route {
+        int origin;          ///< Aeroporto de origem (posição em airports).
+        int destination;     ///< Aeroporto de destino (posição em airports).
+        int start;           ///< Primeiro voo da rota em routeFlights.
+        int end;             ///< Fim (exclusive) dos voos da rota em routeFlights.
+        double minPrice;     ///< Menor preço da rota.
+        int minDuration;     ///< Menor duração da rota.
+        int minStops;        ///< Menor número de paradas da rota.
+    };
+
+    FlightManager* singleManager;           ///< Gerenciador do construtor com um só gerenciador.
+    FlightManager* const* flightManagers;   ///< Gerenciadores com os voos.
+    int managerCount;                       ///< Número de gerenciadores.
+    const PartitionedStore* store;          ///< Armazenamento particionado (nullptr = ids locais já são globais).
+    int builtVersion;              ///< Soma das versões dos voos usada na montagem (-1 = não montadas).
+    AirportCode* airports;         ///< Aeroportos de origem ou destino, ordenados.
+    int airportCount;              ///< Número de aeroportos.
+    Flight** originFlights;        ///< Voos agrupados por origem, cada grupo ordenado pela partida.
+    int* originIds;                ///< Identificador global de cada voo de originFlights.
+    int* originStart;              ///< Início do grupo de cada aeroporto em originFlights (airportCount + 1 posições).
+    Flight** routeFlights;         ///< Voos agrupados por rota, cada grupo ordenado pela partida.
+    int* routeIds;                 ///< Identificador global de cada voo de routeFlights.
+    Route* routes;                 ///< Rotas, ordenadas por origem e destino.
+    int routeCount;                ///< Número de rotas.
+    int* routeStart;               ///< Primeira rota de cada aeroporto em routes (airportCount + 1 posições).
+
+    /**
+     * @brief Remonta as listas de adjacência se os voos mudaram desde a última montagem.
+     */
+    void refresh();
+
+    /**
+     * @brief Libera as listas de adjacência.
+     */
+    void clear();
+
+    /**
+     * @brief Retorna a posição de um aeroporto em airports, ou -1 se ele não tem voos.
+     */
+    int findAirport(AirportCode code) const;
+
+    /**
+     * @brief Retorna a rota entre dois aeroportos (posições em airports), ou nullptr se não há voos.
+     */
+    const Route* findRoute(int origin, int destination) const;
+
+    struct SearchState;  ///< Estado de uma busca (heap e mínimos até o destino), definido no .cpp.
+
+    /**
+     * @brief Oferece um itinerário completo ao heap dos melhores.
+     */
+    void offer(SearchState &state, const Itinerary &itinerary) const;
+
+    /**
+     * @brief Verifica se um limite inferior dos totais já é pior que o último itinerário do heap (heap cheio).
+     */
+    bool pruned(const SearchState &state, const Flight &bound) const;
+
+    /**
+     * @brief Completa o itinerário com um voo da rota hub -> destino que respeite a espera na conexão.
+     */
+    void finishFrom(SearchState &state, Itinerary &prefix, int hub) const;
+
+    /**
+     * @brief Acrescenta um trecho intermediário saindo de hub e completa cada itinerário até o destino.
+     */
+    void connectFrom(SearchState &state, Itinerary &prefix, int hub) const;
+
+    ItinerarySearch(const ItinerarySearch&);
+    ItinerarySearch& operator=(const ItinerarySearch&);
+};
+
+#endif // ITINERARYSEARCH_HPP
@@ -0,0 +1,218 @@
+#ifndef KDTREE_HPP
+#define KDTREE_HPP
+
+#include "Flight.hpp"
+#include "MemoryReport.hpp"
+
+/**
+ * @brief Caixa fechada sobre (preço, duração, partida): low[d] <= coordenada <= high[d].
+ *
+ * Limites estritos são convertidos em fechados por quem monta a caixa (veja
+ * conjunctionBox()). Uma dimensão sem restrição vai de -HUGE_VAL a HUGE_VAL.
+ */
+struct KDBox {
+    static const int DIMENSIONS = 3;  ///< Preço, duração e partida.
+
+    double low[DIMENSIONS];   ///< Menor coordenada aceita em cada dimensão.
+    double high[DIMENSIONS];  ///< Maior coordenada aceita em cada dimensão.
+
+    /**
+     * @brief Construtor: caixa sem limites.
+     */
+    KDBox();
+
+    /**
+     * @brief Verifica se um ponto está na caixa.
+     */
+    bool contains(const double* coords) const {
+        for (int d = 0; d < DIMENSIONS; d++)
+            if (coords[d] < low[d] || coords[d] > high[d])
+                return false;
+        return true;
+    }
+
+    /**
+     * @brief Verifica se a caixa não tem pontos (algum limite inferior acima do superior).
+     */
+    bool isEmpty() const {
+        for (int d = 0; d < DIMENSIONS; d++)
+            if (low[d] > high[d])
+                return true;
+        return false;
+    }
+};
+
+/**
+ * @brief Ponto de uma KDTree: coordenadas copiadas do voo.
+ */
+struct KDPoint {
+    double coords[KDBox::DIMENSIONS];  ///< Preço, duração e partida.
+    Flight* flight;                    ///< Voo (nullptr se o voo foi removido).
+};
+
+/**
+ * @brief Nó de uma KDTree: faixa de pontos e a caixa mínima que os contém.
+ */
+struct KDNode {
+    double low[KDBox::DIMENSIONS];   ///< Menores coordenadas dos pontos do nó.
+    double high[KDBox::DIMENSIONS];  ///< Maiores coordenadas dos pontos do nó.
+    int start;                       ///< Primeiro ponto do nó.
+    int end;                         ///< Fim (exclusive) dos pontos do nó.
+    int left;                        ///< Filho esquerdo (-1 em folhas).
+    int right;                       ///< Filho direito (-1 em folhas).
+};
+
+/**
+ * @brief Árvore k-d sobre (preço, duração, partida), para conjunções de intervalos nesses campos.
+ *
+ * Os pontos ficam em um único array: cada nó é uma faixa contígua, dividida
+ * na mediana da dimensão de maior extensão até folhas de no máximo LEAF_SIZE
+ * pontos. Cada nó guarda a caixa mínima dos seus pontos, então uma busca
+ * descarta os nós disjuntos da caixa pedida e entrega inteiros, sem comparar
+ * coordenadas, os nós contidos nela.
+ *
+ * A árvore é estática entre reconstruções. Inserções vão para um trecho de
+ * transbordo no fim do array, percorrido linearmente em cada busca; remoções
+ * apenas marcam o ponto. A árvore é reconstruída quando o transbordo passa de
+ * 1/16 dos pontos da árvore ou os removidos passam de 1/4 dos ativos, o que
+ * mantém o custo amortizado de uma atualização em O(log n).
+ */
+class KDTree {
+public:
+    static const int LEAF_SIZE = 32;  ///< Máximo de pontos por folha.
+
+    /**
+     * @brief Construtor: árvore vazia.
+     */
+    KDTree();
+
+    /**
+     * @brief Destrutor: libera os pontos e os nós.
+     */
+    ~KDTree();
+
+    /**
+     * @brief Carrega a árvore de uma vez (a árvore precisa estar vazia).
+     * @param flights Voos a indexar.
+     * @param count Número de voos.
+     */
+    void build(Flight** flights, int count);
+
+    /**
+     * @brief Insere um voo no trecho de transbordo (pode reconstruir a árvore).
+     * @param flight Ponteiro para o voo.
+     */
+    void insert(Flight* flight);
+
+    /**
+     * @brief Remove o ponto de um voo.
+     * @param flight Ponteiro para o voo.
+     * @return true se o voo estava na árvore; false caso contrário.
+     */
+    bool remove(const Flight* flight);
+
+    /**
+     * @brief Retorna o número de voos na árvore.
+     */
+    int size() const { return liveCount; }
+
+    /**
+     * @brief Acrescenta a memória da árvore ao relatório (pontos, nós e posições).
+     */
+    void reportMemory(MemoryReport &report, const string &name) const;
+
+    /**
+     * @brief Entrega a sink os voos cujos pontos estão na caixa.
+     *
+     * Sink precisa de um método add(Flight*). A ordem dos voos é a do array
+     * de pontos, não a de alguma chave.
+     *
+     * @param box Caixa da busca.
+     * @param sink Destino dos voos.
+     */
+    template<typename Sink>
+    void search(const KDBox &box, Sink &sink) const;
+
+    /**
+     * @brief Calcula as coordenadas (preço, duração, partida) de um voo.
+     */
+    static void coordinatesOf(const Flight &flight, double* coords);
+
+private:
+    KDPoint* points;       ///< Pontos: árvore em [0, treeSize), transbordo em [treeSize, pointCount).
+    int treeSize;          ///< Pontos cobertos pelos nós.
+    int pointCount;        ///< Pontos em uso (inclui removidos).
+    int pointCapacity;     ///< Capacidade de points.
+    KDNode* nodes;         ///< Nós; a raiz é o nó 0.
+    int nodeCount;         ///< Nós em uso.
+    int nodeCapacity;      ///< Capacidade de nodes.
+    int* positions;        ///< Posição em points do ponto de cada voo, pelo identificador (-1 = ausente).
+    int positionCapacity;  ///< Capacidade de positions.
+    int liveCount;         ///< Pontos de voos ativos.
+    int removedCount;      ///< Pontos marcados como removidos.
+
+    /**
+     * @brief Divide recursivamente points[start, end) e retorna o nó criado.
+     */
+    int buildNode(int start, int end);
+
+    /**
+     * @brief Reconstrói a árvore com os pontos ativos (árvore e transbordo).
+     */
+    void rebuild();
+
+    /**
+     * @brief Registra a posição do ponto de um voo, ampliando positions se preciso.
+     */
+    void setPosition(int id, int position);
+
+    KDTree(const KDTree&);
+    KDTree& operator=(const KDTree&);
+};
+
+/**
+ * @brief Entrega a sink os voos cujos pontos estão na caixa.
+ *
+ * A descida usa uma pilha explícita; a profundidade é O(log n), pois as
+ * divisões são na mediana.
+ */
+template<typename Sink>
+void KDTree::search(const KDBox &box, Sink &sink) const {
+    const int D = KDBox::DIMENSIONS;
+    if (box.isEmpty())
+        return;
+    int stack[64];
+    int top = 0;
+    if (nodeCount > 0)
+        stack[top++] = 0;
+    while (top > 0) {
+        const KDNode &node = nodes[stack[--top]];
+        bool inside = true;
+        bool disjoint = false;
+        for (int d = 0; d < D; d++) {
+            if (node.high[d] < box.low[d] || node.low[d] > box.high[d])
+                disjoint = true;
+            if (node.low[d] < box.low[d] || node.high[d] > box.high[d])
+                inside = false;
+        }
+        if (disjoint)
+            continue;
+        if (inside) {
+            for (int i = node.start; i < node.end; i++)
+                if (points[i].flight)
+                    sink.add(points[i].flight);
+        } else if (node.left < 0) {
+            for (int i = node.start; i < node.end; i++)
+                if (points[i].flight && box.contains(points[i].coords))
+                    sink.add(points[i].flight);
+        } else {
+            stack[top++] = node.right;
+            stack[top++] = node.left;
+        }
+    }
+    for (int i = treeSize; i < pointCount; i++)
+        if (points[i].flight && box.contains(points[i].coords))
+            sink.add(points[i].flight);
+}
+
+#endif // KDTREE_HPP
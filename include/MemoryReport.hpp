@@ -0,0 +1,174 @@
+#ifndef MEMORYREPORT_HPP
+#define MEMORYREPORT_HPP
+
+#include <cstdio>
+#include <string>
+
+using std::string;
+
+/**
+ * @brief Memória de uma estrutura (ou de uma parte dela) no relatório.
+ */
+struct MemoryEntry {
+    string name;          ///< Nome da estrutura (ex.: "avl.prc.nodes").
+    long long objects;    ///< Objetos em uso (voos, nós, entradas...).
+    long long bytes;      ///< Bytes pedidos ao alocador (capacidade reservada, não só a usada).
+    long long heapBytes;  ///< Estimativa do heap ocupado, com o cabeçalho e o arredondamento de cada bloco.
+};
+
+/**
+ * @brief Contabilidade de memória por estrutura, calculada a partir das capacidades.
+ *
+ * Cada estrutura descreve os próprios blocos (reportMemory()): um array conta
+ * como um bloco de capacidade × tamanho do elemento; nós alocados um a um
+ * (árvores AVL, listas de voos) contam um bloco por nó, que é onde o
+ * cabeçalho do alocador mais pesa. Entradas com o mesmo nome são somadas, o
+ * que junta as partições de um PartitionedStore.
+ *
+ * Não depende de ENABLE_METRICS: os números vêm dos contadores das estruturas,
+ * não de ganchos no alocador.
+ */
+class MemoryReport {
+public:
+    static const int MAX_ENTRIES = 64;  ///< Número máximo de entradas distintas.
+
+    MemoryReport() : entryCount(0) {}
+
+    /**
+     * @brief Estima o tamanho de um bloco no heap (glibc, 64 bits).
+     *
+     * O bloco ocupa o pedido mais 8 bytes de cabeçalho, arredondado para
+     * múltiplos de 16, com no mínimo 32 bytes.
+     */
+    static long long chunkBytes(long long size) {
+        long long chunk = (size + 8 + 15) & ~15LL;
+        return chunk < 32 ? 32 : chunk;
+    }
+
+    /**
+     * @brief Soma objetos e bytes a uma entrada (criada se o nome é novo).
+     */
+    void add(const string &name, long long objects, long long bytes, long long heapBytes);
+
+    /**
+     * @brief Soma um array alocado em um bloco só.
+     * @param name Nome da entrada.
+     * @param objects Elementos em uso.
+     * @param capacity Elementos reservados.
+     * @param elementSize Tamanho de um elemento.
+     */
+    void addArray(const string &name, long long objects, long long capacity, long long elementSize) {
+        long long bytes = capacity * elementSize;
+        add(name, objects, bytes, capacity > 0 ? chunkBytes(bytes) : 0);
+    }
+
+    /**
+     * @brief Soma objetos alocados um a um (um bloco por objeto).
+     */
+    void addNodes(const string &name, long long count, long long nodeSize) {
+        add(name, count, count * nodeSize, count * chunkBytes(nodeSize));
+    }
+
+    int getEntryCount() const { return entryCount; }
+    const MemoryEntry& getEntry(int i) const { return entries[i]; }
+
+    /**
+     * @brief Soma dos bytes pedidos de todas as entradas.
+     */
+    long long totalBytes() const;
+
+    /**
+     * @brief Soma das estimativas de heap de todas as entradas.
+     */
+    long long totalHeapBytes() const;
+
+    /**
+     * @brief Escreve uma linha "MEMORY structure=..." por entrada e uma linha com o total.
+     *
+     * share é a fração de heap_bytes no total. Em builds com métricas, o total
+     * traz também os bytes vivos do processo medidos pelo operator new
+     * (process_heap_bytes), o que mostra o que as estruturas não cobrem.
+     */
+    void print(FILE* out) const;
+
+private:
+    MemoryEntry entries[MAX_ENTRIES];  ///< Entradas, na ordem da primeira inclusão.
+    int entryCount;                    ///< Entradas em uso.
+};
+
+/**
+ * @brief Memória das consultas: resultado e pico de heap de cada uma.
+ *
+ * Os bytes do resultado (ponteiros para voos) são sempre contados. O pico é
+ * medido pelo operator new de Metrics.cpp e só existe em builds com
+ * ENABLE_METRICS; ele inclui tudo o que a consulta aloca (candidatos, bitmaps,
+ * ordenação, resultado), descontados os bytes vivos no início da consulta.
+ */
+class QueryMemoryTracker {
+public:
+    /**
+     * @brief Construtor.
+     * @param out Destino das linhas "MEMORY query=...".
+     */
+    explicit QueryMemoryTracker(FILE* out);
+
+    /**
+     * @brief Marca o início de uma consulta: zera o pico e guarda os bytes vivos.
+     */
+    void beginQuery();
+
+    /**
+     * @brief Registra o resultado de uma consulta.
+     * @param resultCount Voos (ou itinerários) no resultado.
+     * @param bytes Bytes do array de resultado.
+     */
+    void addResult(int resultCount, long long bytes);
+
+    /**
+     * @brief Fecha a consulta e escreve a sua linha.
+     * @param lineNumber Número do comando na entrada.
+     */
+    void endQuery(int lineNumber);
+
+    /**
+     * @brief Escreve a linha de resumo: consultas, maiores resultados e maior pico.
+     */
+    void printSummary();
+
+private:
+    FILE* out;                    ///< Destino das linhas.
+    bool active;                  ///< true entre beginQuery() e endQuery().
+    long long liveAtStart;        ///< Bytes vivos no início da consulta (-1 sem métricas).
+    int resultCount;              ///< Resultados da consulta atual.
+    long long resultBytes;        ///< Bytes do resultado da consulta atual.
+    int queryCount;               ///< Consultas registradas.
+    long long maxResultBytes;     ///< Maior resultado em bytes.
+    int maxResultQuery;           ///< Comando com o maior resultado.
+    long long maxPeakBytes;       ///< Maior pico de heap.
+    int maxPeakQuery;             ///< Comando com o maior pico.
+};
+
+/**
+ * @brief Delimita uma consulta no QueryMemoryTracker (endQuery() no destrutor, inclusive em saídas antecipadas).
+ */
+class QueryMemoryScope {
+public:
+    QueryMemoryScope(QueryMemoryTracker* tracker, int lineNumber) : tracker(tracker), lineNumber(lineNumber) {
+        if (tracker)
+            tracker->beginQuery();
+    }
+
+    ~QueryMemoryScope() {
+        if (tracker)
+            tracker->endQuery(lineNumber);
+    }
+
+private:
+    QueryMemoryTracker* tracker;  ///< Rastreador (nullptr = desativado).
+    int lineNumber;               ///< Número do comando.
+
+    QueryMemoryScope(const QueryMemoryScope&);
+    QueryMemoryScope& operator=(const QueryMemoryScope&);
+};
+
+#endif // MEMORYREPORT_HPP
@@ -0,0 +1,192 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+/**
+ * @file Metrics.hpp
+ * @brief Contadores e histogramas cumulativos dos caminhos críticos.
+ *
+ * Só existem quando o projeto é compilado com -DENABLE_METRICS (make METRICS=1).
+ * Sem a flag, as macros METRIC_* expandem para nada e não há custo algum.
+ *
+ * Cada thread escreve no seu próprio shard (sem operações atômicas
+ * read-modify-write e sem compartilhar linhas de cache); a leitura soma todos
+ * os shards. O resultado pode ser gravado no formato de texto do Prometheus.
+ */
+
+/**
+ * @brief Contadores simples.
+ */
+enum MetricCounter {
+    METRIC_QUERIES,             ///< Consultas executadas.
+    METRIC_INDEX_PLANS,         ///< Consultas resolvidas com índice.
+    METRIC_SCAN_PLANS,          ///< Consultas resolvidas com varredura completa.
+    METRIC_CANDIDATES,          ///< Candidatos avaliados pelo filtro.
+    METRIC_RESULTS,             ///< Voos que satisfizeram a expressão.
+    METRIC_RANGE_REGROWTHS,     ///< Realocações do array de resultados das consultas por intervalo.
+    METRIC_RESERVATIONS,        ///< Reservas de assentos bem-sucedidas.
+    METRIC_RESERVATION_FAILURES,///< Reservas recusadas.
+    METRIC_ALLOCATIONS,         ///< Chamadas a operator new.
+    METRIC_ALLOCATED_BYTES,     ///< Bytes pedidos a operator new.
+    METRIC_INGESTED_FLIGHTS,    ///< Voos inseridos a partir do arquivo acompanhado (--follow).
+    METRIC_COUNTER_COUNT
+};
+
+/**
+ * @brief Histogramas com buckets em potências de 2.
+ */
+enum MetricHistogram {
+    METRIC_HIST_CANDIDATES,     ///< Candidatos por consulta.
+    METRIC_HIST_CANDIDATES_PER_RESULT, ///< Candidatos examinados por resultado retornado.
+    METRIC_HIST_SORT_SIZE,      ///< Tamanho dos arrays ordenados.
+    METRIC_HIST_INGEST_LAG_MS,  ///< Atraso de cada lote do arquivo acompanhado, em ms.
+    METRIC_HISTOGRAM_COUNT
+};
+
+/**
+ * @brief Caminho usado para um campo referenciado por uma consulta.
+ */
+enum MetricFieldPath {
+    METRIC_PATH_INDEX,          ///< O campo foi usado como índice.
+    METRIC_PATH_SCAN,           ///< O campo foi avaliado voo a voo.
+    METRIC_PATH_COUNT
+};
+
+#ifdef ENABLE_METRICS
+
+#include <atomic>
+#include <cstdint>
+
+static const int METRIC_FIELD_COUNT = 8;     ///< Campos consultáveis (ordem de IndexField).
+static const int METRIC_BUCKET_COUNT = 34;   ///< 0, 1, 2, 4, ..., 2^31 e +Inf.
+static const int METRIC_MAX_SHARDS = 128;    ///< Threads com shard exclusivo.
+
+/**
+ * @brief Contadores de uma thread.
+ *
+ * Cada valor tem um único escritor, então incrementos são load + store
+ * relaxados; a leitura concorrente vê valores possivelmente atrasados, mas
+ * nunca corrompidos. Threads além de METRIC_MAX_SHARDS compartilham o último
+ * shard e usam fetch_add.
+ */
+struct alignas(64) MetricsShard {
+    std::atomic<uint64_t> counters[METRIC_COUNTER_COUNT];
+    std::atomic<uint64_t> buckets[METRIC_HISTOGRAM_COUNT][METRIC_BUCKET_COUNT];
+    std::atomic<uint64_t> sums[METRIC_HISTOGRAM_COUNT];
+    std::atomic<uint64_t> fieldPaths[METRIC_FIELD_COUNT][METRIC_PATH_COUNT];
+    bool shared;
+};
+
+/**
+ * @brief Shard da thread atual (nullptr até o primeiro uso).
+ */
+extern thread_local MetricsShard* currentMetricsShard;
+
+/**
+ * @brief Reserva um shard para a thread atual.
+ */
+MetricsShard* registerMetricsShard();
+
+/**
+ * @brief Soma n a um contador atômico do shard.
+ */
+inline void metricsBump(MetricsShard* shard, std::atomic<uint64_t> &value, uint64_t n) {
+    if (shard->shared)
+        value.fetch_add(n, std::memory_order_relaxed);
+    else
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Retorna o shard da thread atual, registrando-o se necessário.
+ */
+inline MetricsShard* metricsShard() {
+    MetricsShard* shard = currentMetricsShard;
+    return shard ? shard : registerMetricsShard();
+}
+
+/**
+ * @brief Índice do bucket de um valor: 0 para 0 e 1 + ceil(log2(v)) para v >= 1.
+ */
+inline int metricsBucket(uint64_t value) {
+    if (value == 0)
+        return 0;
+    int bucket = value == 1 ? 1 : 1 + (64 - __builtin_clzll(value - 1));
+    return bucket < METRIC_BUCKET_COUNT - 1 ? bucket : METRIC_BUCKET_COUNT - 1;
+}
+
+inline void metricsAdd(MetricCounter counter, uint64_t n) {
+    MetricsShard* shard = metricsShard();
+    metricsBump(shard, shard->counters[counter], n);
+}
+
+inline void metricsObserve(MetricHistogram histogram, uint64_t value) {
+    MetricsShard* shard = metricsShard();
+    metricsBump(shard, shard->buckets[histogram][metricsBucket(value)], 1);
+    metricsBump(shard, shard->sums[histogram], value);
+}
+
+inline void metricsField(int field, MetricFieldPath path) {
+    if (field < 0 || field >= METRIC_FIELD_COUNT)
+        return;
+    MetricsShard* shard = metricsShard();
+    metricsBump(shard, shard->fieldPaths[field][path], 1);
+}
+
+/**
+ * @brief Grava todas as métricas (soma dos shards) no formato de texto do Prometheus.
+ * @param path Arquivo de destino (escrito em um temporário e renomeado).
+ * @return true se o arquivo foi gravado.
+ */
+bool writeMetrics(const char* path);
+
+/**
+ * @brief Inicia a thread que grava as métricas a cada intervalo e ao receber SIGUSR1.
+ * @param path Arquivo de destino.
+ * @param intervalSeconds Intervalo entre gravações (0 = apenas por sinal e no fim).
+ * @return true se o relatório foi iniciado.
+ */
+bool startMetricsReporter(const char* path, double intervalSeconds);
+
+/**
+ * @brief Para a thread de relatório e faz uma última gravação.
+ */
+void stopMetricsReporter();
+
+/**
+ * @brief Bytes vivos no heap: alocados por operator new e ainda não liberados.
+ *
+ * Conta o tamanho real dos blocos (malloc_usable_size), não só o pedido.
+ */
+long long metricsHeapLiveBytes();
+
+/**
+ * @brief Maior valor de metricsHeapLiveBytes() desde a última chamada a metricsResetHeapPeak().
+ */
+long long metricsHeapPeakBytes();
+
+/**
+ * @brief Reinicia o pico com os bytes vivos atuais.
+ */
+void metricsResetHeapPeak();
+
+#define METRIC_ADD(counter, n) metricsAdd((counter), (n))
+#define METRIC_INC(counter) metricsAdd((counter), 1)
+#define METRIC_OBSERVE(histogram, value) metricsObserve((histogram), (value))
+#define METRIC_FIELD(field, path) metricsField((field), (path))
+
+#else
+
+inline bool startMetricsReporter(const char*, double) { return false; }
+inline void stopMetricsReporter() {}
+inline long long metricsHeapLiveBytes() { return -1; }
+inline long long metricsHeapPeakBytes() { return -1; }
+inline void metricsResetHeapPeak() {}
+
+#define METRIC_ADD(counter, n) ((void)0)
+#define METRIC_INC(counter) ((void)0)
+#define METRIC_OBSERVE(histogram, value) ((void)0)
+#define METRIC_FIELD(field, path) ((void)0)
+
+#endif // ENABLE_METRICS
+
+#endif // METRICS_HPP
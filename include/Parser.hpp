@@ -2,65 +2,106 @@
 #define PARSER_HPP
 
 #include "Expression.hpp"
+#include "ExprArena.hpp"
 #include "DateTime.hpp"
 #include <string>
 #include <cctype>
 #include <cstdlib>
-#include <iostream>
+#include <cstring>
 
 using std::string;
 
+/**
+ * @brief Erro de sintaxe encontrado pelo parser.
+ */
+struct ParseError {
+    int position;         ///< Posição (0-based) na expressão onde o erro foi detectado.
+    const char* message;  ///< Descrição do erro (string estática).
+};
+
 /**
  * @brief Parser para expressões.
+ *
+ * Trabalha sobre uma visão (ponteiro + tamanho) da expressão, sem copiá-la e
+ * sem criar strings temporárias para os tokens. A memória apontada deve
+ * continuar válida enquanto o parser for usado.
+ *
+ * Os nós são criados na ExprArena recebida; a árvore vale até o próximo
+ * reset() da arena e não deve ser liberada com delete.
+ *
+ * Erros de sintaxe não encerram o programa: parseExpression() retorna nullptr
+ * e o erro fica disponível em getError().
+ *
+ * Com parametersAllowed, um valor pode ser "?" (parâmetro de um template
+ * preparado); os parâmetros são numerados na ordem em que aparecem.
  */
 class Parser {
 public:
-    string input;   ///< String de entrada a ser analisada.
-    int position;   ///< Posição atual na string.
+    const char* input;  ///< Início da expressão (não pertence ao parser).
+    int length;         ///< Tamanho da expressão.
+    int position;       ///< Posição atual na expressão.
+    bool parametersAllowed;  ///< Aceita "?" no lugar dos valores.
+    int parameterCount;      ///< Número de parâmetros "?" lidos.
+    ExprArena &arena;        ///< Arena onde os nós são criados.
 
     /**
      * @brief Construtor.
-     * @param str String de entrada.
+     * @param str Expressão (deve continuar viva enquanto o parser for usado).
+     * @param exprArena Arena onde os nós são criados.
+     */
+    Parser(const string &str, ExprArena &exprArena)
+        : input(str.data()), length(static_cast<int>(str.size())), position(0),
+          parametersAllowed(false), parameterCount(0), arena(exprArena) {
+        error.position = -1;
+        error.message = nullptr;
+    }
+
+    /**
+     * @brief Construtor a partir de um trecho de memória.
+     * @param text Início da expressão.
+     * @param textLength Número de caracteres da expressão.
+     * @param exprArena Arena onde os nós são criados.
      */
-    Parser(const string &str) : input(str), position(0) {}
+    Parser(const char* text, int textLength, ExprArena &exprArena)
+        : input(text), length(textLength), position(0),
+          parametersAllowed(false), parameterCount(0), arena(exprArena) {
+        error.position = -1;
+        error.message = nullptr;
+    }
 
     /**
      * @brief Retorna o caractere atual sem avançar.
-     * @return Caractere atual ou '\0' se no fim da string.
+     * @return Caractere atual ou '\0' se no fim da expressão.
      */
-    char peek() {
-        if (position < static_cast<int>(input.size()))
-            return input[position];
-        return '\0';
+    char peek() const {
+        return position < length ? input[position] : '\0';
     }
 
     /**
      * @brief Retorna o caractere atual e avança a posição.
-     * @return Caractere atual ou '\0' se no fim da string.
+     * @return Caractere atual ou '\0' se no fim da expressão.
      */
     char get() {
-        if (position < static_cast<int>(input.size()))
-            return input[position++];
-        return '\0';
+        return position < length ? input[position++] : '\0';
     }
 
     /**
      * @brief Pula os caracteres de espaço.
      */
     void skipWhitespace() {
-        while (position < static_cast<int>(input.size()) && isspace(input[position]))
+        while (position < length && isspace(static_cast<unsigned char>(input[position])))
             position++;
     }
 
     /**
      * @brief Tenta casar um token na posição atual.
-     * @param token Token a ser casado.
+     * @param token Token a ser casado (string terminada em '\0').
      * @return true se casou; false caso contrário.
      */
-    bool match(const string &token) {
+    bool match(const char* token) {
         skipWhitespace();
-        int len = token.size();
-        if (input.substr(position, len) == token) {
+        int len = static_cast<int>(strlen(token));
+        if (length - position >= len && memcmp(input + position, token, len) == 0) {
             position += len;
             return true;
         }
@@ -68,172 +109,265 @@ public:
     }
 
     /**
-     * @brief Lê um identificador.
-     * @return Identificador lido.
+     * @brief Lê um identificador (sequência de letras).
+     * @param tokenLength (Saída) Tamanho do identificador.
+     * @return Ponteiro para o início do identificador na expressão.
      */
-    string parseIdentifier() {
+    const char* parseIdentifier(int &tokenLength) {
         skipWhitespace();
-        string identifier;
-        while (position < static_cast<int>(input.size()) && isalpha(input[position])) {
-            identifier.push_back(input[position]);
+        int start = position;
+        while (position < length && isalpha(static_cast<unsigned char>(input[position])))
             position++;
-        }
-        return identifier;
+        tokenLength = position - start;
+        return input + start;
     }
 
     /**
-     * @brief Lê uma string numérica.
-     * @return String contendo o número.
+     * @brief Lê um número (dígitos e '.').
+     * @param tokenLength (Saída) Tamanho do número.
+     * @return Ponteiro para o início do número na expressão.
      */
-    string parseNumberString() {
+    const char* parseNumberToken(int &tokenLength) {
         skipWhitespace();
-        string numberStr;
-        while (position < static_cast<int>(input.size()) && (isdigit(input[position]) || input[position]=='.')) {
-            numberStr.push_back(input[position]);
+        int start = position;
+        while (position < length && (isdigit(static_cast<unsigned char>(input[position])) || input[position] == '.'))
             position++;
-        }
-        return numberStr;
+        tokenLength = position - start;
+        return input + start;
     }
 
     /**
-     * @brief Lê um token de data/hora.
-     * @return Token de data/hora.
+     * @brief Lê um token de data/hora (até um espaço ou ')').
+     * @param tokenLength (Saída) Tamanho do token.
+     * @return Ponteiro para o início do token na expressão.
      */
-    string parseTimeToken() {
+    const char* parseTimeToken(int &tokenLength) {
         skipWhitespace();
-        string token;
-        while (position < static_cast<int>(input.size()) && !isspace(input[position]) && input[position] != ')') {
-            token.push_back(input[position]);
+        int start = position;
+        while (position < length && !isspace(static_cast<unsigned char>(input[position])) && input[position] != ')')
             position++;
-        }
-        return token;
+        tokenLength = position - start;
+        return input + start;
     }
 
     /**
-     * @brief Inicia a análise da expressão.
-     * @return Ponteiro para a árvore de expressão resultante.
+     * @brief Analisa a expressão inteira.
+     * @return Ponteiro para a árvore de expressão resultante, ou nullptr em caso de erro (veja getError()).
      */
-    Expr* parseExpression() { 
-        return parseOr(); 
+    Expr* parseExpression() {
+        Expr* expr = parseOr();
+        if (!expr)
+            return nullptr;
+        skipWhitespace();
+        if (position < length)
+            return fail("unexpected characters after expression");
+        return expr;
     }
 
+    /**
+     * @brief Retorna o primeiro erro encontrado (message == nullptr se não houve erro).
+     */
+    const ParseError& getError() const { return error; }
+
 private:
+    static const int MAX_VALUE_LENGTH = 63;  ///< Tamanho máximo de um valor numérico ou de data.
+
+    ParseError error;  ///< Primeiro erro encontrado.
+
+    /**
+     * @brief Registra um erro na posição atual.
+     * @return Sempre nullptr, para encerrar a análise.
+     */
+    Expr* fail(const char* message) {
+        if (!error.message) {
+            error.position = position;
+            error.message = message;
+        }
+        return nullptr;
+    }
+
     /**
      * @brief Analisa uma expressão OR.
-     * @return Ponteiro para a expressão analisada.
+     * @return Ponteiro para a expressão analisada, ou nullptr em caso de erro.
      */
     Expr* parseOr() {
-        Expr* leftExpr = parseAnd();
-        skipWhitespace();
-        while (match("||")) {
-            Expr* rightExpr = parseAnd();
-            BinaryExpr* binaryExpr = new BinaryExpr();
-            binaryExpr->op = '|';
-            binaryExpr->left = leftExpr;
-            binaryExpr->right = rightExpr;
-            leftExpr = binaryExpr;
-            skipWhitespace();
-        }
-        return leftExpr;
+        return parseChain('|');
     }
 
     /**
      * @brief Analisa uma expressão AND.
-     * @return Ponteiro para a expressão analisada.
+     * @return Ponteiro para a expressão analisada, ou nullptr em caso de erro.
      */
     Expr* parseAnd() {
-        Expr* leftExpr = parseNot();
-        skipWhitespace();
-        while (match("&&")) {
-            Expr* rightExpr = parseNot();
-            BinaryExpr* binaryExpr = new BinaryExpr();
-            binaryExpr->op = '&';
-            binaryExpr->left = leftExpr;
-            binaryExpr->right = rightExpr;
-            leftExpr = binaryExpr;
-            skipWhitespace();
+        return parseChain('&');
+    }
+
+    /**
+     * @brief Analisa uma cadeia de operandos ligados pelo mesmo operador em um único LogicalExpr.
+     *
+     * Um operando que já é um LogicalExpr do mesmo operador (vindo de
+     * parênteses) tem seus filhos incorporados à cadeia.
+     *
+     * @param op '&' para AND, '|' para OR.
+     * @return Ponteiro para a expressão analisada, ou nullptr em caso de erro.
+     */
+    Expr* parseChain(char op) {
+        const char* token = op == '&' ? "&&" : "||";
+        Expr* first = op == '&' ? parseNot() : parseAnd();
+        if (!first)
+            return nullptr;
+        if (!match(token))
+            return first;
+        LogicalExpr* logical = arena.create<LogicalExpr>();
+        logical->op = op;
+        appendOperand(logical, first);
+        do {
+            Expr* operand = op == '&' ? parseNot() : parseAnd();
+            if (!operand)
+                return nullptr;
+            appendOperand(logical, operand);
+        } while (match(token));
+        return logical;
+    }
+
+    /**
+     * @brief Acrescenta um operando à cadeia, achatando cadeias aninhadas do mesmo operador.
+     */
+    void appendOperand(LogicalExpr* logical, Expr* operand) {
+        if (operand->kind == EXPR_LOGICAL && static_cast<LogicalExpr*>(operand)->op == logical->op) {
+            LogicalExpr* nested = static_cast<LogicalExpr*>(operand);
+            for (int i = 0; i < nested->childCount; i++)
+                appendChild(logical, nested->children[i]);
+        } else {
+            appendChild(logical, operand);
         }
-        return leftExpr;
+    }
+
+    /**
+     * @brief Acrescenta um filho ao array do nó, que cresce em potências de 2 dentro da arena.
+     */
+    void appendChild(LogicalExpr* logical, Expr* child) {
+        int count = logical->childCount;
+        // A capacidade não é guardada: é 4 até encher e depois dobra a cada potência de 2.
+        if (count == 0 || (count >= 4 && (count & (count - 1)) == 0)) {
+            Expr** grown = arena.createArray<Expr*>(count == 0 ? 4 : count * 2);
+            for (int i = 0; i < count; i++)
+                grown[i] = logical->children[i];
+            logical->children = grown;
+        }
+        logical->children[logical->childCount++] = child;
     }
 
     /**
      * @brief Analisa uma expressão NOT.
-     * @return Ponteiro para a expressão analisada.
+     * @return Ponteiro para a expressão analisada, ou nullptr em caso de erro.
      */
     Expr* parseNot() {
-        skipWhitespace();
         if (match("!")) {
-            NotExpr* notExpr = new NotExpr();
-            notExpr->child = parseNot();
+            Expr* child = parseNot();
+            if (!child)
+                return nullptr;
+            NotExpr* notExpr = arena.create<NotExpr>();
+            notExpr->child = child;
             return notExpr;
-        } else {
-            return parsePrimary();
         }
+        return parsePrimary();
     }
 
     /**
      * @brief Analisa uma expressão primária.
-     * @return Ponteiro para a expressão analisada.
+     * @return Ponteiro para a expressão analisada, ou nullptr em caso de erro.
      */
     Expr* parsePrimary() {
-        skipWhitespace();
         if (match("(")) {
-            Expr* expr = parseExpression();
-            skipWhitespace();
-            if (!match(")")) {
-                std::cerr << "Error: expected ')' at position " << position << std::endl;
-                exit(1);
-            }
+            Expr* expr = parseOr();
+            if (!expr)
+                return nullptr;
+            if (!match(")"))
+                return fail("expected ')'");
             return expr;
-        } else {
-            return parsePredicate();
         }
+        return parsePredicate();
     }
 
     /**
      * @brief Analisa um predicado.
-     * @return Ponteiro para o predicado analisado.
+     * @return Ponteiro para o predicado analisado, ou nullptr em caso de erro.
      */
     Expr* parsePredicate() {
-        skipWhitespace();
-        string fieldName = parseIdentifier();
-        skipWhitespace();
-        string opStr;
-        if (match("==")) { opStr = "=="; }
-        else if (match("!=")) { opStr = "!="; }
-        else if (match("<=")) { opStr = "<="; }
-        else if (match(">=")) { opStr = ">="; }
-        else if (peek() == '<') { opStr = "<"; position++; }
-        else if (peek() == '>') { opStr = ">"; position++; }
-        else {
-            std::cerr << "Error: expected comparison operator at position " << position << std::endl;
-            exit(1);
+        int fieldLength;
+        const char* fieldStart = parseIdentifier(fieldLength);
+        if (fieldLength == 0)
+            return fail("expected field name");
+        IndexField field = fieldFromName(fieldStart, fieldLength);
+        if (field == INDEX_COUNT) {
+            position -= fieldLength;
+            return fail("unknown field");
         }
-        skipWhitespace();
-        bool numericField = !(fieldName == "org" || fieldName == "dst");
-        PredicateExpr* predicate = new PredicateExpr();
-        predicate->field = fieldName;
-        if (opStr == "==") predicate->op = PredicateExpr::EQ;
-        else if (opStr == "!=") predicate->op = PredicateExpr::NE;
-        else if (opStr == "<") predicate->op = PredicateExpr::LT;
-        else if (opStr == "<=") predicate->op = PredicateExpr::LE;
-        else if (opStr == ">") predicate->op = PredicateExpr::GT;
-        else if (opStr == ">=") predicate->op = PredicateExpr::GE;
+
+        PredicateExpr::CompOp op;
+        if (match("==")) op = PredicateExpr::EQ;
+        else if (match("!=")) op = PredicateExpr::NE;
+        else if (match("<=")) op = PredicateExpr::LE;
+        else if (match(">=")) op = PredicateExpr::GE;
+        else if (match("<")) op = PredicateExpr::LT;
+        else if (match(">")) op = PredicateExpr::GT;
+        else return fail("expected comparison operator");
+
+        bool numericField = field != INDEX_ORIGIN && field != INDEX_DESTINATION;
+        bool timeField = field == INDEX_DEPARTURE || field == INDEX_ARRIVAL;
+        if (match("?")) {
+            if (!parametersAllowed) {
+                position--;
+                return fail("parameters are only allowed in prepared templates");
+            }
+            PredicateExpr* predicate = arena.create<PredicateExpr>();
+            predicate->field = field;
+            predicate->op = op;
+            predicate->isNumeric = numericField;
+            predicate->parameterIndex = parameterCount++;
+            return predicate;
+        }
+        int valueStart = position;
+        int valueLength;
+        const char* value = !numericField ? parseIdentifier(valueLength)
+                          : timeField ? parseTimeToken(valueLength)
+                          : parseNumberToken(valueLength);
+        if (valueLength == 0)
+            return fail(!numericField ? "expected airport code" : timeField ? "expected date/time" : "expected number");
+        if (numericField && valueLength > MAX_VALUE_LENGTH) {
+            position = valueStart;
+            return fail("value too long");
+        }
+        if (!numericField && valueLength > 3) {
+            position = valueStart;
+            return fail("airport code longer than 3 letters");
+        }
+
+        PredicateExpr* predicate = arena.create<PredicateExpr>();
+        predicate->field = field;
+        predicate->op = op;
         predicate->isNumeric = numericField;
-        
         if (numericField) {
-            if (fieldName == "dep" || fieldName == "arr") {
-                string timeString = parseTimeToken();
-                predicate->numValue = static_cast<double>(parseDateTime(timeString.c_str()));
+            // Cópia em buffer local: atof e parseDateTimeChecked esperam strings terminadas em '\0'.
+            char buffer[MAX_VALUE_LENGTH + 1];
+            memcpy(buffer, value, valueLength);
+            buffer[valueLength] = '\0';
+            if (timeField) {
+                time_t time;
+                if (!parseDateTimeChecked(buffer, time)) {
+                    position = valueStart;
+                    return fail("expected date/time");
+                }
+                predicate->numValue = static_cast<double>(time);
             } else {
-                string numberString = parseNumberString();
-                predicate->numValue = atof(numberString.c_str());
+                predicate->numValue = atof(buffer);
             }
         } else {
-            predicate->strValue = parseIdentifier();
+            predicate->setString(value, valueLength);
         }
         return predicate;
     }
 };
 
-#endif // PARSER_HPP
\ No newline at end of file
+#endif // PARSER_HPP
@@ -0,0 +1,222 @@
+#ifndef PARTITIONEDSTORE_HPP
+#define PARTITIONEDSTORE_HPP
+
+#include "Flight.hpp"
+#include "Expression.hpp"
+#include "Aggregate.hpp"
+#include "FlightManager.hpp"
+#include "QueryExecutor.hpp"
+#include "PreparedQuery.hpp"
+#include <ctime>
+#include <string>
+
+using std::string;
+
+/**
+ * @brief Critério que decide a partição de um voo.
+ */
+enum PartitionScheme {
+    PARTITION_BY_MONTH,  ///< Mês da partida (mês % partições): janelas de partida curtas tocam poucas partições.
+    PARTITION_BY_ROUTE   ///< Hash de (origem, destino): uma rota inteira fica em uma partição.
+};
+
+/**
+ * @brief Armazenamento de voos dividido em partições, cada uma com o seu FlightManager.
+ *
+ * Cada partição tem os próprios índices, construídos em paralelo (uma thread
+ * por partição, até o número de núcleos). Uma consulta é enviada só às
+ * partições que podem ter resultados (veja selectPartitions()), executada em
+ * cada uma pelo planejador de sempre e os resultados, já ordenados, são
+ * intercalados por um heap de cursores (k-way merge) até maxResults. As
+ * agregações são combinadas com AggregateResult::merge().
+ *
+ * Os identificadores dos comandos (del, upd, res) são globais, na ordem de
+ * inserção, como em um FlightManager; cada um é mapeado para a partição e o
+ * identificador local. Uma atualização que muda a partição do voo o move
+ * (remoção em uma, inserção na outra) e mantém o identificador global.
+ *
+ * Com uma partição só, todas as operações são repassadas ao FlightManager, sem
+ * poda nem intercalação.
+ */
+class PartitionedStore {
+public:
+    static const int MAX_PARTITIONS = 256;  ///< Número máximo de partições.
+
+    /**
+     * @brief Construtor: partições vazias e sem índices.
+     * @param partitionCount Número de partições (1 a MAX_PARTITIONS).
+     * @param scheme Critério de partição.
+     */
+    explicit PartitionedStore(int partitionCount = 1, PartitionScheme scheme = PARTITION_BY_MONTH);
+
+    /**
+     * @brief Destrutor: libera as partições.
+     */
+    ~PartitionedStore();
+
+    /**
+     * @brief Retorna o número de partições.
+     */
+    int getPartitionCount() const { return partitionCount; }
+
+    /**
+     * @brief Retorna os gerenciadores das partições (ex.: para ItinerarySearch).
+     */
+    FlightManager* const* getPartitions() const { return managers; }
+
+    /**
+     * @brief Retorna o identificador global de um voo a partir da partição e do identificador local.
+     *
+     * Flight::id é o identificador local da partição; desempates que precisam
+     * ser os mesmos para qualquer número de partições usam o global.
+     */
+    int globalId(int partition, int localId) const {
+        return partitionCount == 1 ? localId : infos[partition].globalIds[localId];
+    }
+
+    /**
+     * @brief Retorna a partição de um voo pelo critério do armazenamento.
+     */
+    int partitionOf(const Flight &flight) const;
+
+    /**
+     * @brief Adiciona um voo sem indexá-lo (carga inicial, antes de buildIndices()).
+     * @return Identificador global atribuído ao voo.
+     */
+    int addFlight(const Flight &flight);
+
+    /**
+     * @brief Constrói os índices das partições em paralelo.
+     */
+    void buildIndices();
+
+    /**
+     * @brief Insere um voo e o indexa na sua partição.
+     * @return Identificador global atribuído ao voo.
+     */
+    int insertFlight(const Flight &flight);
+
+    /**
+     * @brief Remove um voo.
+     * @return true se o voo existia; false caso contrário.
+     */
+    bool removeFlight(int id);
+
+    /**
+     * @brief Substitui os dados de um voo, movendo-o de partição se preciso.
+     * @return true se o voo existia; false caso contrário.
+     */
+    bool updateFlight(int id, const Flight &flight);
+
+    /**
+     * @brief Reserva assentos de um voo (veja FlightManager::reserveSeats()).
+     * @return true se a reserva foi feita; false caso contrário.
+     */
+    bool reserveSeats(int id, int seatCount);
+
+    /**
+     * @brief Retorna um voo pelo identificador global, ou nullptr se ele não existe.
+     */
+    Flight* getFlight(int id);
+
+    /**
+     * @brief Acrescenta ao relatório a memória de todas as partições (entradas de
+     * mesmo nome são somadas) e, com mais de uma partição, o mapeamento de
+     * identificadores ("partition_ids").
+     */
+    void reportMemory(MemoryReport &report) const;
+
+    /**
+     * @brief Marca as partições que podem ter voos que satisfazem a expressão.
+     *
+     * Usa os metadados de cada partição: partições vazias são descartadas, a
+     * janela de partida da conjunção principal (conjunctionBox()) é comparada
+     * com a menor e a maior partida da partição e, por mês, com os meses da
+     * partição; por rota, "org==X" e "dst==Y" na conjunção principal levam à
+     * partição da rota.
+     *
+     * @param expression Árvore de expressão (nullptr = todos os voos).
+     * @param selected (Saída) selected[p] é true se a partição p deve ser consultada.
+     * @return Número de partições marcadas.
+     */
+    int selectPartitions(const Expr* expression, bool* selected) const;
+
+    /**
+     * @brief Executa uma consulta nas partições selecionadas e intercala os resultados.
+     *
+     * Com um profile, o caminho de acesso é "partitions(<consultadas>/<total>:<caminhos>)",
+     * as contagens e os tempos são somados e a intercalação entra em sortUs.
+     *
+     * @param expression Árvore de expressão da consulta.
+     * @param sortCriteria Critérios de ordenação.
+     * @param maxResults Voos pedidos (o resultado é cortado nesse número).
+     * @param resultCount (Saída) Número de voos no resultado.
+     * @param profile (Saída, opcional) Perfil da execução.
+     * @return Array dinamicamente alocado com o resultado ordenado (deve ser liberado pelo chamador).
+     */
+    Flight** executeQuery(Expr* expression, const string &sortCriteria, int maxResults, int &resultCount,
+                          QueryProfile* profile = nullptr);
+
+    /**
+     * @brief Executa um template preparado nas partições selecionadas e intercala os resultados.
+     *
+     * Cada partição tem o seu plano no template (PreparedQuery::execute() com
+     * slot = índice da partição): as estimativas de uma partição não são
+     * comparadas com as de outra, e a ordem dos operandos escolhida para ela
+     * é reaplicada nas execuções seguintes.
+     */
+    Flight** executePrepared(PreparedQuery &prepared, const string &sortCriteria, int maxResults,
+                             int &resultCount, QueryProfile* profile = nullptr);
+
+    /**
+     * @brief Executa uma agregação nas partições selecionadas e combina os resultados parciais.
+     */
+    void executeAggregate(Expr* expression, AggregateResult &result, QueryProfile* profile = nullptr);
+
+private:
+    /**
+     * @brief Metadados de uma partição usados na poda.
+     *
+     * A janela de partidas só cresce (remoções não a estreitam), então é
+     * sempre um limite conservador.
+     */
+    struct PartitionInfo {
+        time_t minDeparture;  ///< Menor partida já armazenada.
+        time_t maxDeparture;  ///< Maior partida já armazenada.
+        int* globalIds;       ///< Identificador global de cada identificador local.
+        int idCapacity;       ///< Capacidade de globalIds.
+    };
+
+    int partitionCount;           ///< Número de partições.
+    PartitionScheme scheme;       ///< Critério de partição.
+    FlightManager** managers;     ///< Gerenciador de cada partição.
+    PartitionInfo* infos;         ///< Metadados de cada partição.
+    int* idPartition;             ///< Partição de cada identificador global.
+    int* idLocal;                 ///< Identificador local de cada identificador global.
+    int idCount;                  ///< Identificadores globais atribuídos.
+    int idCapacity;               ///< Capacidade de idPartition e idLocal.
+
+    /**
+     * @brief Registra um voo recém-armazenado na partição: metadados e mapeamento de identificadores.
+     * @param partition Partição do voo.
+     * @param localId Identificador local atribuído pelo FlightManager.
+     * @param flight Dados do voo.
+     * @param globalId Identificador global (-1 = atribui um novo).
+     * @return Identificador global.
+     */
+    int registerFlight(int partition, int localId, const Flight &flight, int globalId);
+
+    /**
+     * @brief Executa run em cada partição selecionada e intercala os resultados ordenados.
+     *
+     * run(flightManager, partição, resultCount, profile) devolve o resultado ordenado da partição.
+     */
+    template<typename Runner>
+    Flight** scatter(Expr* expression, Runner &run, const string &sortCriteria, int maxResults,
+                     int &resultCount, QueryProfile* profile);
+
+    PartitionedStore(const PartitionedStore&);
+    PartitionedStore& operator=(const PartitionedStore&);
+};
+
+#endif // PARTITIONEDSTORE_HPP
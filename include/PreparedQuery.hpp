@@ -0,0 +1,150 @@
+#ifndef PREPAREDQUERY_HPP
+#define PREPAREDQUERY_HPP
+
+#include "Flight.hpp"
+#include "Expression.hpp"
+#include "ExprArena.hpp"
+#include "Parser.hpp"
+#include "FlightManager.hpp"
+#include "QueryExecutor.hpp"
+#include <string>
+
+using std::string;
+
+/**
+ * @brief Template de consulta preparado, com parâmetros "?".
+ *
+ * A expressão é analisada uma única vez; cada execução apenas grava os valores
+ * dos parâmetros nos predicados da árvore. O caminho de acesso (predicado
+ * usado como índice) também é reaproveitado: ele é escolhido pela menor
+ * estimativa de candidatos (FlightManager::estimateCandidates) entre os
+ * predicados indexáveis da conjunção principal, e só é recalculado quando a
+ * estimativa de algum predicado parametrizado muda por um fator de
+ * REPLAN_FACTOR ou mais desde o último planejamento.
+ *
+ * O estado do plano (predicado escolhido, estimativas e ordem dos operandos)
+ * fica em um PlanSlot por gerenciador: PartitionedStore usa um slot por
+ * partição, de modo que partições com distribuições diferentes não forçam
+ * novos planejamentos umas às outras.
+ */
+class PreparedQuery {
+public:
+    static const int REPLAN_FACTOR = 4;  ///< Variação da estimativa que dispara um novo planejamento.
+
+    /**
+     * @brief Construtor: template vazio; use prepare() antes de executar.
+     */
+    PreparedQuery();
+
+    /**
+     * @brief Destrutor: libera os arrays auxiliares (a árvore fica na arena do template).
+     */
+    ~PreparedQuery();
+
+    /**
+     * @brief Analisa a expressão do template (com parâmetros "?").
+     * @param expressionStr Expressão do template.
+     * @return true se a expressão é válida; false caso contrário (veja getError()).
+     */
+    bool prepare(const string &expressionStr);
+
+    /**
+     * @brief Retorna o erro de sintaxe da última chamada a prepare().
+     */
+    const ParseError& getError() const { return error; }
+
+    /**
+     * @brief Retorna o número de parâmetros do template.
+     */
+    int getParameterCount() const { return parameterCount; }
+
+    /**
+     * @brief Atribui o valor de um parâmetro.
+     *
+     * Origem e destino recebem o código do aeroporto; "dep" e "arr", uma data no
+     * formato YYYY-MM-DDTHH:MM:SS (validada por parseDateTimeChecked()); os
+     * demais campos, um número.
+     *
+     * @param index Índice do parâmetro (ordem de aparição, a partir de 0).
+     * @param value Valor textual.
+     * @return true se o valor é válido para o campo; false caso contrário.
+     */
+    bool bind(int index, const string &value);
+
+    /**
+     * @brief Executa o template com os valores atribuídos.
+     * @param flightManager Gerenciador de voos.
+     * @param sortCriteria Critérios de ordenação.
+     * @param resultCount (Saída) Número de voos no resultado.
+     * @param profile (Saída, opcional) Perfil da execução.
+     * @param slot Plano usado (um por partição; sempre o mesmo para um mesmo gerenciador).
+     * @return Array dinamicamente alocado com o resultado ordenado (deve ser liberado pelo chamador).
+     */
+    Flight** execute(FlightManager &flightManager, const string &sortCriteria, int &resultCount,
+                     QueryProfile* profile = nullptr, int slot = 0);
+
+    /**
+     * @brief Retorna quantas vezes o caminho de acesso foi escolhido, somando os slots (inclui os primeiros planejamentos).
+     */
+    int getPlanCount() const { return planCount; }
+
+    /**
+     * @brief Retorna a árvore de expressão do template (com os valores atribuídos).
+     */
+    Expr* getExpression() const { return expression; }
+
+private:
+    /**
+     * @brief Plano do template para um gerenciador (uma partição).
+     */
+    struct PlanSlot {
+        bool planned;              ///< false até o primeiro planejamento.
+        PredicateExpr* plan;       ///< Caminho de acesso (nullptr = varredura).
+        double* estimates;         ///< Estimativa de cada predicado indexável no último planejamento.
+        Expr** order;              ///< Ordem dos operandos escolhida por optimizeExpression() (saveOperandOrder()).
+    };
+
+    ExprArena arena;               ///< Arena com os nós da árvore do template.
+    Expr* expression;              ///< Árvore de expressão do template.
+    ParseError error;              ///< Erro da última chamada a prepare().
+    int parameterCount;            ///< Número de parâmetros.
+    PredicateExpr** parameters;    ///< Predicado de cada parâmetro, por índice.
+    PredicateExpr** indexable;     ///< Predicados que podem ser usados como índice.
+    int indexableCount;            ///< Número de predicados indexáveis.
+    int operandCount;              ///< Operandos dos nós AND/OR (tamanho de PlanSlot::order).
+    PlanSlot* slots;               ///< Planos, por slot.
+    int slotCount;                 ///< Número de slots alocados.
+    int planCount;                 ///< Número de planejamentos feitos.
+
+    /**
+     * @brief Percorre a árvore registrando parâmetros e predicados indexáveis.
+     * @param expr Nó atual.
+     * @param inConjunction True se o nó está na conjunção principal (apenas ANDs acima dele).
+     */
+    void collect(Expr* expr, bool inConjunction);
+
+    /**
+     * @brief Libera os slots.
+     */
+    void clearSlots();
+
+    /**
+     * @brief Retorna o slot pedido, alocando-o se preciso.
+     */
+    PlanSlot& planSlot(int slot);
+
+    /**
+     * @brief Verifica se alguma estimativa mudou o bastante desde o planejamento do slot.
+     */
+    bool needsReplan(FlightManager &flightManager, const PlanSlot &slot) const;
+
+    /**
+     * @brief Escolhe o predicado indexável com a menor estimativa de candidatos e reordena a expressão.
+     */
+    void choosePlan(FlightManager &flightManager, PlanSlot &slot);
+
+    PreparedQuery(const PreparedQuery&);
+    PreparedQuery& operator=(const PreparedQuery&);
+};
+
+#endif // PREPAREDQUERY_HPP
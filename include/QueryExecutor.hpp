@@ -0,0 +1,155 @@
+#ifndef QUERYEXECUTOR_HPP
+#define QUERYEXECUTOR_HPP
+
+#include "Flight.hpp"
+#include "Expression.hpp"
+#include "Aggregate.hpp"
+#include "FlightManager.hpp"
+#include <cstdio>
+#include <string>
+
+using std::string;
+
+/**
+ * @brief Perfil de execução de uma consulta (modo EXPLAIN).
+ *
+ * Os tempos são medidos com std::chrono::steady_clock, em microssegundos.
+ * As fases de parsing e de saída são medidas por quem chama executeQuery().
+ */
+struct QueryProfile {
+    string accessPath;     ///< Caminho de acesso: "index(<predicado>)", "kdtree(<predicados>)", "bitmap(<operandos>)", "scan" ou "aggregate(<predicados>)".
+    int candidateCount;    ///< Voos avaliados pelo filtro.
+    int resultCount;       ///< Voos que satisfizeram a expressão.
+    double parseUs;        ///< Tempo de parsing da expressão.
+    double planUs;         ///< Tempo de escolha do caminho de acesso.
+    double candidatesUs;   ///< Tempo de obtenção dos candidatos (com índice, inclui a avaliação da expressão).
+    double filterUs;       ///< Tempo de avaliação da expressão sobre os candidatos (só na varredura).
+    double sortUs;         ///< Tempo de ordenação do resultado.
+    double outputUs;       ///< Tempo de escrita do resultado.
+
+    QueryProfile()
+        : candidateCount(0), resultCount(0), parseUs(0), planUs(0), candidatesUs(0),
+          filterUs(0), sortUs(0), outputUs(0) {}
+};
+
+/**
+ * @brief Descreve um predicado no formato da consulta (ex.: "prc<=300").
+ */
+string describePredicate(const PredicateExpr* predicate);
+
+/**
+ * @brief Escreve o perfil de uma consulta em uma linha.
+ * @param out Destino (stderr ou arquivo).
+ * @param queryNumber Número da consulta na entrada (a partir de 1).
+ * @param profile Perfil medido.
+ */
+void printQueryProfile(FILE* out, int queryNumber, const QueryProfile &profile);
+
+/**
+ * @brief Reordena os operandos de cada AND/OR para que o curto-circuito aconteça o mais cedo possível.
+ *
+ * A seletividade de cada predicado vem das estatísticas dos índices
+ * (FlightManager::estimateCandidates) e o custo é o número esperado de
+ * predicados avaliados: 1 para um predicado, mais para um AND/OR aninhado.
+ * Em um AND os operandos são ordenados por custo / (1 - seletividade); em um
+ * OR, por custo / seletividade. Entre predicados simples, a ordem depende
+ * só da seletividade. O predicado usado como índice é satisfeito por todos
+ * os candidatos, então vai para o fim do AND. O resultado não muda: só a
+ * ordem de avaliação.
+ *
+ * Deve ser chamada depois de escolhido o caminho de acesso, pois
+ * findIndexablePredicate() depende da ordem escrita na consulta.
+ *
+ * @param flightManager Gerenciador de voos (estatísticas).
+ * @param expression Árvore de expressão (alterada no lugar).
+ * @param plan Predicado usado como índice, ou nullptr para varredura completa.
+ */
+void optimizeExpression(FlightManager &flightManager, Expr* expression, const PredicateExpr* plan);
+
+/**
+ * @brief Conta os operandos dos nós AND/OR da expressão (tamanho do array de saveOperandOrder()).
+ */
+int countOperands(const Expr* expression);
+
+/**
+ * @brief Copia para saved a ordem dos operandos de cada AND/OR, em pré-ordem.
+ *
+ * Com restoreOperandOrder(), desfaz ou reaplica a reordenação feita por
+ * optimizeExpression() com as estatísticas de outro gerenciador.
+ *
+ * @param expression Árvore de expressão.
+ * @param saved (Saída) Array com countOperands(expression) posições.
+ */
+void saveOperandOrder(const Expr* expression, Expr** saved);
+
+/**
+ * @brief Restaura a ordem dos operandos gravada por saveOperandOrder().
+ * @param expression Árvore de expressão (alterada no lugar).
+ * @param saved Ordem gravada.
+ */
+void restoreOperandOrder(Expr* expression, Expr* const* saved);
+
+/**
+ * @brief Executa uma consulta sobre os voos do gerenciador.
+ *
+ * Os candidatos vêm de um índice quando a expressão tem um predicado indexável
+ * (ver findIndexablePredicate); caso contrário, todos os voos ativos são
+ * avaliados. Quando a conjunção principal tem intervalos em duas ou mais das
+ * dimensões preço, duração e partida, a árvore k-d substitui o índice se a
+ * estimativa da caixa (FlightManager::estimateBox) for bem menor que a do
+ * predicado. Operandos da conjunção principal sobre campos com índice de
+ * bitmap (inclusive com OR, NOT e NE) viram uma interseção de bitmaps, usada
+ * quando a estimativa dela é menor que a do caminho anterior. Os voos que
+ * satisfazem a expressão são ordenados pelos critérios.
+ *
+ * Pode ser chamada por várias threads ao mesmo tempo, desde que nenhuma delas
+ * insira, remova ou atualize voos (reservas de assentos são permitidas).
+ *
+ * @param flightManager Gerenciador de voos.
+ * @param expression Árvore de expressão da consulta.
+ * @param sortCriteria Critérios de ordenação.
+ * @param resultCount (Saída) Número de voos no resultado.
+ * @param profile (Saída, opcional) Caminho de acesso, contagens e tempos por fase.
+ * @return Array dinamicamente alocado com o resultado ordenado (deve ser liberado pelo chamador).
+ */
+Flight** executeQuery(FlightManager &flightManager, Expr* expression,
+                      const string &sortCriteria, int &resultCount,
+                      QueryProfile* profile = nullptr);
+
+/**
+ * @brief Executa uma consulta com um caminho de acesso já escolhido.
+ *
+ * Usada por executeQuery() e pelos templates preparados, que reaproveitam o plano.
+ *
+ * @param flightManager Gerenciador de voos.
+ * @param expression Árvore de expressão da consulta.
+ * @param plan Predicado usado como índice, ou nullptr para varredura completa.
+ * @param sortCriteria Critérios de ordenação.
+ * @param resultCount (Saída) Número de voos no resultado.
+ * @param profile (Saída, opcional) Caminho de acesso, contagens e tempos por fase (exceto planejamento).
+ * @param box Caixa da árvore k-d usada no lugar de plan (nullptr = usa plan).
+ * @param useBitmap True para usar o bitmap da conjunção principal no lugar de plan e de box.
+ * @return Array dinamicamente alocado com o resultado ordenado (deve ser liberado pelo chamador).
+ */
+Flight** executePlannedQuery(FlightManager &flightManager, Expr* expression, PredicateExpr* plan,
+                             const string &sortCriteria, int &resultCount,
+                             QueryProfile* profile = nullptr, const KDBox* box = nullptr, bool useBitmap = false);
+
+/**
+ * @brief Executa uma consulta de agregação (count, min, max, sum ou avg).
+ *
+ * Primeiro tenta responder só com as contagens e somas dos nós de um índice
+ * (FlightManager::aggregateFromIndex), em O(log n). Se não der, o caminho de
+ * acesso (índice, árvore k-d, bitmap ou varredura) é escolhido como em executeQuery() e os voos que satisfazem a
+ * expressão são acumulados durante o percurso, sem array de resultados,
+ * ordenação ou impressão.
+ *
+ * @param flightManager Gerenciador de voos.
+ * @param expression Árvore de expressão da consulta (nullptr = todos os voos).
+ * @param result (Entrada/Saída) Agregado vazio com a função e o campo pedidos.
+ * @param profile (Saída, opcional) Caminho de acesso, contagens e tempos por fase.
+ */
+void executeAggregate(FlightManager &flightManager, Expr* expression, AggregateResult &result,
+                      QueryProfile* profile = nullptr);
+
+#endif // QUERYEXECUTOR_HPP
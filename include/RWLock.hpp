@@ -0,0 +1,51 @@
+#ifndef RWLOCK_HPP
+#define RWLOCK_HPP
+
+#include <pthread.h>
+
+/**
+ * @brief Trava de leitura/escrita (vários leitores ou um escritor).
+ *
+ * Envolve pthread_rwlock_t, já que o C++11 não tem std::shared_mutex.
+ */
+class RWLock {
+public:
+    RWLock() { pthread_rwlock_init(&lock, nullptr); }
+    ~RWLock() { pthread_rwlock_destroy(&lock); }
+
+    void lockRead() { pthread_rwlock_rdlock(&lock); }
+    void lockWrite() { pthread_rwlock_wrlock(&lock); }
+    void unlock() { pthread_rwlock_unlock(&lock); }
+
+private:
+    pthread_rwlock_t lock;  ///< Trava POSIX subjacente.
+
+    RWLock(const RWLock&);
+    RWLock& operator=(const RWLock&);
+};
+
+/**
+ * @brief Mantém uma trava de leitura enquanto o objeto existir.
+ */
+class ReadGuard {
+public:
+    explicit ReadGuard(RWLock &rwLock) : lock(rwLock) { lock.lockRead(); }
+    ~ReadGuard() { lock.unlock(); }
+
+private:
+    RWLock &lock;  ///< Trava protegida.
+};
+
+/**
+ * @brief Mantém uma trava de escrita enquanto o objeto existir.
+ */
+class WriteGuard {
+public:
+    explicit WriteGuard(RWLock &rwLock) : lock(rwLock) { lock.lockWrite(); }
+    ~WriteGuard() { lock.unlock(); }
+
+private:
+    RWLock &lock;  ///< Trava protegida.
+};
+
+#endif // RWLOCK_HPP
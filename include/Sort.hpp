@@ -21,7 +21,7 @@ using std::string;
  * @param orderCriteria String com os critérios de ordenação.
  * @return -1 se flightA < flightB, 1 se flightA > flightB, 0 se forem iguais.
  */
-int compareFlightByCriteria(const Flight* flightA, const Flight* flightB, const string &orderCriteria) {
+inline int compareFlightByCriteria(const Flight* flightA, const Flight* flightB, const string &orderCriteria) {
     for (size_t i = 0; i < orderCriteria.size(); i++) {
         char criterion = orderCriteria[i];
         if (criterion == 'p') {
@@ -43,46 +43,192 @@ int compareFlightByCriteria(const Flight* flightA, const Flight* flightB, const
  * @param a Primeiro ponteiro.
  * @param b Segundo ponteiro.
  */
-void swapFlightPointers(Flight*& a, Flight*& b) {
+inline void swapFlightPointers(Flight*& a, Flight*& b) {
     Flight* temp = a;
     a = b;
     b = temp;
 }
 
 /**
- * @brief Particiona um array de voos para o quicksort.
- * @param arr Array de ponteiros para Flight.
- * @param low Índice inicial.
- * @param high Índice final.
- * @param orderCriteria Critérios de ordenação.
- * @return Índice de partição.
+ * @brief Critérios de ordenação pré-processados, com a mesma ordem de compareFlightByCriteria().
+ *
+ * Letras desconhecidas e repetidas são descartadas uma vez, na construção, e
+ * não a cada comparação (uma repetição nunca decide: a primeira ocorrência já
+ * desempatou ou deu igual).
  */
-int partitionFlights(Flight** arr, int low, int high, const string &orderCriteria) {
-    Flight* pivot = arr[high];
-    int i = low;
-    for (int j = low; j < high; j++) {
-        if (compareFlightByCriteria(arr[j], pivot, orderCriteria) < 0) {
-            swapFlightPointers(arr[i], arr[j]);
-            i++;
+struct FlightOrder {
+    char keys[3];  ///< Critérios efetivos ('p', 'd' ou 's'), na ordem.
+    int keyCount;  ///< Critérios em uso.
+
+    explicit FlightOrder(const string &orderCriteria) : keyCount(0) {
+        for (size_t i = 0; i < orderCriteria.size() && keyCount < 3; i++) {
+            char criterion = orderCriteria[i];
+            if (criterion != 'p' && criterion != 'd' && criterion != 's')
+                continue;
+            bool repeated = false;
+            for (int k = 0; k < keyCount; k++)
+                repeated = repeated || keys[k] == criterion;
+            if (!repeated)
+                keys[keyCount++] = criterion;
         }
     }
-    swapFlightPointers(arr[i], arr[high]);
-    return i;
+
+    /**
+     * @brief Compara dois voos: negativo, zero ou positivo.
+     */
+    int compare(const Flight* flightA, const Flight* flightB) const {
+        for (int k = 0; k < keyCount; k++) {
+            if (keys[k] == 'p') {
+                if (flightA->price < flightB->price) return -1;
+                if (flightA->price > flightB->price) return 1;
+            } else if (keys[k] == 'd') {
+                if (flightA->duration < flightB->duration) return -1;
+                if (flightA->duration > flightB->duration) return 1;
+            } else {
+                if (flightA->stops < flightB->stops) return -1;
+                if (flightA->stops > flightB->stops) return 1;
+            }
+        }
+        return 0;
+    }
+};
+
+static const int SORT_INSERTION_CUTOFF = 16;    ///< Trechos até este tamanho são ordenados por inserção.
+static const int SORT_NINTHER_THRESHOLD = 128;  ///< A partir deste tamanho o pivô é a mediana de três medianas.
+
+/**
+ * @brief Ordena arr[low, high] por inserção (trechos curtos).
+ */
+inline void insertionSortFlights(Flight** arr, int low, int high, const FlightOrder &order) {
+    for (int i = low + 1; i <= high; i++) {
+        Flight* current = arr[i];
+        int j = i - 1;
+        while (j >= low && order.compare(arr[j], current) > 0) {
+            arr[j + 1] = arr[j];
+            j--;
+        }
+        arr[j + 1] = current;
+    }
 }
 
 /**
- * @brief Ordena um array de voos usando quicksort.
+ * @brief Desce arr[low + root] no heap de máximo arr[low, low + size).
+ */
+inline void siftDownFlights(Flight** arr, int low, int root, int size, const FlightOrder &order) {
+    Flight* value = arr[low + root];
+    for (;;) {
+        int child = 2 * root + 1;
+        if (child >= size)
+            break;
+        if (child + 1 < size && order.compare(arr[low + child], arr[low + child + 1]) < 0)
+            child++;
+        if (order.compare(value, arr[low + child]) >= 0)
+            break;
+        arr[low + root] = arr[low + child];
+        root = child;
+    }
+    arr[low + root] = value;
+}
+
+/**
+ * @brief Ordena arr[low, high] por heapsort: O(n log n) garantido, usado quando o quicksort degenera.
+ */
+inline void heapSortFlights(Flight** arr, int low, int high, const FlightOrder &order) {
+    int size = high - low + 1;
+    for (int root = size / 2 - 1; root >= 0; root--)
+        siftDownFlights(arr, low, root, size, order);
+    for (int end = size - 1; end > 0; end--) {
+        swapFlightPointers(arr[low], arr[low + end]);
+        siftDownFlights(arr, low, 0, end, order);
+    }
+}
+
+/**
+ * @brief Retorna a posição da mediana de arr[a], arr[b] e arr[c].
+ */
+inline int medianOfThreeFlights(Flight** arr, int a, int b, int c, const FlightOrder &order) {
+    if (order.compare(arr[a], arr[b]) < 0) {
+        if (order.compare(arr[b], arr[c]) < 0)
+            return b;
+        return order.compare(arr[a], arr[c]) < 0 ? c : a;
+    }
+    if (order.compare(arr[a], arr[c]) < 0)
+        return a;
+    return order.compare(arr[b], arr[c]) < 0 ? c : b;
+}
+
+/**
+ * @brief Introsort de arr[low, high]: quicksort com partição em três vias, inserção nos trechos curtos e heapsort como limite.
+ *
+ * O pivô é a mediana de três (início, meio e fim) ou, em trechos grandes, a
+ * mediana de três medianas (ninther), o que torna entradas já ordenadas ou
+ * invertidas, comuns nos resultados que saem de um índice, casos bons. A
+ * partição em três vias (menores, iguais, maiores) deixa os iguais ao pivô
+ * de fora das recursões, então chaves muito repetidas (paradas, um preço)
+ * custam uma passada. Se a profundidade passa de depthLimit, o trecho é
+ * ordenado por heapsort. A recursão vai para o lado menor e o maior continua
+ * no laço, o que limita a pilha a O(log n).
+ */
+inline void introSortFlights(Flight** arr, int low, int high, int depthLimit, const FlightOrder &order) {
+    while (high - low + 1 > SORT_INSERTION_CUTOFF) {
+        if (depthLimit-- == 0) {
+            heapSortFlights(arr, low, high, order);
+            return;
+        }
+        int size = high - low + 1;
+        int middle = low + size / 2;
+        int pivotIndex;
+        if (size >= SORT_NINTHER_THRESHOLD) {
+            int step = size / 8;
+            pivotIndex = medianOfThreeFlights(arr,
+                medianOfThreeFlights(arr, low, low + step, low + 2 * step, order),
+                medianOfThreeFlights(arr, middle - step, middle, middle + step, order),
+                medianOfThreeFlights(arr, high - 2 * step, high - step, high, order), order);
+        } else {
+            pivotIndex = medianOfThreeFlights(arr, low, middle, high, order);
+        }
+        Flight* pivot = arr[pivotIndex];
+
+        // Invariante: [low, less) < pivô, [less, i) == pivô, (greater, high] > pivô.
+        int less = low, i = low, greater = high;
+        while (i <= greater) {
+            int result = order.compare(arr[i], pivot);
+            if (result < 0)
+                swapFlightPointers(arr[less++], arr[i++]);
+            else if (result > 0)
+                swapFlightPointers(arr[i], arr[greater--]);
+            else
+                i++;
+        }
+
+        if (less - low < high - greater) {
+            introSortFlights(arr, low, less - 1, depthLimit, order);
+            low = greater + 1;
+        } else {
+            introSortFlights(arr, greater + 1, high, depthLimit, order);
+            high = less - 1;
+        }
+    }
+    insertionSortFlights(arr, low, high, order);
+}
+
+/**
+ * @brief Ordena um array de voos (introsort; veja introSortFlights()).
+ *
+ * A ordem entre voos iguais em todos os critérios não é especificada.
+ *
  * @param arr Array de ponteiros para Flight.
  * @param low Índice inicial.
  * @param high Índice final.
  * @param orderCriteria Critérios de ordenação.
  */
-void quickSortFlights(Flight** arr, int low, int high, const string &orderCriteria) {
-    if (low < high) {
-        int partitionIndex = partitionFlights(arr, low, high, orderCriteria);
-        quickSortFlights(arr, low, partitionIndex - 1, orderCriteria);
-        quickSortFlights(arr, partitionIndex + 1, high, orderCriteria);
-    }
+inline void quickSortFlights(Flight** arr, int low, int high, const string &orderCriteria) {
+    if (low >= high)
+        return;
+    int depthLimit = 0;
+    for (int size = high - low + 1; size > 1; size >>= 1)
+        depthLimit += 2;
+    introSortFlights(arr, low, high, depthLimit, FlightOrder(orderCriteria));
 }
 
 #endif // SORT_HPP
\ No newline at end of file
@@ -0,0 +1,124 @@
+#ifndef SPSCQUEUE_HPP
+#define SPSCQUEUE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+/**
+ * @brief Fila circular limitada, sem travas, para um produtor e um consumidor.
+ *
+ * O produtor só escreve tail e o consumidor só escreve head, cada um na sua
+ * linha de cache; a publicação de um item é um store release em tail, visto
+ * pelo consumidor com um load acquire (e o inverso para liberar a posição).
+ * Cada lado guarda a última posição lida do outro e só relê o atômico quando
+ * a fila parece cheia (ou vazia), o que evita tráfego de cache a cada item.
+ *
+ * push() e pop() esperam cedendo o processador (std::this_thread::yield), o
+ * que mantém a fila utilizável mesmo com menos núcleos que threads.
+ *
+ * @tparam T Tipo dos itens (copiável; em geral um ponteiro).
+ */
+template<typename T>
+class SpscQueue {
+public:
+    /**
+     * @brief Construtor.
+     * @param minCapacity Capacidade mínima (arredondada para uma potência de 2).
+     */
+    explicit SpscQueue(int minCapacity) : head(0), cachedTail(0), tail(0), cachedHead(0) {
+        int capacity = 1;
+        while (capacity < minCapacity)
+            capacity *= 2;
+        mask = capacity - 1;
+        items = new T[capacity];
+    }
+
+    ~SpscQueue() {
+        delete[] items;
+    }
+
+    /**
+     * @brief (Produtor) Insere um item se houver espaço.
+     * @return true se o item foi inserido; false se a fila está cheia.
+     */
+    bool tryPush(const T &item) {
+        unsigned position = tail.load(std::memory_order_relaxed);
+        if (position - cachedHead > static_cast<unsigned>(mask)) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (position - cachedHead > static_cast<unsigned>(mask))
+                return false;
+        }
+        items[position & mask] = item;
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief (Consumidor) Retira um item se a fila não está vazia.
+     * @return true se um item foi retirado; false se a fila está vazia.
+     */
+    bool tryPop(T &item) {
+        unsigned position = head.load(std::memory_order_relaxed);
+        if (position == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (position == cachedTail)
+                return false;
+        }
+        item = items[position & mask];
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief (Produtor) Insere um item, esperando por espaço.
+     */
+    void push(const T &item) {
+        for (int attempt = 0; !tryPush(item); attempt++)
+            backoff(attempt);
+    }
+
+    /**
+     * @brief (Consumidor) Retira um item, esperando que haja um.
+     */
+    T pop() {
+        T item;
+        for (int attempt = 0; !tryPop(item); attempt++)
+            backoff(attempt);
+        return item;
+    }
+
+    /**
+     * @brief Espera entre tentativas: cede o processador nas primeiras e depois dorme.
+     *
+     * Só ceder mantém a thread que espera disputando o núcleo com as que
+     * trabalham (o escalonador a trata como pronta); dormir um pouco a tira da
+     * disputa quando a espera é longa (ex.: a entrada ainda não chegou).
+     *
+     * @param attempt Tentativas já feitas (começando em 0).
+     */
+    static void backoff(int attempt) {
+        int sleepMicroseconds = SLEEP_MICROSECONDS;  // Cópia: microseconds recebe uma referência.
+        if (attempt < SPIN_ATTEMPTS)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(sleepMicroseconds));
+    }
+
+    static const int SPIN_ATTEMPTS = 64;       ///< Tentativas com yield antes de dormir.
+    static const int SLEEP_MICROSECONDS = 50;  ///< Duração de cada espera longa.
+
+private:
+    T* items;  ///< Posições da fila.
+    int mask;  ///< Capacidade - 1.
+
+    alignas(64) std::atomic<unsigned> head;  ///< Próxima posição a retirar (escrita pelo consumidor).
+    unsigned cachedTail;                     ///< Última tail lida pelo consumidor.
+    alignas(64) std::atomic<unsigned> tail;  ///< Próxima posição a inserir (escrita pelo produtor).
+    unsigned cachedHead;                     ///< Última head lida pelo produtor.
+
+    SpscQueue(const SpscQueue&);
+    SpscQueue& operator=(const SpscQueue&);
+};
+
+#endif // SPSCQUEUE_HPP
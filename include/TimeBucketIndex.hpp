@@ -0,0 +1,284 @@
+#ifndef TIMEBUCKETINDEX_HPP
+#define TIMEBUCKETINDEX_HPP
+
+#include "Flight.hpp"
+#include "AVLTree.hpp"
+#include "MemoryReport.hpp"
+#include <ctime>
+
+/**
+ * @brief Entrada de um índice de tempo: chave e voo.
+ */
+struct TimeEntry {
+    time_t key;      ///< Horário indexado.
+    Flight* flight;  ///< Voo.
+};
+
+/**
+ * @brief Balde de um índice de tempo: as entradas de um intervalo fixo de horários, ordenadas.
+ */
+struct TimeBucket {
+    long long number;    ///< Número do balde (horário / largura do balde, arredondado para baixo).
+    TimeEntry* entries;  ///< Entradas ordenadas pela chave.
+    int size;            ///< Entradas em uso.
+    int capacity;        ///< Capacidade de entries.
+    double sum;          ///< Soma das chaves das entradas.
+};
+
+/**
+ * @brief Cursor que percorre em ordem as entradas de um intervalo de um TimeBucketIndex.
+ *
+ * Início e fim do intervalo são posições (balde, entrada) calculadas na
+ * criação do cursor, então next() não compara chaves: apenas avança pelos
+ * arrays dos baldes. O cursor deixa de ser válido se o índice for modificado.
+ */
+class TimeBucketCursor {
+public:
+    /**
+     * @brief Construtor: percorre as entradas de (bucket, position) até (endBucket, endPosition), exclusive.
+     */
+    TimeBucketCursor(const TimeBucket* buckets, int bucket, int position, int endBucket, int endPosition)
+        : buckets(buckets), bucket(bucket), position(position), endBucket(endBucket), endPosition(endPosition) {}
+
+    /**
+     * @brief Avança para o próximo voo do intervalo.
+     * @return Ponteiro para o voo, ou nullptr quando o intervalo termina.
+     */
+    Flight* next() {
+        while (bucket < endBucket && position >= buckets[bucket].size) {
+            bucket++;
+            position = 0;
+        }
+        if (bucket > endBucket || (bucket == endBucket && position >= endPosition))
+            return nullptr;
+        return buckets[bucket].entries[position++].flight;
+    }
+
+private:
+    const TimeBucket* buckets;  ///< Baldes do índice.
+    int bucket;                 ///< Balde atual.
+    int position;               ///< Próxima entrada do balde atual.
+    int endBucket;              ///< Balde do fim do intervalo.
+    int endPosition;            ///< Primeira entrada de endBucket fora do intervalo.
+};
+
+/**
+ * @brief Índice de horários particionado em baldes de largura fixa (uma hora, por padrão).
+ *
+ * Substitui a árvore AVL nos campos "dep" e "arr": com chaves em segundos,
+ * quase todo voo tem uma chave própria e a árvore teria um nó por voo. Aqui,
+ * cada balde guarda um array ordenado de entradas, e só os baldes não vazios
+ * existem, em um diretório ordenado pelo número do balde. Uma janela de
+ * horários localiza os baldes das pontas por busca binária no diretório e a
+ * posição dentro deles por busca binária no array; os baldes do meio são
+ * percorridos inteiros, em memória contígua.
+ *
+ * As contagens e somas por balde ficam em árvores de Fenwick sobre o
+ * diretório, de modo que countBelow(), countRange() e selectEntry() custam
+ * O(log B + log b) (B baldes, b entradas por balde) e sumBelow() acrescenta a
+ * soma parcial de um balde, O(b). A interface segue a de AVLTree, para que o
+ * FlightManager use os mesmos algoritmos de intervalo nos dois tipos de índice.
+ *
+ * Inserções e remoções deslocam o array do balde, O(log B + b). Um balde
+ * novo depois do último (um horário mais recente que todos) entra nas
+ * árvores de Fenwick em O(log B); no meio do diretório (um horário sem
+ * voos entre outros já indexados), ele desloca o diretório e reconstrói as
+ * árvores, O(B). As leituras (contagens, somas, cursores) não alteram o
+ * índice e podem rodar em várias threads enquanto nada o modifica. Baldes
+ * esvaziados por remoções liberam as entradas e saem do diretório quando
+ * passam de um quarto dele (O(B) a cada B/4 baldes esvaziados).
+ *
+ * Voos com a mesma chave ficam na ordem inversa de inserção, como nas listas
+ * de duplicatas da AVL.
+ */
+class TimeBucketIndex {
+public:
+    typedef time_t KeyType;           ///< Tipo da chave.
+    typedef TimeBucketCursor Cursor;  ///< Cursor sobre intervalos do índice.
+
+    static const int DEFAULT_BUCKET_SECONDS = 3600;  ///< Largura padrão de um balde (uma hora).
+
+    ThreeWayCompare<time_t> compare;  ///< Comparador das chaves.
+    int entryCount;                   ///< Número de voos (entradas) no índice.
+
+    /**
+     * @brief Construtor: índice vazio.
+     * @param bucketSeconds Largura de cada balde, em segundos.
+     */
+    explicit TimeBucketIndex(int bucketSeconds = DEFAULT_BUCKET_SECONDS);
+
+    /**
+     * @brief Destrutor: libera os baldes.
+     */
+    ~TimeBucketIndex();
+
+    /**
+     * @brief Carrega o índice de uma vez (o índice precisa estar vazio).
+     *
+     * Ordena as entradas e preenche os baldes em uma passada, sem as
+     * inserções uma a uma. O resultado é o mesmo de inserir as entradas na
+     * ordem do array.
+     *
+     * @param entries Entradas na ordem de inserção (o array é reordenado).
+     * @param count Número de entradas.
+     */
+    void build(TimeEntry* entries, int count);
+
+    /**
+     * @brief Insere um voo com a chave fornecida.
+     *
+     * Custo O(log B + b); um balde novo no meio do diretório desloca o
+     * diretório e reconstrói as árvores de Fenwick, O(B).
+     *
+     * @param key Horário.
+     * @param flight Ponteiro para o voo.
+     */
+    void insert(time_t key, Flight* flight);
+
+    /**
+     * @brief Remove a entrada de um voo.
+     *
+     * Custo O(log B + b), mais O(B) quando a remoção leva os baldes vazios a
+     * mais de um quarto do diretório e ele é compactado.
+     *
+     * @param key Chave com que o voo foi inserido.
+     * @param flight Ponteiro para o voo.
+     * @return true se a entrada foi removida; false se ela não existe.
+     */
+    bool remove(time_t key, const Flight* flight);
+
+    /**
+     * @brief Conta as entradas com chave menor (ou menor ou igual) que key.
+     * @param key Chave de referência.
+     * @param inclusive Se true, conta também as entradas com chave igual a key.
+     * @return Número de entradas.
+     */
+    int countBelow(time_t key, bool inclusive) const;
+
+    /**
+     * @brief Conta as entradas de um intervalo sem percorrê-lo.
+     *
+     * Se os ponteiros para os limites forem nullptr, não há restrição inferior/superior.
+     *
+     * @param low Ponteiro para o limite inferior.
+     * @param lowInclusive True se o limite inferior é inclusivo.
+     * @param high Ponteiro para o limite superior.
+     * @param highInclusive True se o limite superior é inclusivo.
+     * @return Número de entradas no intervalo.
+     */
+    int countRange(const time_t* low, bool lowInclusive, const time_t* high, bool highInclusive) const;
+
+    /**
+     * @brief Soma as chaves das entradas com chave menor (ou menor ou igual) que key.
+     * @param key Chave de referência.
+     * @param inclusive Se true, soma também as entradas com chave igual a key.
+     * @return Soma das chaves (cada duplicata conta uma vez).
+     */
+    double sumBelow(time_t key, bool inclusive) const;
+
+    /**
+     * @brief Soma as chaves das entradas de um intervalo sem percorrê-lo.
+     * @param low Ponteiro para o limite inferior (nullptr = sem limite).
+     * @param lowInclusive True se o limite inferior é inclusivo.
+     * @param high Ponteiro para o limite superior (nullptr = sem limite).
+     * @param highInclusive True se o limite superior é inclusivo.
+     * @return Soma das chaves no intervalo (0 se o intervalo for vazio).
+     */
+    double sumRange(const time_t* low, bool lowInclusive, const time_t* high, bool highInclusive) const;
+
+    /**
+     * @brief Retorna o voo de posição rank na ordem das chaves.
+     * @param rank Posição (0 = primeira entrada da menor chave).
+     * @return Ponteiro para o voo, ou nullptr se rank estiver fora de [0, entryCount).
+     */
+    Flight* selectEntry(int rank) const;
+
+    /**
+     * @brief Cria um cursor sobre as entradas de um intervalo.
+     * @param low Ponteiro para o limite inferior (nullptr = sem limite).
+     * @param lowInclusive True se o limite inferior é inclusivo.
+     * @param high Ponteiro para o limite superior (nullptr = sem limite).
+     * @param highInclusive True se o limite superior é inclusivo.
+     * @return Cursor posicionado na primeira entrada do intervalo.
+     */
+    Cursor rangeCursor(const time_t* low, bool lowInclusive, const time_t* high, bool highInclusive) const;
+
+    /**
+     * @brief Retorna o número de baldes (inclui até um quarto de baldes esvaziados por remoções).
+     */
+    int getBucketCount() const { return bucketCount; }
+
+    /**
+     * @brief Acrescenta a memória do índice ao relatório: "<name>.entries" (arrays
+     * dos baldes) e "<name>.directory" (diretório e árvores de Fenwick).
+     */
+    void reportMemory(MemoryReport &report, const string &name) const;
+
+private:
+    long long bucketSeconds;  ///< Largura de um balde.
+    TimeBucket* buckets;      ///< Diretório de baldes, ordenado por número.
+    int bucketCount;          ///< Baldes em uso.
+    int bucketCapacity;       ///< Capacidade do diretório.
+    int emptyBuckets;         ///< Baldes do diretório esvaziados por remoções.
+    int* countTree;           ///< Árvore de Fenwick com o número de entradas de cada balde.
+    double* sumTree;          ///< Árvore de Fenwick com a soma das chaves de cada balde.
+
+    /**
+     * @brief Retorna o número do balde de um horário.
+     */
+    long long bucketOf(time_t key) const;
+
+    /**
+     * @brief Retorna a posição no diretório do primeiro balde com número maior ou igual a number.
+     */
+    int findBucket(long long number) const;
+
+    /**
+     * @brief Localiza a primeira entrada com chave maior ou igual (after = false) ou maior (after = true) que key.
+     * @param key Chave de referência.
+     * @param after Se true, pula as entradas com chave igual a key.
+     * @param bucket (Saída) Posição do balde no diretório (bucketCount = fim).
+     * @param position (Saída) Posição da entrada no balde.
+     */
+    void locate(time_t key, bool after, int &bucket, int &position) const;
+
+    /**
+     * @brief Retorna o número de entradas nos baldes [0, bucket).
+     */
+    int prefixCount(int bucket) const;
+
+    /**
+     * @brief Retorna a soma das chaves nos baldes [0, bucket).
+     */
+    double prefixSum(int bucket) const;
+
+    /**
+     * @brief Soma variações à contagem e à soma de um balde nas árvores de Fenwick.
+     */
+    void addTotals(int bucket, int countDelta, double sumDelta);
+
+    /**
+     * @brief Reconstrói as árvores de Fenwick a partir dos baldes, em O(B).
+     */
+    void rebuildTotals();
+
+    /**
+     * @brief Inclui nas árvores de Fenwick o último balde do diretório, vazio, em O(log B).
+     */
+    void appendTotals();
+
+    /**
+     * @brief Abre um balde vazio na posição bucket do diretório.
+     */
+    void insertBucket(int bucket, long long number);
+
+    /**
+     * @brief Tira do diretório os baldes vazios e reconstrói as árvores de Fenwick.
+     */
+    void compactBuckets();
+
+    TimeBucketIndex(const TimeBucketIndex&);
+    TimeBucketIndex& operator=(const TimeBucketIndex&);
+};
+
+#endif // TIMEBUCKETINDEX_HPP
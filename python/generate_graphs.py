@@ -1,10 +1,12 @@
 import os
+import csv
 import matplotlib.pyplot as plt
 import numpy as np
 
 RESULTS_DIR = "benchmarks"
 GRAPHS_DIR = "graphs"
 SIZES = [100, 1000, 5000, 10000, 50000, 100000, 250000, 500000]
+QUERIES_CSV = f"{RESULTS_DIR}/queries.csv"
 
 def read_benchmark_results():
     """Lê os resultados dos benchmarks e retorna os dados formatados."""
@@ -54,6 +56,73 @@ def plot_results(sizes, avl_insert, linear_insert, sorting):
     plt.savefig(f"{GRAPHS_DIR}/ordenacao.png")
     plt.close()
 
+def read_query_results():
+    """Lê o CSV do benchmark de consultas e agrupa as linhas por mistura."""
+    by_mix = {}
+    if not os.path.exists(QUERIES_CSV):
+        return by_mix
+
+    with open(QUERIES_CSV, "r") as file:
+        for row in csv.DictReader(file):
+            by_mix.setdefault(row["mix"], []).append(row)
+
+    for rows in by_mix.values():
+        rows.sort(key=lambda row: int(row["size"]))
+    return by_mix
+
+def plot_query_results(by_mix):
+    """Gera gráficos de latência (p50/p95/p99), vazão, construção dos índices e memória."""
+    if not by_mix:
+        return
+    os.makedirs(GRAPHS_DIR, exist_ok=True)
+
+    # Latência por percentil, uma figura por mistura
+    for mix, rows in by_mix.items():
+        sizes = [int(row["size"]) for row in rows]
+        plt.figure(figsize=(8, 5))
+        for column, label in [("p50_us", "p50"), ("p95_us", "p95"), ("p99_us", "p99")]:
+            plt.plot(sizes, [float(row[column]) for row in rows], label=label, marker="o")
+        plt.xscale("log")
+        plt.yscale("log")
+        plt.xlabel("Número de Voos")
+        plt.ylabel("Latência (µs)")
+        plt.title(f"Latência das Consultas ({mix})")
+        plt.legend()
+        plt.savefig(f"{GRAPHS_DIR}/latencia_{mix}.png")
+        plt.close()
+
+    # Vazão de todas as misturas
+    plt.figure(figsize=(8, 5))
+    for mix, rows in by_mix.items():
+        sizes = [int(row["size"]) for row in rows]
+        plt.plot(sizes, [float(row["throughput_qps"]) for row in rows], label=mix, marker="o")
+    plt.xscale("log")
+    plt.yscale("log")
+    plt.xlabel("Número de Voos")
+    plt.ylabel("Consultas por segundo")
+    plt.title("Vazão por Mistura de Consultas")
+    plt.legend()
+    plt.savefig(f"{GRAPHS_DIR}/vazao_consultas.png")
+    plt.close()
+
+    # Carga, construção dos índices e pico de memória (iguais entre misturas)
+    rows = next(iter(by_mix.values()))
+    sizes = [int(row["size"]) for row in rows]
+    fig, ax_time = plt.subplots(figsize=(8, 5))
+    ax_time.plot(sizes, [float(row["load_ms"]) for row in rows], label="Carga", marker="o")
+    ax_time.plot(sizes, [float(row["build_ms"]) for row in rows], label="Construção dos índices", marker="o")
+    ax_time.set_xlabel("Número de Voos")
+    ax_time.set_ylabel("Tempo (ms)")
+    ax_memory = ax_time.twinx()
+    ax_memory.plot(sizes, [int(row["peak_rss_kb"]) / 1024 for row in rows],
+                   label="Pico de RSS", marker="s", linestyle="--", color="gray")
+    ax_memory.set_ylabel("Memória (MB)")
+    fig.legend(loc="upper left")
+    plt.title("Construção dos Índices e Memória")
+    plt.savefig(f"{GRAPHS_DIR}/construcao_memoria.png")
+    plt.close()
+
 # Executa a análise
 sizes, avl_insert, linear_insert, sorting = read_benchmark_results()
-plot_results(sizes, avl_insert, linear_insert, sorting)
\ No newline at end of file
+plot_results(sizes, avl_insert, linear_insert, sorting)
+plot_query_results(read_query_results())
\ No newline at end of file
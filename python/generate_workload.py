@@ -0,0 +1,217 @@
+#!/usr/bin/env python3
+"""Gera cargas sintéticas grandes (voos + consultas) para testes de desempenho.
+
+Diferente de generate_inputs.py, os voos são gerados em blocos com numpy e
+gravados à medida que são produzidos, então a memória usada não depende do
+número de linhas (1M-50M voos). A popularidade das rotas segue uma distribuição
+de Zipf, a duração depende da distância entre os aeroportos e do número de
+paradas, e o preço cresce com a distância com ruído log-normal.
+
+As consultas usam quantis de uma amostra dos voos gerados para atingir a
+seletividade pedida (fração de voos que satisfaz cada consulta).
+
+Exemplos:
+    python3 python/generate_workload.py --flights 1000000 --queries 100000 --out inputs/workload_1M.txt
+    python3 python/generate_workload.py --flights 5000000 --queries 0 --out inputs/flights_5000000.txt
+"""
+import argparse
+import datetime
+import itertools
+import string
+
+import numpy as np
+
+# Aeroportos reais usados primeiro; o restante é completado com códigos sintéticos.
+BASE_AIRPORTS = ["ATL", "LAX", "ORD", "DFW", "DEN", "JFK", "SFO", "SEA", "LAS", "MCO",
+                 "EWR", "CLT", "PHX", "IAH", "MIA", "BOS", "MSP", "FLL", "DTW", "PHL",
+                 "LGA", "BWI", "SLC", "SAN", "IAD", "DCA", "MDW", "TPA", "PDX", "HNL",
+                 "OAK", "DAL", "AUS", "BNA", "STL", "RDU", "SJC", "SMF", "MSY", "SNA"]
+
+CHUNK_SIZE = 200_000       # Voos gerados por bloco.
+SAMPLE_SIZE = 200_000      # Tamanho da amostra usada para calibrar as consultas.
+CRITERIA = ["pds", "psd", "dps", "dsp", "spd", "sdp"]
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description="Gera voos e consultas sintéticos em streaming.")
+    parser.add_argument("--flights", type=int, default=1_000_000, help="número de voos (ex.: 1000000 a 50000000)")
+    parser.add_argument("--queries", type=int, default=100_000, help="número de consultas (0 = apenas voos)")
+    parser.add_argument("--out", required=True, help="arquivo de saída no formato de entrada do busca_voos")
+    parser.add_argument("--queries-out", help="grava as consultas também em um arquivo separado")
+    parser.add_argument("--airports", type=int, default=200, help="número de aeroportos")
+    parser.add_argument("--zipf", type=float, default=1.1, help="expoente de Zipf da popularidade dos aeroportos")
+    parser.add_argument("--selectivity", type=float, default=0.001,
+                        help="fração alvo de voos que satisfaz cada consulta")
+    parser.add_argument("--start", default="2024-01-01", help="primeiro dia das partidas (YYYY-MM-DD)")
+    parser.add_argument("--days", type=int, default=365, help="dias cobertos pelas partidas")
+    parser.add_argument("--seed", type=int, default=42, help="semente do gerador")
+    return parser.parse_args()
+
+
+def airport_codes(count):
+    """Retorna `count` códigos de três letras, começando pelos aeroportos reais."""
+    codes = list(BASE_AIRPORTS[:count])
+    used = set(codes)
+    for letters in itertools.product(string.ascii_uppercase, repeat=3):
+        if len(codes) >= count:
+            break
+        code = "".join(letters)
+        if code not in used:
+            codes.append(code)
+    return np.array(codes)
+
+
+def zipf_weights(count, exponent):
+    """Pesos de Zipf normalizados para `count` itens (o primeiro é o mais popular)."""
+    weights = 1.0 / np.arange(1, count + 1) ** exponent
+    return weights / weights.sum()
+
+
+def generate_chunk(rng, size, codes, weights, coords, start_epoch, days):
+    """Gera um bloco de voos como arrays numpy (uma coluna por campo)."""
+    n_airports = len(codes)
+    origin = rng.choice(n_airports, size=size, p=weights)
+    destination = rng.choice(n_airports, size=size, p=weights)
+    same = destination == origin
+    while same.any():
+        destination[same] = rng.choice(n_airports, size=int(same.sum()), p=weights)
+        same = destination == origin
+
+    distance = np.linalg.norm(coords[origin] - coords[destination], axis=1)  # km
+    stops = np.minimum(rng.geometric(0.55, size=size) - 1, 3)
+    # ~800 km/h, 30 min de taxiamento e 45-150 min por parada.
+    duration = (distance / 800.0 * 3600 + 1800
+                + stops * rng.uniform(2700, 9000, size=size)
+                + rng.normal(0, 600, size=size)).clip(1800).astype(np.int64)
+    price = (40 + 0.11 * distance) * rng.lognormal(0.0, 0.35, size=size) * (1 - 0.08 * stops)
+    price = np.round(price.clip(29), 2)
+    seats = np.minimum(rng.poisson(3.0, size=size), 9)
+
+    # Partidas concentradas entre 6h e 22h, minutos múltiplos de 5.
+    day = rng.integers(0, days, size=size)
+    minute = np.round(rng.normal(14 * 60, 4 * 60, size=size).clip(5 * 60, 23 * 60 + 55) / 5) * 5
+    dep = start_epoch + day * 86400 + minute.astype(np.int64) * 60
+    arr = dep + duration
+    return origin, destination, price, seats, dep, arr, stops
+
+
+def format_times(epochs):
+    """Converte segundos desde a época para "YYYY-MM-DDTHH:MM:SS"."""
+    return np.datetime_as_string(epochs.astype("datetime64[s]"), unit="s")
+
+
+def write_flights(out, args, rng, codes, weights, coords, start_epoch):
+    """Grava os voos em blocos e retorna uma amostra uniforme para calibrar as consultas."""
+    sample = {key: np.empty(0) for key in ("origin", "destination", "price", "duration", "dep", "stops")}
+    written = 0
+    while written < args.flights:
+        size = min(CHUNK_SIZE, args.flights - written)
+        origin, destination, price, seats, dep, arr, stops = generate_chunk(
+            rng, size, codes, weights, coords, start_epoch, args.days)
+        dep_str = format_times(dep)
+        arr_str = format_times(arr)
+        org_str = codes[origin]
+        dst_str = codes[destination]
+        out.write("".join(
+            f"{o} {d} {p:g} {s} {ds} {as_} {st}\n"
+            for o, d, p, s, ds, as_, st in zip(org_str, dst_str, price.tolist(), seats.tolist(),
+                                               dep_str, arr_str, stops.tolist())))
+
+        # Amostra de Bernoulli com ~SAMPLE_SIZE voos no total.
+        keep = rng.random(size) < SAMPLE_SIZE / max(args.flights, 1)
+        chunk = {"origin": origin, "destination": destination, "price": price,
+                 "duration": arr - dep, "dep": dep, "stops": stops}
+        for key in sample:
+            sample[key] = np.concatenate([sample[key], chunk[key][keep]])
+        written += size
+        print(f"\r  {written}/{args.flights} voos", end="", flush=True)
+    print()
+    return sample
+
+
+def range_bounds(rng, sorted_values, selectivity):
+    """Escolhe um intervalo [low, high] que contém ~`selectivity` dos valores (já ordenados) da amostra."""
+    width = max(int(len(sorted_values) * selectivity), 1)
+    start = int(rng.integers(0, max(len(sorted_values) - width, 1)))
+    return sorted_values[start], sorted_values[min(start + width, len(sorted_values) - 1)]
+
+
+def generate_queries(rng, count, sample, codes, weights, selectivity):
+    """Gera `count` consultas cuja seletividade aproxima `selectivity`."""
+    prices = np.sort(sample["price"])
+    durations = np.sort(sample["duration"])
+    departures = np.sort(sample["dep"])
+    origin_share = np.bincount(sample["origin"].astype(int), minlength=len(codes)) / max(len(sample["origin"]), 1)
+    destination_share = (np.bincount(sample["destination"].astype(int), minlength=len(codes))
+                         / max(len(sample["destination"]), 1))
+    # Rotas cuja fração estimada (independência entre origem e destino) fica a até 2x do alvo.
+    route_share = np.outer(origin_share, destination_share)
+    np.fill_diagonal(route_share, 0)
+    ratio = np.abs(np.log((route_share + 1e-12) / selectivity))
+    route_candidates = np.argwhere(ratio <= np.log(2))
+    if len(route_candidates) == 0:
+        route_candidates = np.array([np.unravel_index(np.argmin(ratio), ratio.shape)])
+    kinds = ["price", "duration", "departure", "route", "route_price", "or", "not"]
+    for i in range(count):
+        kind = kinds[i % len(kinds)]
+        max_results = int(rng.choice([5, 10, 20, 50]))
+        criteria = CRITERIA[int(rng.integers(0, len(CRITERIA)))]
+        if kind == "price":
+            low, high = range_bounds(rng, prices, selectivity)
+            expr = f"((prc>={low:g})&&(prc<={high:g}))"
+        elif kind == "duration":
+            low, high = range_bounds(rng, durations, selectivity)
+            expr = f"((dur>={int(low)})&&(dur<={int(high)}))"
+        elif kind == "departure":
+            low, high = range_bounds(rng, departures, selectivity)
+            low_str, high_str = format_times(np.array([low, high], dtype=np.int64))
+            expr = f"((dep>={low_str})&&(dep<={high_str}))"
+        elif kind == "route":
+            origin, destination = route_candidates[int(rng.integers(0, len(route_candidates)))]
+            expr = f"((org=={codes[origin]})&&(dst=={codes[destination]}))"
+        elif kind == "route_price":
+            origin = int(rng.choice(len(codes), p=weights))
+            share = max(origin_share[origin], selectivity)
+            low, high = range_bounds(rng, prices, min(selectivity / share, 1.0))
+            expr = f"((org=={codes[origin]})&&(prc>={low:g})&&(prc<={high:g}))"
+        elif kind == "or":
+            low, high = range_bounds(rng, prices, selectivity / 2)
+            dlow, dhigh = range_bounds(rng, durations, selectivity / 2)
+            expr = f"(((prc>={low:g})&&(prc<={high:g}))||((dur>={int(dlow)})&&(dur<={int(dhigh)})))"
+        else:
+            low, high = range_bounds(rng, prices, selectivity)
+            stops = int(rng.integers(0, 4))
+            expr = f"((prc>={low:g})&&(prc<={high:g})&&(!(sto=={stops})))"
+        yield f"{max_results} {criteria} {expr}"
+
+
+def main():
+    args = parse_args()
+    rng = np.random.default_rng(args.seed)
+    codes = airport_codes(args.airports)
+    weights = zipf_weights(len(codes), args.zipf)
+    coords = rng.uniform(0, 4500, size=(len(codes), 2))  # posições em km num plano
+    start_epoch = int(datetime.datetime.strptime(args.start, "%Y-%m-%d")
+                      .replace(tzinfo=datetime.timezone.utc).timestamp())
+
+    print(f"Gerando {args.flights} voos em {args.out}...")
+    with open(args.out, "w", buffering=1 << 20) as out:
+        out.write(f"{args.flights}\n")
+        sample = write_flights(out, args, rng, codes, weights, coords, start_epoch)
+
+        if args.queries > 0:
+            print(f"Gerando {args.queries} consultas (seletividade ~{args.selectivity})...")
+            queries_file = open(args.queries_out, "w", buffering=1 << 20) if args.queries_out else None
+            out.write(f"{args.queries}\n")
+            if queries_file:
+                queries_file.write(f"{args.queries}\n")
+            for query in generate_queries(rng, args.queries, sample, codes, weights, args.selectivity):
+                out.write(query + "\n")
+                if queries_file:
+                    queries_file.write(query + "\n")
+            if queries_file:
+                queries_file.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -11,10 +11,6 @@
 using namespace std;
 using namespace std::chrono;
 
-int compareDoubles(const double &a, const double &b) {
-    return (a < b) ? -1 : (a > b) ? 1 : 0;
-}
-
 struct FlightData {
     string origin;
     string destination;
@@ -56,7 +52,7 @@ void runBenchmarks(const string &filename, int size) {
     vector<FlightData> sampleFlights(flights.begin(), flights.begin() + size);
 
     // Medindo inserção AVL
-    AVLTree<double> avlTree(compareDoubles);
+    AVLTree<double> avlTree;
     auto start_insert_avl = high_resolution_clock::now();
     for (auto &flight : sampleFlights) {
         avlTree.insert(flight.price, nullptr);
@@ -0,0 +1,638 @@
+#include "../include/BitmapIndex.hpp"
+#include <cstring>
+
+/**
+ * @brief Construtor: conjunto vazio.
+ */
+RoaringBitmap::RoaringBitmap() : containers(nullptr), containerCount(0), containerCapacity(0) {}
+
+/**
+ * @brief Destrutor: libera os contêineres.
+ */
+RoaringBitmap::~RoaringBitmap() {
+    for (int c = 0; c < containerCount; c++)
+        release(containers[c]);
+    delete[] containers;
+}
+
+/**
+ * @brief Retorna a posição do primeiro contêiner com bloco maior ou igual a block.
+ */
+int RoaringBitmap::findContainer(uint16_t block) const {
+    int low = 0, high = containerCount;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (containers[middle].block < block)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+/**
+ * @brief Abre um contêiner vazio (array) na posição index.
+ */
+void RoaringBitmap::insertContainer(int index, uint16_t block) {
+    if (containerCount == containerCapacity) {
+        int newCapacity = containerCapacity ? containerCapacity * 2 : 4;
+        Container* newContainers = new Container[newCapacity];
+        for (int c = 0; c < containerCount; c++)
+            newContainers[c] = containers[c];
+        delete[] containers;
+        containers = newContainers;
+        containerCapacity = newCapacity;
+    }
+    for (int c = containerCount; c > index; c--)
+        containers[c] = containers[c - 1];
+    Container &container = containers[index];
+    container.block = block;
+    container.cardinality = 0;
+    container.values = nullptr;
+    container.capacity = 0;
+    container.words = nullptr;
+    containerCount++;
+}
+
+/**
+ * @brief Remove os contêineres vazios.
+ */
+void RoaringBitmap::dropEmpty() {
+    int count = 0;
+    for (int c = 0; c < containerCount; c++) {
+        if (containers[c].cardinality == 0)
+            release(containers[c]);
+        else
+            containers[count++] = containers[c];
+    }
+    containerCount = count;
+}
+
+/**
+ * @brief Libera o conteúdo de um contêiner.
+ */
+void RoaringBitmap::release(Container &container) {
+    delete[] container.values;
+    delete[] container.words;
+    container.values = nullptr;
+    container.words = nullptr;
+    container.capacity = 0;
+}
+
+/**
+ * @brief Copia um contêiner (arrays e mapas são duplicados).
+ */
+void RoaringBitmap::copyContainer(Container &target, const Container &source) {
+    target.block = source.block;
+    target.cardinality = source.cardinality;
+    target.values = nullptr;
+    target.capacity = 0;
+    target.words = nullptr;
+    if (source.words) {
+        target.words = new uint64_t[BITMAP_WORDS];
+        memcpy(target.words, source.words, BITMAP_WORDS * sizeof(uint64_t));
+    } else {
+        target.capacity = source.cardinality > 0 ? source.cardinality : 1;
+        target.values = new uint16_t[target.capacity];
+        memcpy(target.values, source.values, source.cardinality * sizeof(uint16_t));
+    }
+}
+
+/**
+ * @brief Converte um array em mapa de bits.
+ */
+void RoaringBitmap::toBitmap(Container &container) {
+    uint64_t* words = new uint64_t[BITMAP_WORDS]();
+    for (int i = 0; i < container.cardinality; i++)
+        words[container.values[i] >> 6] |= uint64_t(1) << (container.values[i] & 63);
+    delete[] container.values;
+    container.values = nullptr;
+    container.capacity = 0;
+    container.words = words;
+}
+
+/**
+ * @brief Converte um mapa de bits em array.
+ */
+void RoaringBitmap::toArray(Container &container) {
+    int capacity = container.cardinality > 0 ? container.cardinality : 1;
+    uint16_t* values = new uint16_t[capacity];
+    int count = 0;
+    for (int w = 0; w < BITMAP_WORDS; w++) {
+        uint64_t word = container.words[w];
+        while (word) {
+            values[count++] = static_cast<uint16_t>(w * 64 + __builtin_ctzll(word));
+            word &= word - 1;
+        }
+    }
+    delete[] container.words;
+    container.words = nullptr;
+    container.values = values;
+    container.capacity = capacity;
+}
+
+/**
+ * @brief Escolhe a representação pela cardinalidade (mapa acima de ARRAY_LIMIT).
+ */
+void RoaringBitmap::normalize(Container &container) {
+    if (container.words && container.cardinality <= ARRAY_LIMIT)
+        toArray(container);
+    else if (!container.words && container.cardinality > ARRAY_LIMIT)
+        toBitmap(container);
+}
+
+/**
+ * @brief Garante espaço para capacity elementos no array de um contêiner.
+ */
+void RoaringBitmap::reserve(Container &container, int capacity) {
+    if (capacity <= container.capacity)
+        return;
+    int newCapacity = container.capacity * 2;
+    if (newCapacity < capacity)
+        newCapacity = capacity < 4 ? 4 : capacity;
+    uint16_t* values = new uint16_t[newCapacity];
+    if (container.cardinality > 0)
+        memcpy(values, container.values, container.cardinality * sizeof(uint16_t));
+    delete[] container.values;
+    container.values = values;
+    container.capacity = newCapacity;
+}
+
+/**
+ * @brief Posição do primeiro valor do array maior ou igual a value.
+ */
+static int lowerBound(const uint16_t* values, int count, uint16_t value) {
+    int low = 0, high = count;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (values[middle] < value)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+/**
+ * @brief Número de bits ligados em um mapa.
+ */
+static int countBits(const uint64_t* words, int wordCount) {
+    int count = 0;
+    for (int w = 0; w < wordCount; w++)
+        count += __builtin_popcountll(words[w]);
+    return count;
+}
+
+/**
+ * @brief Acrescenta um identificador.
+ */
+void RoaringBitmap::add(int id) {
+    uint16_t block = static_cast<uint16_t>(id >> 16);
+    uint16_t low = static_cast<uint16_t>(id & 0xFFFF);
+    int index = findContainer(block);
+    if (index == containerCount || containers[index].block != block)
+        insertContainer(index, block);
+    Container &container = containers[index];
+
+    if (container.words) {
+        uint64_t bit = uint64_t(1) << (low & 63);
+        if (!(container.words[low >> 6] & bit)) {
+            container.words[low >> 6] |= bit;
+            container.cardinality++;
+        }
+        return;
+    }
+    int position = container.cardinality;
+    if (position > 0 && container.values[position - 1] >= low) {
+        position = lowerBound(container.values, container.cardinality, low);
+        if (container.values[position] == low)
+            return;
+    }
+    reserve(container, container.cardinality + 1);
+    for (int i = container.cardinality; i > position; i--)
+        container.values[i] = container.values[i - 1];
+    container.values[position] = low;
+    container.cardinality++;
+    if (container.cardinality > ARRAY_LIMIT)
+        toBitmap(container);
+}
+
+/**
+ * @brief Remove um identificador.
+ *
+ * Um mapa só volta a array com metade de ARRAY_LIMIT, para que inserções e
+ * remoções alternadas na fronteira não convertam o contêiner a cada operação.
+ */
+bool RoaringBitmap::remove(int id) {
+    uint16_t block = static_cast<uint16_t>(id >> 16);
+    uint16_t low = static_cast<uint16_t>(id & 0xFFFF);
+    int index = findContainer(block);
+    if (index == containerCount || containers[index].block != block)
+        return false;
+    Container &container = containers[index];
+
+    if (container.words) {
+        uint64_t bit = uint64_t(1) << (low & 63);
+        if (!(container.words[low >> 6] & bit))
+            return false;
+        container.words[low >> 6] &= ~bit;
+        container.cardinality--;
+        if (container.cardinality <= ARRAY_LIMIT / 2)
+            toArray(container);
+    } else {
+        int position = lowerBound(container.values, container.cardinality, low);
+        if (position == container.cardinality || container.values[position] != low)
+            return false;
+        for (int i = position + 1; i < container.cardinality; i++)
+            container.values[i - 1] = container.values[i];
+        container.cardinality--;
+    }
+    if (container.cardinality == 0) {
+        release(container);
+        for (int c = index + 1; c < containerCount; c++)
+            containers[c - 1] = containers[c];
+        containerCount--;
+    }
+    return true;
+}
+
+/**
+ * @brief Verifica se um identificador está no conjunto.
+ */
+bool RoaringBitmap::contains(int id) const {
+    uint16_t block = static_cast<uint16_t>(id >> 16);
+    uint16_t low = static_cast<uint16_t>(id & 0xFFFF);
+    int index = findContainer(block);
+    if (index == containerCount || containers[index].block != block)
+        return false;
+    const Container &container = containers[index];
+    if (container.words)
+        return (container.words[low >> 6] >> (low & 63)) & 1;
+    int position = lowerBound(container.values, container.cardinality, low);
+    return position < container.cardinality && container.values[position] == low;
+}
+
+/**
+ * @brief Retorna o número de identificadores no conjunto.
+ */
+int RoaringBitmap::cardinality() const {
+    int count = 0;
+    for (int c = 0; c < containerCount; c++)
+        count += containers[c].cardinality;
+    return count;
+}
+
+/**
+ * @brief Substitui o conteúdo por uma cópia de other.
+ */
+void RoaringBitmap::copyFrom(const RoaringBitmap &other) {
+    if (&other == this)
+        return;
+    for (int c = 0; c < containerCount; c++)
+        release(containers[c]);
+    delete[] containers;
+    containerCapacity = other.containerCount > 4 ? other.containerCount : 4;
+    containers = new Container[containerCapacity];
+    containerCount = other.containerCount;
+    for (int c = 0; c < containerCount; c++)
+        copyContainer(containers[c], other.containers[c]);
+}
+
+/**
+ * @brief Interseção de dois contêineres do mesmo bloco, em target.
+ */
+void RoaringBitmap::intersect(Container &target, const Container &other) {
+    if (target.words && other.words) {
+        for (int w = 0; w < BITMAP_WORDS; w++)
+            target.words[w] &= other.words[w];
+        target.cardinality = countBits(target.words, BITMAP_WORDS);
+        normalize(target);
+    } else if (target.words) {
+        int capacity = other.cardinality > 0 ? other.cardinality : 1;
+        uint16_t* values = new uint16_t[capacity];
+        int count = 0;
+        for (int i = 0; i < other.cardinality; i++) {
+            uint16_t value = other.values[i];
+            if ((target.words[value >> 6] >> (value & 63)) & 1)
+                values[count++] = value;
+        }
+        delete[] target.words;
+        target.words = nullptr;
+        target.values = values;
+        target.capacity = capacity;
+        target.cardinality = count;
+    } else if (other.words) {
+        int count = 0;
+        for (int i = 0; i < target.cardinality; i++) {
+            uint16_t value = target.values[i];
+            if ((other.words[value >> 6] >> (value & 63)) & 1)
+                target.values[count++] = value;
+        }
+        target.cardinality = count;
+    } else {
+        int count = 0, j = 0;
+        for (int i = 0; i < target.cardinality && j < other.cardinality; ) {
+            if (target.values[i] < other.values[j]) {
+                i++;
+            } else if (other.values[j] < target.values[i]) {
+                j++;
+            } else {
+                target.values[count++] = target.values[i];
+                i++;
+                j++;
+            }
+        }
+        target.cardinality = count;
+    }
+}
+
+/**
+ * @brief União de dois contêineres do mesmo bloco, em target.
+ */
+void RoaringBitmap::unite(Container &target, const Container &other) {
+    if (target.words && other.words) {
+        for (int w = 0; w < BITMAP_WORDS; w++)
+            target.words[w] |= other.words[w];
+        target.cardinality = countBits(target.words, BITMAP_WORDS);
+    } else if (target.words) {
+        for (int i = 0; i < other.cardinality; i++) {
+            uint16_t value = other.values[i];
+            uint64_t bit = uint64_t(1) << (value & 63);
+            if (!(target.words[value >> 6] & bit)) {
+                target.words[value >> 6] |= bit;
+                target.cardinality++;
+            }
+        }
+    } else if (other.words) {
+        uint64_t* words = new uint64_t[BITMAP_WORDS];
+        memcpy(words, other.words, BITMAP_WORDS * sizeof(uint64_t));
+        for (int i = 0; i < target.cardinality; i++)
+            words[target.values[i] >> 6] |= uint64_t(1) << (target.values[i] & 63);
+        delete[] target.values;
+        target.values = nullptr;
+        target.capacity = 0;
+        target.words = words;
+        target.cardinality = countBits(words, BITMAP_WORDS);
+    } else {
+        int capacity = target.cardinality + other.cardinality;
+        uint16_t* values = new uint16_t[capacity > 0 ? capacity : 1];
+        int count = 0, i = 0, j = 0;
+        while (i < target.cardinality || j < other.cardinality) {
+            if (j == other.cardinality || (i < target.cardinality && target.values[i] < other.values[j])) {
+                values[count++] = target.values[i++];
+            } else if (i == target.cardinality || other.values[j] < target.values[i]) {
+                values[count++] = other.values[j++];
+            } else {
+                values[count++] = target.values[i++];
+                j++;
+            }
+        }
+        delete[] target.values;
+        target.values = values;
+        target.capacity = capacity > 0 ? capacity : 1;
+        target.cardinality = count;
+        normalize(target);
+    }
+}
+
+/**
+ * @brief Diferença de dois contêineres do mesmo bloco, em target.
+ */
+void RoaringBitmap::subtract(Container &target, const Container &other) {
+    if (target.words && other.words) {
+        for (int w = 0; w < BITMAP_WORDS; w++)
+            target.words[w] &= ~other.words[w];
+        target.cardinality = countBits(target.words, BITMAP_WORDS);
+        normalize(target);
+    } else if (target.words) {
+        for (int i = 0; i < other.cardinality; i++) {
+            uint16_t value = other.values[i];
+            uint64_t bit = uint64_t(1) << (value & 63);
+            if (target.words[value >> 6] & bit) {
+                target.words[value >> 6] &= ~bit;
+                target.cardinality--;
+            }
+        }
+        normalize(target);
+    } else if (other.words) {
+        int count = 0;
+        for (int i = 0; i < target.cardinality; i++) {
+            uint16_t value = target.values[i];
+            if (!((other.words[value >> 6] >> (value & 63)) & 1))
+                target.values[count++] = value;
+        }
+        target.cardinality = count;
+    } else {
+        int count = 0, j = 0;
+        for (int i = 0; i < target.cardinality; i++) {
+            while (j < other.cardinality && other.values[j] < target.values[i])
+                j++;
+            if (j == other.cardinality || other.values[j] != target.values[i])
+                target.values[count++] = target.values[i];
+        }
+        target.cardinality = count;
+    }
+}
+
+/**
+ * @brief Interseção com other, no lugar.
+ */
+void RoaringBitmap::andWith(const RoaringBitmap &other) {
+    int j = 0;
+    for (int c = 0; c < containerCount; c++) {
+        while (j < other.containerCount && other.containers[j].block < containers[c].block)
+            j++;
+        if (j < other.containerCount && other.containers[j].block == containers[c].block)
+            intersect(containers[c], other.containers[j]);
+        else
+            containers[c].cardinality = 0;
+    }
+    dropEmpty();
+}
+
+/**
+ * @brief União com other, no lugar.
+ *
+ * Os contêineres dos dois lados são intercalados em um array novo; os de
+ * this são movidos, e os que só existem em other, copiados.
+ */
+void RoaringBitmap::orWith(const RoaringBitmap &other) {
+    if (&other == this || other.containerCount == 0)
+        return;
+    int capacity = containerCount + other.containerCount;
+    Container* merged = new Container[capacity];
+    int count = 0, i = 0, j = 0;
+    while (i < containerCount || j < other.containerCount) {
+        if (j == other.containerCount || (i < containerCount && containers[i].block < other.containers[j].block)) {
+            merged[count++] = containers[i++];
+        } else if (i == containerCount || other.containers[j].block < containers[i].block) {
+            copyContainer(merged[count++], other.containers[j++]);
+        } else {
+            unite(containers[i], other.containers[j++]);
+            merged[count++] = containers[i++];
+        }
+    }
+    delete[] containers;
+    containers = merged;
+    containerCount = count;
+    containerCapacity = capacity;
+}
+
+/**
+ * @brief Diferença (this AND NOT other), no lugar.
+ */
+void RoaringBitmap::andNotWith(const RoaringBitmap &other) {
+    if (&other == this) {
+        for (int c = 0; c < containerCount; c++)
+            containers[c].cardinality = 0;
+        dropEmpty();
+        return;
+    }
+    int j = 0;
+    for (int c = 0; c < containerCount; c++) {
+        while (j < other.containerCount && other.containers[j].block < containers[c].block)
+            j++;
+        if (j < other.containerCount && other.containers[j].block == containers[c].block)
+            subtract(containers[c], other.containers[j]);
+    }
+    dropEmpty();
+}
+
+/**
+ * @brief Construtor: índice vazio.
+ */
+BitmapIndex::BitmapIndex() : keys(nullptr), bitmaps(nullptr), keyCount(0), keyCapacity(0) {}
+
+/**
+ * @brief Destrutor: libera os bitmaps.
+ */
+BitmapIndex::~BitmapIndex() {
+    for (int i = 0; i < keyCount; i++)
+        delete bitmaps[i];
+    delete[] keys;
+    delete[] bitmaps;
+}
+
+/**
+ * @brief Acrescenta a memória do bitmap ao relatório.
+ *
+ * objects conta os identificadores; cada contêiner é um bloco próprio (array
+ * de 16 bits ou mapa de 8 KB).
+ */
+void RoaringBitmap::reportMemory(MemoryReport &report, const string &name) const {
+    report.addArray(name, 0, containerCapacity, sizeof(Container));
+    for (int c = 0; c < containerCount; c++) {
+        const Container &container = containers[c];
+        if (container.words)
+            report.addArray(name, container.cardinality, BITMAP_WORDS, sizeof(uint64_t));
+        else
+            report.addArray(name, container.cardinality, container.capacity, sizeof(uint16_t));
+    }
+}
+
+/**
+ * @brief Retorna a posição da primeira chave maior ou igual a key.
+ */
+int BitmapIndex::findKey(long long key) const {
+    int low = 0, high = keyCount;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (keys[middle] < key)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+/**
+ * @brief Acrescenta um voo à chave.
+ */
+void BitmapIndex::insert(long long key, int id) {
+    int index = findKey(key);
+    if (index == keyCount || keys[index] != key) {
+        if (keyCount == keyCapacity) {
+            int newCapacity = keyCapacity ? keyCapacity * 2 : 8;
+            long long* newKeys = new long long[newCapacity];
+            RoaringBitmap** newBitmaps = new RoaringBitmap*[newCapacity];
+            for (int i = 0; i < keyCount; i++) {
+                newKeys[i] = keys[i];
+                newBitmaps[i] = bitmaps[i];
+            }
+            delete[] keys;
+            delete[] bitmaps;
+            keys = newKeys;
+            bitmaps = newBitmaps;
+            keyCapacity = newCapacity;
+        }
+        for (int i = keyCount; i > index; i--) {
+            keys[i] = keys[i - 1];
+            bitmaps[i] = bitmaps[i - 1];
+        }
+        keys[index] = key;
+        bitmaps[index] = new RoaringBitmap();
+        keyCount++;
+    }
+    bitmaps[index]->add(id);
+}
+
+/**
+ * @brief Remove um voo da chave.
+ */
+bool BitmapIndex::remove(long long key, int id) {
+    int index = findKey(key);
+    if (index == keyCount || keys[index] != key)
+        return false;
+    bool removed = bitmaps[index]->remove(id);
+    if (bitmaps[index]->cardinality() == 0) {
+        delete bitmaps[index];
+        for (int i = index + 1; i < keyCount; i++) {
+            keys[i - 1] = keys[i];
+            bitmaps[i - 1] = bitmaps[i];
+        }
+        keyCount--;
+    }
+    return removed;
+}
+
+/**
+ * @brief Retorna os voos com chave que satisfaz "chave op value".
+ *
+ * As chaves são poucas, então todas são comparadas; os bitmaps das que
+ * satisfazem o operador são unidos.
+ */
+RoaringBitmap* BitmapIndex::select(PredicateExpr::CompOp op, long long value) const {
+    RoaringBitmap* result = new RoaringBitmap();
+    bool empty = true;
+    for (int i = 0; i < keyCount; i++) {
+        bool match;
+        switch (op) {
+            case PredicateExpr::EQ: match = keys[i] == value; break;
+            case PredicateExpr::NE: match = keys[i] != value; break;
+            case PredicateExpr::LT: match = keys[i] < value; break;
+            case PredicateExpr::LE: match = keys[i] <= value; break;
+            case PredicateExpr::GT: match = keys[i] > value; break;
+            default: match = keys[i] >= value; break;
+        }
+        if (!match)
+            continue;
+        if (empty)
+            result->copyFrom(*bitmaps[i]);
+        else
+            result->orWith(*bitmaps[i]);
+        empty = false;
+    }
+    return result;
+}
+
+/**
+ * @brief Acrescenta a memória do índice ao relatório (chaves e bitmaps de todas as chaves).
+ */
+void BitmapIndex::reportMemory(MemoryReport &report, const string &name) const {
+    report.addArray(name, 0, keyCapacity, sizeof(long long));
+    report.addArray(name, 0, keyCapacity, sizeof(RoaringBitmap*));
+    for (int i = 0; i < keyCount; i++) {
+        report.add(name, 0, sizeof(RoaringBitmap), MemoryReport::chunkBytes(sizeof(RoaringBitmap)));
+        bitmaps[i]->reportMemory(report, name);
+    }
+}
@@ -26,4 +26,140 @@ time_t parseDateTime(const char* dateTimeStr) {
     timeStruct.tm_isdst = 0;
     
     return timegm(&timeStruct);
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Escreve um número com width dígitos, completando com zeros à esquerda.
+ */
+static char* writeDigits(char* out, long long value, int width) {
+    for (int i = width - 1; i >= 0; i--) {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return out + width;
+}
+
+/**
+ * @brief Calcula a data civil a partir do número de dias desde 1970-01-01.
+ *
+ * Algoritmo "civil_from_days" de Howard Hinnant, sem gmtime.
+ */
+static void civilFromDays(long long days, long long &year, long long &month, long long &day) {
+    days += 719468;
+    long long era = (days >= 0 ? days : days - 146096) / 146097;
+    long long dayOfEra = days - era * 146097;
+    long long yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    long long dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    long long shiftedMonth = (5 * dayOfYear + 2) / 153;
+    day = dayOfYear - (153 * shiftedMonth + 2) / 5 + 1;
+    month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9;
+    year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+}
+
+/**
+ * @brief Escreve um time_t (UTC) no formato "YYYY-MM-DDTHH:MM:SS".
+ *
+ * A data civil vem de civilFromDays(), sem gmtime/strftime.
+ */
+void formatDateTime(time_t value, char* buffer) {
+    long long seconds = static_cast<long long>(value);
+    long long days = seconds / 86400;
+    long long secondOfDay = seconds % 86400;
+    if (secondOfDay < 0) {
+        secondOfDay += 86400;
+        days--;
+    }
+
+    long long year, month, day;
+    civilFromDays(days, year, month, day);
+
+    char* out = writeDigits(buffer, year, 4);
+    *out++ = '-';
+    out = writeDigits(out, month, 2);
+    *out++ = '-';
+    out = writeDigits(out, day, 2);
+    *out++ = 'T';
+    out = writeDigits(out, secondOfDay / 3600, 2);
+    *out++ = ':';
+    out = writeDigits(out, secondOfDay / 60 % 60, 2);
+    *out++ = ':';
+    out = writeDigits(out, secondOfDay % 60, 2);
+    *out = '\0';
+}
+
+/**
+ * @brief Lê de 1 a maxDigits dígitos decimais.
+ * @return Posição depois dos dígitos, ou nullptr se não há dígito.
+ */
+static const char* readDigits(const char* text, int maxDigits, int &value) {
+    value = 0;
+    int digits = 0;
+    while (digits < maxDigits && isdigit(static_cast<unsigned char>(text[digits]))) {
+        value = value * 10 + (text[digits] - '0');
+        digits++;
+    }
+    return digits > 0 ? text + digits : nullptr;
+}
+
+/**
+ * @brief Retorna o número de dias de um mês (1 a 12) no calendário gregoriano.
+ */
+static int daysInMonth(int year, int month) {
+    static const int DAYS[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    return month == 2 && leap ? 29 : DAYS[month - 1];
+}
+
+/**
+ * @brief Converte e valida uma data/hora "YYYY-MM-DDTHH:MM:SS".
+ *
+ * Cada campo é lido com seu separador; os milissegundos opcionais são
+ * pulados. Os intervalos são verificados antes de timegm(), que normalizaria
+ * um campo fora do intervalo em outra data.
+ */
+bool parseDateTimeChecked(const char* text, time_t &value) {
+    static const char SEPARATORS[] = "--T::";
+    static const int MAX_DIGITS[6] = { 4, 2, 2, 2, 2, 2 };
+    int fields[6];
+    const char* position = text;
+    for (int i = 0; i < 6; i++) {
+        position = readDigits(position, MAX_DIGITS[i], fields[i]);
+        if (!position || (i < 5 && *position++ != SEPARATORS[i]))
+            return false;
+    }
+    if (*position == '.') {
+        int fraction;
+        position = readDigits(position + 1, 9, fraction);
+        if (!position)
+            return false;
+    }
+    if (*position != '\0')
+        return false;
+
+    int year = fields[0], month = fields[1], day = fields[2];
+    if (month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month)
+        || fields[3] > 23 || fields[4] > 59 || fields[5] > 59)
+        return false;
+
+    struct tm timeStruct;
+    timeStruct.tm_year = year - 1900;
+    timeStruct.tm_mon = month - 1;
+    timeStruct.tm_mday = day;
+    timeStruct.tm_hour = fields[3];
+    timeStruct.tm_min = fields[4];
+    timeStruct.tm_sec = fields[5];
+    timeStruct.tm_isdst = 0;
+    value = timegm(&timeStruct);
+    return true;
+}
+
+/**
+ * @brief Retorna o mês (UTC) de um time_t como ano * 12 + mês - 1.
+ */
+long long monthIndex(time_t value) {
+    long long seconds = static_cast<long long>(value);
+    long long days = seconds / 86400 - (seconds % 86400 < 0 ? 1 : 0);
+    long long year, month, day;
+    civilFromDays(days, year, month, day);
+    return year * 12 + month - 1;
+}
@@ -0,0 +1,887 @@
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <random>
+#include <string>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <climits>
+#include "../include/Flight.hpp"
+#include "../include/DateTime.hpp"
+#include "../include/FlightManager.hpp"
+#include "../include/PartitionedStore.hpp"
+#include "../include/Parser.hpp"
+#include "../include/QueryExecutor.hpp"
+#include "../include/PreparedQuery.hpp"
+#include "../include/ItinerarySearch.hpp"
+#include "../include/Aggregate.hpp"
+#include "../include/Sort.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+/**
+ * @brief Aeroportos dos voos gerados (poucos, para que origem e destino tenham índice de bitmap).
+ */
+static const char* AIRPORTS[] = { "ATL", "BOS", "DFW", "JFK", "LAX", "MIA", "ORD", "SFO" };
+static const int AIRPORT_COUNT = 8;
+
+/**
+ * @brief Templates preparados exercitados pelo comando exec (um "?" por parâmetro).
+ */
+static const char* TEMPLATES[] = {
+    "((org==?)&&(dst==?)&&(dep>=?))",
+    "((prc>=?)&&(prc<=?)&&(sto==?))",
+    "((sea>=?)||(dur<?))",
+};
+static const int TEMPLATE_COUNT = 3;
+
+/**
+ * @brief Início das partidas geradas (2024-01-01T00:00:00) e a faixa coberta, em segundos (14 meses).
+ */
+static const time_t FIRST_DEPARTURE = 1704067200;
+static const int DEPARTURE_SPAN = 14 * 30 * 86400;
+
+/**
+ * @brief Motor de referência: os voos em um vetor indexado pelo identificador, sem índices.
+ *
+ * Cada consulta é uma varredura completa avaliando a expressão em todos os
+ * voos ativos, seguida de std::stable_sort pelos critérios (empates na ordem
+ * dos identificadores). Não compartilha nada com os caminhos otimizados além
+ * da avaliação de predicados (Expr::evaluate) e da comparação pelos critérios.
+ */
+struct ReferenceStore {
+    vector<Flight> flights;  ///< Voo de cada identificador.
+    vector<bool> active;     ///< Se o voo de cada identificador existe.
+
+    int insertFlight(const Flight &flight) {
+        flights.push_back(flight);
+        flights.back().id = static_cast<int>(flights.size()) - 1;
+        active.push_back(true);
+        return flights.back().id;
+    }
+
+    bool exists(int id) const {
+        return id >= 0 && id < static_cast<int>(flights.size()) && active[id];
+    }
+};
+
+/**
+ * @brief Ordem do motor de referência: critérios e, nos empates, o identificador.
+ */
+struct ReferenceLess {
+    const string* criteria;
+
+    bool operator()(const Flight* a, const Flight* b) const {
+        int result = compareFlightByCriteria(a, b, *criteria);
+        return result != 0 ? result < 0 : a->id < b->id;
+    }
+};
+
+/**
+ * @brief Tempos acumulados de um caminho de acesso (otimizado vs. referência).
+ */
+struct PathStats {
+    int queries;
+    double optimizedUs;
+    double naiveUs;
+
+    PathStats() : queries(0), optimizedUs(0), naiveUs(0) {}
+};
+
+/**
+ * @brief Estado de uma rodada: motores, geradores e contadores de divergências.
+ */
+struct Round {
+    unsigned seed;
+    mt19937 rng;
+    ReferenceStore reference;
+    FlightManager* flightManager;
+    PartitionedStore* partitionedStore;
+    map<string, PathStats>* stats;
+    int mismatches;
+    int checks;
+
+    explicit Round(unsigned roundSeed) : seed(roundSeed), rng(roundSeed), flightManager(nullptr),
+                                         partitionedStore(nullptr), stats(nullptr), mismatches(0), checks(0) {}
+};
+
+/**
+ * @brief Microssegundos decorridos desde start.
+ */
+static double elapsedUs(const steady_clock::time_point &start) {
+    return duration<double, micro>(steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Formata um time_t no formato das consultas.
+ */
+static string timeText(time_t value) {
+    char buffer[DATETIME_LENGTH + 1];
+    formatDateTime(value, buffer);
+    return buffer;
+}
+
+/**
+ * @brief Descreve um voo em uma linha, no formato da entrada.
+ */
+static string flightText(const Flight &f) {
+    char origin[4], destination[4];
+    decodeAirportCode(f.origin, origin);
+    decodeAirportCode(f.destination, destination);
+    ostringstream out;
+    out << origin << " " << destination << " " << f.price << " " << f.seats << " " << timeText(f.dep_time)
+        << " " << timeText(f.arr_time) << " " << f.stops;
+    return out.str();
+}
+
+/**
+ * @brief Gera um voo: preços em centavos com muitos empates, poucas paradas e 14 meses de partidas.
+ */
+static Flight randomFlight(mt19937 &rng) {
+    static const int DURATIONS[] = { 1800, 3600, 5400, 7200, 10800, 21600, 36000 };
+    Flight flight;
+    flight.origin = encodeAirportCode(AIRPORTS[rng() % AIRPORT_COUNT], 3);
+    do {
+        flight.destination = encodeAirportCode(AIRPORTS[rng() % AIRPORT_COUNT], 3);
+    } while (flight.destination == flight.origin);
+    flight.price = rng() % 4 ? (50 + rng() % 20) * 25 : (5000 + rng() % 150000) / 100.0;
+    flight.seats = rng() % 301;
+    flight.stops = rng() % 4;
+    flight.dep_time = FIRST_DEPARTURE + static_cast<time_t>(rng() % (DEPARTURE_SPAN / 60)) * 60;
+    flight.duration = DURATIONS[rng() % 7] + (rng() % 3 == 0 ? static_cast<int>(rng() % 120) * 60 : 0);
+    flight.arr_time = flight.dep_time + flight.duration;
+    flight.id = -1;
+    return flight;
+}
+
+/**
+ * @brief Retorna um voo qualquer já gerado (ativo ou não), fonte das constantes das consultas.
+ */
+static const Flight& sampleFlight(Round &round) {
+    return round.reference.flights[round.rng() % round.reference.flights.size()];
+}
+
+/**
+ * @brief Valor de um campo de um voo no formato das consultas.
+ */
+static string fieldValueText(IndexField field, const Flight &f) {
+    char code[4];
+    ostringstream out;
+    switch (field) {
+        case INDEX_ORIGIN: decodeAirportCode(f.origin, code); return code;
+        case INDEX_DESTINATION: decodeAirportCode(f.destination, code); return code;
+        case INDEX_PRICE: out << f.price; break;
+        case INDEX_DURATION: out << f.duration; break;
+        case INDEX_STOPS: out << f.stops; break;
+        case INDEX_SEATS: out << f.seats; break;
+        case INDEX_DEPARTURE: return timeText(f.dep_time);
+        default: return timeText(f.arr_time);
+    }
+    return out.str();
+}
+
+/**
+ * @brief Gera um predicado com a constante de um voo real (para acertar igualdades e limites).
+ */
+static string randomPredicate(Round &round) {
+    static const char* OPERATORS[] = { "==", "!=", "<", "<=", ">", ">=" };
+    IndexField field = static_cast<IndexField>(round.rng() % INDEX_COUNT);
+    return "(" + string(fieldName(field)) + OPERATORS[round.rng() % 6] + fieldValueText(field, sampleFlight(round)) + ")";
+}
+
+/**
+ * @brief Gera um intervalo fechado ou semiaberto sobre um campo ordenado.
+ */
+static string randomRange(Round &round) {
+    static const IndexField FIELDS[] = { INDEX_PRICE, INDEX_DURATION, INDEX_SEATS, INDEX_DEPARTURE, INDEX_ARRIVAL };
+    IndexField field = FIELDS[round.rng() % 5];
+    string low = fieldValueText(field, sampleFlight(round));
+    string high = fieldValueText(field, sampleFlight(round));
+    if (field == INDEX_DEPARTURE || field == INDEX_ARRIVAL ? low > high : atof(low.c_str()) > atof(high.c_str()))
+        swap(low, high);
+    string name = fieldName(field);
+    return "(" + name + (round.rng() % 2 ? ">=" : ">") + low + ")&&(" + name + (round.rng() % 2 ? "<=" : "<") + high + ")";
+}
+
+/**
+ * @brief Gera uma subexpressão com AND, OR e NOT até a profundidade depth.
+ */
+static string randomExpression(Round &round, int depth) {
+    int choice = round.rng() % 10;
+    if (depth >= 2 || choice < 5)
+        return randomPredicate(round);
+    if (choice < 6)
+        return "!(" + randomExpression(round, depth + 1) + ")";
+    const char* op = choice < 8 ? "&&" : "||";
+    int operandCount = 2 + round.rng() % 2;
+    string expression = "(";
+    for (int i = 0; i < operandCount; i++)
+        expression += (i ? op : "") + randomExpression(round, depth + 1);
+    return expression + ")";
+}
+
+/**
+ * @brief Gera a expressão de uma consulta: uma conjunção de intervalos, igualdades e subexpressões.
+ *
+ * As formas favorecem cada caminho: intervalos (índices e árvore k-d),
+ * igualdades de aeroportos e paradas (bitmaps) e OR/NOT/!= (bitmaps e varredura).
+ */
+static string randomQueryExpression(Round &round) {
+    vector<string> operands;
+    int shape = round.rng() % 4;
+    if (shape == 0 || round.rng() % 3 == 0)
+        operands.push_back(randomRange(round));
+    if (shape == 1) {
+        operands.push_back(randomRange(round));
+        operands.push_back(randomRange(round));
+    }
+    if (shape == 2) {
+        const Flight &f = sampleFlight(round);
+        operands.push_back("(org==" + fieldValueText(INDEX_ORIGIN, f) + ")");
+        if (round.rng() % 2)
+            operands.push_back("(dst!=" + fieldValueText(INDEX_DESTINATION, sampleFlight(round)) + ")");
+        operands.push_back("(sto" + string(round.rng() % 2 ? "==" : "<=") + fieldValueText(INDEX_STOPS, f) + ")");
+    }
+    if (shape == 3 || operands.empty() || round.rng() % 2)
+        operands.push_back(randomExpression(round, 0));
+    string expression = "(";
+    for (size_t i = 0; i < operands.size(); i++)
+        expression += (i ? "&&" : "") + operands[i];
+    return expression + ")";
+}
+
+/**
+ * @brief Executa uma consulta no motor de referência: varredura completa e ordenação estável.
+ */
+static vector<Flight*> naiveQuery(ReferenceStore &reference, const Expr* expression, const string &sortCriteria) {
+    vector<Flight*> result;
+    for (size_t id = 0; id < reference.flights.size(); id++)
+        if (reference.active[id] && expression->evaluate(reference.flights[id]))
+            result.push_back(&reference.flights[id]);
+    ReferenceLess less = { &sortCriteria };
+    stable_sort(result.begin(), result.end(), less);
+    return result;
+}
+
+/**
+ * @brief Ordem total pelos dados do voo (sem o identificador), para comparar grupos de empate.
+ */
+static bool contentLess(const Flight* a, const Flight* b) {
+    if (a->price != b->price) return a->price < b->price;
+    if (a->dep_time != b->dep_time) return a->dep_time < b->dep_time;
+    if (a->arr_time != b->arr_time) return a->arr_time < b->arr_time;
+    if (a->seats != b->seats) return a->seats < b->seats;
+    if (a->stops != b->stops) return a->stops < b->stops;
+    if (a->origin != b->origin) return a->origin < b->origin;
+    return a->destination < b->destination;
+}
+
+/**
+ * @brief Compara os primeiros limit voos de um resultado otimizado com os da referência.
+ *
+ * A sequência de chaves (critérios) deve ser a mesma. Dentro de um grupo de
+ * voos empatados nos critérios a ordem é livre: cada grupo inteiro deve ter os
+ * mesmos voos, e o último grupo, cortado pelo limite, deve ser parte do grupo
+ * da referência.
+ *
+ * @return Descrição da primeira divergência, ou "" se os resultados batem.
+ */
+static string compareResults(Flight** optimized, int optimizedCount, const vector<Flight*> &expected,
+                             int limit, const string &sortCriteria) {
+    int expectedCount = static_cast<int>(expected.size());
+    int shown = min(limit, expectedCount);
+    if (min(limit, optimizedCount) != shown) {
+        ostringstream out;
+        out << optimizedCount << " resultados, esperados " << expectedCount;
+        return out.str();
+    }
+    for (int start = 0; start < shown; ) {
+        int end = start + 1;
+        while (end < expectedCount && compareFlightByCriteria(expected[end], expected[start], sortCriteria) == 0)
+            end++;
+        int groupEnd = min(end, shown);
+        vector<const Flight*> got(optimized + start, optimized + groupEnd);
+        vector<const Flight*> want(expected.begin() + start, expected.begin() + end);
+        for (size_t i = 0; i < got.size(); i++)
+            if (compareFlightByCriteria(got[i], want[0], sortCriteria) != 0)
+                return "ordem diferente na posição " + to_string(start + i) + ": " + flightText(*got[i])
+                       + " no lugar de " + flightText(*want[0]);
+        sort(got.begin(), got.end(), contentLess);
+        sort(want.begin(), want.end(), contentLess);
+        size_t w = 0;
+        for (size_t g = 0; g < got.size(); g++) {
+            while (w < want.size() && contentLess(want[w], got[g]))
+                w++;
+            if (w == want.size() || contentLess(got[g], want[w]))
+                return "voo inesperado " + flightText(*got[g]);
+            w++;
+        }
+        if (groupEnd == end && got.size() != want.size())
+            return "grupo de empate incompleto na posição " + to_string(start);
+        start = end;
+    }
+    return "";
+}
+
+/**
+ * @brief Categoria de um caminho de acesso no relatório: o nome antes dos parênteses.
+ */
+static string pathCategory(const string &accessPath) {
+    size_t paren = accessPath.find('(');
+    string category = accessPath.substr(0, paren);
+    if (category == "index") {
+        size_t end = accessPath.find_first_of("=!<>", paren);
+        category += "(" + accessPath.substr(paren + 1, end - paren - 1) + ")";
+    }
+    return category;
+}
+
+/**
+ * @brief Registra uma divergência com o necessário para reproduzi-la.
+ */
+static void reportMismatch(Round &round, int command, const string &engine, const string &text, const string &why) {
+    round.mismatches++;
+    if (round.mismatches <= 10)
+        cerr << "DIVERGÊNCIA seed=" << round.seed << " comando=" << command << " motor=" << engine << ": " << text
+             << "\n  " << why << endl;
+}
+
+/**
+ * @brief Executa uma consulta nos motores otimizados e na referência e compara os resultados.
+ */
+static void checkQuery(Round &round, int command) {
+    static const char* CRITERIA[] = { "pds", "dps", "spd", "psd", "p", "d", "s", "sd" };
+    string sortCriteria = CRITERIA[round.rng() % 8];
+    int maxResults = round.rng() % 3 ? 1 + round.rng() % 20 : 1 + round.rng() % 2000;
+    string text = randomQueryExpression(round);
+
+    ExprArena referenceArena, singleArena, partitionedArena;
+    Parser referenceParser(text, referenceArena);
+    Expr* referenceExpression = referenceParser.parseExpression();
+    steady_clock::time_point start = steady_clock::now();
+    vector<Flight*> expected = naiveQuery(round.reference, referenceExpression, sortCriteria);
+    double naiveUs = elapsedUs(start);
+
+    QueryProfile profile;
+    Parser singleParser(text, singleArena);
+    Expr* expression = singleParser.parseExpression();
+    int resultCount = 0;
+    start = steady_clock::now();
+    Flight** resultFlights = executeQuery(*round.flightManager, expression, sortCriteria, resultCount, &profile);
+    double optimizedUs = elapsedUs(start);
+    string why = compareResults(resultFlights, resultCount, expected, maxResults, sortCriteria);
+    if (!why.empty())
+        reportMismatch(round, command, profile.accessPath, text + " " + sortCriteria, why);
+    delete[] resultFlights;
+    PathStats &stats = (*round.stats)[pathCategory(profile.accessPath)];
+    stats.queries++;
+    stats.optimizedUs += optimizedUs;
+    stats.naiveUs += naiveUs;
+
+    if (round.partitionedStore) {
+        Parser partitionedParser(text, partitionedArena);
+        expression = partitionedParser.parseExpression();
+        start = steady_clock::now();
+        resultFlights = round.partitionedStore->executeQuery(expression, sortCriteria, maxResults, resultCount);
+        optimizedUs = elapsedUs(start);
+        why = compareResults(resultFlights, resultCount, expected, maxResults, sortCriteria);
+        if (!why.empty())
+            reportMismatch(round, command, "partitions", text + " " + sortCriteria, why);
+        delete[] resultFlights;
+        PathStats &partitionStats = (*round.stats)["partitions"];
+        partitionStats.queries++;
+        partitionStats.optimizedUs += optimizedUs;
+        partitionStats.naiveUs += naiveUs;
+    }
+    round.checks++;
+}
+
+/**
+ * @brief Nome de uma função de agregação, para as mensagens.
+ */
+static string aggregateText(AggregateFunction function, IndexField field) {
+    static const char* NAMES[] = { "count", "min", "max", "sum", "avg" };
+    return function == AGG_COUNT ? "count" : string(NAMES[function]) + " " + fieldName(field);
+}
+
+/**
+ * @brief Compara um agregado otimizado com o da referência (somas com tolerância relativa).
+ */
+static string compareAggregates(const AggregateResult &got, const AggregateResult &want) {
+    ostringstream out;
+    if (got.count != want.count)
+        out << "count " << got.count << ", esperado " << want.count;
+    else if (fabs(got.sum - want.sum) > 1e-9 * max(1.0, fabs(want.sum)))
+        out << "sum " << got.sum << ", esperado " << want.sum;
+    else if (want.count > 0 && (got.minValue != want.minValue || got.maxValue != want.maxValue))
+        out << "min/max " << got.minValue << "/" << got.maxValue << ", esperado " << want.minValue << "/" << want.maxValue;
+    return out.str();
+}
+
+/**
+ * @brief Executa uma agregação nos motores otimizados e na referência e compara os valores.
+ */
+static void checkAggregate(Round &round, int command) {
+    static const IndexField FIELDS[] = { INDEX_PRICE, INDEX_DURATION, INDEX_STOPS, INDEX_SEATS };
+    AggregateFunction function = static_cast<AggregateFunction>(round.rng() % (AGG_AVG + 1));
+    IndexField field = function == AGG_COUNT ? INDEX_COUNT : FIELDS[round.rng() % 4];
+    string text = round.rng() % 8 ? (round.rng() % 2 ? randomRange(round) : randomQueryExpression(round)) : "";
+
+    ExprArena referenceArena, singleArena, partitionedArena;
+    Expr* referenceExpression = nullptr;
+    Expr* expression = nullptr;
+    Expr* partitionedExpression = nullptr;
+    if (!text.empty()) {
+        Parser referenceParser(text, referenceArena), singleParser(text, singleArena), partitionedParser(text, partitionedArena);
+        referenceExpression = referenceParser.parseExpression();
+        expression = singleParser.parseExpression();
+        partitionedExpression = partitionedParser.parseExpression();
+    }
+
+    AggregateResult expected(function, field);
+    steady_clock::time_point start = steady_clock::now();
+    for (size_t id = 0; id < round.reference.flights.size(); id++)
+        if (round.reference.active[id] && (!referenceExpression || referenceExpression->evaluate(round.reference.flights[id])))
+            expected.add(&round.reference.flights[id]);
+    double naiveUs = elapsedUs(start);
+
+    QueryProfile profile;
+    AggregateResult result(function, field);
+    start = steady_clock::now();
+    executeAggregate(*round.flightManager, expression, result, &profile);
+    double optimizedUs = elapsedUs(start);
+    string why = compareAggregates(result, expected);
+    if (!why.empty())
+        reportMismatch(round, command, profile.accessPath, aggregateText(function, field) + " " + text, why);
+    PathStats &stats = (*round.stats)["aggregate:" + pathCategory(profile.accessPath)];
+    stats.queries++;
+    stats.optimizedUs += optimizedUs;
+    stats.naiveUs += naiveUs;
+
+    if (round.partitionedStore) {
+        AggregateResult partitioned(function, field);
+        round.partitionedStore->executeAggregate(partitionedExpression, partitioned);
+        why = compareAggregates(partitioned, expected);
+        if (!why.empty())
+            reportMismatch(round, command, "partitions", aggregateText(function, field) + " " + text, why);
+    }
+    round.checks++;
+}
+
+/**
+ * @brief Executa um template preparado e compara com a consulta equivalente, escrita com as constantes.
+ *
+ * No armazenamento particionado, o template tem um plano por partição
+ * (partitionedPrepared, separado do template do gerenciador único).
+ */
+static void checkPrepared(Round &round, PreparedQuery* prepared, PreparedQuery* partitionedPrepared, int command) {
+    int index = round.rng() % TEMPLATE_COUNT;
+    const Flight &a = sampleFlight(round);
+    const Flight &b = sampleFlight(round);
+    vector<string> values;
+    if (index == 0) {
+        values.push_back(fieldValueText(INDEX_ORIGIN, a));
+        values.push_back(fieldValueText(INDEX_DESTINATION, round.rng() % 2 ? a : b));
+        values.push_back(timeText(a.dep_time - static_cast<time_t>(round.rng() % 60) * 86400));
+    } else if (index == 1) {
+        double low = min(a.price, b.price), high = max(a.price, b.price);
+        values.push_back(fieldValueText(INDEX_PRICE, low == a.price ? a : b));
+        values.push_back(fieldValueText(INDEX_PRICE, high == a.price ? a : b));
+        values.push_back(fieldValueText(INDEX_STOPS, a));
+    } else {
+        values.push_back(fieldValueText(INDEX_SEATS, a));
+        values.push_back(fieldValueText(INDEX_DURATION, b));
+    }
+
+    string text;
+    size_t parameter = 0;
+    for (const char* c = TEMPLATES[index]; *c; c++)
+        text += *c == '?' ? values[parameter++] : string(1, *c);
+    for (size_t p = 0; p < values.size(); p++)
+        prepared[index].bind(static_cast<int>(p), values[p]);
+
+    string sortCriteria = "pds";
+    int maxResults = 1 + round.rng() % 30;
+    ExprArena referenceArena;
+    Parser referenceParser(text, referenceArena);
+    Expr* referenceExpression = referenceParser.parseExpression();
+    steady_clock::time_point start = steady_clock::now();
+    vector<Flight*> expected = naiveQuery(round.reference, referenceExpression, sortCriteria);
+    double naiveUs = elapsedUs(start);
+
+    QueryProfile profile;
+    int resultCount = 0;
+    start = steady_clock::now();
+    Flight** resultFlights = prepared[index].execute(*round.flightManager, sortCriteria, resultCount, &profile);
+    double optimizedUs = elapsedUs(start);
+    string why = compareResults(resultFlights, resultCount, expected, maxResults, sortCriteria);
+    if (!why.empty())
+        reportMismatch(round, command, "prepared:" + profile.accessPath, text, why);
+    delete[] resultFlights;
+    PathStats &stats = (*round.stats)["prepared:" + pathCategory(profile.accessPath)];
+    stats.queries++;
+    stats.optimizedUs += optimizedUs;
+    stats.naiveUs += naiveUs;
+
+    if (round.partitionedStore) {
+        for (size_t p = 0; p < values.size(); p++)
+            partitionedPrepared[index].bind(static_cast<int>(p), values[p]);
+        resultFlights = round.partitionedStore->executePrepared(partitionedPrepared[index], sortCriteria, maxResults,
+                                                                resultCount);
+        why = compareResults(resultFlights, resultCount, expected, maxResults, sortCriteria);
+        if (!why.empty())
+            reportMismatch(round, command, "prepared:partitions", text, why);
+        delete[] resultFlights;
+    }
+    round.checks++;
+}
+
+/**
+ * @brief Itinerário do motor de referência: identificadores dos trechos e totais.
+ */
+struct ReferenceItinerary {
+    vector<int> legIds;
+    Flight total;
+};
+
+/**
+ * @brief Ordem de ItinerarySearch: critérios dos totais, número de trechos e identificadores dos trechos.
+ */
+struct ReferenceItineraryLess {
+    const string* criteria;
+
+    bool operator()(const ReferenceItinerary &a, const ReferenceItinerary &b) const {
+        int result = compareFlightByCriteria(&a.total, &b.total, *criteria);
+        if (result != 0)
+            return result < 0;
+        if (a.legIds.size() != b.legIds.size())
+            return a.legIds.size() < b.legIds.size();
+        return a.legIds < b.legIds;
+    }
+};
+
+/**
+ * @brief Acrescenta ao resultado os itinerários que estendem legIds até o destino (junção aninhada).
+ *
+ * Cada trecho seguinte é procurado entre todos os voos ativos que saem do
+ * aeroporto de chegada, sem ordenação nem limites inferiores; visited guarda
+ * os aeroportos já usados.
+ */
+static void naiveExtend(const ReferenceStore &reference, const vector<vector<int> > &byOrigin,
+                        const ItineraryQuery &query, vector<int> &legIds, vector<AirportCode> &visited,
+                        vector<ReferenceItinerary> &result) {
+    const Flight &last = reference.flights[legIds.back()];
+    if (last.destination == query.destination) {
+        ReferenceItinerary itinerary;
+        itinerary.legIds = legIds;
+        const Flight &first = reference.flights[legIds[0]];
+        Flight &total = itinerary.total;
+        total.origin = first.origin;
+        total.destination = last.destination;
+        total.dep_time = first.dep_time;
+        total.arr_time = last.arr_time;
+        total.duration = static_cast<int>(last.arr_time - first.dep_time);
+        total.price = 0;
+        total.stops = static_cast<int>(legIds.size()) - 1;
+        total.seats = INT_MAX;
+        total.id = -1;
+        for (size_t i = 0; i < legIds.size(); i++) {
+            const Flight &leg = reference.flights[legIds[i]];
+            total.price += leg.price;
+            total.stops += leg.stops;
+            total.seats = min(total.seats, leg.seats);
+        }
+        result.push_back(itinerary);
+        return;
+    }
+    if (static_cast<int>(legIds.size()) > query.maxConnections)
+        return;
+    for (size_t airport = 0; airport < AIRPORT_COUNT; airport++) {
+        if (encodeAirportCode(AIRPORTS[airport], 3) != last.destination)
+            continue;
+        const vector<int> &candidates = byOrigin[airport];
+        for (size_t c = 0; c < candidates.size(); c++) {
+            const Flight &next = reference.flights[candidates[c]];
+            if (!reference.active[candidates[c]] || next.dep_time < last.arr_time + query.minLayover
+                || next.dep_time > last.arr_time + query.maxLayover
+                || find(visited.begin(), visited.end(), next.destination) != visited.end())
+                continue;
+            legIds.push_back(candidates[c]);
+            visited.push_back(next.destination);
+            naiveExtend(reference, byOrigin, query, legIds, visited, result);
+            visited.pop_back();
+            legIds.pop_back();
+        }
+    }
+}
+
+/**
+ * @brief Busca de itinerários no motor de referência: todos os itinerários válidos, ordenados.
+ */
+static vector<ReferenceItinerary> naiveRoute(const ReferenceStore &reference, const ItineraryQuery &query) {
+    vector<vector<int> > byOrigin(AIRPORT_COUNT);
+    for (size_t id = 0; id < reference.flights.size(); id++)
+        for (int airport = 0; airport < AIRPORT_COUNT; airport++)
+            if (reference.flights[id].origin == encodeAirportCode(AIRPORTS[airport], 3))
+                byOrigin[airport].push_back(static_cast<int>(id));
+
+    vector<ReferenceItinerary> result;
+    vector<int> legIds;
+    vector<AirportCode> visited;
+    for (size_t id = 0; id < reference.flights.size(); id++) {
+        const Flight &first = reference.flights[id];
+        if (!reference.active[id] || first.origin != query.origin || (query.filter && !query.filter->evaluate(first)))
+            continue;
+        legIds.assign(1, static_cast<int>(id));
+        visited.assign(1, first.origin);
+        visited.push_back(first.destination);
+        naiveExtend(reference, byOrigin, query, legIds, visited, result);
+    }
+    ReferenceItineraryLess less = { &query.sortCriteria };
+    sort(result.begin(), result.end(), less);
+    return result;
+}
+
+/**
+ * @brief Compara os itinerários de ItinerarySearch com os primeiros maxResults da referência.
+ *
+ * A ordem é total (empates pelos identificadores dos trechos), então os
+ * trechos devem ser exatamente os mesmos, na mesma posição.
+ *
+ * @return Descrição da primeira divergência, ou "" se os resultados batem.
+ */
+static string compareItineraries(const Itinerary* itineraries, int count, const vector<ReferenceItinerary> &expected,
+                                 int maxResults) {
+    int shown = min(maxResults, static_cast<int>(expected.size()));
+    if (count != shown)
+        return to_string(count) + " itinerários, esperados " + to_string(shown);
+    for (int i = 0; i < count; i++) {
+        vector<int> got(itineraries[i].legIds, itineraries[i].legIds + itineraries[i].legCount);
+        if (got != expected[i].legIds) {
+            ostringstream out;
+            out << "itinerário diferente na posição " << i << ":";
+            for (size_t l = 0; l < got.size(); l++)
+                out << " " << got[l];
+            out << " no lugar de";
+            for (size_t l = 0; l < expected[i].legIds.size(); l++)
+                out << " " << expected[i].legIds[l];
+            return out.str();
+        }
+    }
+    return "";
+}
+
+/**
+ * @brief Executa um comando route nos dois motores otimizados e compara com a junção ingênua.
+ *
+ * Cobre de 0 a 2 conexões, esperas curtas e longas, filtros do primeiro
+ * trecho (janelas de partida, que restringem a lista da origem, e predicados
+ * quaisquer) e os empates de preço dos voos gerados.
+ */
+static void checkRoute(Round &round, ItinerarySearch &search, ItinerarySearch* partitionedSearch, int command) {
+    static const char* CRITERIA[] = { "pds", "dps", "spd", "psd", "p", "d", "s", "sd" };
+    ItineraryQuery query;
+    int origin = round.rng() % AIRPORT_COUNT;
+    int destination = (origin + 1 + round.rng() % (AIRPORT_COUNT - 1)) % AIRPORT_COUNT;
+    query.origin = encodeAirportCode(AIRPORTS[origin], 3);
+    query.destination = encodeAirportCode(AIRPORTS[destination], 3);
+    query.maxConnections = round.rng() % 3;
+    query.minLayover = static_cast<int>(round.rng() % 5) * 30 * 60;
+    // Os voos se espalham por mais de um ano: esperas de até 4 dias tornam as conexões frequentes.
+    query.maxLayover = query.minLayover + static_cast<int>(1 + round.rng() % 8) * 12 * 60 * 60;
+    query.sortCriteria = CRITERIA[round.rng() % 8];
+    query.maxResults = 1 + round.rng() % 20;
+
+    string filterText;
+    int filterKind = round.rng() % 3;
+    if (filterKind == 1) {
+        time_t low = sampleFlight(round).dep_time;
+        filterText = "(dep>=" + timeText(low) + ")&&(dep<" + timeText(low + (1 + round.rng() % 30) * 86400) + ")";
+    } else if (filterKind == 2) {
+        filterText = randomPredicate(round);
+    }
+    ExprArena arena;
+    Expr* filter = nullptr;
+    if (!filterText.empty()) {
+        Parser parser(filterText, arena);
+        filter = parser.parseExpression();
+    }
+    query.filter = filter;
+
+    ostringstream text;
+    text << "route " << query.maxResults << " " << query.sortCriteria << " " << AIRPORTS[origin] << " "
+         << AIRPORTS[destination] << " " << query.maxConnections << " " << query.minLayover / 60 << " "
+         << query.maxLayover / 60 << " " << filterText;
+
+    steady_clock::time_point start = steady_clock::now();
+    vector<ReferenceItinerary> expected = naiveRoute(round.reference, query);
+    double naiveUs = elapsedUs(start);
+
+    int resultCount = 0;
+    start = steady_clock::now();
+    Itinerary* itineraries = search.search(query, resultCount);
+    double optimizedUs = elapsedUs(start);
+    string why = compareItineraries(itineraries, resultCount, expected, query.maxResults);
+    if (!why.empty())
+        reportMismatch(round, command, "route", text.str(), why);
+    delete[] itineraries;
+    PathStats &stats = (*round.stats)["route"];
+    stats.queries++;
+    stats.optimizedUs += optimizedUs;
+    stats.naiveUs += naiveUs;
+
+    if (partitionedSearch) {
+        itineraries = partitionedSearch->search(query, resultCount);
+        why = compareItineraries(itineraries, resultCount, expected, query.maxResults);
+        if (!why.empty())
+            reportMismatch(round, command, "route:partitions", text.str(), why);
+        delete[] itineraries;
+    }
+    round.checks++;
+}
+
+/**
+ * @brief Aplica uma inserção, remoção, atualização ou reserva aos três motores e compara os retornos.
+ */
+static void applyMutation(Round &round, int command) {
+    int kind = round.rng() % 4;
+    int slotCount = static_cast<int>(round.reference.flights.size());
+    int id = static_cast<int>(round.rng() % (slotCount + 2)) - 1;  // Inclui identificadores inválidos.
+    bool expected, single, partitioned;
+    string text;
+    if (kind == 0) {
+        Flight flight = randomFlight(round.rng);
+        int referenceId = round.reference.insertFlight(flight);
+        int singleId = round.flightManager->insertFlight(flight);
+        int partitionedId = round.partitionedStore ? round.partitionedStore->insertFlight(flight) : referenceId;
+        expected = true;
+        single = singleId == referenceId;
+        partitioned = partitionedId == referenceId;
+        text = "ins " + flightText(flight);
+    } else if (kind == 1) {
+        expected = round.reference.exists(id);
+        if (expected)
+            round.reference.active[id] = false;
+        single = round.flightManager->removeFlight(id);
+        partitioned = round.partitionedStore ? round.partitionedStore->removeFlight(id) : expected;
+        text = "del " + to_string(id);
+    } else if (kind == 2) {
+        Flight flight = randomFlight(round.rng);
+        expected = round.reference.exists(id);
+        if (expected) {
+            flight.id = id;
+            round.reference.flights[id] = flight;
+        }
+        single = round.flightManager->updateFlight(id, flight);
+        partitioned = round.partitionedStore ? round.partitionedStore->updateFlight(id, flight) : expected;
+        text = "upd " + to_string(id) + " " + flightText(flight);
+    } else {
+        int seatCount = 1 + round.rng() % 40;
+        expected = round.reference.exists(id) && round.reference.flights[id].seats >= seatCount;
+        if (expected)
+            round.reference.flights[id].seats -= seatCount;
+        single = round.flightManager->reserveSeats(id, seatCount);
+        partitioned = round.partitionedStore ? round.partitionedStore->reserveSeats(id, seatCount) : expected;
+        text = "res " + to_string(id) + " " + to_string(seatCount);
+    }
+    if (single != expected)
+        reportMismatch(round, command, "single", text, "retorno " + to_string(single));
+    if (partitioned != expected)
+        reportMismatch(round, command, "partitions", text, "retorno " + to_string(partitioned));
+}
+
+/**
+ * @brief Roda uma rodada: gera os voos, constrói os motores e intercala consultas e atualizações.
+ * @return Número de divergências.
+ */
+static int runRound(unsigned seed, int flightCount, int commandCount, int partitionCount,
+                    map<string, PathStats> &stats, int &checks) {
+    Round round(seed);
+    round.stats = &stats;
+    FlightManager flightManager;
+    PartitionScheme scheme = seed % 2 ? PARTITION_BY_ROUTE : PARTITION_BY_MONTH;
+    PartitionedStore* partitionedStore = partitionCount > 1 ? new PartitionedStore(partitionCount, scheme) : nullptr;
+    for (int i = 0; i < flightCount; i++) {
+        Flight flight = randomFlight(round.rng);
+        round.reference.insertFlight(flight);
+        flightManager.addFlight(flight);
+        if (partitionedStore)
+            partitionedStore->addFlight(flight);
+    }
+    flightManager.buildIndices();
+    if (partitionedStore)
+        partitionedStore->buildIndices();
+    round.flightManager = &flightManager;
+    round.partitionedStore = partitionedStore;
+
+    PreparedQuery prepared[TEMPLATE_COUNT];
+    PreparedQuery partitionedPrepared[TEMPLATE_COUNT];
+    for (int t = 0; t < TEMPLATE_COUNT; t++) {
+        prepared[t].prepare(TEMPLATES[t]);
+        partitionedPrepared[t].prepare(TEMPLATES[t]);
+    }
+    ItinerarySearch itinerarySearch(flightManager);
+    ItinerarySearch* partitionedSearch = partitionedStore ? new ItinerarySearch(*partitionedStore) : nullptr;
+
+    for (int command = 0; command < commandCount; command++) {
+        int choice = round.rng() % 100;
+        if (choice < 55)
+            checkQuery(round, command);
+        else if (choice < 70)
+            checkAggregate(round, command);
+        else if (choice < 75)
+            checkPrepared(round, prepared, partitionedPrepared, command);
+        else if (choice < 80)
+            checkRoute(round, itinerarySearch, partitionedSearch, command);
+        else
+            applyMutation(round, command);
+    }
+    delete partitionedSearch;
+    delete partitionedStore;
+    checks += round.checks;
+    return round.mismatches;
+}
+
+int main(int argc, char* argv[]) {
+    int rounds = 5, flightCount = 20000, commandCount = 300, partitionCount = 4;
+    unsigned firstSeed = 1;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--rounds") && i + 1 < argc) rounds = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--flights") && i + 1 < argc) flightCount = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--commands") && i + 1 < argc) commandCount = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--partitions") && i + 1 < argc) partitionCount = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) firstSeed = static_cast<unsigned>(atoi(argv[++i]));
+        else {
+            cerr << "Uso: " << argv[0] << " [--rounds 5] [--flights 20000] [--commands 300] [--partitions 4] [--seed 1]\n";
+            return 1;
+        }
+    }
+    if (flightCount < 1 || partitionCount < 1 || partitionCount > PartitionedStore::MAX_PARTITIONS) {
+        cerr << "Erro: --flights deve ser positivo e --partitions entre 1 e " << PartitionedStore::MAX_PARTITIONS << ".\n";
+        return 1;
+    }
+
+    map<string, PathStats> stats;
+    int mismatches = 0, checks = 0;
+    for (int r = 0; r < rounds; r++) {
+        unsigned seed = firstSeed + static_cast<unsigned>(r);
+        int roundMismatches = runRound(seed, flightCount, commandCount, partitionCount, stats, checks);
+        cout << "rodada seed=" << seed << ": " << (roundMismatches ? to_string(roundMismatches) + " divergências" : "ok") << endl;
+        mismatches += roundMismatches;
+    }
+
+    printf("\n%-24s %8s %14s %14s %9s\n", "caminho", "consultas", "otimizado_us", "referencia_us", "speedup");
+    for (map<string, PathStats>::iterator it = stats.begin(); it != stats.end(); ++it) {
+        const PathStats &s = it->second;
+        printf("%-24s %8d %14.1f %14.1f %8.1fx\n", it->first.c_str(), s.queries, s.optimizedUs / s.queries,
+               s.naiveUs / s.queries, s.optimizedUs > 0 ? s.naiveUs / s.optimizedUs : 0);
+    }
+    printf("\n%d verificações, %d divergências\n", checks, mismatches);
+    return mismatches ? 1 : 0;
+}
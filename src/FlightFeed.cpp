@@ -0,0 +1,152 @@
+#include "../include/FlightFeed.hpp"
+#include "../include/FlightManager.hpp"
+#include "../include/Metrics.hpp"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <sstream>
+#include <iostream>
+
+using namespace std::chrono;
+
+FlightFeed::FlightFeed(const string &path, double intervalMs, int maxBatchLines)
+    : path(path), fd(-1), intervalMs(intervalMs), maxBatchLines(maxBatchLines), readOffset(0), fileSize(0),
+      fileModifiedNs(0), lineNumber(0), checked(false), batchCount(0), insertedTotal(0), errorTotal(0),
+      maxLagMs(0) {}
+
+FlightFeed::~FlightFeed() {
+    if (fd >= 0)
+        close(fd);
+}
+
+bool FlightFeed::open() {
+    fd = ::open(path.c_str(), O_RDONLY);
+    return fd >= 0;
+}
+
+/**
+ * @brief Atualiza tamanho e data de modificação; trata um arquivo truncado.
+ *
+ * Um arquivo menor que o já lido foi truncado ou substituído: o aviso vai
+ * para stderr e a leitura recomeça do início (os voos já inseridos ficam).
+ */
+bool FlightFeed::refresh() {
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+        return false;
+    if (info.st_size < readOffset) {
+        std::cerr << "Warning: flights feed " << path << " was truncated; reading it from the beginning.\n";
+        readOffset = 0;
+        buffer.clear();
+    }
+    fileSize = info.st_size;
+    fileModifiedNs = info.st_mtim.tv_sec * 1000000000LL + info.st_mtim.tv_nsec;
+    return true;
+}
+
+bool FlightFeed::hasNewData() const {
+    return readOffset < fileSize || buffer.find('\n') != string::npos;
+}
+
+/**
+ * @brief Verifica, no máximo uma vez por intervalo, se há dados novos a processar.
+ *
+ * Entre verificações custa só uma leitura do relógio; a verificação é um fstat().
+ */
+bool FlightFeed::due() {
+    steady_clock::time_point now = steady_clock::now();
+    if (checked && duration<double, std::milli>(now - lastCheck).count() < intervalMs)
+        return false;
+    checked = true;
+    lastCheck = now;
+    return refresh() && hasNewData();
+}
+
+/**
+ * @brief Processa as linhas completas novas (até maxBatchLines) e as insere no armazenamento.
+ *
+ * Os bytes são lidos em blocos de READ_CHUNK só quando o buffer não tem mais
+ * uma linha completa, de modo que um lote cortado não lê o arquivo todo.
+ */
+bool FlightFeed::poll(PartitionedStore &store, IngestBatch &batch) {
+    batch = IngestBatch();
+    if (fd < 0 || !refresh())
+        return false;
+
+    steady_clock::time_point start = steady_clock::now();
+    std::istringstream lineStream;
+    string line;
+    size_t position = 0;
+    while (batch.lines < maxBatchLines) {
+        size_t newline = buffer.find('\n', position);
+        if (newline == string::npos) {
+            if (readOffset >= fileSize)
+                break;
+            buffer.erase(0, position);
+            position = 0;
+            size_t previous = buffer.size();
+            long long chunk = fileSize - readOffset < READ_CHUNK ? fileSize - readOffset : READ_CHUNK;
+            buffer.resize(previous + chunk);
+            ssize_t readBytes = pread(fd, &buffer[previous], chunk, readOffset);
+            if (readBytes <= 0) {
+                buffer.resize(previous);
+                break;
+            }
+            buffer.resize(previous + readBytes);
+            readOffset += readBytes;
+            continue;
+        }
+
+        line.assign(buffer, position, newline - position);
+        batch.bytes += newline + 1 - position;
+        position = newline + 1;
+        lineNumber++;
+        if (line.find_first_not_of(" \t\r") == string::npos)
+            continue;
+        batch.lines++;
+
+        Flight flight;
+        lineStream.clear();
+        lineStream.str(line);
+        if (!readFlight(lineStream, flight)) {
+            std::cerr << "Error parsing flight in feed line " << lineNumber << ".\n";
+            batch.errors++;
+            continue;
+        }
+        if (flight.arr_time < flight.dep_time) {
+            std::cerr << "Error: arrival time is before departure in feed line " << lineNumber << ".\n";
+            batch.errors++;
+            continue;
+        }
+        store.insertFlight(flight);
+        batch.inserted++;
+    }
+    buffer.erase(0, position);
+    if (batch.lines == 0)
+        return false;
+
+    batch.pendingBytes = fileSize - readOffset + static_cast<long long>(buffer.size());
+    batch.insertUs = duration<double, std::micro>(steady_clock::now() - start).count();
+    long long nowNs = duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+    batch.lagMs = nowNs > fileModifiedNs ? (nowNs - fileModifiedNs) / 1e6 : 0.0;
+
+    batchCount++;
+    insertedTotal += batch.inserted;
+    errorTotal += batch.errors;
+    if (batch.lagMs > maxLagMs)
+        maxLagMs = batch.lagMs;
+    METRIC_ADD(METRIC_INGESTED_FLIGHTS, batch.inserted);
+    METRIC_OBSERVE(METRIC_HIST_INGEST_LAG_MS, static_cast<uint64_t>(batch.lagMs));
+    return true;
+}
+
+void FlightFeed::printBatch(FILE* out, const IngestBatch &batch) const {
+    fprintf(out, "INGEST batch=%d lines=%d inserted=%d errors=%d bytes=%lld pending_bytes=%lld insert_us=%.0f lag_ms=%.1f\n",
+            batchCount, batch.lines, batch.inserted, batch.errors, batch.bytes, batch.pendingBytes,
+            batch.insertUs, batch.lagMs);
+}
+
+void FlightFeed::printSummary(FILE* out) const {
+    fprintf(out, "INGEST batches=%d inserted=%lld errors=%lld max_lag_ms=%.1f\n", batchCount, insertedTotal,
+            errorTotal, maxLagMs);
+}
@@ -0,0 +1,1098 @@
+#include "../include/FlightManager.hpp"
+#include "../include/DateTime.hpp"
+#include "../include/Metrics.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+
+/**
+ * @brief Lê um voo no formato da entrada e calcula os campos derivados.
+ */
+bool readFlight(std::istream &in, Flight &flight) {
+    char origin[4], destination[4], departureStr[40], arrivalStr[40];
+    if (!(in >> std::setw(sizeof(origin)) >> origin
+             >> std::setw(sizeof(destination)) >> destination
+             >> flight.price >> flight.seats
+             >> std::setw(sizeof(departureStr)) >> departureStr
+             >> std::setw(sizeof(arrivalStr)) >> arrivalStr
+             >> flight.stops))
+        return false;
+
+    if (!parseDateTimeChecked(departureStr, flight.dep_time) || !parseDateTimeChecked(arrivalStr, flight.arr_time))
+        return false;
+
+    flight.id = -1;
+    flight.origin = encodeAirportCode(origin, static_cast<int>(strlen(origin)));
+    flight.destination = encodeAirportCode(destination, static_cast<int>(strlen(destination)));
+    flight.duration = static_cast<int>(flight.arr_time - flight.dep_time);
+    return true;
+}
+
+/**
+ * @brief Construtor: cria um armazenamento vazio e sem índices.
+ */
+FlightManager::FlightManager()
+    : indexOrigin(nullptr), indexDestination(nullptr), indexPrice(nullptr),
+      indexDuration(nullptr), indexStops(nullptr), indexSeats(nullptr),
+      indexDeparture(nullptr), indexArrival(nullptr), indexRangeBox(nullptr),
+      flightBlocks(nullptr), slotBlocks(nullptr), blockCount(0), blockCapacity(0),
+      slotCount(0), activeCount(0), version(0), pendingSeatHead(-1) {
+    for (int field = 0; field < INDEX_COUNT; field++)
+        bitmapIndex[field] = nullptr;
+}
+
+/**
+ * @brief Destrutor: libera os índices e os blocos de voos.
+ */
+FlightManager::~FlightManager() {
+    delete indexOrigin;
+    delete indexDestination;
+    delete indexPrice;
+    delete indexDuration;
+    delete indexStops;
+    delete indexSeats;
+    delete indexDeparture;
+    delete indexArrival;
+    delete indexRangeBox;
+    for (int field = 0; field < INDEX_COUNT; field++)
+        delete bitmapIndex[field];
+    for (int i = 0; i < blockCount; i++) {
+        delete[] flightBlocks[i];
+        delete[] slotBlocks[i];
+    }
+    delete[] flightBlocks;
+    delete[] slotBlocks;
+}
+
+/**
+ * @brief Acrescenta ao relatório a memória do armazenamento e de cada índice.
+ *
+ * Os blocos de voos são contados inteiros (inclusive posições ainda livres do
+ * último bloco e voos removidos, que continuam ocupando a posição).
+ */
+void FlightManager::reportMemory(MemoryReport &report) const {
+    for (int i = 0; i < blockCount; i++) {
+        int used = slotCount - i * BLOCK_SIZE < BLOCK_SIZE ? slotCount - i * BLOCK_SIZE : BLOCK_SIZE;
+        report.addArray("flights", used, BLOCK_SIZE, sizeof(Flight));
+        report.addArray("flight_slots", used, BLOCK_SIZE, sizeof(FlightSlot));
+    }
+    report.addArray("flight_blocks", blockCount, blockCapacity, sizeof(Flight*));
+    report.addArray("flight_blocks", blockCount, blockCapacity, sizeof(FlightSlot*));
+
+    string avl = "avl.";
+    if (indexOrigin) {
+        indexOrigin->reportMemory(report, avl + fieldName(INDEX_ORIGIN));
+        indexDestination->reportMemory(report, avl + fieldName(INDEX_DESTINATION));
+        indexPrice->reportMemory(report, avl + fieldName(INDEX_PRICE));
+        indexDuration->reportMemory(report, avl + fieldName(INDEX_DURATION));
+        indexStops->reportMemory(report, avl + fieldName(INDEX_STOPS));
+        indexSeats->reportMemory(report, avl + fieldName(INDEX_SEATS));
+        indexDeparture->reportMemory(report, string("buckets.") + fieldName(INDEX_DEPARTURE));
+        indexArrival->reportMemory(report, string("buckets.") + fieldName(INDEX_ARRIVAL));
+        indexRangeBox->reportMemory(report, "kdtree");
+    }
+    for (int field = 0; field < INDEX_COUNT; field++)
+        if (bitmapIndex[field])
+            bitmapIndex[field]->reportMemory(report, string("bitmap.") + fieldName(static_cast<IndexField>(field)));
+    activeIds.reportMemory(report, "bitmap.active");
+}
+
+/**
+ * @brief Adiciona um voo ao armazenamento sem indexá-lo.
+ */
+int FlightManager::addFlight(const Flight &flight) {
+    if (slotCount == blockCount * BLOCK_SIZE) {
+        if (blockCount == blockCapacity) {
+            int newCapacity = blockCapacity ? blockCapacity * 2 : 4;
+            Flight** newFlightBlocks = new Flight*[newCapacity];
+            FlightSlot** newSlotBlocks = new FlightSlot*[newCapacity];
+            for (int i = 0; i < blockCount; i++) {
+                newFlightBlocks[i] = flightBlocks[i];
+                newSlotBlocks[i] = slotBlocks[i];
+            }
+            delete[] flightBlocks;
+            delete[] slotBlocks;
+            flightBlocks = newFlightBlocks;
+            slotBlocks = newSlotBlocks;
+            blockCapacity = newCapacity;
+        }
+        flightBlocks[blockCount] = new Flight[BLOCK_SIZE];
+        slotBlocks[blockCount] = new FlightSlot[BLOCK_SIZE];
+        blockCount++;
+    }
+
+    int id = slotCount++;
+    Flight &stored = flightAt(id);
+    stored = flight;
+    stored.id = id;
+    FlightSlot &slot = slotAt(id);
+    for (int field = 0; field < INDEX_COUNT; field++)
+        slot.entries[field] = nullptr;
+    slot.active = true;
+    slot.indexedSeats = stored.seats;
+    slot.seatIndexPending = false;
+    slot.nextPending = -1;
+    activeCount++;
+    version++;
+    return id;
+}
+
+/**
+ * @brief Constrói os índices (árvores AVL) para os voos armazenados.
+ */
+void FlightManager::buildIndices() {
+    indexOrigin = new OriginIndex();
+    indexDestination = new DestinationIndex();
+    indexPrice = new PriceIndex();
+    indexDuration = new DurationIndex();
+    indexStops = new StopsIndex();
+    indexSeats = new SeatIndex();
+    indexDeparture = new DepartureIndex();
+    indexArrival = new ArrivalIndex();
+    indexRangeBox = new RangeBoxIndex();
+
+    // Os índices de tempo e a árvore k-d são carregados de uma vez, depois de reunir os voos.
+    TimeEntry* departures = new TimeEntry[activeCount > 0 ? activeCount : 1];
+    TimeEntry* arrivals = new TimeEntry[activeCount > 0 ? activeCount : 1];
+    Flight** boxFlights = new Flight*[activeCount > 0 ? activeCount : 1];
+    int timeCount = 0;
+    for (int id = 0; id < slotCount; id++) {
+        FlightSlot &slot = slotAt(id);
+        if (!slot.active)
+            continue;
+        Flight &flight = flightAt(id);
+        for (int field = 0; field < INDEX_COUNT; field++)
+            if (field != INDEX_DEPARTURE && field != INDEX_ARRIVAL)
+                indexField(field, flight, slot);
+        departures[timeCount].key = flight.dep_time;
+        departures[timeCount].flight = &flight;
+        arrivals[timeCount].key = flight.arr_time;
+        arrivals[timeCount].flight = &flight;
+        boxFlights[timeCount] = &flight;
+        timeCount++;
+        activeIds.add(id);
+    }
+    indexDeparture->build(departures, timeCount);
+    indexArrival->build(arrivals, timeCount);
+    indexRangeBox->build(boxFlights, timeCount);
+    delete[] departures;
+    delete[] arrivals;
+    delete[] boxFlights;
+
+    // O tipo de índice de cada campo discreto sai da cardinalidade observada nas árvores AVL.
+    int keyCounts[INDEX_COUNT] = { 0 };
+    keyCounts[INDEX_ORIGIN] = indexOrigin->keyCount;
+    keyCounts[INDEX_DESTINATION] = indexDestination->keyCount;
+    keyCounts[INDEX_STOPS] = indexStops->keyCount;
+    keyCounts[INDEX_SEATS] = indexSeats->keyCount;
+    for (int field = 0; field < INDEX_COUNT; field++)
+        if (keyCounts[field] > 0 && keyCounts[field] <= MAX_BITMAP_KEYS)
+            bitmapIndex[field] = new BitmapIndex();
+    // Identificadores crescentes entram no fim dos contêineres dos bitmaps.
+    for (int id = 0; id < slotCount; id++) {
+        FlightSlot &slot = slotAt(id);
+        if (!slot.active)
+            continue;
+        for (int field = 0; field < INDEX_COUNT; field++)
+            if (bitmapIndex[field])
+                bitmapIndex[field]->insert(bitmapKey(field, flightAt(id), slot), id);
+    }
+}
+
+/**
+ * @brief Insere um voo e o indexa em todos os índices.
+ */
+int FlightManager::insertFlight(const Flight &flight) {
+    int id = addFlight(flight);
+    for (int field = 0; field < INDEX_COUNT; field++)
+        indexField(field, flightAt(id), slotAt(id));
+    indexRangeBox->insert(&flightAt(id));
+    activeIds.add(id);
+    dropCrowdedBitmaps();
+    return id;
+}
+
+/**
+ * @brief Remove um voo do armazenamento e de todos os índices.
+ */
+bool FlightManager::removeFlight(int id) {
+    if (!getFlight(id))
+        return false;
+    FlightSlot &slot = slotAt(id);
+    for (int field = 0; field < INDEX_COUNT; field++)
+        unindexField(field, flightAt(id), slot);
+    indexRangeBox->remove(&flightAt(id));
+    activeIds.remove(id);
+    slot.active = false;
+    activeCount--;
+    version++;
+    return true;
+}
+
+/**
+ * @brief Atualiza os dados de um voo, reindexando apenas os campos alterados.
+ */
+bool FlightManager::updateFlight(int id, const Flight &flight) {
+    Flight* stored = getFlight(id);
+    if (!stored)
+        return false;
+    FlightSlot &slot = slotAt(id);
+
+    bool changed[INDEX_COUNT];
+    changed[INDEX_ORIGIN] = stored->origin != flight.origin;
+    changed[INDEX_DESTINATION] = stored->destination != flight.destination;
+    changed[INDEX_PRICE] = stored->price != flight.price;
+    changed[INDEX_DURATION] = stored->duration != flight.duration;
+    changed[INDEX_STOPS] = stored->stops != flight.stops;
+    changed[INDEX_SEATS] = slot.indexedSeats != flight.seats;
+    changed[INDEX_DEPARTURE] = stored->dep_time != flight.dep_time;
+    changed[INDEX_ARRIVAL] = stored->arr_time != flight.arr_time;
+
+    // As entradas antigas precisam ser removidas com as chaves antigas.
+    bool boxChanged = changed[INDEX_PRICE] || changed[INDEX_DURATION] || changed[INDEX_DEPARTURE];
+    for (int field = 0; field < INDEX_COUNT; field++)
+        if (changed[field])
+            unindexField(field, *stored, slot);
+    if (boxChanged)
+        indexRangeBox->remove(stored);
+    *stored = flight;
+    stored->id = id;
+    for (int field = 0; field < INDEX_COUNT; field++)
+        if (changed[field])
+            indexField(field, *stored, slot);
+    if (boxChanged)
+        indexRangeBox->insert(stored);
+    dropCrowdedBitmaps();
+    version++;
+    return true;
+}
+
+/**
+ * @brief Reserva assentos de um voo.
+ */
+bool FlightManager::reserveSeats(int id, int seatCount) {
+    Flight* flight = getFlight(id);
+    if (!flight || seatCount <= 0)
+        return false;
+
+    int seats = __atomic_load_n(&flight->seats, __ATOMIC_RELAXED);
+    do {
+        if (seats < seatCount) {
+            METRIC_INC(METRIC_RESERVATION_FAILURES);
+            return false;
+        }
+    } while (!__atomic_compare_exchange_n(&flight->seats, &seats, seats - seatCount, true,
+                                          __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+    METRIC_INC(METRIC_RESERVATIONS);
+
+    // Empilha o voo para reindexação apenas se ele ainda não estiver na pilha.
+    FlightSlot &slot = slotAt(id);
+    if (!slot.seatIndexPending.exchange(true)) {
+        int head = pendingSeatHead.load();
+        do {
+            slot.nextPending = head;
+        } while (!pendingSeatHead.compare_exchange_weak(head, id));
+    }
+    return true;
+}
+
+/**
+ * @brief Move no índice de assentos os voos com reservas pendentes.
+ */
+void FlightManager::syncSeatIndex() {
+    if (pendingSeatHead.load() < 0)
+        return;
+    WriteGuard guard(seatIndexLock);
+    int id = pendingSeatHead.exchange(-1);
+    while (id >= 0) {
+        FlightSlot &slot = slotAt(id);
+        int nextId = slot.nextPending;
+        // Liberado antes da leitura: uma reserva posterior empilha o voo de novo.
+        slot.seatIndexPending = false;
+        Flight &flight = flightAt(id);
+        int seats = __atomic_load_n(&flight.seats, __ATOMIC_SEQ_CST);
+        if (slot.active && slot.entries[INDEX_SEATS] && seats != slot.indexedSeats) {
+            unindexField(INDEX_SEATS, flight, slot);
+            slot.indexedSeats = seats;
+            slot.entries[INDEX_SEATS] = indexSeats->insert(seats, &flight);
+            if (bitmapIndex[INDEX_SEATS])
+                bitmapIndex[INDEX_SEATS]->insert(seats, id);
+        }
+        id = nextId;
+    }
+}
+
+/**
+ * @brief Retorna o voo com o identificador fornecido.
+ */
+Flight* FlightManager::getFlight(int id) {
+    if (id < 0 || id >= slotCount || !slotAt(id).active)
+        return nullptr;
+    return &flightAt(id);
+}
+
+/**
+ * @brief Insere o voo de uma posição em um índice.
+ */
+void FlightManager::indexField(int field, Flight &flight, FlightSlot &slot) {
+    // Os índices de tempo não guardam entrada nem têm bitmap.
+    if (field == INDEX_DEPARTURE) {
+        indexDeparture->insert(flight.dep_time, &flight);
+        return;
+    }
+    if (field == INDEX_ARRIVAL) {
+        indexArrival->insert(flight.arr_time, &flight);
+        return;
+    }
+    if (field == INDEX_SEATS)
+        slot.indexedSeats = flight.seats;
+    if (bitmapIndex[field])
+        bitmapIndex[field]->insert(bitmapKey(field, flight, slot), flight.id);
+    FlightListNode* &entry = slot.entries[field];
+    switch (field) {
+        case INDEX_ORIGIN: entry = indexOrigin->insert(flight.origin, &flight); break;
+        case INDEX_DESTINATION: entry = indexDestination->insert(flight.destination, &flight); break;
+        case INDEX_PRICE: entry = indexPrice->insert(flight.price, &flight); break;
+        case INDEX_DURATION: entry = indexDuration->insert(flight.duration, &flight); break;
+        case INDEX_STOPS: entry = indexStops->insert(flight.stops, &flight); break;
+        case INDEX_SEATS: entry = indexSeats->insert(slot.indexedSeats, &flight); break;
+    }
+}
+
+/**
+ * @brief Remove o voo de uma posição de um índice.
+ */
+void FlightManager::unindexField(int field, Flight &flight, FlightSlot &slot) {
+    // Os índices de tempo não guardam entrada: o voo é localizado pela chave.
+    if (field == INDEX_DEPARTURE) {
+        indexDeparture->remove(flight.dep_time, &flight);
+        return;
+    }
+    if (field == INDEX_ARRIVAL) {
+        indexArrival->remove(flight.arr_time, &flight);
+        return;
+    }
+    FlightListNode* entry = slot.entries[field];
+    if (!entry)
+        return;
+    if (bitmapIndex[field])
+        bitmapIndex[field]->remove(bitmapKey(field, flight, slot), flight.id);
+    switch (field) {
+        case INDEX_ORIGIN: indexOrigin->remove(flight.origin, entry); break;
+        case INDEX_DESTINATION: indexDestination->remove(flight.destination, entry); break;
+        case INDEX_PRICE: indexPrice->remove(flight.price, entry); break;
+        case INDEX_DURATION: indexDuration->remove(flight.duration, entry); break;
+        case INDEX_STOPS: indexStops->remove(flight.stops, entry); break;
+        case INDEX_SEATS: indexSeats->remove(slot.indexedSeats, entry); break;
+    }
+    slot.entries[field] = nullptr;
+}
+
+/**
+ * @brief Descarta os índices de bitmap cujo número de chaves passou de 2 * MAX_BITMAP_KEYS.
+ *
+ * Com chaves demais, cada predicado une muitos bitmaps pequenos e a árvore
+ * AVL do campo passa a ser o melhor caminho. Chamada só nas inserções e
+ * atualizações: syncSeatIndex() roda junto com consultas e não descarta nada.
+ */
+void FlightManager::dropCrowdedBitmaps() {
+    for (int field = 0; field < INDEX_COUNT; field++) {
+        if (bitmapIndex[field] && bitmapIndex[field]->getKeyCount() > 2 * MAX_BITMAP_KEYS) {
+            delete bitmapIndex[field];
+            bitmapIndex[field] = nullptr;
+        }
+    }
+}
+
+/**
+ * @brief Calcula a chave de um voo no índice de bitmap de um campo.
+ */
+long long bitmapKey(int field, const Flight &flight, const FlightSlot &slot) {
+    switch (field) {
+        case INDEX_ORIGIN: return flight.origin;
+        case INDEX_DESTINATION: return flight.destination;
+        case INDEX_STOPS: return flight.stops;
+        case INDEX_SEATS: return slot.indexedSeats;
+        default: return 0;
+    }
+}
+
+/**
+ * @brief Calcula a chave com que um predicado é comparado no índice de bitmap do seu campo.
+ *
+ * Mesma conversão de PredicateExpr::evaluate(): o valor numérico é truncado para int.
+ */
+long long bitmapKey(const PredicateExpr* predicate) {
+    if (predicate->field == INDEX_ORIGIN || predicate->field == INDEX_DESTINATION)
+        return predicate->codeValue;
+    return static_cast<int>(predicate->numValue);
+}
+
+/**
+ * @brief Procura recursivamente um predicado indexável na árvore de expressão.
+ *
+ * Apenas predicados com operador diferente de NE e em campos indexáveis são considerados.
+ *
+ * @param expr Ponteiro para a expressão.
+ * @return Ponteiro para o PredicateExpr indexável, ou nullptr se não houver.
+ */
+PredicateExpr* findIndexablePredicate(Expr* expr) {
+    if (!expr)
+        return nullptr;
+    if (expr->kind == EXPR_PREDICATE) {
+        PredicateExpr* predicate = static_cast<PredicateExpr*>(expr);
+        if (predicate->op != PredicateExpr::NE && predicate->field != INDEX_COUNT)
+            return predicate;
+        return nullptr;
+    }
+    if (expr->kind == EXPR_LOGICAL) {
+        LogicalExpr* logical = static_cast<LogicalExpr*>(expr);
+        if (logical->op == '&') {
+            for (int i = 0; i < logical->childCount; i++) {
+                PredicateExpr* predicate = findIndexablePredicate(logical->children[i]);
+                if (predicate)
+                    return predicate;
+            }
+        }
+        return nullptr;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Restringe um intervalo fechado [low, high] com o predicado "campo op valor".
+ *
+ * Limites estritos viram fechados pelo valor vizinho: em campos inteiros,
+ * somando ou subtraindo 1; no preço, pelo double seguinte ou anterior.
+ */
+static void narrowClosedRange(const PredicateExpr* predicate, bool integral, double &low, double &high) {
+    double value = integral ? std::trunc(predicate->numValue) : predicate->numValue;
+    double below = integral ? value - 1 : std::nextafter(value, -HUGE_VAL);
+    double above = integral ? value + 1 : std::nextafter(value, HUGE_VAL);
+    switch (predicate->op) {
+        case PredicateExpr::EQ: low = std::max(low, value); high = std::min(high, value); break;
+        case PredicateExpr::LT: high = std::min(high, below); break;
+        case PredicateExpr::LE: high = std::min(high, value); break;
+        case PredicateExpr::GT: low = std::max(low, above); break;
+        case PredicateExpr::GE: low = std::max(low, value); break;
+        default: break;
+    }
+}
+
+/**
+ * @brief Monta a caixa de preço, duração e partida dos predicados da conjunção principal.
+ */
+int conjunctionBox(const Expr* expr, KDBox &box) {
+    box = KDBox();
+    if (!expr)
+        return 0;
+    const Expr* const* children = &expr;
+    int childCount = 1;
+    if (expr->kind == EXPR_LOGICAL) {
+        const LogicalExpr* logical = static_cast<const LogicalExpr*>(expr);
+        if (logical->op != '&')
+            return 0;
+        children = logical->children;
+        childCount = logical->childCount;
+    }
+    bool restricted[KDBox::DIMENSIONS] = { false, false, false };
+    for (int i = 0; i < childCount; i++) {
+        if (children[i]->kind != EXPR_PREDICATE)
+            continue;
+        const PredicateExpr* predicate = static_cast<const PredicateExpr*>(children[i]);
+        if (predicate->op == PredicateExpr::NE)
+            continue;
+        int dimension;
+        switch (predicate->field) {
+            case INDEX_PRICE: dimension = 0; break;
+            case INDEX_DURATION: dimension = 1; break;
+            case INDEX_DEPARTURE: dimension = 2; break;
+            default: continue;
+        }
+        narrowClosedRange(predicate, dimension != 0, box.low[dimension], box.high[dimension]);
+        restricted[dimension] = true;
+    }
+    return restricted[0] + restricted[1] + restricted[2];
+}
+
+/**
+ * @brief Conta as entradas de um índice que satisfazem "chave op valor" (O(log n)).
+ */
+template<typename Tree>
+static double countIndexRange(const Tree* index, PredicateExpr::CompOp op, const typename Tree::KeyType &value) {
+    switch (op) {
+        case PredicateExpr::EQ: return index->countRange(&value, true, &value, true);
+        case PredicateExpr::NE: return index->entryCount - index->countRange(&value, true, &value, true);
+        case PredicateExpr::LT: return index->countBelow(value, false);
+        case PredicateExpr::LE: return index->countBelow(value, true);
+        case PredicateExpr::GT: return index->entryCount - index->countBelow(value, true);
+        case PredicateExpr::GE: return index->entryCount - index->countBelow(value, false);
+    }
+    return index->entryCount;
+}
+
+/**
+ * @brief Conta quantos voos do índice satisfazem o predicado.
+ */
+double FlightManager::estimateCandidates(const PredicateExpr* predicate) {
+    PredicateExpr::CompOp op = predicate->op;
+    switch (predicate->field) {
+        case INDEX_ORIGIN: return countIndexRange(indexOrigin, op, predicate->codeValue);
+        case INDEX_DESTINATION: return countIndexRange(indexDestination, op, predicate->codeValue);
+        case INDEX_PRICE: return countIndexRange(indexPrice, op, predicate->numValue);
+        case INDEX_DURATION: return countIndexRange(indexDuration, op, static_cast<int>(predicate->numValue));
+        case INDEX_STOPS: return countIndexRange(indexStops, op, static_cast<int>(predicate->numValue));
+        case INDEX_DEPARTURE: return countIndexRange(indexDeparture, op, static_cast<time_t>(predicate->numValue));
+        case INDEX_ARRIVAL: return countIndexRange(indexArrival, op, static_cast<time_t>(predicate->numValue));
+        case INDEX_SEATS: {
+            ReadGuard guard(seatIndexLock);
+            return countIndexRange(indexSeats, op, static_cast<int>(predicate->numValue));
+        }
+        default: return activeCount;
+    }
+}
+
+/**
+ * @brief Conta as entradas de um índice com chave no intervalo fechado [low, high] (limites infinitos = sem limite).
+ */
+template<typename Tree>
+static double countClosedRange(const Tree* index, double low, double high) {
+    typedef typename Tree::KeyType Key;
+    double keyMin = static_cast<double>(std::numeric_limits<Key>::lowest());
+    double keyMax = static_cast<double>(std::numeric_limits<Key>::max());
+    if (low > high || low >= keyMax || high <= keyMin)
+        return 0;
+    Key lowKey = low > keyMin ? static_cast<Key>(low) : Key();
+    Key highKey = high < keyMax ? static_cast<Key>(high) : Key();
+    return index->countRange(low > keyMin ? &lowKey : nullptr, true, high < keyMax ? &highKey : nullptr, true);
+}
+
+/**
+ * @brief Estima quantos voos estão em uma caixa da árvore k-d.
+ */
+double FlightManager::estimateBox(const KDBox &box) {
+    if (activeCount == 0)
+        return 0;
+    double total = activeCount;
+    double estimate = total;
+    estimate *= countClosedRange(indexPrice, box.low[0], box.high[0]) / total;
+    estimate *= countClosedRange(indexDuration, box.low[1], box.high[1]) / total;
+    estimate *= countClosedRange(indexDeparture, box.low[2], box.high[2]) / total;
+    return estimate;
+}
+
+/**
+ * @brief Cria um cursor sobre o intervalo de um índice que satisfaz "chave op valor".
+ *
+ * NE não é indexável; para ele o cursor retornado é vazio.
+ */
+template<typename Tree>
+static typename Tree::Cursor indexCursor(const Tree* index, PredicateExpr::CompOp op,
+                                         const typename Tree::KeyType &value) {
+    switch (op) {
+        case PredicateExpr::EQ: return index->rangeCursor(&value, true, &value, true);
+        case PredicateExpr::LT: return index->rangeCursor(nullptr, true, &value, false);
+        case PredicateExpr::LE: return index->rangeCursor(nullptr, true, &value, true);
+        case PredicateExpr::GT: return index->rangeCursor(&value, false, nullptr, true);
+        case PredicateExpr::GE: return index->rangeCursor(&value, true, nullptr, true);
+        default: return index->rangeCursor(&value, false, &value, false);
+    }
+}
+
+/**
+ * @brief Array de voos aceitos, usado como destino de FlightManager::walkIndex().
+ *
+ * A capacidade inicial é no mínimo 10; o array dobra se faltar espaço.
+ */
+struct MatchArray {
+    Flight** matches;  ///< Voos aceitos (liberado por quem recebe o array).
+    int capacity;      ///< Capacidade de matches.
+    int count;         ///< Voos em matches.
+
+    explicit MatchArray(int initialCapacity)
+        : matches(nullptr), capacity(initialCapacity < 10 ? 10 : initialCapacity), count(0) {
+        matches = new Flight*[capacity];
+    }
+
+    void add(Flight* flight) {
+        if (count >= capacity) {
+            METRIC_INC(METRIC_RANGE_REGROWTHS);
+            int newCapacity = capacity * 2;
+            Flight** newArray = new Flight*[newCapacity];
+            for (int i = 0; i < count; i++)
+                newArray[i] = matches[i];
+            delete[] matches;
+            matches = newArray;
+            capacity = newCapacity;
+        }
+        matches[count++] = flight;
+    }
+};
+
+/**
+ * @brief Restringe o intervalo [low, high] de um índice com o predicado "chave op valor".
+ *
+ * Um limite só é trocado se o novo for mais restritivo; nullptr = sem limite.
+ */
+template<typename T, typename Compare>
+static void narrowRange(const Compare &compare, PredicateExpr::CompOp op, const T &value,
+                        const T* &low, bool &lowInclusive, const T* &high, bool &highInclusive) {
+    if (op == PredicateExpr::EQ || op == PredicateExpr::GT || op == PredicateExpr::GE) {
+        bool inclusive = op != PredicateExpr::GT;
+        int cmp = low ? compare(value, *low) : 1;
+        if (cmp > 0 || (cmp == 0 && !inclusive)) {
+            low = &value;
+            lowInclusive = inclusive;
+        }
+    }
+    if (op == PredicateExpr::EQ || op == PredicateExpr::LT || op == PredicateExpr::LE) {
+        bool inclusive = op != PredicateExpr::LT;
+        int cmp = high ? compare(value, *high) : -1;
+        if (cmp < 0 || (cmp == 0 && !inclusive)) {
+            high = &value;
+            highInclusive = inclusive;
+        }
+    }
+}
+
+/**
+ * @brief Cria um cursor sobre a janela de horários da conjunção principal.
+ *
+ * Além do predicado escolhido, os demais predicados do mesmo campo ligados a
+ * ele por AND no topo do filtro estreitam o intervalo (ex.: "dep>=X && dep<Y"
+ * percorre só [X, Y)), de modo que só os baldes que cruzam a janela são
+ * visitados. O filtro continua sendo avaliado em cada voo.
+ */
+static TimeBucketIndex::Cursor timeWindowCursor(const TimeBucketIndex* index, const PredicateExpr* predicate,
+                                                const Expr* filter) {
+    time_t keys[FlightManager::MAX_RANGE_PREDICATES];
+    const time_t* low = nullptr;
+    const time_t* high = nullptr;
+    bool lowInclusive = true, highInclusive = true;
+    int keyCount = 0;
+    keys[keyCount] = static_cast<time_t>(predicate->numValue);
+    narrowRange(index->compare, predicate->op, keys[keyCount++], low, lowInclusive, high, highInclusive);
+
+    if (filter && filter->kind == EXPR_LOGICAL && static_cast<const LogicalExpr*>(filter)->op == '&') {
+        const LogicalExpr* logical = static_cast<const LogicalExpr*>(filter);
+        for (int i = 0; i < logical->childCount && keyCount < FlightManager::MAX_RANGE_PREDICATES; i++) {
+            if (logical->children[i]->kind != EXPR_PREDICATE || logical->children[i] == predicate)
+                continue;
+            const PredicateExpr* sibling = static_cast<const PredicateExpr*>(logical->children[i]);
+            if (sibling->field != predicate->field || sibling->op == PredicateExpr::NE)
+                continue;
+            keys[keyCount] = static_cast<time_t>(sibling->numValue);
+            narrowRange(index->compare, sibling->op, keys[keyCount++], low, lowInclusive, high, highInclusive);
+        }
+    }
+    return index->rangeCursor(low, lowInclusive, high, highInclusive);
+}
+
+/**
+ * @brief Percorre um cursor entregando a sink os voos que satisfazem o filtro (todos, se filter for nullptr).
+ */
+template<typename Cursor, typename Sink>
+static void walkRange(Cursor cursor, const Expr* filter, Sink &sink, int &scannedCount) {
+    scannedCount = 0;
+    while (Flight* flight = cursor.next()) {
+        scannedCount++;
+        if (!filter || filter->evaluate(*flight))
+            sink.add(flight);
+    }
+}
+
+/**
+ * @brief Percorre o intervalo do índice do predicado, entregando a sink os voos que satisfazem o filtro.
+ */
+template<typename Sink>
+void FlightManager::walkIndex(PredicateExpr* predicate, const Expr* filter, Sink &sink, int &candidateCount) {
+    PredicateExpr::CompOp op = predicate->op;
+    candidateCount = 0;
+    switch (predicate->field) {
+        case INDEX_PRICE:
+            walkRange(indexCursor(indexPrice, op, predicate->numValue), filter, sink, candidateCount);
+            break;
+        case INDEX_DURATION:
+            walkRange(indexCursor(indexDuration, op, static_cast<int>(predicate->numValue)), filter, sink, candidateCount);
+            break;
+        case INDEX_STOPS:
+            walkRange(indexCursor(indexStops, op, static_cast<int>(predicate->numValue)), filter, sink, candidateCount);
+            break;
+        case INDEX_SEATS: {
+            if (op != PredicateExpr::GT && op != PredicateExpr::GE)
+                syncSeatIndex();
+            ReadGuard guard(seatIndexLock);
+            walkRange(indexCursor(indexSeats, op, static_cast<int>(predicate->numValue)), filter, sink, candidateCount);
+            break;
+        }
+        case INDEX_DEPARTURE:
+            walkRange(timeWindowCursor(indexDeparture, predicate, filter), filter, sink, candidateCount);
+            break;
+        case INDEX_ARRIVAL:
+            walkRange(timeWindowCursor(indexArrival, predicate, filter), filter, sink, candidateCount);
+            break;
+        case INDEX_ORIGIN:
+            walkRange(indexCursor(indexOrigin, op, predicate->codeValue), filter, sink, candidateCount);
+            break;
+        case INDEX_DESTINATION:
+            walkRange(indexCursor(indexDestination, op, predicate->codeValue), filter, sink, candidateCount);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Retorna candidatos usando o índice, conforme o predicado.
+ *
+ * @param predicate Predicado indexável.
+ * @param candidateCount (Saída) Número de candidatos encontrados.
+ * @return Array dinamicamente alocado de ponteiros para Flight (deve ser liberado pelo chamador).
+ */
+Flight** FlightManager::getCandidatesFromIndex(PredicateExpr* predicate, int &candidateCount) {
+    int scannedCount;
+    return findMatchesFromIndex(predicate, nullptr, scannedCount, candidateCount);
+}
+
+/**
+ * @brief Percorre o intervalo do índice avaliando a expressão em cada voo.
+ */
+Flight** FlightManager::findMatchesFromIndex(PredicateExpr* predicate, const Expr* filter,
+                                             int &candidateCount, int &matchCount) {
+    if (predicate->field == INDEX_COUNT) {
+        candidateCount = 0;
+        matchCount = 0;
+        return nullptr;
+    }
+    // Sem filtro, o número de candidatos é conhecido de antemão (countRange) e o array não precisa crescer.
+    MatchArray matches(filter ? 0 : static_cast<int>(estimateCandidates(predicate)));
+    walkIndex(predicate, filter, matches, candidateCount);
+    matchCount = matches.count;
+    return matches.matches;
+}
+
+/**
+ * @brief Percorre o intervalo do índice acumulando os voos que satisfazem a expressão.
+ */
+void FlightManager::accumulateMatchesFromIndex(PredicateExpr* predicate, const Expr* filter,
+                                               AggregateResult &result, int &candidateCount) {
+    walkIndex(predicate, filter, result, candidateCount);
+}
+
+/**
+ * @brief Destino da árvore k-d: conta os candidatos e repassa a sink os que satisfazem o filtro.
+ */
+template<typename Sink>
+struct FilteringSink {
+    const Expr* filter;  ///< Expressão avaliada em cada candidato (nullptr = aceita todos).
+    Sink* sink;          ///< Destino dos voos aceitos.
+    int count;           ///< Candidatos recebidos.
+
+    void add(Flight* flight) {
+        count++;
+        if (!filter || filter->evaluate(*flight))
+            sink->add(flight);
+    }
+};
+
+/**
+ * @brief Percorre a caixa da árvore k-d, entregando a sink os voos que satisfazem o filtro.
+ */
+template<typename Sink>
+void FlightManager::walkBox(const KDBox &box, const Expr* filter, Sink &sink, int &candidateCount) {
+    FilteringSink<Sink> filtering;
+    filtering.filter = filter;
+    filtering.sink = &sink;
+    filtering.count = 0;
+    indexRangeBox->search(box, filtering);
+    candidateCount = filtering.count;
+}
+
+/**
+ * @brief Percorre os voos de uma caixa da árvore k-d avaliando a expressão em cada voo.
+ */
+Flight** FlightManager::findMatchesFromBox(const KDBox &box, const Expr* filter, int &candidateCount, int &matchCount) {
+    MatchArray matches(0);
+    walkBox(box, filter, matches, candidateCount);
+    matchCount = matches.count;
+    return matches.matches;
+}
+
+/**
+ * @brief Percorre os voos de uma caixa da árvore k-d acumulando os que satisfazem a expressão.
+ */
+void FlightManager::accumulateMatchesFromBox(const KDBox &box, const Expr* filter, AggregateResult &result,
+                                             int &candidateCount) {
+    walkBox(box, filter, result, candidateCount);
+}
+
+/**
+ * @brief Calcula o bitmap exato de uma subexpressão só com campos de índice de bitmap.
+ *
+ * NOT é a diferença entre os voos ativos e o bitmap do operando. Quem chama
+ * segura seatIndexLock para leitura.
+ */
+RoaringBitmap* FlightManager::bitmapOf(const Expr* expr) {
+    if (expr->kind == EXPR_PREDICATE) {
+        const PredicateExpr* predicate = static_cast<const PredicateExpr*>(expr);
+        if (!hasBitmapIndex(predicate))
+            return nullptr;
+        return bitmapIndex[predicate->field]->select(predicate->op, bitmapKey(predicate));
+    }
+    if (expr->kind == EXPR_NOT) {
+        RoaringBitmap* child = bitmapOf(static_cast<const NotExpr*>(expr)->child);
+        if (!child)
+            return nullptr;
+        RoaringBitmap* result = new RoaringBitmap();
+        result->copyFrom(activeIds);
+        result->andNotWith(*child);
+        delete child;
+        return result;
+    }
+    const LogicalExpr* logical = static_cast<const LogicalExpr*>(expr);
+    RoaringBitmap* result = nullptr;
+    for (int i = 0; i < logical->childCount; i++) {
+        RoaringBitmap* child = bitmapOf(logical->children[i]);
+        if (!child) {
+            delete result;
+            return nullptr;
+        }
+        if (!result) {
+            result = child;
+            continue;
+        }
+        if (logical->op == '&')
+            result->andWith(*child);
+        else
+            result->orWith(*child);
+        delete child;
+    }
+    return result;
+}
+
+/**
+ * @brief Verifica se a subexpressão tem algum predicado sobre o campo.
+ */
+static bool referencesField(const Expr* expr, IndexField field) {
+    if (expr->kind == EXPR_PREDICATE)
+        return static_cast<const PredicateExpr*>(expr)->field == field;
+    if (expr->kind == EXPR_NOT)
+        return referencesField(static_cast<const NotExpr*>(expr)->child, field);
+    const LogicalExpr* logical = static_cast<const LogicalExpr*>(expr);
+    for (int i = 0; i < logical->childCount; i++)
+        if (referencesField(logical->children[i], field))
+            return true;
+    return false;
+}
+
+/**
+ * @brief Calcula a interseção dos bitmaps dos operandos da conjunção principal que têm bitmap.
+ *
+ * O bitmap só dispensa a avaliação da expressão se cobre todos os operandos
+ * e nenhum deles é sobre assentos: reservas feitas depois da sincronização
+ * podem tirar voos do predicado, e a avaliação lê os assentos atuais.
+ */
+RoaringBitmap* FlightManager::candidateBitmap(const Expr* expression, bool &complete) {
+    complete = false;
+    if (!expression)
+        return nullptr;
+    const Expr* const* children = &expression;
+    int childCount = 1;
+    if (expression->kind == EXPR_LOGICAL && static_cast<const LogicalExpr*>(expression)->op == '&') {
+        children = static_cast<const LogicalExpr*>(expression)->children;
+        childCount = static_cast<const LogicalExpr*>(expression)->childCount;
+    }
+
+    if (bitmapIndex[INDEX_SEATS])
+        syncSeatIndex();
+    ReadGuard guard(seatIndexLock);
+    RoaringBitmap* result = nullptr;
+    int coveredCount = 0;
+    bool seats = false;
+    for (int i = 0; i < childCount; i++) {
+        RoaringBitmap* child = bitmapOf(children[i]);
+        if (!child)
+            continue;
+        coveredCount++;
+        seats = seats || referencesField(children[i], INDEX_SEATS);
+        if (!result) {
+            result = child;
+        } else {
+            result->andWith(*child);
+            delete child;
+        }
+    }
+    complete = result && coveredCount == childCount && !seats;
+    return result;
+}
+
+/**
+ * @brief Repassa a um FilteringSink os voos dos identificadores de um bitmap.
+ */
+template<typename Sink>
+struct BitmapVisitor {
+    FlightManager* flightManager;  ///< Dono dos voos.
+    Sink* sink;                    ///< Destino dos voos.
+
+    void operator()(int id) {
+        Flight* flight = flightManager->getFlight(id);
+        if (flight)
+            sink->add(flight);
+    }
+};
+
+/**
+ * @brief Percorre os voos de um bitmap, entregando a sink os que satisfazem o filtro.
+ */
+template<typename Sink>
+void FlightManager::walkBitmap(const RoaringBitmap &bitmap, const Expr* filter, Sink &sink, int &candidateCount) {
+    FilteringSink<Sink> filtering;
+    filtering.filter = filter;
+    filtering.sink = &sink;
+    filtering.count = 0;
+    BitmapVisitor<FilteringSink<Sink> > visitor;
+    visitor.flightManager = this;
+    visitor.sink = &filtering;
+    bitmap.forEach(visitor);
+    candidateCount = filtering.count;
+}
+
+/**
+ * @brief Percorre os voos do bitmap da conjunção principal avaliando a expressão em cada voo.
+ */
+Flight** FlightManager::findMatchesFromBitmap(const Expr* expression, int &candidateCount, int &matchCount) {
+    bool complete;
+    RoaringBitmap* bitmap = candidateBitmap(expression, complete);
+    candidateCount = 0;
+    matchCount = 0;
+    if (!bitmap)
+        return nullptr;
+    MatchArray matches(complete ? bitmap->cardinality() : 0);
+    walkBitmap(*bitmap, complete ? nullptr : expression, matches, candidateCount);
+    matchCount = matches.count;
+    delete bitmap;
+    return matches.matches;
+}
+
+/**
+ * @brief Percorre os voos do bitmap da conjunção principal acumulando os que satisfazem a expressão.
+ */
+void FlightManager::accumulateMatchesFromBitmap(const Expr* expression, AggregateResult &result, int &candidateCount) {
+    bool complete;
+    RoaringBitmap* bitmap = candidateBitmap(expression, complete);
+    candidateCount = 0;
+    if (!bitmap)
+        return;
+    if (complete && result.function == AGG_COUNT)
+        result.count += bitmap->cardinality();
+    else
+        walkBitmap(*bitmap, complete ? nullptr : expression, result, candidateCount);
+    delete bitmap;
+}
+
+/**
+ * @brief Agrega o intervalo de um índice definido pela conjunção dos predicados.
+ *
+ * keys[i] é o valor de predicates[i] já convertido para o tipo da chave.
+ */
+template<typename Tree>
+static void aggregateRange(const Tree* index, PredicateExpr** predicates, const typename Tree::KeyType* keys,
+                           int predicateCount, AggregateResult &result) {
+    const typename Tree::KeyType* low = nullptr;
+    const typename Tree::KeyType* high = nullptr;
+    bool lowInclusive = true, highInclusive = true;
+    for (int i = 0; i < predicateCount; i++)
+        narrowRange(index->compare, predicates[i]->op, keys[i], low, lowInclusive, high, highInclusive);
+
+    result.count = index->countRange(low, lowInclusive, high, highInclusive);
+    result.fromIndex = true;
+    if (result.count == 0 || result.function == AGG_COUNT)
+        return;
+    result.sum = index->sumRange(low, lowInclusive, high, highInclusive);
+    int first = low ? index->countBelow(*low, !lowInclusive) : 0;
+    result.minFlight = index->selectEntry(first);
+    result.maxFlight = index->selectEntry(first + static_cast<int>(result.count) - 1);
+    result.minValue = flightFieldValue(*result.minFlight, result.field);
+    result.maxValue = flightFieldValue(*result.maxFlight, result.field);
+}
+
+/**
+ * @brief Converte os valores dos predicados para chaves numéricas do tipo T e agrega o intervalo.
+ */
+template<typename Tree>
+static void aggregateNumericRange(const Tree* index, PredicateExpr** predicates, int predicateCount,
+                                  AggregateResult &result) {
+    typedef typename Tree::KeyType Key;
+    Key keys[FlightManager::MAX_RANGE_PREDICATES];
+    for (int i = 0; i < predicateCount; i++)
+        keys[i] = static_cast<Key>(predicates[i]->numValue);
+    aggregateRange(index, predicates, keys, predicateCount, result);
+}
+
+/**
+ * @brief Usa os códigos de aeroporto dos predicados como chaves e agrega o intervalo.
+ */
+template<typename Tree>
+static void aggregateCodeRange(const Tree* index, PredicateExpr** predicates, int predicateCount,
+                               AggregateResult &result) {
+    AirportCode keys[FlightManager::MAX_RANGE_PREDICATES];
+    for (int i = 0; i < predicateCount; i++)
+        keys[i] = predicates[i]->codeValue;
+    aggregateRange(index, predicates, keys, predicateCount, result);
+}
+
+/**
+ * @brief Responde a uma agregação só com as contagens e somas dos nós de um índice.
+ */
+bool FlightManager::aggregateFromIndex(Expr* expression, AggregateResult &result) {
+    PredicateExpr* predicates[MAX_RANGE_PREDICATES];
+    int predicateCount = 0;
+    if (!expression) {
+        if (result.function == AGG_COUNT) {
+            result.count = activeCount;
+            result.fromIndex = true;
+            return true;
+        }
+    } else if (expression->kind == EXPR_PREDICATE) {
+        predicates[predicateCount++] = static_cast<PredicateExpr*>(expression);
+    } else if (expression->kind == EXPR_LOGICAL) {
+        LogicalExpr* logical = static_cast<LogicalExpr*>(expression);
+        if (logical->op != '&' || logical->childCount > MAX_RANGE_PREDICATES)
+            return false;
+        for (int i = 0; i < logical->childCount; i++) {
+            if (logical->children[i]->kind != EXPR_PREDICATE)
+                return false;
+            predicates[predicateCount++] = static_cast<PredicateExpr*>(logical->children[i]);
+        }
+    } else {
+        return false;
+    }
+
+    IndexField field = predicateCount > 0 ? predicates[0]->field : result.field;
+    for (int i = 0; i < predicateCount; i++)
+        if (predicates[i]->field != field || predicates[i]->op == PredicateExpr::NE)
+            return false;
+    if (result.function != AGG_COUNT && result.field != field)
+        return false;
+
+    switch (field) {
+        case INDEX_ORIGIN: aggregateCodeRange(indexOrigin, predicates, predicateCount, result); break;
+        case INDEX_DESTINATION: aggregateCodeRange(indexDestination, predicates, predicateCount, result); break;
+        case INDEX_PRICE: aggregateNumericRange(indexPrice, predicates, predicateCount, result); break;
+        case INDEX_DURATION: aggregateNumericRange(indexDuration, predicates, predicateCount, result); break;
+        case INDEX_STOPS: aggregateNumericRange(indexStops, predicates, predicateCount, result); break;
+        case INDEX_SEATS: {
+            // As chaves precisam refletir as reservas já feitas.
+            syncSeatIndex();
+            ReadGuard guard(seatIndexLock);
+            aggregateNumericRange(indexSeats, predicates, predicateCount, result);
+            break;
+        }
+        case INDEX_DEPARTURE: aggregateNumericRange(indexDeparture, predicates, predicateCount, result); break;
+        case INDEX_ARRIVAL: aggregateNumericRange(indexArrival, predicates, predicateCount, result); break;
+        default: return false;
+    }
+    return true;
+}
@@ -0,0 +1,592 @@
+#include "../include/ItinerarySearch.hpp"
+#include "../include/Sort.hpp"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <limits>
+
+/**
+ * @brief Estado de uma busca: parâmetros, heap dos melhores itinerários e mínimos das rotas até o destino.
+ */
+struct ItinerarySearch::SearchState {
+    const ItineraryQuery* query;  ///< Parâmetros da busca.
+    int origin;                   ///< Aeroporto de partida (posição em airports).
+    int destination;              ///< Aeroporto de chegada (posição em airports).
+    Itinerary* heap;              ///< Melhores itinerários; o pior fica na raiz.
+    int heapSize;                 ///< Itinerários no heap.
+    double* minPrice;             ///< Menor preço de um voo de cada aeroporto até o destino (HUGE_VAL = sem rota).
+    int* minDuration;             ///< Menor duração de um voo de cada aeroporto até o destino.
+    int* minStops;                ///< Menor número de paradas de um voo de cada aeroporto até o destino.
+    double anyPrice;              ///< Menor preço de qualquer voo até o destino.
+    int anyDuration;              ///< Menor duração de qualquer voo até o destino.
+    int anyStops;                 ///< Menor número de paradas de qualquer voo até o destino.
+    int examined;                 ///< Trechos examinados.
+};
+
+/**
+ * @brief Voo com o seu identificador global, usado na montagem das listas.
+ */
+struct FlightEntry {
+    Flight* flight;  ///< Voo.
+    int id;          ///< Identificador global.
+};
+
+/**
+ * @brief Ordem de montagem por origem: origem, partida e identificador global.
+ */
+static bool originOrderLess(const FlightEntry &a, const FlightEntry &b) {
+    if (a.flight->origin != b.flight->origin)
+        return a.flight->origin < b.flight->origin;
+    if (a.flight->dep_time != b.flight->dep_time)
+        return a.flight->dep_time < b.flight->dep_time;
+    return a.id < b.id;
+}
+
+/**
+ * @brief Ordem de montagem por rota: origem, destino, partida e identificador global.
+ */
+static bool routeOrderLess(const FlightEntry &a, const FlightEntry &b) {
+    if (a.flight->origin != b.flight->origin)
+        return a.flight->origin < b.flight->origin;
+    if (a.flight->destination != b.flight->destination)
+        return a.flight->destination < b.flight->destination;
+    if (a.flight->dep_time != b.flight->dep_time)
+        return a.flight->dep_time < b.flight->dep_time;
+    return a.id < b.id;
+}
+
+/**
+ * @brief Posição do primeiro voo de flights[start, end) com partida maior ou igual a time.
+ */
+static int firstDepartureFrom(Flight** flights, int start, int end, time_t time) {
+    while (start < end) {
+        int middle = start + (end - start) / 2;
+        if (flights[middle]->dep_time < time)
+            start = middle + 1;
+        else
+            end = middle;
+    }
+    return start;
+}
+
+/**
+ * @brief Estreita [low, high] (inclusive) com os predicados de partida da conjunção principal do filtro.
+ *
+ * Os voos de cada aeroporto estão ordenados pela partida, então a janela vira
+ * uma faixa de posições; o filtro continua sendo avaliado em cada voo.
+ */
+static void departureWindow(const Expr* filter, time_t &low, time_t &high) {
+    if (!filter)
+        return;
+    const Expr* const* children = &filter;
+    int childCount = 1;
+    if (filter->kind == EXPR_LOGICAL && static_cast<const LogicalExpr*>(filter)->op == '&') {
+        children = static_cast<const LogicalExpr*>(filter)->children;
+        childCount = static_cast<const LogicalExpr*>(filter)->childCount;
+    }
+    for (int i = 0; i < childCount; i++) {
+        if (children[i]->kind != EXPR_PREDICATE)
+            continue;
+        const PredicateExpr* predicate = static_cast<const PredicateExpr*>(children[i]);
+        if (predicate->field != INDEX_DEPARTURE || predicate->parameterIndex >= 0)
+            continue;
+        time_t value = static_cast<time_t>(predicate->numValue);
+        if (predicate->op == PredicateExpr::EQ || predicate->op == PredicateExpr::GE)
+            low = std::max(low, value);
+        else if (predicate->op == PredicateExpr::GT)
+            low = std::max(low, value + 1);
+        if (predicate->op == PredicateExpr::EQ || predicate->op == PredicateExpr::LE)
+            high = std::min(high, value);
+        else if (predicate->op == PredicateExpr::LT)
+            high = std::min(high, value - 1);
+    }
+}
+
+/**
+ * @brief Calcula os totais de um itinerário a partir dos seus trechos.
+ *
+ * Os assentos do total são os do trecho com menos assentos livres.
+ */
+static void computeTotal(Itinerary &itinerary) {
+    const Flight* first = itinerary.legs[0];
+    const Flight* last = itinerary.legs[itinerary.legCount - 1];
+    Flight &total = itinerary.total;
+    total.origin = first->origin;
+    total.destination = last->destination;
+    total.dep_time = first->dep_time;
+    total.arr_time = last->arr_time;
+    total.duration = static_cast<int>(last->arr_time - first->dep_time);
+    total.price = 0;
+    total.stops = itinerary.legCount - 1;
+    total.seats = INT_MAX;
+    total.id = -1;
+    for (int i = 0; i < itinerary.legCount; i++) {
+        const Flight* leg = itinerary.legs[i];
+        total.price += leg->price;
+        total.stops += leg->stops;
+        int seats = __atomic_load_n(&leg->seats, __ATOMIC_RELAXED);
+        if (seats < total.seats)
+            total.seats = seats;
+    }
+}
+
+/**
+ * @brief Limite inferior dos totais de um itinerário que ainda precisa de pelo menos mais um trecho.
+ *
+ * @param prefix Trechos já escolhidos.
+ * @param layover Espera mínima na próxima conexão.
+ * @param price Menor preço do restante.
+ * @param duration Menor duração de voo do restante.
+ * @param stops Menor número de paradas do restante (conexões incluídas).
+ * @param bound (Saída) Totais mínimos.
+ */
+static void boundTotal(const Itinerary &prefix, int layover, double price, int duration, int stops, Flight &bound) {
+    const Flight* first = prefix.legs[0];
+    const Flight* last = prefix.legs[prefix.legCount - 1];
+    bound.price = price;
+    bound.stops = prefix.legCount + stops;
+    for (int i = 0; i < prefix.legCount; i++) {
+        bound.price += prefix.legs[i]->price;
+        bound.stops += prefix.legs[i]->stops;
+    }
+    // Folga para o arredondamento: o total soma os mesmos preços em outra ordem.
+    bound.price -= std::fabs(bound.price) * 1e-12;
+    bound.duration = static_cast<int>(last->arr_time + layover + duration - first->dep_time);
+}
+
+/**
+ * @brief Compara dois itinerários pelos critérios; empates seguem o número de trechos e os identificadores globais.
+ */
+static int compareItineraries(const Itinerary &a, const Itinerary &b, const string &criteria) {
+    int result = compareFlightByCriteria(&a.total, &b.total, criteria);
+    if (result != 0)
+        return result;
+    if (a.legCount != b.legCount)
+        return a.legCount < b.legCount ? -1 : 1;
+    for (int i = 0; i < a.legCount; i++)
+        if (a.legIds[i] != b.legIds[i])
+            return a.legIds[i] < b.legIds[i] ? -1 : 1;
+    return 0;
+}
+
+/**
+ * @brief Desce um itinerário no heap (o pior na raiz).
+ */
+static void siftDown(Itinerary* heap, int size, int index, const string &criteria) {
+    while (true) {
+        int worst = index;
+        int left = 2 * index + 1, right = left + 1;
+        if (left < size && compareItineraries(heap[left], heap[worst], criteria) > 0)
+            worst = left;
+        if (right < size && compareItineraries(heap[right], heap[worst], criteria) > 0)
+            worst = right;
+        if (worst == index)
+            return;
+        Itinerary temp = heap[index];
+        heap[index] = heap[worst];
+        heap[worst] = temp;
+        index = worst;
+    }
+}
+
+/**
+ * @brief Trecho inicial de uma busca com o limite inferior dos totais dos itinerários que começam nele.
+ */
+struct FirstLeg {
+    Flight* flight;  ///< Voo do trecho.
+    int id;          ///< Identificador global do voo.
+    int hub;         ///< Aeroporto de chegada (posição em airports).
+    Flight bound;    ///< Limite inferior dos totais.
+};
+
+/**
+ * @brief Ordem de visita dos trechos iniciais: limite inferior crescente, depois identificador global.
+ */
+struct FirstLegLess {
+    const string* criteria;
+
+    bool operator()(const FirstLeg &a, const FirstLeg &b) const {
+        int result = compareFlightByCriteria(&a.bound, &b.bound, *criteria);
+        return result != 0 ? result < 0 : a.id < b.id;
+    }
+};
+
+/**
+ * @brief Construtor: as listas são montadas na primeira busca.
+ */
+ItinerarySearch::ItinerarySearch(FlightManager &flightManager)
+    : singleManager(&flightManager), flightManagers(&singleManager), managerCount(1), store(nullptr),
+      builtVersion(-1), airports(nullptr), airportCount(0), originFlights(nullptr), originIds(nullptr),
+      originStart(nullptr), routeFlights(nullptr), routeIds(nullptr), routes(nullptr), routeCount(0),
+      routeStart(nullptr) {}
+
+/**
+ * @brief Construtor sobre um armazenamento particionado.
+ */
+ItinerarySearch::ItinerarySearch(const PartitionedStore &store)
+    : singleManager(nullptr), flightManagers(store.getPartitions()), managerCount(store.getPartitionCount()),
+      store(&store), builtVersion(-1), airports(nullptr), airportCount(0), originFlights(nullptr),
+      originIds(nullptr), originStart(nullptr), routeFlights(nullptr), routeIds(nullptr), routes(nullptr),
+      routeCount(0), routeStart(nullptr) {}
+
+/**
+ * @brief Destrutor: libera as listas de adjacência.
+ */
+ItinerarySearch::~ItinerarySearch() {
+    clear();
+}
+
+/**
+ * @brief Libera as listas de adjacência.
+ */
+void ItinerarySearch::clear() {
+    delete[] airports;
+    delete[] originFlights;
+    delete[] originIds;
+    delete[] originStart;
+    delete[] routeFlights;
+    delete[] routeIds;
+    delete[] routes;
+    delete[] routeStart;
+    airports = nullptr;
+    originFlights = nullptr;
+    originIds = nullptr;
+    originStart = nullptr;
+    routeFlights = nullptr;
+    routeIds = nullptr;
+    routes = nullptr;
+    routeStart = nullptr;
+    airportCount = 0;
+    routeCount = 0;
+    builtVersion = -1;
+}
+
+/**
+ * @brief Remonta as listas de adjacência se os voos mudaram desde a última montagem.
+ *
+ * Custo O(n log n): duas ordenações dos voos ativos (por origem e por rota).
+ */
+void ItinerarySearch::refresh() {
+    int version = 0, flightCount = 0;
+    for (int m = 0; m < managerCount; m++) {
+        version += flightManagers[m]->getVersion();
+        flightCount += flightManagers[m]->getFlightCount();
+    }
+    if (builtVersion == version)
+        return;
+    clear();
+
+    FlightEntry* entries = new FlightEntry[flightCount > 0 ? flightCount : 1];
+    AirportCode* codes = new AirportCode[2 * flightCount + 1];
+    int count = 0;
+    for (int m = 0; m < managerCount; m++) {
+        FlightManager &flightManager = *flightManagers[m];
+        for (int id = 0; id < flightManager.getSlotCount(); id++) {
+            Flight* flight = flightManager.getFlight(id);
+            if (!flight)
+                continue;
+            entries[count].flight = flight;
+            entries[count].id = store ? store->globalId(m, id) : id;
+            codes[2 * count] = flight->origin;
+            codes[2 * count + 1] = flight->destination;
+            count++;
+        }
+    }
+
+    std::sort(codes, codes + 2 * count);
+    airportCount = static_cast<int>(std::unique(codes, codes + 2 * count) - codes);
+    airports = new AirportCode[airportCount > 0 ? airportCount : 1];
+    for (int i = 0; i < airportCount; i++)
+        airports[i] = codes[i];
+    delete[] codes;
+
+    std::sort(entries, entries + count, originOrderLess);
+    originFlights = new Flight*[count > 0 ? count : 1];
+    originIds = new int[count > 0 ? count : 1];
+    for (int i = 0; i < count; i++) {
+        originFlights[i] = entries[i].flight;
+        originIds[i] = entries[i].id;
+    }
+    originStart = new int[airportCount + 1];
+    for (int airport = 0, i = 0; airport <= airportCount; airport++) {
+        while (i < count && airport < airportCount && originFlights[i]->origin < airports[airport])
+            i++;
+        originStart[airport] = airport < airportCount ? i : count;
+    }
+
+    std::sort(entries, entries + count, routeOrderLess);
+    routeFlights = new Flight*[count > 0 ? count : 1];
+    routeIds = new int[count > 0 ? count : 1];
+    for (int i = 0; i < count; i++) {
+        routeFlights[i] = entries[i].flight;
+        routeIds[i] = entries[i].id;
+    }
+    delete[] entries;
+
+    routes = new Route[count > 0 ? count : 1];
+    routeStart = new int[airportCount + 1];
+    int originAirport = 0;
+    for (int i = 0; i < count; ) {
+        Route &route = routes[routeCount];
+        while (airports[originAirport] != routeFlights[i]->origin)
+            routeStart[++originAirport] = routeCount;
+        route.origin = originAirport;
+        route.destination = findAirport(routeFlights[i]->destination);
+        route.start = i;
+        route.minPrice = routeFlights[i]->price;
+        route.minDuration = routeFlights[i]->duration;
+        route.minStops = routeFlights[i]->stops;
+        for (i++; i < count && routeFlights[i]->origin == routeFlights[route.start]->origin
+                  && routeFlights[i]->destination == routeFlights[route.start]->destination; i++) {
+            route.minPrice = std::min(route.minPrice, routeFlights[i]->price);
+            route.minDuration = std::min(route.minDuration, routeFlights[i]->duration);
+            route.minStops = std::min(route.minStops, routeFlights[i]->stops);
+        }
+        route.end = i;
+        routeCount++;
+    }
+    routeStart[0] = 0;
+    while (originAirport < airportCount)
+        routeStart[++originAirport] = routeCount;
+
+    builtVersion = version;
+}
+
+/**
+ * @brief Retorna a posição de um aeroporto em airports, ou -1 se ele não tem voos.
+ */
+int ItinerarySearch::findAirport(AirportCode code) const {
+    int low = 0, high = airportCount;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (airports[middle] < code)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low < airportCount && airports[low] == code ? low : -1;
+}
+
+/**
+ * @brief Retorna a rota entre dois aeroportos, ou nullptr se não há voos.
+ */
+const ItinerarySearch::Route* ItinerarySearch::findRoute(int origin, int destination) const {
+    int low = routeStart[origin], high = routeStart[origin + 1];
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (routes[middle].destination < destination)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low < routeStart[origin + 1] && routes[low].destination == destination ? &routes[low] : nullptr;
+}
+
+/**
+ * @brief Oferece um itinerário completo ao heap dos melhores.
+ */
+void ItinerarySearch::offer(SearchState &state, const Itinerary &itinerary) const {
+    const string &criteria = state.query->sortCriteria;
+    if (state.heapSize < state.query->maxResults) {
+        // Sobe o novo itinerário enquanto ele for pior que o pai.
+        int index = state.heapSize++;
+        state.heap[index] = itinerary;
+        while (index > 0) {
+            int parent = (index - 1) / 2;
+            if (compareItineraries(state.heap[index], state.heap[parent], criteria) <= 0)
+                break;
+            Itinerary temp = state.heap[index];
+            state.heap[index] = state.heap[parent];
+            state.heap[parent] = temp;
+            index = parent;
+        }
+    } else if (compareItineraries(itinerary, state.heap[0], criteria) < 0) {
+        state.heap[0] = itinerary;
+        siftDown(state.heap, state.heapSize, 0, criteria);
+    }
+}
+
+/**
+ * @brief Verifica se um limite inferior dos totais já é pior que o último itinerário do heap.
+ *
+ * Todo itinerário que completa o limite tem totais maiores ou iguais em cada
+ * campo, então também não é menor na ordem dos critérios. Empates nos
+ * critérios não podam, pois ainda podem ganhar no desempate.
+ */
+bool ItinerarySearch::pruned(const SearchState &state, const Flight &bound) const {
+    return state.heapSize == state.query->maxResults
+        && compareFlightByCriteria(&bound, &state.heap[0].total, state.query->sortCriteria) > 0;
+}
+
+/**
+ * @brief Completa o itinerário com um voo da rota hub -> destino que respeite a espera na conexão.
+ */
+void ItinerarySearch::finishFrom(SearchState &state, Itinerary &prefix, int hub) const {
+    const Route* route = findRoute(hub, state.destination);
+    if (!route)
+        return;
+    time_t arrival = prefix.legs[prefix.legCount - 1]->arr_time;
+    time_t latest = arrival + state.query->maxLayover;
+    Itinerary itinerary = prefix;
+    itinerary.legCount = prefix.legCount + 1;
+    for (int i = firstDepartureFrom(routeFlights, route->start, route->end, arrival + state.query->minLayover);
+         i < route->end && routeFlights[i]->dep_time <= latest; i++) {
+        state.examined++;
+        itinerary.legs[prefix.legCount] = routeFlights[i];
+        itinerary.legIds[prefix.legCount] = routeIds[i];
+        computeTotal(itinerary);
+        offer(state, itinerary);
+    }
+}
+
+/**
+ * @brief Acrescenta um trecho intermediário saindo de hub e completa cada itinerário até o destino.
+ *
+ * Trechos que voltam a um aeroporto já visitado, que chegam direto ao destino
+ * (cobertos por finishFrom()) ou que chegam a um aeroporto sem rota até o
+ * destino são descartados, assim como os que não podem melhorar o heap.
+ */
+void ItinerarySearch::connectFrom(SearchState &state, Itinerary &prefix, int hub) const {
+    time_t arrival = prefix.legs[prefix.legCount - 1]->arr_time;
+    time_t latest = arrival + state.query->maxLayover;
+    Itinerary itinerary = prefix;
+    itinerary.legCount = prefix.legCount + 1;
+    Flight bound;
+    int end = originStart[hub + 1];
+    for (int i = firstDepartureFrom(originFlights, originStart[hub], end, arrival + state.query->minLayover);
+         i < end && originFlights[i]->dep_time <= latest; i++) {
+        state.examined++;
+        Flight* leg = originFlights[i];
+        int next = findAirport(leg->destination);
+        if (next == state.destination || next == state.origin || next == hub
+            || state.minPrice[next] == HUGE_VAL)
+            continue;
+        itinerary.legs[prefix.legCount] = leg;
+        itinerary.legIds[prefix.legCount] = originIds[i];
+        boundTotal(itinerary, state.query->minLayover, state.minPrice[next], state.minDuration[next],
+                   state.minStops[next], bound);
+        if (pruned(state, bound))
+            continue;
+        finishFrom(state, itinerary, next);
+    }
+}
+
+/**
+ * @brief Busca os melhores itinerários entre dois aeroportos.
+ */
+Itinerary* ItinerarySearch::search(const ItineraryQuery &query, int &resultCount, int* examinedCount) {
+    refresh();
+    resultCount = 0;
+    if (examinedCount)
+        *examinedCount = 0;
+    Itinerary* results = new Itinerary[query.maxResults > 0 ? query.maxResults : 1];
+    int origin = findAirport(query.origin);
+    int destination = findAirport(query.destination);
+    if (origin < 0 || destination < 0 || origin == destination || query.maxResults <= 0)
+        return results;
+
+    SearchState state;
+    state.query = &query;
+    state.origin = origin;
+    state.destination = destination;
+    state.heap = results;
+    state.heapSize = 0;
+    state.examined = 0;
+    state.minPrice = new double[airportCount];
+    state.minDuration = new int[airportCount];
+    state.minStops = new int[airportCount];
+    state.anyPrice = HUGE_VAL;
+    state.anyDuration = INT_MAX;
+    state.anyStops = INT_MAX;
+    for (int airport = 0; airport < airportCount; airport++) {
+        state.minPrice[airport] = HUGE_VAL;
+        const Route* route = findRoute(airport, destination);
+        if (!route)
+            continue;
+        state.minPrice[airport] = route->minPrice;
+        state.minDuration[airport] = route->minDuration;
+        state.minStops[airport] = route->minStops;
+        state.anyPrice = std::min(state.anyPrice, route->minPrice);
+        state.anyDuration = std::min(state.anyDuration, route->minDuration);
+        state.anyStops = std::min(state.anyStops, route->minStops);
+    }
+
+    // Trechos iniciais com o limite inferior dos itinerários que começam em cada um.
+    int start = originStart[origin], end = originStart[origin + 1];
+    time_t low = std::numeric_limits<time_t>::min(), high = std::numeric_limits<time_t>::max();
+    departureWindow(query.filter, low, high);
+    if (low > high) {
+        end = start;
+    } else {
+        end = high == std::numeric_limits<time_t>::max() ? end : firstDepartureFrom(originFlights, start, end, high + 1);
+        start = firstDepartureFrom(originFlights, start, end, low);
+    }
+    FirstLeg* firstLegs = new FirstLeg[end > start ? end - start : 1];
+    int firstCount = 0;
+    for (int i = start; i < end; i++) {
+        Flight* flight = originFlights[i];
+        state.examined++;
+        if (query.filter && !query.filter->evaluate(*flight))
+            continue;
+        FirstLeg &first = firstLegs[firstCount];
+        first.flight = flight;
+        first.id = originIds[i];
+        first.hub = findAirport(flight->destination);
+        Itinerary prefix;
+        prefix.legs[0] = flight;
+        prefix.legIds[0] = first.id;
+        prefix.legCount = 1;
+        if (first.hub == destination) {
+            computeTotal(prefix);
+            first.bound = prefix.total;
+        } else if (first.hub == origin || query.maxConnections == 0) {
+            continue;
+        } else if (query.maxConnections == 1) {
+            if (state.minPrice[first.hub] == HUGE_VAL)
+                continue;
+            boundTotal(prefix, query.minLayover, state.minPrice[first.hub], state.minDuration[first.hub],
+                       state.minStops[first.hub], first.bound);
+        } else {
+            // Com duas conexões, o restante pode passar por outro aeroporto: vale o mínimo geral.
+            boundTotal(prefix, query.minLayover, state.anyPrice, state.anyDuration, state.anyStops, first.bound);
+        }
+        firstCount++;
+    }
+    FirstLegLess less;
+    less.criteria = &query.sortCriteria;
+    std::sort(firstLegs, firstLegs + firstCount, less);
+
+    for (int i = 0; i < firstCount; i++) {
+        // Os limites seguintes são maiores ou iguais: nenhum deles melhora o heap.
+        if (pruned(state, firstLegs[i].bound))
+            break;
+        Itinerary prefix;
+        prefix.legs[0] = firstLegs[i].flight;
+        prefix.legIds[0] = firstLegs[i].id;
+        prefix.legCount = 1;
+        if (firstLegs[i].hub == destination) {
+            computeTotal(prefix);
+            offer(state, prefix);
+            continue;
+        }
+        finishFrom(state, prefix, firstLegs[i].hub);
+        if (query.maxConnections >= 2)
+            connectFrom(state, prefix, firstLegs[i].hub);
+    }
+    delete[] firstLegs;
+    delete[] state.minPrice;
+    delete[] state.minDuration;
+    delete[] state.minStops;
+
+    // Ordena o heap no lugar: o pior vai para o fim a cada passo.
+    resultCount = state.heapSize;
+    for (int size = state.heapSize - 1; size > 0; size--) {
+        Itinerary temp = results[0];
+        results[0] = results[size];
+        results[size] = temp;
+        siftDown(results, size, 0, query.sortCriteria);
+    }
+    if (examinedCount)
+        *examinedCount = state.examined;
+    return results;
+}
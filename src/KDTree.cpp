@@ -0,0 +1,205 @@
+#include "../include/KDTree.hpp"
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Construtor: caixa sem limites.
+ */
+KDBox::KDBox() {
+    for (int d = 0; d < DIMENSIONS; d++) {
+        low[d] = -HUGE_VAL;
+        high[d] = HUGE_VAL;
+    }
+}
+
+/**
+ * @brief Ordem dos pontos em uma dimensão, usada na escolha da mediana.
+ */
+struct KDPointLess {
+    int dimension;
+
+    bool operator()(const KDPoint &a, const KDPoint &b) const {
+        return a.coords[dimension] < b.coords[dimension];
+    }
+};
+
+/**
+ * @brief Construtor: árvore vazia.
+ */
+KDTree::KDTree()
+    : points(nullptr), treeSize(0), pointCount(0), pointCapacity(0), nodes(nullptr), nodeCount(0),
+      nodeCapacity(0), positions(nullptr), positionCapacity(0), liveCount(0), removedCount(0) {}
+
+/**
+ * @brief Destrutor: libera os pontos e os nós.
+ */
+KDTree::~KDTree() {
+    delete[] points;
+    delete[] nodes;
+    delete[] positions;
+}
+
+/**
+ * @brief Calcula as coordenadas (preço, duração, partida) de um voo.
+ */
+void KDTree::coordinatesOf(const Flight &flight, double* coords) {
+    coords[0] = flight.price;
+    coords[1] = flight.duration;
+    coords[2] = static_cast<double>(flight.dep_time);
+}
+
+/**
+ * @brief Carrega a árvore de uma vez.
+ */
+void KDTree::build(Flight** flights, int count) {
+    pointCapacity = count > LEAF_SIZE ? count : LEAF_SIZE;
+    points = new KDPoint[pointCapacity];
+    for (int i = 0; i < count; i++) {
+        coordinatesOf(*flights[i], points[i].coords);
+        points[i].flight = flights[i];
+    }
+    pointCount = count;
+    liveCount = count;
+    rebuild();
+}
+
+/**
+ * @brief Insere um voo no trecho de transbordo.
+ */
+void KDTree::insert(Flight* flight) {
+    if (pointCount == pointCapacity) {
+        int newCapacity = pointCapacity ? pointCapacity * 2 : LEAF_SIZE;
+        KDPoint* newPoints = new KDPoint[newCapacity];
+        for (int i = 0; i < pointCount; i++)
+            newPoints[i] = points[i];
+        delete[] points;
+        points = newPoints;
+        pointCapacity = newCapacity;
+    }
+    KDPoint &point = points[pointCount];
+    coordinatesOf(*flight, point.coords);
+    point.flight = flight;
+    setPosition(flight->id, pointCount);
+    pointCount++;
+    liveCount++;
+
+    int overflow = pointCount - treeSize;
+    if (overflow > LEAF_SIZE * 8 && overflow > treeSize / 16)
+        rebuild();
+}
+
+/**
+ * @brief Remove o ponto de um voo.
+ *
+ * O ponto só é marcado; o espaço é recuperado na próxima reconstrução.
+ */
+bool KDTree::remove(const Flight* flight) {
+    int id = flight->id;
+    if (id < 0 || id >= positionCapacity || positions[id] < 0)
+        return false;
+    points[positions[id]].flight = nullptr;
+    positions[id] = -1;
+    liveCount--;
+    removedCount++;
+    if (removedCount > LEAF_SIZE * 8 && removedCount > liveCount / 4)
+        rebuild();
+    return true;
+}
+
+/**
+ * @brief Reconstrói a árvore com os pontos ativos.
+ *
+ * Os pontos removidos são descartados; a divisão custa O(n log n)
+ * (std::nth_element em cada nível).
+ */
+void KDTree::rebuild() {
+    int count = 0;
+    for (int i = 0; i < pointCount; i++)
+        if (points[i].flight)
+            points[count++] = points[i];
+    pointCount = count;
+    treeSize = count;
+    removedCount = 0;
+
+    delete[] nodes;
+    // Folhas têm ao menos LEAF_SIZE / 2 pontos, então há menos de 4n / LEAF_SIZE nós.
+    nodeCapacity = 4 * (count / LEAF_SIZE) + 1;
+    nodes = new KDNode[nodeCapacity];
+    nodeCount = 0;
+    if (count > 0)
+        buildNode(0, count);
+    for (int i = 0; i < count; i++)
+        setPosition(points[i].flight->id, i);
+}
+
+/**
+ * @brief Divide recursivamente points[start, end) e retorna o nó criado.
+ */
+int KDTree::buildNode(int start, int end) {
+    const int D = KDBox::DIMENSIONS;
+    int index = nodeCount++;
+    KDNode &node = nodes[index];
+    node.start = start;
+    node.end = end;
+    node.left = -1;
+    node.right = -1;
+    for (int d = 0; d < D; d++) {
+        node.low[d] = HUGE_VAL;
+        node.high[d] = -HUGE_VAL;
+    }
+    for (int i = start; i < end; i++) {
+        for (int d = 0; d < D; d++) {
+            node.low[d] = std::min(node.low[d], points[i].coords[d]);
+            node.high[d] = std::max(node.high[d], points[i].coords[d]);
+        }
+    }
+    if (end - start <= LEAF_SIZE)
+        return index;
+
+    KDPointLess less;
+    less.dimension = 0;
+    for (int d = 1; d < D; d++)
+        if (node.high[d] - node.low[d] > node.high[less.dimension] - node.low[less.dimension])
+            less.dimension = d;
+    if (node.high[less.dimension] == node.low[less.dimension])
+        return index;  // Pontos iguais em todas as dimensões: a folha fica maior.
+
+    int middle = start + (end - start) / 2;
+    std::nth_element(points + start, points + middle, points + end, less);
+    int left = buildNode(start, middle);
+    int right = buildNode(middle, end);
+    nodes[index].left = left;
+    nodes[index].right = right;
+    return index;
+}
+
+/**
+ * @brief Registra a posição do ponto de um voo, ampliando positions se preciso.
+ */
+void KDTree::setPosition(int id, int position) {
+    if (id >= positionCapacity) {
+        int newCapacity = positionCapacity ? positionCapacity : 1024;
+        while (newCapacity <= id)
+            newCapacity *= 2;
+        int* newPositions = new int[newCapacity];
+        for (int i = 0; i < positionCapacity; i++)
+            newPositions[i] = positions[i];
+        for (int i = positionCapacity; i < newCapacity; i++)
+            newPositions[i] = -1;
+        delete[] positions;
+        positions = newPositions;
+        positionCapacity = newCapacity;
+    }
+    positions[id] = position;
+}
+
+/**
+ * @brief Acrescenta a memória da árvore ao relatório.
+ *
+ * Os pontos removidos continuam ocupando o array até a próxima reconstrução.
+ */
+void KDTree::reportMemory(MemoryReport &report, const string &name) const {
+    report.addArray(name + ".points", pointCount, pointCapacity, sizeof(KDPoint));
+    report.addArray(name + ".nodes", nodeCount, nodeCapacity, sizeof(KDNode));
+    report.addArray(name + ".positions", liveCount, positionCapacity, sizeof(int));
+}
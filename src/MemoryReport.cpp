@@ -0,0 +1,108 @@
+#include "../include/MemoryReport.hpp"
+#include "../include/Metrics.hpp"
+
+/**
+ * @brief Soma objetos e bytes a uma entrada (criada se o nome é novo).
+ *
+ * Entradas além de MAX_ENTRIES são somadas à última.
+ */
+void MemoryReport::add(const string &name, long long objects, long long bytes, long long heapBytes) {
+    int i = 0;
+    while (i < entryCount && entries[i].name != name)
+        i++;
+    if (i == entryCount) {
+        if (entryCount == MAX_ENTRIES) {
+            i = MAX_ENTRIES - 1;
+        } else {
+            entries[i].name = name;
+            entries[i].objects = 0;
+            entries[i].bytes = 0;
+            entries[i].heapBytes = 0;
+            entryCount++;
+        }
+    }
+    entries[i].objects += objects;
+    entries[i].bytes += bytes;
+    entries[i].heapBytes += heapBytes;
+}
+
+long long MemoryReport::totalBytes() const {
+    long long total = 0;
+    for (int i = 0; i < entryCount; i++)
+        total += entries[i].bytes;
+    return total;
+}
+
+long long MemoryReport::totalHeapBytes() const {
+    long long total = 0;
+    for (int i = 0; i < entryCount; i++)
+        total += entries[i].heapBytes;
+    return total;
+}
+
+void MemoryReport::print(FILE* out) const {
+    long long heapTotal = totalHeapBytes();
+    for (int i = 0; i < entryCount; i++) {
+        const MemoryEntry &entry = entries[i];
+        fprintf(out, "MEMORY structure=%s objects=%lld bytes=%lld heap_bytes=%lld share=%.1f%%\n",
+                entry.name.c_str(), entry.objects, entry.bytes, entry.heapBytes,
+                heapTotal > 0 ? 100.0 * entry.heapBytes / heapTotal : 0.0);
+    }
+    fprintf(out, "MEMORY structure=total bytes=%lld heap_bytes=%lld", totalBytes(), heapTotal);
+    long long live = metricsHeapLiveBytes();
+    if (live >= 0)
+        fprintf(out, " process_heap_bytes=%lld", live);
+    fprintf(out, "\n");
+}
+
+QueryMemoryTracker::QueryMemoryTracker(FILE* out)
+    : out(out), active(false), liveAtStart(-1), resultCount(0), resultBytes(0), queryCount(0),
+      maxResultBytes(0), maxResultQuery(0), maxPeakBytes(0), maxPeakQuery(0) {}
+
+void QueryMemoryTracker::beginQuery() {
+    active = true;
+    resultCount = 0;
+    resultBytes = 0;
+    metricsResetHeapPeak();
+    liveAtStart = metricsHeapLiveBytes();
+}
+
+void QueryMemoryTracker::addResult(int count, long long bytes) {
+    resultCount += count;
+    resultBytes += bytes;
+}
+
+/**
+ * @brief Fecha a consulta e escreve a sua linha.
+ *
+ * peak_bytes (só com métricas) é o pico de bytes vivos durante a consulta
+ * menos os bytes vivos no início dela.
+ */
+void QueryMemoryTracker::endQuery(int lineNumber) {
+    if (!active)
+        return;
+    active = false;
+    queryCount++;
+    fprintf(out, "MEMORY query=%d results=%d result_bytes=%lld", lineNumber, resultCount, resultBytes);
+    if (resultBytes > maxResultBytes) {
+        maxResultBytes = resultBytes;
+        maxResultQuery = lineNumber;
+    }
+    if (liveAtStart >= 0) {
+        long long peak = metricsHeapPeakBytes() - liveAtStart;
+        fprintf(out, " peak_bytes=%lld", peak);
+        if (peak > maxPeakBytes) {
+            maxPeakBytes = peak;
+            maxPeakQuery = lineNumber;
+        }
+    }
+    fprintf(out, "\n");
+}
+
+void QueryMemoryTracker::printSummary() {
+    fprintf(out, "MEMORY queries=%d max_result_bytes=%lld max_result_query=%d", queryCount,
+            maxResultBytes, maxResultQuery);
+    if (metricsHeapLiveBytes() >= 0)
+        fprintf(out, " max_peak_bytes=%lld max_peak_query=%d", maxPeakBytes, maxPeakQuery);
+    fprintf(out, "\n");
+}
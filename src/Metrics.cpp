@@ -0,0 +1,282 @@
+#include "../include/Metrics.hpp"
+
+#ifdef ENABLE_METRICS
+
+#include <chrono>
+#include <csignal>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Shards de todas as threads. Armazenamento estático, para que o
+ * registro não dependa de operator new (que também é contabilizado).
+ */
+static MetricsShard metricsShards[METRIC_MAX_SHARDS];
+static std::atomic<int> metricsShardCount(0);
+
+thread_local MetricsShard* currentMetricsShard = nullptr;
+
+/**
+ * @brief Reserva um shard para a thread atual.
+ *
+ * Os shards nunca são liberados: os contadores de threads encerradas continuam
+ * somados nas leituras seguintes.
+ */
+MetricsShard* registerMetricsShard() {
+    int index = metricsShardCount.fetch_add(1);
+    MetricsShard* shard;
+    if (index < METRIC_MAX_SHARDS - 1) {
+        shard = &metricsShards[index];
+    } else {
+        shard = &metricsShards[METRIC_MAX_SHARDS - 1];
+        shard->shared = true;
+    }
+    currentMetricsShard = shard;
+    return shard;
+}
+
+static std::atomic<long long> heapLiveBytes(0);  ///< Bytes vivos (veja metricsHeapLiveBytes()).
+static std::atomic<long long> heapPeakBytes(0);  ///< Pico desde metricsResetHeapPeak().
+
+/**
+ * @brief Substitui operator new para contabilizar as alocações do processo inteiro.
+ *
+ * Além dos contadores por shard, mantém os bytes vivos e o pico do processo em
+ * atômicos globais: o pico precisa de uma visão única, e só existe em builds
+ * com métricas.
+ */
+void* operator new(std::size_t size) {
+    METRIC_INC(METRIC_ALLOCATIONS);
+    METRIC_ADD(METRIC_ALLOCATED_BYTES, size);
+    for (;;) {
+        void* memory = std::malloc(size ? size : 1);
+        if (memory) {
+            long long usable = static_cast<long long>(malloc_usable_size(memory));
+            long long live = heapLiveBytes.fetch_add(usable, std::memory_order_relaxed) + usable;
+            long long peak = heapPeakBytes.load(std::memory_order_relaxed);
+            while (live > peak && !heapPeakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+                ;
+            return memory;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+    if (memory)
+        heapLiveBytes.fetch_sub(malloc_usable_size(memory), std::memory_order_relaxed);
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    operator delete(memory);
+}
+
+long long metricsHeapLiveBytes() {
+    return heapLiveBytes.load(std::memory_order_relaxed);
+}
+
+long long metricsHeapPeakBytes() {
+    return heapPeakBytes.load(std::memory_order_relaxed);
+}
+
+void metricsResetHeapPeak() {
+    heapPeakBytes.store(heapLiveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+/**
+ * @brief Totais de todos os shards.
+ */
+struct MetricsSnapshot {
+    uint64_t counters[METRIC_COUNTER_COUNT];
+    uint64_t buckets[METRIC_HISTOGRAM_COUNT][METRIC_BUCKET_COUNT];
+    uint64_t sums[METRIC_HISTOGRAM_COUNT];
+    uint64_t fieldPaths[METRIC_FIELD_COUNT][METRIC_PATH_COUNT];
+};
+
+/**
+ * @brief Soma os shards registrados.
+ */
+static void takeSnapshot(MetricsSnapshot &snapshot) {
+    snapshot = MetricsSnapshot();
+    int shardCount = metricsShardCount.load();
+    if (shardCount > METRIC_MAX_SHARDS)
+        shardCount = METRIC_MAX_SHARDS;
+    for (int s = 0; s < shardCount; s++) {
+        const MetricsShard &shard = metricsShards[s];
+        for (int c = 0; c < METRIC_COUNTER_COUNT; c++)
+            snapshot.counters[c] += shard.counters[c].load(std::memory_order_relaxed);
+        for (int h = 0; h < METRIC_HISTOGRAM_COUNT; h++) {
+            for (int b = 0; b < METRIC_BUCKET_COUNT; b++)
+                snapshot.buckets[h][b] += shard.buckets[h][b].load(std::memory_order_relaxed);
+            snapshot.sums[h] += shard.sums[h].load(std::memory_order_relaxed);
+        }
+        for (int f = 0; f < METRIC_FIELD_COUNT; f++)
+            for (int p = 0; p < METRIC_PATH_COUNT; p++)
+                snapshot.fieldPaths[f][p] += shard.fieldPaths[f][p].load(std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Acrescenta uma linha formatada ao texto.
+ */
+static void appendf(std::string &text, const char* format, ...) __attribute__((format(printf, 2, 3)));
+static void appendf(std::string &text, const char* format, ...) {
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    text += line;
+}
+
+/**
+ * @brief Formata os totais no formato de texto do Prometheus.
+ */
+static std::string formatMetrics(const MetricsSnapshot &snapshot) {
+    static const char* counterNames[METRIC_COUNTER_COUNT][2] = {
+        { "flights_queries_total", "Consultas executadas." },
+        { "flights_index_plans_total", "Consultas resolvidas com indice." },
+        { "flights_scan_plans_total", "Consultas resolvidas com varredura completa." },
+        { "flights_candidates_total", "Candidatos avaliados pelo filtro." },
+        { "flights_results_total", "Voos que satisfizeram a expressao." },
+        { "flights_range_query_regrowths_total", "Realocacoes do array de resultados das consultas por intervalo." },
+        { "flights_reservations_total", "Reservas de assentos bem-sucedidas." },
+        { "flights_reservation_failures_total", "Reservas recusadas." },
+        { "flights_allocations_total", "Chamadas a operator new." },
+        { "flights_allocated_bytes_total", "Bytes pedidos a operator new." },
+        { "flights_ingested_total", "Voos inseridos a partir do arquivo acompanhado." }
+    };
+    static const char* histogramNames[METRIC_HISTOGRAM_COUNT][2] = {
+        { "flights_query_candidates", "Candidatos por consulta." },
+        { "flights_candidates_per_result", "Candidatos examinados por resultado retornado." },
+        { "flights_sort_size", "Tamanho dos arrays ordenados." },
+        { "flights_ingest_lag_ms", "Atraso de cada lote do arquivo acompanhado, em ms." }
+    };
+    static const char* fieldNames[METRIC_FIELD_COUNT] = { "org", "dst", "prc", "dur", "sto", "sea", "dep", "arr" };
+    static const char* pathNames[METRIC_PATH_COUNT] = { "index", "scan" };
+
+    std::string text;
+    for (int c = 0; c < METRIC_COUNTER_COUNT; c++) {
+        appendf(text, "# HELP %s %s\n# TYPE %s counter\n", counterNames[c][0], counterNames[c][1], counterNames[c][0]);
+        appendf(text, "%s %llu\n", counterNames[c][0], (unsigned long long)snapshot.counters[c]);
+    }
+
+    appendf(text, "# HELP flights_heap_live_bytes Bytes vivos no heap (alocados por operator new).\n"
+                  "# TYPE flights_heap_live_bytes gauge\nflights_heap_live_bytes %lld\n", metricsHeapLiveBytes());
+
+    appendf(text, "# HELP flights_field_predicates_total Predicados por campo e forma de avaliacao.\n"
+                  "# TYPE flights_field_predicates_total counter\n");
+    for (int f = 0; f < METRIC_FIELD_COUNT; f++)
+        for (int p = 0; p < METRIC_PATH_COUNT; p++)
+            appendf(text, "flights_field_predicates_total{field=\"%s\",path=\"%s\"} %llu\n",
+                    fieldNames[f], pathNames[p], (unsigned long long)snapshot.fieldPaths[f][p]);
+
+    for (int h = 0; h < METRIC_HISTOGRAM_COUNT; h++) {
+        const char* name = histogramNames[h][0];
+        appendf(text, "# HELP %s %s\n# TYPE %s histogram\n", name, histogramNames[h][1], name);
+        uint64_t cumulative = 0;
+        for (int b = 0; b < METRIC_BUCKET_COUNT - 1; b++) {
+            cumulative += snapshot.buckets[h][b];
+            unsigned long long bound = b == 0 ? 0ULL : 1ULL << (b - 1);
+            appendf(text, "%s_bucket{le=\"%llu\"} %llu\n", name, bound, (unsigned long long)cumulative);
+        }
+        cumulative += snapshot.buckets[h][METRIC_BUCKET_COUNT - 1];
+        appendf(text, "%s_bucket{le=\"+Inf\"} %llu\n", name, (unsigned long long)cumulative);
+        appendf(text, "%s_sum %llu\n%s_count %llu\n", name, (unsigned long long)snapshot.sums[h],
+                name, (unsigned long long)cumulative);
+    }
+    return text;
+}
+
+/**
+ * @brief Grava todas as métricas no formato de texto do Prometheus.
+ */
+bool writeMetrics(const char* path) {
+    MetricsSnapshot snapshot;
+    takeSnapshot(snapshot);
+    std::string text = formatMetrics(snapshot);
+
+    // Grava em um temporário e renomeia, para que leitores nunca vejam um arquivo pela metade.
+    std::string temporaryPath = std::string(path) + ".tmp";
+    FILE* out = fopen(temporaryPath.c_str(), "w");
+    if (!out)
+        return false;
+    bool written = fwrite(text.data(), 1, text.size(), out) == text.size();
+    written = fclose(out) == 0 && written;
+    return written && rename(temporaryPath.c_str(), path) == 0;
+}
+
+static volatile sig_atomic_t metricsDumpRequested = 0;  ///< Marcado pelo tratador de SIGUSR1.
+static std::atomic<bool> metricsReporterRunning(false);
+static std::thread metricsReporterThread;
+static std::string metricsPath;
+
+/**
+ * @brief Tratador de SIGUSR1: apenas pede uma gravação à thread de relatório.
+ */
+static void requestMetricsDump(int) {
+    metricsDumpRequested = 1;
+}
+
+/**
+ * @brief Laço da thread de relatório.
+ */
+static void metricsReporterLoop(double intervalSeconds) {
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point lastDump = Clock::now();
+    while (metricsReporterRunning.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        bool intervalElapsed = intervalSeconds > 0 &&
+            std::chrono::duration<double>(Clock::now() - lastDump).count() >= intervalSeconds;
+        if (metricsDumpRequested || intervalElapsed) {
+            metricsDumpRequested = 0;
+            if (!writeMetrics(metricsPath.c_str()))
+                fprintf(stderr, "Error writing metrics to %s.\n", metricsPath.c_str());
+            lastDump = Clock::now();
+        }
+    }
+}
+
+/**
+ * @brief Inicia a thread que grava as métricas a cada intervalo e ao receber SIGUSR1.
+ */
+bool startMetricsReporter(const char* path, double intervalSeconds) {
+    if (metricsReporterRunning.exchange(true))
+        return false;
+    metricsPath = path;
+
+    struct sigaction action;
+    action.sa_handler = requestMetricsDump;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;  // Não interrompe as leituras da entrada.
+    sigaction(SIGUSR1, &action, nullptr);
+
+    metricsReporterThread = std::thread(metricsReporterLoop, intervalSeconds);
+    return true;
+}
+
+/**
+ * @brief Para a thread de relatório e faz uma última gravação.
+ */
+void stopMetricsReporter() {
+    if (!metricsReporterRunning.exchange(false))
+        return;
+    metricsReporterThread.join();
+    if (!writeMetrics(metricsPath.c_str()))
+        fprintf(stderr, "Error writing metrics to %s.\n", metricsPath.c_str());
+}
+
+#endif // ENABLE_METRICS
@@ -0,0 +1,86 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <cstdlib>
+#include "../include/Parser.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+/**
+ * @brief Lê as expressões da seção de consultas de um arquivo de entrada.
+ *
+ * Os voos e os comandos de atualização (ins, del, upd, res) são ignorados.
+ */
+bool loadExpressions(const string &filename, vector<string> &expressions) {
+    ifstream file(filename);
+    if (!file) {
+        cerr << "Erro ao abrir " << filename << endl;
+        return false;
+    }
+    int flightCount;
+    if (!(file >> flightCount))
+        return false;
+    string line;
+    getline(file, line);
+    for (int i = 0; i < flightCount; i++)
+        getline(file, line);
+
+    int queryCount;
+    if (!(file >> queryCount))
+        return false;
+    getline(file, line);
+    while (static_cast<int>(expressions.size()) < queryCount && getline(file, line)) {
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == string::npos)
+            continue;
+        string command = line.substr(first, 3);
+        if (command == "ins" || command == "del" || command == "upd" || command == "res")
+            continue;
+        // Pula "<max_resultados> <critério>" e mantém apenas a expressão.
+        size_t space = line.find(' ', first);
+        space = space == string::npos ? space : line.find(' ', line.find_first_not_of(' ', space));
+        if (space == string::npos)
+            continue;
+        expressions.push_back(line.substr(space + 1));
+    }
+    return !expressions.empty();
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "Uso: " << argv[0] << " <arquivo_de_entrada> [segundos=2]\n";
+        return 1;
+    }
+    double seconds = argc > 2 ? atof(argv[2]) : 2.0;
+
+    vector<string> expressions;
+    if (!loadExpressions(argv[1], expressions)) {
+        cerr << "Nenhuma consulta encontrada em " << argv[1] << endl;
+        return 1;
+    }
+
+    // Repete o lote inteiro até atingir o tempo pedido; só o parsing é medido.
+    long long parsed = 0, errors = 0, rounds = 0;
+    auto start = steady_clock::now();
+    double elapsed = 0;
+    ExprArena arena;
+    while (elapsed < seconds) {
+        for (size_t i = 0; i < expressions.size(); i++) {
+            arena.reset();
+            Parser parser(expressions[i], arena);
+            if (!parser.parseExpression())
+                errors++;
+        }
+        parsed += expressions.size();
+        rounds++;
+        elapsed = duration<double>(steady_clock::now() - start).count();
+    }
+
+    cout << "Consultas\tRepeticoes\tConsultas/s\tns/consulta\tErros\n";
+    cout << expressions.size() << "\t" << rounds << "\t" << parsed / elapsed << "\t"
+         << elapsed * 1e9 / parsed << "\t" << errors / rounds << "\n";
+    return 0;
+}
@@ -0,0 +1,485 @@
+#include "../include/PartitionedStore.hpp"
+#include "../include/DateTime.hpp"
+#include "../include/KDTree.hpp"
+#include "../include/Sort.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <stdint.h>
+#include <thread>
+
+using std::chrono::steady_clock;
+
+/**
+ * @brief Microssegundos decorridos desde start.
+ */
+static double elapsedUs(const steady_clock::time_point &start) {
+    return std::chrono::duration<double, std::micro>(steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Resto não negativo de value por divisor.
+ */
+static int positiveModulo(long long value, int divisor) {
+    long long remainder = value % divisor;
+    return static_cast<int>(remainder < 0 ? remainder + divisor : remainder);
+}
+
+/**
+ * @brief Partição de uma rota: hash multiplicativo de (origem, destino).
+ */
+static int routePartition(AirportCode origin, AirportCode destination, int partitionCount) {
+    uint64_t key = (static_cast<uint64_t>(origin) << 32) | destination;
+    return static_cast<int>(((key * 0x9E3779B97F4A7C15ULL) >> 32) % static_cast<uint64_t>(partitionCount));
+}
+
+/**
+ * @brief Garante espaço para count + 1 posições em um array de inteiros, dobrando a capacidade.
+ */
+static void reserveIds(int* &ids, int count, int &capacity) {
+    if (count < capacity)
+        return;
+    int newCapacity = capacity ? capacity * 2 : 1024;
+    int* newIds = new int[newCapacity];
+    for (int i = 0; i < count; i++)
+        newIds[i] = ids[i];
+    delete[] ids;
+    ids = newIds;
+    capacity = newCapacity;
+}
+
+/**
+ * @brief Soma o perfil de uma partição ao perfil da consulta e acrescenta o caminho de acesso, se novo.
+ */
+static void mergeProfile(QueryProfile &profile, const QueryProfile &partial) {
+    profile.candidateCount += partial.candidateCount;
+    profile.resultCount += partial.resultCount;
+    profile.planUs += partial.planUs;
+    profile.candidatesUs += partial.candidatesUs;
+    profile.filterUs += partial.filterUs;
+    profile.sortUs += partial.sortUs;
+    if (("|" + profile.accessPath + "|").find("|" + partial.accessPath + "|") == string::npos)
+        profile.accessPath += (profile.accessPath.empty() ? "" : "|") + partial.accessPath;
+}
+
+/**
+ * @brief Cursor sobre o resultado ordenado de uma partição.
+ */
+struct MergeCursor {
+    Flight** flights;      ///< Resultado da partição.
+    int position;          ///< Próximo voo.
+    int count;             ///< Voos no resultado.
+    const int* globalIds;  ///< Identificador global de cada identificador local da partição.
+};
+
+/**
+ * @brief Ordem do heap da intercalação: true se o voo atual de a vem depois do de b.
+ *
+ * Empates nos critérios são desfeitos pelo identificador global, de modo que
+ * a intercalação não depende da ordem das partições.
+ */
+struct CursorAfter {
+    const string* criteria;
+
+    bool operator()(const MergeCursor &a, const MergeCursor &b) const {
+        const Flight* flightA = a.flights[a.position];
+        const Flight* flightB = b.flights[b.position];
+        int result = compareFlightByCriteria(flightA, flightB, *criteria);
+        return result != 0 ? result > 0 : a.globalIds[flightA->id] > b.globalIds[flightB->id];
+    }
+};
+
+/**
+ * @brief Executa uma consulta ad hoc em um FlightManager.
+ */
+struct QueryRunner {
+    Expr* expression;
+    const string* sortCriteria;
+
+    Flight** operator()(FlightManager &flightManager, int, int &resultCount, QueryProfile* profile) {
+        return ::executeQuery(flightManager, expression, *sortCriteria, resultCount, profile);
+    }
+};
+
+/**
+ * @brief Executa um template preparado em um FlightManager, com o plano da partição.
+ */
+struct PreparedRunner {
+    PreparedQuery* prepared;
+    const string* sortCriteria;
+
+    Flight** operator()(FlightManager &flightManager, int partition, int &resultCount, QueryProfile* profile) {
+        return prepared->execute(flightManager, *sortCriteria, resultCount, profile, partition);
+    }
+};
+
+/**
+ * @brief Construtor: partições vazias e sem índices.
+ */
+PartitionedStore::PartitionedStore(int partitionCount, PartitionScheme scheme)
+    : partitionCount(std::max(1, std::min(partitionCount, static_cast<int>(MAX_PARTITIONS)))), scheme(scheme),
+      managers(nullptr), infos(nullptr), idPartition(nullptr), idLocal(nullptr), idCount(0), idCapacity(0) {
+    managers = new FlightManager*[this->partitionCount];
+    infos = new PartitionInfo[this->partitionCount];
+    for (int p = 0; p < this->partitionCount; p++) {
+        managers[p] = new FlightManager();
+        infos[p].minDeparture = 0;
+        infos[p].maxDeparture = 0;
+        infos[p].globalIds = nullptr;
+        infos[p].idCapacity = 0;
+    }
+}
+
+/**
+ * @brief Destrutor: libera as partições.
+ */
+PartitionedStore::~PartitionedStore() {
+    for (int p = 0; p < partitionCount; p++) {
+        delete managers[p];
+        delete[] infos[p].globalIds;
+    }
+    delete[] managers;
+    delete[] infos;
+    delete[] idPartition;
+    delete[] idLocal;
+}
+
+/**
+ * @brief Retorna a partição de um voo pelo critério do armazenamento.
+ */
+int PartitionedStore::partitionOf(const Flight &flight) const {
+    if (partitionCount == 1)
+        return 0;
+    if (scheme == PARTITION_BY_ROUTE)
+        return routePartition(flight.origin, flight.destination, partitionCount);
+    return positiveModulo(monthIndex(flight.dep_time), partitionCount);
+}
+
+/**
+ * @brief Registra um voo recém-armazenado na partição: metadados e mapeamento de identificadores.
+ */
+int PartitionedStore::registerFlight(int partition, int localId, const Flight &flight, int globalId) {
+    PartitionInfo &info = infos[partition];
+    if (managers[partition]->getSlotCount() == 1 || flight.dep_time < info.minDeparture)
+        info.minDeparture = flight.dep_time;
+    if (managers[partition]->getSlotCount() == 1 || flight.dep_time > info.maxDeparture)
+        info.maxDeparture = flight.dep_time;
+    reserveIds(info.globalIds, localId, info.idCapacity);
+
+    if (globalId < 0) {
+        int capacity = idCapacity;
+        reserveIds(idPartition, idCount, capacity);
+        reserveIds(idLocal, idCount, idCapacity);
+        globalId = idCount++;
+    }
+    info.globalIds[localId] = globalId;
+    idPartition[globalId] = partition;
+    idLocal[globalId] = localId;
+    return globalId;
+}
+
+/**
+ * @brief Adiciona um voo sem indexá-lo (carga inicial).
+ */
+int PartitionedStore::addFlight(const Flight &flight) {
+    if (partitionCount == 1)
+        return managers[0]->addFlight(flight);
+    int partition = partitionOf(flight);
+    return registerFlight(partition, managers[partition]->addFlight(flight), flight, -1);
+}
+
+/**
+ * @brief Constrói os índices das partições em paralelo.
+ *
+ * As partições são distribuídas dinamicamente entre min(partições, núcleos)
+ * threads, de modo que partições maiores não atrasam as demais.
+ */
+void PartitionedStore::buildIndices() {
+    int threadCount = std::min(partitionCount, static_cast<int>(std::thread::hardware_concurrency()));
+    if (threadCount <= 1) {
+        for (int p = 0; p < partitionCount; p++)
+            managers[p]->buildIndices();
+        return;
+    }
+    std::atomic<int> next(0);
+    std::thread* threads = new std::thread[threadCount];
+    for (int t = 0; t < threadCount; t++) {
+        threads[t] = std::thread([this, &next]() {
+            for (int p = next++; p < partitionCount; p = next++)
+                managers[p]->buildIndices();
+        });
+    }
+    for (int t = 0; t < threadCount; t++)
+        threads[t].join();
+    delete[] threads;
+}
+
+/**
+ * @brief Insere um voo e o indexa na sua partição.
+ */
+int PartitionedStore::insertFlight(const Flight &flight) {
+    if (partitionCount == 1)
+        return managers[0]->insertFlight(flight);
+    int partition = partitionOf(flight);
+    return registerFlight(partition, managers[partition]->insertFlight(flight), flight, -1);
+}
+
+/**
+ * @brief Remove um voo.
+ */
+bool PartitionedStore::removeFlight(int id) {
+    if (partitionCount == 1)
+        return managers[0]->removeFlight(id);
+    if (id < 0 || id >= idCount)
+        return false;
+    return managers[idPartition[id]]->removeFlight(idLocal[id]);
+}
+
+/**
+ * @brief Substitui os dados de um voo, movendo-o de partição se preciso.
+ */
+bool PartitionedStore::updateFlight(int id, const Flight &flight) {
+    if (partitionCount == 1)
+        return managers[0]->updateFlight(id, flight);
+    if (id < 0 || id >= idCount)
+        return false;
+    int from = idPartition[id];
+    int to = partitionOf(flight);
+    if (from == to) {
+        if (!managers[from]->updateFlight(idLocal[id], flight))
+            return false;
+        infos[from].minDeparture = std::min(infos[from].minDeparture, flight.dep_time);
+        infos[from].maxDeparture = std::max(infos[from].maxDeparture, flight.dep_time);
+        return true;
+    }
+    if (!managers[from]->removeFlight(idLocal[id]))
+        return false;
+    registerFlight(to, managers[to]->insertFlight(flight), flight, id);
+    return true;
+}
+
+/**
+ * @brief Reserva assentos de um voo.
+ */
+bool PartitionedStore::reserveSeats(int id, int seatCount) {
+    if (partitionCount == 1)
+        return managers[0]->reserveSeats(id, seatCount);
+    if (id < 0 || id >= idCount)
+        return false;
+    return managers[idPartition[id]]->reserveSeats(idLocal[id], seatCount);
+}
+
+/**
+ * @brief Retorna um voo pelo identificador global, ou nullptr se ele não existe.
+ */
+Flight* PartitionedStore::getFlight(int id) {
+    if (partitionCount == 1)
+        return managers[0]->getFlight(id);
+    if (id < 0 || id >= idCount)
+        return nullptr;
+    return managers[idPartition[id]]->getFlight(idLocal[id]);
+}
+
+/**
+ * @brief Acrescenta ao relatório a memória de todas as partições e o mapeamento de identificadores.
+ */
+void PartitionedStore::reportMemory(MemoryReport &report) const {
+    for (int p = 0; p < partitionCount; p++)
+        managers[p]->reportMemory(report);
+    if (partitionCount == 1)
+        return;
+    report.addArray("partition_ids", idCount, idCapacity, sizeof(int));
+    report.addArray("partition_ids", 0, idCapacity, sizeof(int));
+    for (int p = 0; p < partitionCount; p++)
+        report.addArray("partition_ids", 0, infos[p].idCapacity, sizeof(int));
+}
+
+/**
+ * @brief Marca as partições que podem ter voos que satisfazem a expressão.
+ */
+int PartitionedStore::selectPartitions(const Expr* expression, bool* selected) const {
+    KDBox box;
+    conjunctionBox(expression, box);
+    double low = box.low[2], high = box.high[2];
+
+    // Por mês: uma janela de partida com menos meses que partições toca só as partições desses meses.
+    bool months[MAX_PARTITIONS];
+    bool monthPruning = false;
+    if (scheme == PARTITION_BY_MONTH && std::isfinite(low) && std::isfinite(high) && low <= high) {
+        long long first = monthIndex(static_cast<time_t>(low));
+        long long last = monthIndex(static_cast<time_t>(high));
+        if (last - first + 1 < partitionCount) {
+            monthPruning = true;
+            for (int p = 0; p < partitionCount; p++)
+                months[p] = false;
+            for (long long month = first; month <= last; month++)
+                months[positiveModulo(month, partitionCount)] = true;
+        }
+    }
+
+    // Por rota: origem e destino fixos na conjunção principal levam à partição da rota.
+    int route = -1;
+    if (scheme == PARTITION_BY_ROUTE && expression) {
+        const Expr* const* children = &expression;
+        int childCount = 1;
+        if (expression->kind == EXPR_LOGICAL && static_cast<const LogicalExpr*>(expression)->op == '&') {
+            children = static_cast<const LogicalExpr*>(expression)->children;
+            childCount = static_cast<const LogicalExpr*>(expression)->childCount;
+        }
+        const PredicateExpr* origin = nullptr;
+        const PredicateExpr* destination = nullptr;
+        for (int i = 0; i < childCount; i++) {
+            if (children[i]->kind != EXPR_PREDICATE)
+                continue;
+            const PredicateExpr* predicate = static_cast<const PredicateExpr*>(children[i]);
+            if (predicate->op != PredicateExpr::EQ)
+                continue;
+            if (predicate->field == INDEX_ORIGIN)
+                origin = predicate;
+            else if (predicate->field == INDEX_DESTINATION)
+                destination = predicate;
+        }
+        if (origin && destination)
+            route = routePartition(origin->codeValue, destination->codeValue, partitionCount);
+    }
+
+    int selectedCount = 0;
+    for (int p = 0; p < partitionCount; p++) {
+        selected[p] = managers[p]->getFlightCount() > 0 && !box.isEmpty()
+                      && static_cast<double>(infos[p].maxDeparture) >= low
+                      && static_cast<double>(infos[p].minDeparture) <= high
+                      && (!monthPruning || months[p]) && (route < 0 || route == p);
+        selectedCount += selected[p];
+    }
+    return selectedCount;
+}
+
+/**
+ * @brief Executa run em cada partição selecionada e intercala os resultados ordenados.
+ */
+template<typename Runner>
+Flight** PartitionedStore::scatter(Expr* expression, Runner &run, const string &sortCriteria, int maxResults,
+                                   int &resultCount, QueryProfile* profile) {
+    steady_clock::time_point phaseStart = steady_clock::now();
+    bool selected[MAX_PARTITIONS];
+    int selectedCount = selectPartitions(expression, selected);
+    Expr** order = new Expr*[countOperands(expression) + 1];
+    saveOperandOrder(expression, order);
+    if (profile)
+        profile->planUs += elapsedUs(phaseStart);
+
+    MergeCursor* cursors = new MergeCursor[selectedCount > 0 ? selectedCount : 1];
+    Flight** partitionResults[MAX_PARTITIONS];
+    int cursorCount = 0, heapSize = 0;
+    long long matchCount = 0;
+    for (int p = 0; p < partitionCount; p++) {
+        if (!selected[p])
+            continue;
+        QueryProfile partial;
+        MergeCursor &cursor = cursors[heapSize];
+        cursor.flights = partitionResults[cursorCount++] = run(*managers[p], p, cursor.count,
+                                                            profile ? &partial : nullptr);
+        cursor.position = 0;
+        cursor.globalIds = infos[p].globalIds;
+        matchCount += cursor.count;
+        if (cursor.count > 0)
+            heapSize++;
+        // optimizeExpression() reordenou a árvore com as estatísticas desta
+        // partição; a próxima planeja a partir da ordem escrita na consulta.
+        restoreOperandOrder(expression, order);
+        if (profile)
+            mergeProfile(*profile, partial);
+    }
+    delete[] order;
+
+    // Intercalação: heap com o voo atual de cada partição, até maxResults voos.
+    phaseStart = steady_clock::now();
+    int limit = static_cast<int>(std::min<long long>(matchCount, std::max(maxResults, 0)));
+    Flight** resultFlights = new Flight*[limit > 0 ? limit : 1];
+    CursorAfter after = { &sortCriteria };
+    std::make_heap(cursors, cursors + heapSize, after);
+    resultCount = 0;
+    while (resultCount < limit) {
+        std::pop_heap(cursors, cursors + heapSize, after);
+        MergeCursor &cursor = cursors[heapSize - 1];
+        resultFlights[resultCount++] = cursor.flights[cursor.position++];
+        if (cursor.position < cursor.count)
+            std::push_heap(cursors, cursors + heapSize, after);
+        else
+            heapSize--;
+    }
+    for (int c = 0; c < cursorCount; c++)
+        delete[] partitionResults[c];
+    delete[] cursors;
+
+    if (profile) {
+        profile->sortUs += elapsedUs(phaseStart);
+        char prefix[32];
+        snprintf(prefix, sizeof(prefix), "partitions(%d/%d", selectedCount, partitionCount);
+        profile->accessPath = string(prefix) + (selectedCount > 0 ? ":" + profile->accessPath : "") + ")";
+    }
+    return resultFlights;
+}
+
+/**
+ * @brief Executa uma consulta nas partições selecionadas e intercala os resultados.
+ */
+Flight** PartitionedStore::executeQuery(Expr* expression, const string &sortCriteria, int maxResults,
+                                        int &resultCount, QueryProfile* profile) {
+    if (partitionCount == 1)
+        return ::executeQuery(*managers[0], expression, sortCriteria, resultCount, profile);
+    QueryRunner run = { expression, &sortCriteria };
+    return scatter(expression, run, sortCriteria, maxResults, resultCount, profile);
+}
+
+/**
+ * @brief Executa um template preparado nas partições selecionadas e intercala os resultados.
+ */
+Flight** PartitionedStore::executePrepared(PreparedQuery &prepared, const string &sortCriteria, int maxResults,
+                                           int &resultCount, QueryProfile* profile) {
+    if (partitionCount == 1)
+        return prepared.execute(*managers[0], sortCriteria, resultCount, profile);
+    PreparedRunner run = { &prepared, &sortCriteria };
+    return scatter(prepared.getExpression(), run, sortCriteria, maxResults, resultCount, profile);
+}
+
+/**
+ * @brief Executa uma agregação nas partições selecionadas e combina os resultados parciais.
+ */
+void PartitionedStore::executeAggregate(Expr* expression, AggregateResult &result, QueryProfile* profile) {
+    if (partitionCount == 1) {
+        ::executeAggregate(*managers[0], expression, result, profile);
+        return;
+    }
+    steady_clock::time_point phaseStart = steady_clock::now();
+    bool selected[MAX_PARTITIONS];
+    int selectedCount = selectPartitions(expression, selected);
+    Expr** order = new Expr*[countOperands(expression) + 1];
+    saveOperandOrder(expression, order);
+    if (profile)
+        profile->planUs += elapsedUs(phaseStart);
+
+    bool fromIndex = selectedCount > 0;
+    for (int p = 0; p < partitionCount; p++) {
+        if (!selected[p])
+            continue;
+        QueryProfile partial;
+        AggregateResult partialResult(result.function, result.field);
+        ::executeAggregate(*managers[p], expression, partialResult, profile ? &partial : nullptr);
+        result.merge(partialResult);
+        fromIndex = fromIndex && partialResult.fromIndex;
+        restoreOperandOrder(expression, order);
+        if (profile)
+            mergeProfile(*profile, partial);
+    }
+    delete[] order;
+    result.fromIndex = fromIndex;
+
+    if (profile) {
+        char prefix[32];
+        snprintf(prefix, sizeof(prefix), "partitions(%d/%d", selectedCount, partitionCount);
+        profile->accessPath = string(prefix) + (selectedCount > 0 ? ":" + profile->accessPath : "") + ")";
+    }
+}
@@ -0,0 +1,220 @@
+#include "../include/PreparedQuery.hpp"
+#include "../include/DateTime.hpp"
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+
+using std::chrono::steady_clock;
+
+/**
+ * @brief Conta os predicados (folhas) de uma expressão.
+ */
+static int countPredicates(Expr* expr) {
+    if (expr->kind == EXPR_LOGICAL) {
+        LogicalExpr* logical = static_cast<LogicalExpr*>(expr);
+        int count = 0;
+        for (int i = 0; i < logical->childCount; i++)
+            count += countPredicates(logical->children[i]);
+        return count;
+    }
+    if (expr->kind == EXPR_NOT)
+        return countPredicates(static_cast<NotExpr*>(expr)->child);
+    return 1;
+}
+
+/**
+ * @brief Construtor: template vazio.
+ */
+PreparedQuery::PreparedQuery()
+    : expression(nullptr), parameterCount(0), parameters(nullptr), indexable(nullptr),
+      indexableCount(0), operandCount(0), slots(nullptr), slotCount(0), planCount(0) {
+    error.position = -1;
+    error.message = nullptr;
+}
+
+/**
+ * @brief Destrutor: libera os arrays auxiliares.
+ */
+PreparedQuery::~PreparedQuery() {
+    delete[] parameters;
+    delete[] indexable;
+    clearSlots();
+}
+
+/**
+ * @brief Libera os slots.
+ */
+void PreparedQuery::clearSlots() {
+    for (int i = 0; i < slotCount; i++) {
+        delete[] slots[i].estimates;
+        delete[] slots[i].order;
+    }
+    delete[] slots;
+    slots = nullptr;
+    slotCount = 0;
+}
+
+/**
+ * @brief Retorna o slot pedido, alocando-o (e os anteriores) se preciso.
+ */
+PreparedQuery::PlanSlot& PreparedQuery::planSlot(int slot) {
+    if (slot >= slotCount) {
+        PlanSlot* grown = new PlanSlot[slot + 1];
+        for (int i = 0; i < slotCount; i++)
+            grown[i] = slots[i];
+        for (int i = slotCount; i <= slot; i++) {
+            grown[i].planned = false;
+            grown[i].plan = nullptr;
+            grown[i].estimates = new double[indexableCount > 0 ? indexableCount : 1];
+            grown[i].order = new Expr*[operandCount > 0 ? operandCount : 1];
+        }
+        delete[] slots;
+        slots = grown;
+        slotCount = slot + 1;
+    }
+    return slots[slot];
+}
+
+/**
+ * @brief Analisa a expressão do template.
+ */
+bool PreparedQuery::prepare(const string &expressionStr) {
+    delete[] parameters;
+    delete[] indexable;
+    clearSlots();
+    parameters = nullptr;
+    indexable = nullptr;
+    arena.reset();
+    indexableCount = 0;
+    operandCount = 0;
+    planCount = 0;
+
+    Parser parser(expressionStr, arena);
+    parser.parametersAllowed = true;
+    expression = parser.parseExpression();
+    error = parser.getError();
+    parameterCount = expression ? parser.parameterCount : 0;
+    if (!expression)
+        return false;
+
+    int predicateCount = countPredicates(expression);
+    parameters = new PredicateExpr*[parameterCount > 0 ? parameterCount : 1];
+    for (int i = 0; i < parameterCount; i++)
+        parameters[i] = nullptr;
+    indexable = new PredicateExpr*[predicateCount];
+    collect(expression, true);
+    operandCount = countOperands(expression);
+    return true;
+}
+
+/**
+ * @brief Percorre a árvore registrando parâmetros e predicados indexáveis.
+ *
+ * Os predicados indexáveis seguem a mesma regra de findIndexablePredicate():
+ * operador diferente de NE, em um campo indexado, alcançável apenas por ANDs.
+ */
+void PreparedQuery::collect(Expr* expr, bool inConjunction) {
+    if (expr->kind == EXPR_PREDICATE) {
+        PredicateExpr* predicate = static_cast<PredicateExpr*>(expr);
+        if (predicate->parameterIndex >= 0 && predicate->parameterIndex < parameterCount)
+            parameters[predicate->parameterIndex] = predicate;
+        if (inConjunction && findIndexablePredicate(predicate) == predicate)
+            indexable[indexableCount++] = predicate;
+    } else if (expr->kind == EXPR_LOGICAL) {
+        LogicalExpr* logical = static_cast<LogicalExpr*>(expr);
+        bool conjunction = inConjunction && logical->op == '&';
+        for (int i = 0; i < logical->childCount; i++)
+            collect(logical->children[i], conjunction);
+    } else {
+        collect(static_cast<NotExpr*>(expr)->child, false);
+    }
+}
+
+/**
+ * @brief Atribui o valor de um parâmetro.
+ */
+bool PreparedQuery::bind(int index, const string &value) {
+    if (!expression || index < 0 || index >= parameterCount || !parameters[index] || value.empty())
+        return false;
+    PredicateExpr* predicate = parameters[index];
+    if (!predicate->isNumeric) {
+        for (size_t i = 0; i < value.size(); i++)
+            if (!isalpha(static_cast<unsigned char>(value[i])))
+                return false;
+        return predicate->setString(value.data(), static_cast<int>(value.size()));
+    } else if (predicate->field == INDEX_DEPARTURE || predicate->field == INDEX_ARRIVAL) {
+        time_t time;
+        if (!parseDateTimeChecked(value.c_str(), time))
+            return false;
+        predicate->numValue = static_cast<double>(time);
+    } else {
+        char* end;
+        double number = strtod(value.c_str(), &end);
+        if (*end != '\0')
+            return false;
+        predicate->numValue = number;
+    }
+    return true;
+}
+
+/**
+ * @brief Verifica se alguma estimativa mudou o bastante desde o planejamento do slot.
+ *
+ * Só os predicados parametrizados são reavaliados: os demais têm valores fixos.
+ */
+bool PreparedQuery::needsReplan(FlightManager &flightManager, const PlanSlot &slot) const {
+    for (int i = 0; i < indexableCount; i++) {
+        if (indexable[i]->parameterIndex < 0)
+            continue;
+        double estimate = flightManager.estimateCandidates(indexable[i]) + 1;
+        double planned = slot.estimates[i] + 1;
+        if (estimate >= planned * REPLAN_FACTOR || planned >= estimate * REPLAN_FACTOR)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Escolhe o predicado indexável com a menor estimativa de candidatos.
+ *
+ * A ordem de avaliação dos operandos (optimizeExpression) é refeita junto com
+ * o plano e gravada no slot, para as execuções seguintes com o mesmo plano.
+ */
+void PreparedQuery::choosePlan(FlightManager &flightManager, PlanSlot &slot) {
+    slot.plan = nullptr;
+    double best = 0;
+    for (int i = 0; i < indexableCount; i++) {
+        slot.estimates[i] = flightManager.estimateCandidates(indexable[i]);
+        if (!slot.plan || slot.estimates[i] < best) {
+            slot.plan = indexable[i];
+            best = slot.estimates[i];
+        }
+    }
+    optimizeExpression(flightManager, expression, slot.plan);
+    saveOperandOrder(expression, slot.order);
+    slot.planned = true;
+    planCount++;
+}
+
+/**
+ * @brief Executa o template com os valores atribuídos e o plano do slot.
+ *
+ * Sem novo planejamento, a ordem dos operandos gravada no slot é reaplicada:
+ * a árvore é compartilhada e pode ter sido reordenada por outro slot.
+ */
+Flight** PreparedQuery::execute(FlightManager &flightManager, const string &sortCriteria, int &resultCount,
+                                QueryProfile* profile, int slot) {
+    steady_clock::time_point planStart;
+    if (profile)
+        planStart = steady_clock::now();
+
+    PlanSlot &state = planSlot(slot);
+    if (!state.planned || needsReplan(flightManager, state))
+        choosePlan(flightManager, state);
+    else
+        restoreOperandOrder(expression, state.order);
+
+    if (profile)
+        profile->planUs = std::chrono::duration<double, std::micro>(steady_clock::now() - planStart).count();
+    return executePlannedQuery(flightManager, expression, state.plan, sortCriteria, resultCount, profile);
+}
@@ -0,0 +1,371 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <sys/resource.h>
+#include "../include/Flight.hpp"
+#include "../include/FlightManager.hpp"
+#include "../include/Parser.hpp"
+#include "../include/QueryExecutor.hpp"
+#include "../include/PreparedQuery.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+/**
+ * @brief Consulta gerada para o benchmark.
+ */
+struct BenchmarkQuery {
+    int maxResults;
+    string sortCriteria;
+    string expression;
+    vector<string> parameters;  ///< Valores dos parâmetros (mistura "prepared").
+};
+
+/**
+ * @brief Template usado pelas misturas "route" (ad hoc) e "prepared".
+ */
+static const char* ROUTE_TEMPLATE = "((org==?)&&(dst==?)&&(dep>=?))";
+
+/**
+ * @brief Resultado de uma mistura de consultas em um tamanho de entrada.
+ */
+struct MixResult {
+    int size;
+    string mix;
+    int queries;
+    double loadMs;
+    double buildMs;
+    double p50Us;
+    double p95Us;
+    double p99Us;
+    double meanUs;
+    double throughput;
+    double avgResults;
+    long peakRssKb;
+};
+
+/**
+ * @brief Retorna o pico de memória residente do processo (KB).
+ *
+ * É um máximo acumulado; como os tamanhos rodam em ordem crescente, o valor
+ * medido após cada tamanho corresponde ao pico daquele tamanho.
+ */
+long peakRssKb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/**
+ * @brief Formata um time_t como "YYYY-MM-DDTHH:MM:SS" (UTC).
+ */
+string formatTime(time_t value) {
+    char buffer[32];
+    struct tm timeStruct;
+    gmtime_r(&value, &timeStruct);
+    strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &timeStruct);
+    return buffer;
+}
+
+/**
+ * @brief Retorna o texto de um código de aeroporto.
+ */
+string airportCode(AirportCode code) {
+    char buffer[4];
+    decodeAirportCode(code, buffer);
+    return buffer;
+}
+
+/**
+ * @brief Gera um predicado indexável (e seletivo) sobre um campo, com constantes de um voo real.
+ */
+string indexedPredicate(int field, const Flight &f, mt19937 &rng) {
+    ostringstream out;
+    switch (field) {
+        case INDEX_ORIGIN: out << "(org==" << airportCode(f.origin) << ")"; break;
+        case INDEX_DESTINATION: out << "(dst==" << airportCode(f.destination) << ")"; break;
+        case INDEX_PRICE: out << "(prc>=" << f.price << ")&&(prc<=" << f.price + 25 << ")"; break;
+        case INDEX_DURATION: out << "(dur>=" << f.duration << ")&&(dur<=" << f.duration + 600 << ")"; break;
+        case INDEX_STOPS: out << "(sto==" << f.stops << ")"; break;
+        case INDEX_SEATS: out << "(sea==" << f.seats << ")"; break;
+        case INDEX_DEPARTURE:
+            out << "(dep>=" << formatTime(f.dep_time) << ")&&(dep<=" << formatTime(f.dep_time + 86400) << ")";
+            break;
+        default:
+            out << "(arr>=" << formatTime(f.arr_time) << ")&&(arr<=" << formatTime(f.arr_time + 86400) << ")";
+            break;
+    }
+    if (rng() % 2)
+        out << "&&(sto<=" << (rng() % 4) << ")";
+    return out.str();
+}
+
+/**
+ * @brief Gera as consultas de uma mistura.
+ *
+ * - indexed: um predicado indexável seletivo, alternando entre os oito campos;
+ * - scan: apenas "!=" e NOT, o que força a varredura completa;
+ * - or: disjunções entre campos diferentes (também sem índice);
+ * - topk: intervalo amplo de preço com poucos resultados, dominado pela ordenação;
+ * - reorder: conjunção escrita com os predicados caros e pouco seletivos primeiro;
+ * - route: origem, destino e partida mínima, analisada a cada consulta;
+ * - prepared: as mesmas consultas de route, executadas por um template preparado;
+ * - box: intervalos de preço, duração e partida em conjunção, com o plano do
+ *   planejador (árvore k-d quando a caixa é bem mais seletiva);
+ * - box1d: as mesmas consultas de box, sempre pelo melhor índice de um campo;
+ * - bitmap: OR, NOT e NE sobre aeroportos, paradas e assentos em conjunção,
+ *   com o plano do planejador (bitmaps quando a interseção é mais seletiva);
+ * - bitmap1d: as mesmas consultas de bitmap, sempre pelo melhor índice de um campo.
+ */
+vector<BenchmarkQuery> generateQueries(const string &mix, FlightManager &flightManager,
+                                       int queryCount, mt19937 &rng) {
+    const char* criteria[] = { "pds", "dps", "spd", "psd" };
+    vector<BenchmarkQuery> queries;
+    int slotCount = flightManager.getSlotCount();
+    for (int i = 0; i < queryCount; i++) {
+        const Flight &a = *flightManager.getFlight(rng() % slotCount);
+        const Flight &b = *flightManager.getFlight(rng() % slotCount);
+        BenchmarkQuery query;
+        query.maxResults = 10;
+        query.sortCriteria = criteria[i % 4];
+        ostringstream out;
+        if (mix == "indexed") {
+            out << "(" << indexedPredicate(i % INDEX_COUNT, a, rng) << ")";
+        } else if (mix == "scan") {
+            out << "((!(org==" << airportCode(a.origin) << "))&&(sto!=" << a.stops << ")&&(dst!=" << airportCode(b.destination) << "))";
+        } else if (mix == "or") {
+            out << "((org==" << airportCode(a.origin) << ")||(dst==" << airportCode(b.destination) << ")||(prc<=" << a.price / 4
+                << ")||((sto==" << b.stops << ")&&(sea>=" << a.seats << ")))";
+        } else if (mix == "reorder") {
+            out << "((dst!=" << airportCode(b.destination) << ")&&(prc>=" << a.price / 8 << ")&&(org!=" << airportCode(b.origin)
+                << ")&&(sto==" << a.stops << ")&&(sea==" << a.seats << "))";
+        } else if (mix == "box" || mix == "box1d") {
+            out << "((prc>=" << a.price * 0.8 << ")&&(prc<=" << a.price * 1.2 << ")&&(dur>=" << a.duration / 2
+                << ")&&(dur<=" << a.duration + 3600 << ")&&(dep>=" << formatTime(a.dep_time - 86400 * 3)
+                << ")&&(dep<=" << formatTime(a.dep_time + 86400 * 3) << "))";
+        } else if (mix == "bitmap" || mix == "bitmap1d") {
+            out << "(((org==" << airportCode(a.origin) << ")||(org==" << airportCode(b.origin) << "))&&(sto==" << a.stops
+                << ")&&(sea>=" << a.seats / 2 << ")&&(!(dst==" << airportCode(a.destination) << "))&&(dst!="
+                << airportCode(b.destination) << "))";
+        } else if (mix == "route" || mix == "prepared") {
+            query.parameters.push_back(airportCode(a.origin));
+            query.parameters.push_back(airportCode(a.destination));
+            query.parameters.push_back(formatTime(a.dep_time - 86400 * (rng() % 30)));
+            out << "((org==" << airportCode(a.origin) << ")&&(dst==" << airportCode(a.destination) << ")&&(dep>="
+                << query.parameters[2] << "))";
+        } else {
+            out << "((prc>=" << a.price / 2 << "))";
+            query.maxResults = 5;
+        }
+        query.expression = out.str();
+        queries.push_back(query);
+    }
+    return queries;
+}
+
+/**
+ * @brief Escolhe o predicado indexável da conjunção com menos candidatos: o melhor plano de um índice só.
+ *
+ * Os predicados de partida contam a janela inteira, pois o percurso do índice
+ * de horários combina os predicados do campo; nos demais campos, o percurso
+ * usa só o predicado escolhido.
+ */
+PredicateExpr* bestSingleIndexPlan(FlightManager &flightManager, Expr* expression) {
+    PredicateExpr* best = findIndexablePredicate(expression);
+    if (!best || expression->kind != EXPR_LOGICAL)
+        return best;
+    KDBox box, window;
+    conjunctionBox(expression, box);
+    window.low[2] = box.low[2];
+    window.high[2] = box.high[2];
+    double bestEstimate = HUGE_VAL;
+    LogicalExpr* logical = static_cast<LogicalExpr*>(expression);
+    for (int i = 0; i < logical->childCount; i++) {
+        PredicateExpr* predicate = findIndexablePredicate(logical->children[i]);
+        if (!predicate || predicate != logical->children[i])
+            continue;
+        double estimate = predicate->field == INDEX_DEPARTURE ? flightManager.estimateBox(window)
+                                                              : flightManager.estimateCandidates(predicate);
+        if (estimate < bestEstimate) {
+            bestEstimate = estimate;
+            best = predicate;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Retorna o percentil p (0-100) de um vetor ordenado.
+ */
+double percentile(const vector<double> &sorted, double p) {
+    if (sorted.empty())
+        return 0;
+    size_t index = static_cast<size_t>(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+/**
+ * @brief Roda todas as misturas para um arquivo de voos.
+ */
+bool runSize(int size, const vector<string> &mixes, int queryCount, vector<MixResult> &results) {
+    string filename = "inputs/flights_" + to_string(size) + ".txt";
+    ifstream file(filename);
+    if (!file)
+        return false;
+
+    FlightManager flightManager;
+    auto startLoad = steady_clock::now();
+    int flightCount;
+    file >> flightCount;
+    for (int i = 0; i < flightCount; i++) {
+        Flight flight;
+        if (!readFlight(file, flight)) {
+            cerr << "Erro ao ler o voo " << i + 1 << " de " << filename << endl;
+            return false;
+        }
+        flightManager.addFlight(flight);
+    }
+    double loadMs = duration<double, milli>(steady_clock::now() - startLoad).count();
+
+    auto startBuild = steady_clock::now();
+    flightManager.buildIndices();
+    double buildMs = duration<double, milli>(steady_clock::now() - startBuild).count();
+
+    mt19937 rng(size);
+    for (size_t m = 0; m < mixes.size(); m++) {
+        // box e box1d (assim como bitmap e bitmap1d) comparam planos: as duas misturas recebem as mesmas consultas.
+        mt19937 planRng(size + 1);
+        bool planMix = mixes[m] == "box" || mixes[m] == "box1d" || mixes[m] == "bitmap" || mixes[m] == "bitmap1d";
+        vector<BenchmarkQuery> queries = generateQueries(mixes[m], flightManager, queryCount, planMix ? planRng : rng);
+        vector<double> latencies;
+        long long totalResults = 0;
+        PreparedQuery* prepared = nullptr;
+        if (mixes[m] == "prepared") {
+            prepared = new PreparedQuery();
+            prepared->prepare(ROUTE_TEMPLATE);
+        }
+        ExprArena arena;
+        auto startMix = steady_clock::now();
+        for (size_t q = 0; q < queries.size(); q++) {
+            auto start = steady_clock::now();
+            int resultCount = 0;
+            if (prepared) {
+                for (size_t p = 0; p < queries[q].parameters.size(); p++)
+                    prepared->bind(static_cast<int>(p), queries[q].parameters[p]);
+                delete[] prepared->execute(flightManager, queries[q].sortCriteria, resultCount);
+            } else {
+                arena.reset();
+                Parser parser(queries[q].expression, arena);
+                Expr* expression = parser.parseExpression();
+                Flight** resultFlights;
+                if (mixes[m] == "box1d" || mixes[m] == "bitmap1d") {
+                    PredicateExpr* plan = bestSingleIndexPlan(flightManager, expression);
+                    optimizeExpression(flightManager, expression, plan);
+                    resultFlights = executePlannedQuery(flightManager, expression, plan, queries[q].sortCriteria, resultCount);
+                } else {
+                    resultFlights = executeQuery(flightManager, expression, queries[q].sortCriteria, resultCount);
+                }
+                delete[] resultFlights;
+            }
+            latencies.push_back(duration<double, micro>(steady_clock::now() - start).count());
+            totalResults += resultCount < queries[q].maxResults ? resultCount : queries[q].maxResults;
+        }
+        double totalSeconds = duration<double>(steady_clock::now() - startMix).count();
+        delete prepared;
+        sort(latencies.begin(), latencies.end());
+
+        MixResult result;
+        result.size = size;
+        result.mix = mixes[m];
+        result.queries = static_cast<int>(queries.size());
+        result.loadMs = loadMs;
+        result.buildMs = buildMs;
+        result.p50Us = percentile(latencies, 50);
+        result.p95Us = percentile(latencies, 95);
+        result.p99Us = percentile(latencies, 99);
+        double sum = 0;
+        for (size_t i = 0; i < latencies.size(); i++)
+            sum += latencies[i];
+        result.meanUs = latencies.empty() ? 0 : sum / latencies.size();
+        result.throughput = totalSeconds > 0 ? queries.size() / totalSeconds : 0;
+        result.avgResults = queries.empty() ? 0 : static_cast<double>(totalResults) / queries.size();
+        result.peakRssKb = peakRssKb();
+        results.push_back(result);
+        cout << size << "\t" << result.mix << "\tp50=" << result.p50Us << "us\tp99=" << result.p99Us
+             << "us\t" << result.throughput << " q/s" << endl;
+    }
+    return true;
+}
+
+/**
+ * @brief Divide uma lista separada por vírgulas.
+ */
+vector<string> splitList(const string &list) {
+    vector<string> items;
+    stringstream stream(list);
+    string item;
+    while (getline(stream, item, ','))
+        if (!item.empty())
+            items.push_back(item);
+    return items;
+}
+
+/**
+ * @brief Grava os resultados em CSV e JSON.
+ */
+void writeResults(const vector<MixResult> &results, const string &prefix) {
+    ofstream csv(prefix + ".csv");
+    csv << "size,mix,queries,load_ms,build_ms,p50_us,p95_us,p99_us,mean_us,throughput_qps,avg_results,peak_rss_kb\n";
+    ofstream json(prefix + ".json");
+    json << "[\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const MixResult &r = results[i];
+        csv << r.size << "," << r.mix << "," << r.queries << "," << r.loadMs << "," << r.buildMs << ","
+            << r.p50Us << "," << r.p95Us << "," << r.p99Us << "," << r.meanUs << ","
+            << r.throughput << "," << r.avgResults << "," << r.peakRssKb << "\n";
+        json << "  {\"size\": " << r.size << ", \"mix\": \"" << r.mix << "\", \"queries\": " << r.queries
+             << ", \"load_ms\": " << r.loadMs << ", \"build_ms\": " << r.buildMs
+             << ", \"p50_us\": " << r.p50Us << ", \"p95_us\": " << r.p95Us << ", \"p99_us\": " << r.p99Us
+             << ", \"mean_us\": " << r.meanUs << ", \"throughput_qps\": " << r.throughput
+             << ", \"avg_results\": " << r.avgResults << ", \"peak_rss_kb\": " << r.peakRssKb << "}"
+             << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    json << "]\n";
+}
+
+int main(int argc, char* argv[]) {
+    vector<string> sizeList = splitList("100,1000,5000,10000,50000,100000,250000,500000");
+    vector<string> mixes = splitList("indexed,scan,or,topk,reorder,route,prepared,box,box1d,bitmap,bitmap1d");
+    int queryCount = 200;
+    string prefix = "benchmarks/queries";
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--sizes") && i + 1 < argc) sizeList = splitList(argv[++i]);
+        else if (!strcmp(argv[i], "--mixes") && i + 1 < argc) mixes = splitList(argv[++i]);
+        else if (!strcmp(argv[i], "--queries") && i + 1 < argc) queryCount = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc) prefix = argv[++i];
+        else {
+            cerr << "Uso: " << argv[0] << " [--sizes 100,1000] [--mixes indexed,scan,or,topk,reorder,route,prepared,box,box1d,bitmap,bitmap1d]"
+                 << " [--queries N] [--out benchmarks/queries]\n";
+            return 1;
+        }
+    }
+
+    vector<MixResult> results;
+    for (size_t i = 0; i < sizeList.size(); i++) {
+        int size = atoi(sizeList[i].c_str());
+        cout << "Rodando consultas para " << size << " voos..." << endl;
+        if (!runSize(size, mixes, queryCount, results))
+            cout << "Arquivo inputs/flights_" << size << ".txt não encontrado, ignorando." << endl;
+    }
+    writeResults(results, prefix);
+    return 0;
+}
@@ -0,0 +1,617 @@
+#include "../include/QueryExecutor.hpp"
+#include "../include/Metrics.hpp"
+#include "../include/Sort.hpp"
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+using std::chrono::steady_clock;
+
+/**
+ * @brief Microssegundos decorridos desde start.
+ */
+static double elapsedUs(const steady_clock::time_point &start) {
+    return std::chrono::duration<double, std::micro>(steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Descreve um predicado no formato da consulta (ex.: "prc<=300").
+ */
+string describePredicate(const PredicateExpr* predicate) {
+    static const char* operators[] = { "==", "!=", "<", "<=", ">", ">=" };
+    std::ostringstream out;
+    out << fieldName(predicate->field) << operators[predicate->op];
+    if (predicate->isNumeric)
+        out << std::setprecision(15) << predicate->numValue;
+    else
+        out << predicate->strValue;
+    return out.str();
+}
+
+/**
+ * @brief Escreve o perfil de uma consulta em uma linha.
+ */
+void printQueryProfile(FILE* out, int queryNumber, const QueryProfile &profile) {
+    fprintf(out, "EXPLAIN query=%d path=%s candidates=%d results=%d "
+                 "parse_us=%.1f plan_us=%.1f candidates_us=%.1f filter_us=%.1f sort_us=%.1f output_us=%.1f\n",
+            queryNumber, profile.accessPath.c_str(), profile.candidateCount, profile.resultCount,
+            profile.parseUs, profile.planUs, profile.candidatesUs, profile.filterUs,
+            profile.sortUs, profile.outputUs);
+}
+
+/**
+ * @brief Quantas vezes a estimativa da caixa precisa ser menor que a do índice de um campo para que a árvore k-d seja usada.
+ *
+ * A estimativa da caixa supõe dimensões independentes e não conta os pontos
+ * das folhas da borda, que são comparados mas ficam fora da caixa.
+ */
+static const double BOX_PLAN_FACTOR = 2;
+
+/**
+ * @brief Quantas vezes a estimativa do bitmap precisa ser menor que a do caminho escolhido para que o bitmap seja usado.
+ *
+ * Montar o bitmap custa uma passada pelos contêineres das chaves envolvidas,
+ * mas os voos são visitados em ordem de identificador (a ordem da memória), o
+ * que compensa; 1 = basta o bitmap ter menos candidatos.
+ */
+static const double BITMAP_PLAN_FACTOR = 1;
+
+/**
+ * @brief Custo esperado de avaliar uma subexpressão e fração dos voos que a satisfazem.
+ *
+ * O custo é o número esperado de predicados avaliados. Todo predicado conta
+ * 1: cada um é uma única comparação de números com um campo do voo (os
+ * códigos de aeroporto são inteiros, veja AirportCode); com 1M de voos, os
+ * oito campos mediram entre 7,7 e 9,4 ns por avaliação. Entre predicados,
+ * a ordem sai só da seletividade; o custo distingue um AND/OR aninhado de
+ * um predicado.
+ */
+struct ExprStats {
+    double cost;         ///< Número esperado de predicados avaliados por voo.
+    double selectivity;  ///< Fração estimada dos voos que satisfazem a subexpressão.
+};
+
+/**
+ * @brief Estima a fração dos voos ativos que satisfazem um predicado.
+ */
+static double predicateSelectivity(FlightManager &flightManager, const PredicateExpr* predicate,
+                                   const PredicateExpr* plan) {
+    if (predicate == plan)
+        return 1;
+    double total = flightManager.getFlightCount();
+    if (total <= 0)
+        return 0.5;
+    double selectivity = flightManager.estimateCandidates(predicate) / total;
+    return selectivity < 0 ? 0 : (selectivity > 1 ? 1 : selectivity);
+}
+
+/**
+ * @brief Ordem de avaliação de um operando: menor primeiro.
+ *
+ * Em um AND vale a pena avaliar cedo o que é barato e rejeita muito; em um
+ * OR, o que é barato e aceita muito.
+ */
+static double evaluationRank(const ExprStats &stats, bool conjunction) {
+    double decisive = conjunction ? 1 - stats.selectivity : stats.selectivity;
+    return decisive > 0 ? stats.cost / decisive : HUGE_VAL;
+}
+
+/**
+ * @brief Reordena recursivamente os operandos e retorna as estatísticas da subexpressão.
+ */
+static ExprStats optimizeNode(FlightManager &flightManager, Expr* expr, const PredicateExpr* plan) {
+    ExprStats stats;
+    if (expr->kind == EXPR_PREDICATE) {
+        PredicateExpr* predicate = static_cast<PredicateExpr*>(expr);
+        stats.cost = 1;
+        stats.selectivity = predicateSelectivity(flightManager, predicate, plan);
+        return stats;
+    }
+    if (expr->kind == EXPR_NOT) {
+        stats = optimizeNode(flightManager, static_cast<NotExpr*>(expr)->child, plan);
+        stats.selectivity = 1 - stats.selectivity;
+        return stats;
+    }
+
+    LogicalExpr* logical = static_cast<LogicalExpr*>(expr);
+    bool conjunction = logical->op == '&';
+    const int LOCAL_CHILDREN = 16;
+    ExprStats localStats[LOCAL_CHILDREN];
+    ExprStats* childStats = logical->childCount <= LOCAL_CHILDREN ? localStats : new ExprStats[logical->childCount];
+    for (int i = 0; i < logical->childCount; i++)
+        childStats[i] = optimizeNode(flightManager, logical->children[i], plan);
+
+    // Inserção estável: operandos com a mesma ordem mantêm a posição escrita na consulta.
+    for (int i = 1; i < logical->childCount; i++) {
+        Expr* child = logical->children[i];
+        ExprStats current = childStats[i];
+        double rank = evaluationRank(current, conjunction);
+        int j = i - 1;
+        while (j >= 0 && evaluationRank(childStats[j], conjunction) > rank) {
+            logical->children[j + 1] = logical->children[j];
+            childStats[j + 1] = childStats[j];
+            j--;
+        }
+        logical->children[j + 1] = child;
+        childStats[j + 1] = current;
+    }
+
+    // Cada operando só é avaliado se os anteriores não decidiram a expressão.
+    double reached = 1;
+    stats.cost = 0;
+    for (int i = 0; i < logical->childCount; i++) {
+        stats.cost += reached * childStats[i].cost;
+        reached *= conjunction ? childStats[i].selectivity : 1 - childStats[i].selectivity;
+    }
+    stats.selectivity = conjunction ? reached : 1 - reached;
+
+    if (childStats != localStats)
+        delete[] childStats;
+    return stats;
+}
+
+/**
+ * @brief Reordena os operandos de cada AND/OR pelo custo e pela seletividade estimados.
+ */
+void optimizeExpression(FlightManager &flightManager, Expr* expression, const PredicateExpr* plan) {
+    if (expression)
+        optimizeNode(flightManager, expression, plan);
+}
+
+/**
+ * @brief Conta os operandos dos nós AND/OR da expressão.
+ */
+int countOperands(const Expr* expr) {
+    if (!expr)
+        return 0;
+    if (expr->kind == EXPR_NOT)
+        return countOperands(static_cast<const NotExpr*>(expr)->child);
+    if (expr->kind != EXPR_LOGICAL)
+        return 0;
+    const LogicalExpr* logical = static_cast<const LogicalExpr*>(expr);
+    int count = logical->childCount;
+    for (int i = 0; i < logical->childCount; i++)
+        count += countOperands(logical->children[i]);
+    return count;
+}
+
+/**
+ * @brief Copia a ordem dos operandos de cada AND/OR (pré-ordem) para saved.
+ */
+static void saveOrder(const Expr* expr, Expr** saved, int &position) {
+    if (!expr)
+        return;
+    if (expr->kind == EXPR_NOT) {
+        saveOrder(static_cast<const NotExpr*>(expr)->child, saved, position);
+    } else if (expr->kind == EXPR_LOGICAL) {
+        const LogicalExpr* logical = static_cast<const LogicalExpr*>(expr);
+        for (int i = 0; i < logical->childCount; i++)
+            saved[position++] = logical->children[i];
+        for (int i = 0; i < logical->childCount; i++)
+            saveOrder(logical->children[i], saved, position);
+    }
+}
+
+/**
+ * @brief Restaura a ordem gravada por saveOrder().
+ */
+static void restoreOrder(Expr* expr, Expr* const* saved, int &position) {
+    if (!expr)
+        return;
+    if (expr->kind == EXPR_NOT) {
+        restoreOrder(static_cast<NotExpr*>(expr)->child, saved, position);
+    } else if (expr->kind == EXPR_LOGICAL) {
+        LogicalExpr* logical = static_cast<LogicalExpr*>(expr);
+        for (int i = 0; i < logical->childCount; i++)
+            logical->children[i] = saved[position++];
+        for (int i = 0; i < logical->childCount; i++)
+            restoreOrder(logical->children[i], saved, position);
+    }
+}
+
+void saveOperandOrder(const Expr* expression, Expr** saved) {
+    int position = 0;
+    saveOrder(expression, saved, position);
+}
+
+void restoreOperandOrder(Expr* expression, Expr* const* saved) {
+    int position = 0;
+    restoreOrder(expression, saved, position);
+}
+
+/**
+ * @brief Estima quantos voos o predicado indexável escolhido percorre (todos os voos, se não houver).
+ *
+ * Um predicado de partida percorre a janela que combina os predicados do
+ * campo, que é a dimensão de partida da caixa da conjunção.
+ *
+ * @param box Caixa da conjunção principal (veja conjunctionBox()).
+ */
+static double indexPlanEstimate(FlightManager &flightManager, const KDBox &box, const PredicateExpr* plan) {
+    if (plan && plan->field == INDEX_DEPARTURE) {
+        KDBox window;
+        window.low[2] = box.low[2];
+        window.high[2] = box.high[2];
+        return flightManager.estimateBox(window);
+    }
+    return plan ? flightManager.estimateCandidates(plan) : flightManager.getFlightCount();
+}
+
+/**
+ * @brief Decide se a árvore k-d é um caminho de acesso melhor que o predicado indexável escolhido.
+ *
+ * Só se aplica quando a conjunção principal restringe ao menos duas das
+ * dimensões da árvore (preço, duração e partida). O custo de cada caminho é
+ * o número estimado de voos percorridos: a contagem do predicado (ou da
+ * janela de partida, que combina os predicados do campo) contra a estimativa
+ * da caixa.
+ *
+ * @param box (Saída) Caixa da conjunção, se a árvore for escolhida.
+ */
+static bool chooseBoxPlan(FlightManager &flightManager, Expr* expression, const PredicateExpr* plan, KDBox &box) {
+    if (conjunctionBox(expression, box) < 2)
+        return false;
+    return flightManager.estimateBox(box) * BOX_PLAN_FACTOR < indexPlanEstimate(flightManager, box, plan);
+}
+
+/**
+ * @brief Descreve uma subexpressão no formato da consulta (ex.: "(sto==0||!(org==GRU))").
+ */
+static string describeExpression(const Expr* expr) {
+    if (expr->kind == EXPR_PREDICATE)
+        return describePredicate(static_cast<const PredicateExpr*>(expr));
+    if (expr->kind == EXPR_NOT)
+        return "!(" + describeExpression(static_cast<const NotExpr*>(expr)->child) + ")";
+    const LogicalExpr* logical = static_cast<const LogicalExpr*>(expr);
+    string description = "(";
+    for (int i = 0; i < logical->childCount; i++) {
+        if (i > 0)
+            description += logical->op == '&' ? "&&" : "||";
+        description += describeExpression(logical->children[i]);
+    }
+    return description + ")";
+}
+
+/**
+ * @brief Estima a fração dos voos no bitmap exato de uma subexpressão (veja FlightManager::findMatchesFromBitmap).
+ *
+ * Combina as frações dos predicados como optimizeNode(): produto no AND,
+ * 1 - produto dos complementos no OR, complemento no NOT.
+ *
+ * @return Fração estimada, ou -1 se a subexpressão usa campos sem índice de bitmap.
+ */
+static double bitmapSelectivity(FlightManager &flightManager, const Expr* expr) {
+    if (expr->kind == EXPR_PREDICATE) {
+        const PredicateExpr* predicate = static_cast<const PredicateExpr*>(expr);
+        if (!flightManager.hasBitmapIndex(predicate))
+            return -1;
+        return predicateSelectivity(flightManager, predicate, nullptr);
+    }
+    if (expr->kind == EXPR_NOT) {
+        double selectivity = bitmapSelectivity(flightManager, static_cast<const NotExpr*>(expr)->child);
+        return selectivity < 0 ? -1 : 1 - selectivity;
+    }
+    const LogicalExpr* logical = static_cast<const LogicalExpr*>(expr);
+    bool conjunction = logical->op == '&';
+    double reached = 1;
+    for (int i = 0; i < logical->childCount; i++) {
+        double selectivity = bitmapSelectivity(flightManager, logical->children[i]);
+        if (selectivity < 0)
+            return -1;
+        reached *= conjunction ? selectivity : 1 - selectivity;
+    }
+    return conjunction ? reached : 1 - reached;
+}
+
+/**
+ * @brief Decide se o bitmap da conjunção principal é um caminho de acesso melhor que o escolhido.
+ *
+ * Os operandos do AND no topo que só usam campos com índice de bitmap entram
+ * na estimativa; os demais são avaliados voo a voo. O custo do caminho
+ * escolhido é o número estimado de voos percorridos (do índice, da caixa ou
+ * de todos os voos, na varredura).
+ *
+ * @param planEstimate Voos percorridos pelo caminho escolhido até aqui.
+ */
+static bool chooseBitmapPlan(FlightManager &flightManager, Expr* expression, double planEstimate) {
+    if (!expression)
+        return false;
+    Expr** children = &expression;
+    int childCount = 1;
+    if (expression->kind == EXPR_LOGICAL && static_cast<LogicalExpr*>(expression)->op == '&') {
+        children = static_cast<LogicalExpr*>(expression)->children;
+        childCount = static_cast<LogicalExpr*>(expression)->childCount;
+    }
+    double fraction = 1;
+    bool covered = false;
+    for (int i = 0; i < childCount; i++) {
+        double selectivity = bitmapSelectivity(flightManager, children[i]);
+        if (selectivity < 0)
+            continue;
+        fraction *= selectivity;
+        covered = true;
+    }
+    return covered && fraction * flightManager.getFlightCount() * BITMAP_PLAN_FACTOR < planEstimate;
+}
+
+/**
+ * @brief Escolhe o caminho de acesso: predicado indexável, árvore k-d, bitmap ou varredura.
+ *
+ * @param candidatePredicate (Entrada/Saída) Predicado indexável; nullptr se outro caminho for escolhido.
+ * @param box (Saída) Caixa da árvore k-d, se useBox.
+ * @param useBox (Saída) True se a árvore k-d foi escolhida.
+ * @param useBitmap (Saída) True se o bitmap foi escolhido.
+ */
+static void chooseAccessPath(FlightManager &flightManager, Expr* expression, PredicateExpr* &candidatePredicate,
+                             KDBox &box, bool &useBox, bool &useBitmap) {
+    useBox = chooseBoxPlan(flightManager, expression, candidatePredicate, box);
+    double planEstimate = useBox ? flightManager.estimateBox(box)
+                                 : indexPlanEstimate(flightManager, box, candidatePredicate);
+    useBitmap = chooseBitmapPlan(flightManager, expression, planEstimate);
+    if (useBitmap)
+        useBox = false;
+    if (useBox || useBitmap)
+        candidatePredicate = nullptr;
+}
+
+/**
+ * @brief Descreve os operandos da conjunção principal respondidos pelo bitmap (ex.: "sto==0&&!(org==GRU)").
+ */
+static string describeBitmap(FlightManager &flightManager, Expr* expression) {
+    Expr** children = &expression;
+    int childCount = 1;
+    if (expression->kind == EXPR_LOGICAL && static_cast<LogicalExpr*>(expression)->op == '&') {
+        children = static_cast<LogicalExpr*>(expression)->children;
+        childCount = static_cast<LogicalExpr*>(expression)->childCount;
+    }
+    string description;
+    for (int i = 0; i < childCount; i++) {
+        if (bitmapSelectivity(flightManager, children[i]) < 0)
+            continue;
+        if (!description.empty())
+            description += "&&";
+        description += describeExpression(children[i]);
+    }
+    return description;
+}
+
+/**
+ * @brief Descreve os predicados da conjunção principal usados na caixa da árvore k-d (ex.: "prc>=100&&dur<=600").
+ */
+static string describeBox(Expr* expression) {
+    Expr** children = &expression;
+    int childCount = 1;
+    if (expression->kind == EXPR_LOGICAL) {
+        children = static_cast<LogicalExpr*>(expression)->children;
+        childCount = static_cast<LogicalExpr*>(expression)->childCount;
+    }
+    string description;
+    for (int i = 0; i < childCount; i++) {
+        if (children[i]->kind != EXPR_PREDICATE)
+            continue;
+        PredicateExpr* predicate = static_cast<PredicateExpr*>(children[i]);
+        if (predicate->op == PredicateExpr::NE || (predicate->field != INDEX_PRICE
+            && predicate->field != INDEX_DURATION && predicate->field != INDEX_DEPARTURE))
+            continue;
+        if (!description.empty())
+            description += "&&";
+        description += describePredicate(predicate);
+    }
+    return description;
+}
+
+#ifdef ENABLE_METRICS
+/**
+ * @brief Registra, para cada predicado da expressão, se o campo foi usado como índice ou avaliado voo a voo.
+ */
+static void recordFieldMetrics(Expr* expr, const PredicateExpr* indexed) {
+    if (expr->kind == EXPR_PREDICATE) {
+        PredicateExpr* predicate = static_cast<PredicateExpr*>(expr);
+        METRIC_FIELD(predicate->field, predicate == indexed ? METRIC_PATH_INDEX : METRIC_PATH_SCAN);
+    } else if (expr->kind == EXPR_LOGICAL) {
+        LogicalExpr* logical = static_cast<LogicalExpr*>(expr);
+        for (int i = 0; i < logical->childCount; i++)
+            recordFieldMetrics(logical->children[i], indexed);
+    } else {
+        recordFieldMetrics(static_cast<NotExpr*>(expr)->child, indexed);
+    }
+}
+#endif
+
+/**
+ * @brief Executa uma consulta sobre os voos do gerenciador.
+ */
+Flight** executeQuery(FlightManager &flightManager, Expr* expression,
+                      const string &sortCriteria, int &resultCount,
+                      QueryProfile* profile) {
+    steady_clock::time_point phaseStart;
+    if (profile)
+        phaseStart = steady_clock::now();
+
+    PredicateExpr* candidatePredicate = findIndexablePredicate(expression);
+    KDBox box;
+    bool useBox, useBitmap;
+    chooseAccessPath(flightManager, expression, candidatePredicate, box, useBox, useBitmap);
+    optimizeExpression(flightManager, expression, candidatePredicate);
+
+    if (profile)
+        profile->planUs = elapsedUs(phaseStart);
+
+    return executePlannedQuery(flightManager, expression, candidatePredicate, sortCriteria, resultCount, profile,
+                               useBox ? &box : nullptr, useBitmap);
+}
+
+/**
+ * @brief Executa uma consulta com um caminho de acesso já escolhido.
+ */
+Flight** executePlannedQuery(FlightManager &flightManager, Expr* expression, PredicateExpr* candidatePredicate,
+                             const string &sortCriteria, int &resultCount,
+                             QueryProfile* profile, const KDBox* box, bool useBitmap) {
+    Flight** candidateFlights = nullptr;
+    int candidateCount = 0;
+    bool indexed = candidatePredicate || box || useBitmap;
+
+    METRIC_INC(METRIC_QUERIES);
+    METRIC_INC(indexed ? METRIC_INDEX_PLANS : METRIC_SCAN_PLANS);
+#ifdef ENABLE_METRICS
+    recordFieldMetrics(expression, candidatePredicate);
+#endif
+
+    steady_clock::time_point phaseStart;
+    if (profile) {
+        if (useBitmap)
+            profile->accessPath = "bitmap(" + describeBitmap(flightManager, expression) + ")";
+        else if (box)
+            profile->accessPath = "kdtree(" + describeBox(expression) + ")";
+        else
+            profile->accessPath = candidatePredicate ? "index(" + describePredicate(candidatePredicate) + ")" : "scan";
+        phaseStart = steady_clock::now();
+    }
+
+    Flight** resultFlights = nullptr;
+    resultCount = 0;
+    if (useBitmap) {
+        resultFlights = flightManager.findMatchesFromBitmap(expression, candidateCount, resultCount);
+    } else if (box) {
+        resultFlights = flightManager.findMatchesFromBox(*box, expression, candidateCount, resultCount);
+    } else if (candidatePredicate) {
+        // O filtro é avaliado durante o percurso do índice, sem array de candidatos.
+        resultFlights = flightManager.findMatchesFromIndex(candidatePredicate, expression,
+                                                           candidateCount, resultCount);
+    } else {
+        int slotCount = flightManager.getSlotCount();
+        candidateFlights = new Flight*[slotCount > 0 ? slotCount : 1];
+        for (int j = 0; j < slotCount; j++) {
+            Flight* flight = flightManager.getFlight(j);
+            if (flight)
+                candidateFlights[candidateCount++] = flight;
+        }
+    }
+
+    if (profile) {
+        profile->candidatesUs = elapsedUs(phaseStart);
+        profile->candidateCount = candidateCount;
+        phaseStart = steady_clock::now();
+    }
+
+    if (!indexed) {
+        int resultCapacity = (candidateCount > 10) ? candidateCount : 10;
+        resultFlights = new Flight*[resultCapacity];
+        for (int j = 0; j < candidateCount; j++)
+            if (expression->evaluate(*candidateFlights[j]))
+                resultFlights[resultCount++] = candidateFlights[j];
+    }
+
+    METRIC_ADD(METRIC_CANDIDATES, candidateCount);
+    METRIC_ADD(METRIC_RESULTS, resultCount);
+    METRIC_OBSERVE(METRIC_HIST_CANDIDATES, candidateCount);
+    METRIC_OBSERVE(METRIC_HIST_CANDIDATES_PER_RESULT, candidateCount / (resultCount > 0 ? resultCount : 1));
+    METRIC_OBSERVE(METRIC_HIST_SORT_SIZE, resultCount);
+
+    if (profile) {
+        profile->filterUs = elapsedUs(phaseStart);
+        profile->resultCount = resultCount;
+        phaseStart = steady_clock::now();
+    }
+
+    if (resultCount > 0)
+        quickSortFlights(resultFlights, 0, resultCount - 1, sortCriteria);
+
+    if (profile)
+        profile->sortUs = elapsedUs(phaseStart);
+
+    delete[] candidateFlights;
+    return resultFlights;
+}
+
+/**
+ * @brief Descreve os predicados de uma conjunção respondida pelo índice (ex.: "prc>=100&&prc<300").
+ */
+static string describeConjunction(Expr* expression) {
+    if (!expression)
+        return "*";
+    if (expression->kind == EXPR_PREDICATE)
+        return describePredicate(static_cast<PredicateExpr*>(expression));
+    LogicalExpr* logical = static_cast<LogicalExpr*>(expression);
+    string description;
+    for (int i = 0; i < logical->childCount; i++) {
+        if (i > 0)
+            description += "&&";
+        description += describePredicate(static_cast<PredicateExpr*>(logical->children[i]));
+    }
+    return description;
+}
+
+/**
+ * @brief Executa uma consulta de agregação (count, min, max, sum ou avg).
+ */
+void executeAggregate(FlightManager &flightManager, Expr* expression, AggregateResult &result,
+                      QueryProfile* profile) {
+    METRIC_INC(METRIC_QUERIES);
+    steady_clock::time_point phaseStart;
+    if (profile)
+        phaseStart = steady_clock::now();
+
+    if (flightManager.aggregateFromIndex(expression, result)) {
+        METRIC_INC(METRIC_INDEX_PLANS);
+        METRIC_ADD(METRIC_RESULTS, result.count);
+        if (profile) {
+            profile->accessPath = "aggregate(" + describeConjunction(expression) + ")";
+            profile->candidatesUs = elapsedUs(phaseStart);
+            profile->resultCount = static_cast<int>(result.count);
+        }
+        return;
+    }
+
+    PredicateExpr* candidatePredicate = findIndexablePredicate(expression);
+    KDBox box;
+    bool useBox, useBitmap;
+    chooseAccessPath(flightManager, expression, candidatePredicate, box, useBox, useBitmap);
+    optimizeExpression(flightManager, expression, candidatePredicate);
+    METRIC_INC(candidatePredicate || useBox || useBitmap ? METRIC_INDEX_PLANS : METRIC_SCAN_PLANS);
+#ifdef ENABLE_METRICS
+    if (expression)
+        recordFieldMetrics(expression, candidatePredicate);
+#endif
+
+    if (profile) {
+        profile->planUs = elapsedUs(phaseStart);
+        if (useBitmap)
+            profile->accessPath = "bitmap(" + describeBitmap(flightManager, expression) + ")";
+        else if (useBox)
+            profile->accessPath = "kdtree(" + describeBox(expression) + ")";
+        else
+            profile->accessPath = candidatePredicate ? "index(" + describePredicate(candidatePredicate) + ")" : "scan";
+        phaseStart = steady_clock::now();
+    }
+
+    int candidateCount = 0;
+    if (useBitmap) {
+        flightManager.accumulateMatchesFromBitmap(expression, result, candidateCount);
+    } else if (useBox) {
+        flightManager.accumulateMatchesFromBox(box, expression, result, candidateCount);
+    } else if (candidatePredicate) {
+        flightManager.accumulateMatchesFromIndex(candidatePredicate, expression, result, candidateCount);
+    } else {
+        int slotCount = flightManager.getSlotCount();
+        for (int j = 0; j < slotCount; j++) {
+            Flight* flight = flightManager.getFlight(j);
+            if (!flight)
+                continue;
+            candidateCount++;
+            if (!expression || expression->evaluate(*flight))
+                result.add(flight);
+        }
+    }
+
+    METRIC_ADD(METRIC_CANDIDATES, candidateCount);
+    METRIC_ADD(METRIC_RESULTS, result.count);
+    METRIC_OBSERVE(METRIC_HIST_CANDIDATES, candidateCount);
+
+    if (profile) {
+        profile->candidatesUs = elapsedUs(phaseStart);
+        profile->candidateCount = candidateCount;
+        profile->resultCount = static_cast<int>(result.count);
+    }
+}
@@ -0,0 +1,176 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <cstdlib>
+#include "../include/Flight.hpp"
+#include "../include/FlightManager.hpp"
+#include "../include/Parser.hpp"
+#include "../include/QueryExecutor.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+/**
+ * @brief Carrega os voos de um arquivo de entrada no gerenciador.
+ *
+ * Os assentos são multiplicados por seatScale para que as reservas não
+ * esgotem o conjunto de dados nos primeiros milissegundos.
+ */
+bool loadFlights(const string &filename, FlightManager &flightManager, int seatScale) {
+    ifstream file(filename);
+    if (!file) {
+        cerr << "Erro ao abrir " << filename << endl;
+        return false;
+    }
+    int flightCount;
+    if (!(file >> flightCount) || flightCount <= 0) {
+        cerr << "Erro: número inválido de voos." << endl;
+        return false;
+    }
+    for (int i = 0; i < flightCount; i++) {
+        Flight flight;
+        if (!readFlight(file, flight)) {
+            cerr << "Erro ao ler o voo " << i + 1 << endl;
+            return false;
+        }
+        flight.seats *= seatScale;
+        flightManager.addFlight(flight);
+    }
+    flightManager.buildIndices();
+    return true;
+}
+
+/**
+ * @brief Confere se indexSeats (e o índice de bitmap de assentos, se houver) corresponde aos assentos atuais de todos os voos.
+ */
+bool checkSeatIndex(FlightManager &flightManager, int maxSeats) {
+    vector<int> scanCounts(maxSeats + 1, 0);
+    for (int id = 0; id < flightManager.getSlotCount(); id++) {
+        Flight* flight = flightManager.getFlight(id);
+        if (flight)
+            scanCounts[flight->seats]++;
+    }
+    for (int seats = 0; seats <= maxSeats; seats++) {
+        int count = 0;
+        Flight** flights = flightManager.indexSeats->rangeQuery(&seats, true, &seats, true, count);
+        bool matches = count == scanCounts[seats];
+        for (int i = 0; matches && i < count; i++)
+            matches = flights[i]->seats == seats;
+        delete[] flights;
+        BitmapIndex* bitmap = flightManager.bitmapIndex[INDEX_SEATS];
+        if (matches && bitmap) {
+            RoaringBitmap* ids = bitmap->select(PredicateExpr::EQ, seats);
+            matches = ids->cardinality() == scanCounts[seats];
+            delete ids;
+        }
+        if (!matches)
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "Uso: " << argv[0] << " <arquivo_de_voos> [threads_reserva] [threads_consulta] [segundos] [escala_assentos]\n";
+        return 1;
+    }
+    string filename = argv[1];
+    int bookingThreads = argc > 2 ? atoi(argv[2]) : 4;
+    int queryThreads = argc > 3 ? atoi(argv[3]) : 2;
+    double seconds = argc > 4 ? atof(argv[4]) : 2.0;
+    int seatScale = argc > 5 ? atoi(argv[5]) : 100;
+
+    FlightManager flightManager;
+    if (!loadFlights(filename, flightManager, seatScale))
+        return 1;
+
+    int flightCount = flightManager.getSlotCount();
+    long long initialSeats = 0;
+    int maxSeats = 0;
+    for (int id = 0; id < flightCount; id++) {
+        int seats = flightManager.getFlight(id)->seats;
+        initialSeats += seats;
+        if (seats > maxSeats)
+            maxSeats = seats;
+    }
+
+    atomic<bool> running(true);
+    atomic<long long> bookings(0), rejections(0), bookedSeats(0), queries(0), invalidResults(0);
+
+    vector<thread> threads;
+    for (int t = 0; t < bookingThreads; t++) {
+        threads.push_back(thread([&, t]() {
+            mt19937 rng(1234 + t);
+            uniform_int_distribution<int> pickFlight(0, flightCount - 1);
+            uniform_int_distribution<int> pickSeats(1, 4);
+            long long ok = 0, rejected = 0, seats = 0;
+            while (running.load(memory_order_relaxed)) {
+                int seatCount = pickSeats(rng);
+                if (flightManager.reserveSeats(pickFlight(rng), seatCount)) {
+                    ok++;
+                    seats += seatCount;
+                } else {
+                    rejected++;
+                }
+            }
+            bookings += ok;
+            rejections += rejected;
+            bookedSeats += seats;
+        }));
+    }
+    for (int t = 0; t < queryThreads; t++) {
+        threads.push_back(thread([&, t]() {
+            mt19937 rng(9876 + t);
+            uniform_int_distribution<int> pickSeats(0, maxSeats);
+            const char* ops[] = { "<=", ">=", "==", "<" };
+            long long done = 0, invalid = 0;
+            ExprArena arena;
+            while (running.load(memory_order_relaxed)) {
+                int value = pickSeats(rng);
+                string expressionStr = string("(sea") + ops[done % 4] + to_string(value) + ")";
+                arena.reset();
+                Parser parser(expressionStr, arena);
+                Expr* expression = parser.parseExpression();
+                int resultCount = 0;
+                Flight** results = executeQuery(flightManager, expression, "p", resultCount);
+                // Assentos só diminuem: resultados de "<=" e "<" continuam válidos
+                // depois da consulta, então podem ser conferidos com o valor atual.
+                if (done % 4 == 0 || done % 4 == 3) {
+                    for (int i = 0; i < resultCount; i++)
+                        if (!expression->evaluate(*results[i]))
+                            invalid++;
+                }
+                delete[] results;
+                done++;
+            }
+            queries += done;
+            invalidResults += invalid;
+        }));
+    }
+
+    auto start = steady_clock::now();
+    this_thread::sleep_for(duration<double>(seconds));
+    running = false;
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+    double elapsed = duration<double>(steady_clock::now() - start).count();
+
+    flightManager.syncSeatIndex();
+    long long finalSeats = 0;
+    for (int id = 0; id < flightCount; id++)
+        finalSeats += flightManager.getFlight(id)->seats;
+    bool seatsConsistent = initialSeats - finalSeats == bookedSeats.load();
+    bool indexConsistent = checkSeatIndex(flightManager, maxSeats);
+
+    cout << "Voos\tThreadsReserva\tThreadsConsulta\tReservas\tRejeitadas\tReservas/s\tConsultas/s\tConsistente\n";
+    cout << flightCount << "\t" << bookingThreads << "\t" << queryThreads << "\t"
+         << bookings.load() << "\t" << rejections.load() << "\t"
+         << bookings.load() / elapsed << "\t" << queries.load() / elapsed << "\t"
+         << (seatsConsistent && indexConsistent && invalidResults.load() == 0 ? "sim" : "NAO") << "\n";
+    return seatsConsistent && indexConsistent && invalidResults.load() == 0 ? 0 : 1;
+}
@@ -0,0 +1,182 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "../include/Sort.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+/**
+ * @brief Partição de Lomuto com o último elemento como pivô (versão anterior de quickSortFlights()).
+ */
+int legacyPartition(Flight** arr, int low, int high, const string &criteria) {
+    Flight* pivot = arr[high];
+    int i = low;
+    for (int j = low; j < high; j++) {
+        if (compareFlightByCriteria(arr[j], pivot, criteria) < 0) {
+            swapFlightPointers(arr[i], arr[j]);
+            i++;
+        }
+    }
+    swapFlightPointers(arr[i], arr[high]);
+    return i;
+}
+
+/**
+ * @brief Quicksort anterior, mantido só para comparação: O(n²) e recursão de profundidade n em entradas ordenadas ou com chaves iguais.
+ */
+void legacyQuickSort(Flight** arr, int low, int high, const string &criteria) {
+    if (low < high) {
+        int pivotIndex = legacyPartition(arr, low, high, criteria);
+        legacyQuickSort(arr, low, pivotIndex - 1, criteria);
+        legacyQuickSort(arr, pivotIndex + 1, high, criteria);
+    }
+}
+
+/**
+ * @brief Preenche os preços conforme o padrão de entrada.
+ *
+ * random: preços aleatórios; sorted/reverse: já ordenados (como os candidatos
+ * de index(prc)) ou invertidos; equal: um preço só; few: quatro valores (como
+ * paradas); pipe: crescente até o meio e decrescente depois (organ pipe).
+ */
+void fillPrices(vector<Flight> &flights, const string &pattern, mt19937 &rng) {
+    int n = static_cast<int>(flights.size());
+    uniform_real_distribution<double> price(50.0, 2000.0);
+    for (int i = 0; i < n; i++) {
+        double value;
+        if (pattern == "sorted")
+            value = 50.0 + i;
+        else if (pattern == "reverse")
+            value = 50.0 + (n - i);
+        else if (pattern == "equal")
+            value = 500.0;
+        else if (pattern == "few")
+            value = static_cast<double>(rng() % 4);
+        else if (pattern == "pipe")
+            value = 50.0 + (i < n / 2 ? i : n - i);
+        else
+            value = price(rng);
+        flights[i].price = value;
+    }
+}
+
+/**
+ * @brief Verifica se arr[0, n) está ordenado pelos critérios.
+ */
+bool isSorted(Flight** arr, int n, const string &criteria) {
+    for (int i = 1; i < n; i++)
+        if (compareFlightByCriteria(arr[i], arr[i - 1], criteria) < 0)
+            return false;
+    return true;
+}
+
+/**
+ * @brief Mede uma ordenação: copia a entrada, ordena e devolve o melhor tempo em ms.
+ */
+template<typename SortFunction>
+double timeSort(const vector<Flight*> &input, vector<Flight*> &work, int repeat, const string &criteria,
+                SortFunction sortFunction, bool &sorted) {
+    double best = -1;
+    for (int r = 0; r < repeat; r++) {
+        work = input;
+        auto start = steady_clock::now();
+        sortFunction(work.data(), static_cast<int>(work.size()));
+        double elapsed = duration<double, milli>(steady_clock::now() - start).count();
+        if (best < 0 || elapsed < best)
+            best = elapsed;
+    }
+    sorted = isSorted(work.data(), static_cast<int>(work.size()), criteria);
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    vector<int> sizes;
+    int legacyLimit = 20000;
+    int repeat = 3;
+    string criteria = "p";
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--sizes" && i + 1 < argc) {
+            string list = argv[++i];
+            for (size_t start = 0; start < list.size();) {
+                size_t comma = list.find(',', start);
+                sizes.push_back(atoi(list.substr(start, comma - start).c_str()));
+                start = comma == string::npos ? list.size() : comma + 1;
+            }
+        } else if (arg == "--legacy-limit" && i + 1 < argc) {
+            legacyLimit = atoi(argv[++i]);
+        } else if (arg == "--repeat" && i + 1 < argc) {
+            repeat = max(1, atoi(argv[++i]));
+        } else if (arg == "--criteria" && i + 1 < argc) {
+            criteria = argv[++i];
+        } else {
+            cerr << "Uso: " << argv[0] << " [--sizes 1000,10000,100000] [--legacy-limit 20000] [--repeat 3] [--criteria p]\n";
+            return 1;
+        }
+    }
+    if (sizes.empty()) {
+        sizes.push_back(1000);
+        sizes.push_back(10000);
+        sizes.push_back(100000);
+    }
+
+    const char* patterns[] = { "random", "sorted", "reverse", "equal", "few", "pipe" };
+    const int patternCount = sizeof(patterns) / sizeof(patterns[0]);
+
+    // O quicksort anterior só roda até legacyLimit: acima disso, nos padrões
+    // degenerados, levaria minutos e a recursão poderia estourar a pilha.
+    printf("%-8s %9s %12s %12s %12s\n", "entrada", "n", "novo(ms)", "anterior(ms)", "std::sort(ms)");
+    bool allSorted = true;
+    for (size_t s = 0; s < sizes.size(); s++) {
+        int n = sizes[s];
+        for (int p = 0; p < patternCount; p++) {
+            mt19937 rng(42);
+            vector<Flight> flights(n);
+            uniform_int_distribution<int> duration(3600, 40000);
+            for (int i = 0; i < n; i++) {
+                memset(&flights[i], 0, sizeof(Flight));
+                flights[i].duration = duration(rng);
+                flights[i].stops = static_cast<int>(rng() % 4);
+                flights[i].id = i;
+            }
+            fillPrices(flights, patterns[p], rng);
+            vector<Flight*> input(n), work;
+            for (int i = 0; i < n; i++)
+                input[i] = &flights[i];
+
+            bool sorted;
+            double introTime = timeSort(input, work, repeat, criteria, [&criteria](Flight** arr, int count) {
+                quickSortFlights(arr, 0, count - 1, criteria);
+            }, sorted);
+            allSorted = allSorted && sorted;
+
+            char legacyText[32] = "-";
+            if (n <= legacyLimit) {
+                double legacyTime = timeSort(input, work, 1, criteria, [&criteria](Flight** arr, int count) {
+                    legacyQuickSort(arr, 0, count - 1, criteria);
+                }, sorted);
+                snprintf(legacyText, sizeof(legacyText), "%.2f", legacyTime);
+            }
+
+            double stdTime = timeSort(input, work, repeat, criteria, [&criteria](Flight** arr, int count) {
+                sort(arr, arr + count, [&criteria](const Flight* a, const Flight* b) {
+                    return compareFlightByCriteria(a, b, criteria) < 0;
+                });
+            }, sorted);
+
+            printf("%-8s %9d %12.2f %12s %12.2f\n", patterns[p], n, introTime, legacyText, stdTime);
+        }
+    }
+    if (!allSorted) {
+        cerr << "Erro: quickSortFlights deixou um resultado fora de ordem." << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,402 @@
+#include "../include/TimeBucketIndex.hpp"
+#include <algorithm>
+
+/**
+ * @brief Ordem das entradas na carga: apenas pela chave (a ordenação é estável).
+ */
+static bool entryKeyLess(const TimeEntry &a, const TimeEntry &b) {
+    return a.key < b.key;
+}
+
+/**
+ * @brief Posição da primeira entrada do balde com chave maior ou igual (ou maior, se after) que key.
+ */
+static int boundInBucket(const TimeBucket &bucket, time_t key, bool after) {
+    int low = 0, high = bucket.size;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        time_t middleKey = bucket.entries[middle].key;
+        if (middleKey < key || (after && middleKey == key))
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+/**
+ * @brief Construtor: índice vazio.
+ */
+TimeBucketIndex::TimeBucketIndex(int bucketSeconds)
+    : entryCount(0), bucketSeconds(bucketSeconds > 0 ? bucketSeconds : DEFAULT_BUCKET_SECONDS),
+      buckets(nullptr), bucketCount(0), bucketCapacity(0), emptyBuckets(0), countTree(nullptr), sumTree(nullptr) {}
+
+/**
+ * @brief Destrutor: libera os baldes.
+ */
+TimeBucketIndex::~TimeBucketIndex() {
+    for (int i = 0; i < bucketCount; i++)
+        delete[] buckets[i].entries;
+    delete[] buckets;
+    delete[] countTree;
+    delete[] sumTree;
+}
+
+/**
+ * @brief Retorna o número do balde de um horário (divisão arredondada para baixo).
+ */
+long long TimeBucketIndex::bucketOf(time_t key) const {
+    long long value = static_cast<long long>(key);
+    return value >= 0 ? value / bucketSeconds : -((-value - 1) / bucketSeconds) - 1;
+}
+
+/**
+ * @brief Carrega o índice de uma vez.
+ *
+ * As entradas são invertidas antes da ordenação estável: chaves iguais
+ * terminam na ordem inversa de inserção, como faria insert().
+ */
+void TimeBucketIndex::build(TimeEntry* entries, int count) {
+    std::reverse(entries, entries + count);
+    std::stable_sort(entries, entries + count, entryKeyLess);
+
+    int distinct = 0;
+    for (int i = 0; i < count; i++)
+        if (i == 0 || bucketOf(entries[i].key) != bucketOf(entries[i - 1].key))
+            distinct++;
+
+    bucketCapacity = distinct > 4 ? distinct : 4;
+    buckets = new TimeBucket[bucketCapacity];
+    countTree = new int[bucketCapacity + 1];
+    sumTree = new double[bucketCapacity + 1];
+
+    int start = 0;
+    while (start < count) {
+        long long number = bucketOf(entries[start].key);
+        int end = start + 1;
+        while (end < count && bucketOf(entries[end].key) == number)
+            end++;
+        TimeBucket &bucket = buckets[bucketCount++];
+        bucket.number = number;
+        bucket.size = end - start;
+        bucket.capacity = bucket.size;
+        bucket.entries = new TimeEntry[bucket.capacity];
+        bucket.sum = 0;
+        for (int i = start; i < end; i++) {
+            bucket.entries[i - start] = entries[i];
+            bucket.sum += static_cast<double>(entries[i].key);
+        }
+        start = end;
+    }
+    entryCount = count;
+    rebuildTotals();
+}
+
+/**
+ * @brief Insere um voo com a chave fornecida.
+ *
+ * A entrada vai antes das de mesma chave (ordem inversa de inserção). Um
+ * balde novo no fim do diretório entra nas árvores de Fenwick sem mudar as
+ * posições dos demais; no meio, as posições seguintes mudam e as árvores são
+ * reconstruídas aqui, para que as leituras nunca as alterem.
+ */
+void TimeBucketIndex::insert(time_t key, Flight* flight) {
+    long long number = bucketOf(key);
+    int index = findBucket(number);
+    bool newBucket = index == bucketCount || buckets[index].number != number;
+    if (newBucket) {
+        insertBucket(index, number);
+    } else if (buckets[index].size == 0) {
+        emptyBuckets--;
+    }
+
+    TimeBucket &bucket = buckets[index];
+    if (bucket.size == bucket.capacity) {
+        int newCapacity = bucket.capacity ? bucket.capacity * 2 : 4;
+        TimeEntry* newEntries = new TimeEntry[newCapacity];
+        for (int i = 0; i < bucket.size; i++)
+            newEntries[i] = bucket.entries[i];
+        delete[] bucket.entries;
+        bucket.entries = newEntries;
+        bucket.capacity = newCapacity;
+    }
+    int position = boundInBucket(bucket, key, false);
+    for (int i = bucket.size; i > position; i--)
+        bucket.entries[i] = bucket.entries[i - 1];
+    bucket.entries[position].key = key;
+    bucket.entries[position].flight = flight;
+    bucket.size++;
+    bucket.sum += static_cast<double>(key);
+    entryCount++;
+
+    if (newBucket && index < bucketCount - 1) {
+        rebuildTotals();
+        return;
+    }
+    if (newBucket)
+        appendTotals();
+    addTotals(index, 1, static_cast<double>(key));
+}
+
+/**
+ * @brief Remove a entrada de um voo.
+ *
+ * Um balde esvaziado libera as entradas na hora, mas continua no diretório
+ * (o cursor e as contagens lidam com baldes vazios) até que os vazios passem
+ * de um quarto dos baldes: tirá-lo muda as posições e custa uma reconstrução
+ * das árvores de Fenwick, que assim se paga com B/4 remoções.
+ */
+bool TimeBucketIndex::remove(time_t key, const Flight* flight) {
+    long long number = bucketOf(key);
+    int index = findBucket(number);
+    if (index == bucketCount || buckets[index].number != number)
+        return false;
+    TimeBucket &bucket = buckets[index];
+    for (int position = boundInBucket(bucket, key, false);
+         position < bucket.size && bucket.entries[position].key == key; position++) {
+        if (bucket.entries[position].flight != flight)
+            continue;
+        for (int i = position + 1; i < bucket.size; i++)
+            bucket.entries[i - 1] = bucket.entries[i];
+        bucket.size--;
+        bucket.sum -= static_cast<double>(key);
+        entryCount--;
+        addTotals(index, -1, -static_cast<double>(key));
+        if (bucket.size == 0) {
+            delete[] bucket.entries;
+            bucket.entries = nullptr;
+            bucket.capacity = 0;
+            bucket.sum = 0;
+            if (++emptyBuckets * 4 > bucketCount)
+                compactBuckets();
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Retorna a posição no diretório do primeiro balde com número maior ou igual a number.
+ */
+int TimeBucketIndex::findBucket(long long number) const {
+    int low = 0, high = bucketCount;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (buckets[middle].number < number)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+/**
+ * @brief Localiza a primeira entrada com chave maior ou igual (ou maior) que key.
+ */
+void TimeBucketIndex::locate(time_t key, bool after, int &bucket, int &position) const {
+    long long number = bucketOf(key);
+    bucket = findBucket(number);
+    position = 0;
+    if (bucket < bucketCount && buckets[bucket].number == number)
+        position = boundInBucket(buckets[bucket], key, after);
+}
+
+/**
+ * @brief Conta as entradas com chave menor (ou menor ou igual) que key.
+ */
+int TimeBucketIndex::countBelow(time_t key, bool inclusive) const {
+    int bucket, position;
+    locate(key, inclusive, bucket, position);
+    return prefixCount(bucket) + position;
+}
+
+/**
+ * @brief Conta as entradas de um intervalo sem percorrê-lo.
+ */
+int TimeBucketIndex::countRange(const time_t* low, bool lowInclusive, const time_t* high, bool highInclusive) const {
+    int upTo = high ? countBelow(*high, highInclusive) : entryCount;
+    int below = low ? countBelow(*low, !lowInclusive) : 0;
+    return upTo > below ? upTo - below : 0;
+}
+
+/**
+ * @brief Soma as chaves das entradas com chave menor (ou menor ou igual) que key.
+ *
+ * Os baldes anteriores vêm da árvore de Fenwick; o balde da chave é somado
+ * entrada a entrada até a posição encontrada.
+ */
+double TimeBucketIndex::sumBelow(time_t key, bool inclusive) const {
+    int bucket, position;
+    locate(key, inclusive, bucket, position);
+    double sum = prefixSum(bucket);
+    for (int i = 0; i < position; i++)
+        sum += static_cast<double>(buckets[bucket].entries[i].key);
+    return sum;
+}
+
+/**
+ * @brief Soma as chaves das entradas de um intervalo sem percorrê-lo.
+ */
+double TimeBucketIndex::sumRange(const time_t* low, bool lowInclusive, const time_t* high, bool highInclusive) const {
+    if (countRange(low, lowInclusive, high, highInclusive) == 0)
+        return 0;
+    double upTo = high ? sumBelow(*high, highInclusive) : prefixSum(bucketCount);
+    double below = low ? sumBelow(*low, !lowInclusive) : 0;
+    return upTo - below;
+}
+
+/**
+ * @brief Retorna o voo de posição rank na ordem das chaves.
+ *
+ * Desce pela árvore de Fenwick até o balde que contém a posição.
+ */
+Flight* TimeBucketIndex::selectEntry(int rank) const {
+    if (rank < 0 || rank >= entryCount)
+        return nullptr;
+    int step = 1;
+    while (step * 2 <= bucketCount)
+        step *= 2;
+    int bucket = 0;
+    for (; step > 0; step /= 2) {
+        if (bucket + step <= bucketCount && countTree[bucket + step] <= rank) {
+            bucket += step;
+            rank -= countTree[bucket];
+        }
+    }
+    return buckets[bucket].entries[rank].flight;
+}
+
+/**
+ * @brief Cria um cursor sobre as entradas de um intervalo.
+ */
+TimeBucketIndex::Cursor TimeBucketIndex::rangeCursor(const time_t* low, bool lowInclusive,
+                                                     const time_t* high, bool highInclusive) const {
+    int bucket = 0, position = 0;
+    int endBucket = bucketCount, endPosition = 0;
+    if (low)
+        locate(*low, !lowInclusive, bucket, position);
+    if (high)
+        locate(*high, highInclusive, endBucket, endPosition);
+    return Cursor(buckets, bucket, position, endBucket, endPosition);
+}
+
+/**
+ * @brief Retorna o número de entradas nos baldes [0, bucket).
+ */
+int TimeBucketIndex::prefixCount(int bucket) const {
+    int count = 0;
+    for (; bucket > 0; bucket -= bucket & -bucket)
+        count += countTree[bucket];
+    return count;
+}
+
+/**
+ * @brief Retorna a soma das chaves nos baldes [0, bucket).
+ */
+double TimeBucketIndex::prefixSum(int bucket) const {
+    double sum = 0;
+    for (; bucket > 0; bucket -= bucket & -bucket)
+        sum += sumTree[bucket];
+    return sum;
+}
+
+/**
+ * @brief Soma variações à contagem e à soma de um balde nas árvores de Fenwick.
+ */
+void TimeBucketIndex::addTotals(int bucket, int countDelta, double sumDelta) {
+    for (int i = bucket + 1; i <= bucketCount; i += i & -i) {
+        countTree[i] += countDelta;
+        sumTree[i] += sumDelta;
+    }
+}
+
+/**
+ * @brief Reconstrói as árvores de Fenwick a partir dos baldes, em O(B).
+ */
+void TimeBucketIndex::rebuildTotals() {
+    for (int i = 1; i <= bucketCount; i++) {
+        countTree[i] = buckets[i - 1].size;
+        sumTree[i] = buckets[i - 1].sum;
+    }
+    for (int i = 1; i <= bucketCount; i++) {
+        int parent = i + (i & -i);
+        if (parent <= bucketCount) {
+            countTree[parent] += countTree[i];
+            sumTree[parent] += sumTree[i];
+        }
+    }
+}
+
+/**
+ * @brief Inclui nas árvores de Fenwick o último balde do diretório, vazio.
+ *
+ * O nó i da árvore cobre os baldes (i - lowbit(i), i]; com o novo balde
+ * vazio, o valor é a diferença entre dois prefixos dos baldes anteriores.
+ */
+void TimeBucketIndex::appendTotals() {
+    int node = bucketCount;
+    int first = node - (node & -node);
+    countTree[node] = prefixCount(node - 1) - prefixCount(first);
+    sumTree[node] = prefixSum(node - 1) - prefixSum(first);
+}
+
+/**
+ * @brief Abre um balde vazio na posição bucket do diretório.
+ *
+ * As árvores de Fenwick acompanham a capacidade do diretório (o conteúdo é
+ * copiado), mas o chamador precisa incluí-lo nelas (appendTotals()) ou
+ * reconstruí-las, pois as posições dos baldes seguintes mudaram.
+ */
+void TimeBucketIndex::insertBucket(int bucket, long long number) {
+    if (bucketCount == bucketCapacity) {
+        int newCapacity = bucketCapacity ? bucketCapacity * 2 : 4;
+        TimeBucket* newBuckets = new TimeBucket[newCapacity];
+        for (int i = 0; i < bucketCount; i++)
+            newBuckets[i] = buckets[i];
+        int* newCountTree = new int[newCapacity + 1];
+        double* newSumTree = new double[newCapacity + 1];
+        for (int i = 1; i <= bucketCount; i++) {
+            newCountTree[i] = countTree[i];
+            newSumTree[i] = sumTree[i];
+        }
+        delete[] buckets;
+        delete[] countTree;
+        delete[] sumTree;
+        buckets = newBuckets;
+        countTree = newCountTree;
+        sumTree = newSumTree;
+        bucketCapacity = newCapacity;
+    }
+    for (int i = bucketCount; i > bucket; i--)
+        buckets[i] = buckets[i - 1];
+    buckets[bucket].number = number;
+    buckets[bucket].entries = nullptr;
+    buckets[bucket].size = 0;
+    buckets[bucket].capacity = 0;
+    buckets[bucket].sum = 0;
+    bucketCount++;
+}
+
+/**
+ * @brief Tira do diretório os baldes vazios e reconstrói as árvores de Fenwick.
+ */
+void TimeBucketIndex::compactBuckets() {
+    int kept = 0;
+    for (int i = 0; i < bucketCount; i++)
+        if (buckets[i].size > 0)
+            buckets[kept++] = buckets[i];
+    bucketCount = kept;
+    emptyBuckets = 0;
+    rebuildTotals();
+}
+
+/**
+ * @brief Acrescenta a memória do índice ao relatório.
+ */
+void TimeBucketIndex::reportMemory(MemoryReport &report, const string &name) const {
+    for (int b = 0; b < bucketCount; b++)
+        report.addArray(name + ".entries", buckets[b].size, buckets[b].capacity, sizeof(TimeEntry));
+    report.addArray(name + ".directory", bucketCount, bucketCapacity, sizeof(TimeBucket));
+    report.addArray(name + ".directory", 0, bucketCapacity + 1, sizeof(int));
+    report.addArray(name + ".directory", 0, bucketCapacity + 1, sizeof(double));
+}
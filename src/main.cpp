@@ -1,264 +1,685 @@
+#include <chrono>
 #include <ctime>
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <map>
+#include <thread>
 #include <string>
 #include <cstdio>
+#include <cstdlib>
 #include "../include/DateTime.hpp"
 #include "../include/Flight.hpp"
 #include "../include/Parser.hpp"
 #include "../include/Expression.hpp"
 #include "../include/AVLTree.hpp"
-#include "../include/Sort.hpp"
+#include "../include/FlightManager.hpp"
+#include "../include/PartitionedStore.hpp"
+#include "../include/QueryExecutor.hpp"
+#include "../include/PreparedQuery.hpp"
+#include "../include/ItinerarySearch.hpp"
+#include "../include/Aggregate.hpp"
+#include "../include/Metrics.hpp"
+#include "../include/MemoryReport.hpp"
+#include "../include/SpscQueue.hpp"
+#include "../include/FlightFeed.hpp"
 
 using namespace std;
 
 /**
- * @brief Compara dois valores do tipo double.
+ * @brief Verifica se a palavra inicial de uma linha é um comando de atualização.
+ *
+ * Comandos aceitos na seção de consultas:
+ * - "ins <voo>": insere um voo (mesmo formato da seção de voos);
+ * - "del <id>": remove o voo com o identificador dado;
+ * - "upd <id> <voo>": substitui os dados do voo com o identificador dado;
+ * - "res <id> <n>": reserva n assentos do voo com o identificador dado.
+ *
+ * Os identificadores são atribuídos na ordem de inserção, começando em 0.
  */
-int compareDoubles(const double &a, const double &b) {
-    if (a < b) return -1;
-    else if (a > b) return 1;
-    else return 0;
+bool isUpdateCommand(const string &command) {
+    return command == "ins" || command == "del" || command == "upd" || command == "res";
 }
 
 /**
- * @brief Compara dois inteiros.
+ * @brief Executa um comando de atualização sobre o armazenamento de voos.
+ *
+ * Erros são reportados em stderr e não interrompem o processamento.
+ *
+ * @param flightStore Armazenamento de voos.
+ * @param command Comando ("ins", "del", "upd" ou "res").
+ * @param commandStream Restante da linha do comando.
+ * @param lineNumber Número da linha na seção de consultas (para mensagens).
  */
-int compareInts(const int &a, const int &b) {
-    if (a < b) return -1;
-    else if (a > b) return 1;
-    else return 0;
+void applyUpdateCommand(PartitionedStore &flightStore, const string &command,
+                        istringstream &commandStream, int lineNumber) {
+    int id = -1;
+    if (command != "ins" && !(commandStream >> id)) {
+        cerr << "Error parsing flight id in command " << lineNumber << ".\n";
+        return;
+    }
+    if (command == "res") {
+        int seatCount;
+        if (!(commandStream >> seatCount)) {
+            cerr << "Error parsing seat count in command " << lineNumber << ".\n";
+            return;
+        }
+        if (!flightStore.reserveSeats(id, seatCount))
+            cerr << "Error: cannot reserve " << seatCount << " seats on flight " << id
+                 << " in command " << lineNumber << ".\n";
+        return;
+    }
+    if (command == "del") {
+        if (!flightStore.removeFlight(id))
+            cerr << "Error: flight " << id << " not found in command " << lineNumber << ".\n";
+        return;
+    }
+
+    Flight flight;
+    if (!readFlight(commandStream, flight)) {
+        cerr << "Error parsing flight in command " << lineNumber << ".\n";
+        return;
+    }
+    if (flight.arr_time < flight.dep_time) {
+        cerr << "Error: arrival time is before departure in command " << lineNumber << ".\n";
+        return;
+    }
+    if (command == "ins")
+        flightStore.insertFlight(flight);
+    else if (!flightStore.updateFlight(id, flight))
+        cerr << "Error: flight " << id << " not found in command " << lineNumber << ".\n";
 }
 
 /**
- * @brief Compara duas strings.
+ * @brief Escreve um voo em uma linha, no formato da entrada.
+ *
+ * Os códigos e as datas só são convertidos para texto aqui, para as linhas impressas.
+ *
+ * @param f Voo.
+ * @param indent Prefixo da linha.
+ * @param priceFormat Formato do preço (printf).
  */
-int compareStrings(const string &a, const string &b) {
-    return a.compare(b);
+void printFlight(const Flight* f, const char* indent = "", const char* priceFormat = "%g") {
+    char origin[4], destination[4], departure[DATETIME_LENGTH + 1], arrival[DATETIME_LENGTH + 1];
+    decodeAirportCode(f->origin, origin);
+    decodeAirportCode(f->destination, destination);
+    formatDateTime(f->dep_time, departure);
+    formatDateTime(f->arr_time, arrival);
+    printf("%s%s %s ", indent, origin, destination);
+    printf(priceFormat, f->price);
+    printf(" %d %s %s %d\n", f->seats, departure, arrival, f->stops);
 }
 
 /**
- * @brief Compara dois valores do tipo time_t.
+ * @brief Escreve os primeiros maxResults voos de um resultado, um por linha.
  */
-int compareTimes(const time_t &a, const time_t &b) {
-    if(a < b) return -1;
-    else if(a > b) return 1;
-    return 0;
+void printResults(Flight** resultFlights, int resultCount, int maxResults) {
+    for (int j = 0; j < resultCount && j < maxResults; j++)
+        printFlight(resultFlights[j]);
 }
 
-// Árvores AVL globais para indexar os voos por diferentes campos.
-AVLTree<string>* indexOrigin = nullptr;
-AVLTree<string>* indexDestination = nullptr;
-AVLTree<double>* indexPrice = nullptr;
-AVLTree<int>* indexDuration = nullptr;
-AVLTree<int>* indexStops = nullptr;
-AVLTree<int>* indexSeats = nullptr;
-AVLTree<time_t>* indexDeparture = nullptr;
-AVLTree<time_t>* indexArrival = nullptr;
+/**
+ * @brief Registra um template preparado: "prep <nome> <expressão com ?>".
+ *
+ * Um template com o mesmo nome é substituído. Nada é escrito na saída padrão.
+ */
+void prepareTemplate(map<string, PreparedQuery*> &templates, istringstream &commandStream, int lineNumber) {
+    string name, expressionStr;
+    if (!(commandStream >> name)) {
+        cerr << "Error parsing template name in command " << lineNumber << ".\n";
+        return;
+    }
+    getline(commandStream, expressionStr);
+    PreparedQuery* prepared = new PreparedQuery();
+    if (!prepared->prepare(expressionStr)) {
+        cerr << "Error parsing template " << name << " in command " << lineNumber << " at position "
+             << prepared->getError().position << ": " << prepared->getError().message << ".\n";
+        delete prepared;
+        return;
+    }
+    PreparedQuery* &slot = templates[name];
+    delete slot;
+    slot = prepared;
+}
 
 /**
- * @brief Gerenciador de voos que constrói os índices.
+ * @brief Associa os valores de "exec <nome> <max_resultados> <critério> <valor1> ... <valorN>" ao template.
+ *
+ * @param templates Templates registrados.
+ * @param commandStream Restante da linha do comando (após "exec").
+ * @param lineNumber Número do comando (para mensagens).
+ * @param maxResults (Saída) Número máximo de resultados.
+ * @param sortCriteria (Saída) Critério de ordenação.
+ * @param error (Saída) Mensagem para stderr, se houve erro.
+ * @return Template pronto para executar, ou nullptr se houve erro.
  */
-class FlightManager {
-public:
-    Flight* flights;    ///< Array de voos.
-    int flightCount;    ///< Número de voos.
-
-    /**
-     * @brief Construtor.
-     * @param flightArray Array de voos.
-     * @param count Número de voos.
-     */
-    FlightManager(Flight* flightArray, int count) : flights(flightArray), flightCount(count) {}
-
-    /**
-     * @brief Constrói os índices (árvores AVL) para os campos.
-     */
-    void buildIndices() {
-        indexOrigin = new AVLTree<string>(compareStrings);
-        indexDestination = new AVLTree<string>(compareStrings);
-        indexPrice = new AVLTree<double>(compareDoubles);
-        indexDuration = new AVLTree<int>(compareInts);
-        indexStops = new AVLTree<int>(compareInts);
-        indexSeats = new AVLTree<int>(compareInts);
-        indexDeparture = new AVLTree<time_t>(compareTimes);
-        indexArrival = new AVLTree<time_t>(compareTimes);
-        
-        for (int i = 0; i < flightCount; i++) {
-            indexOrigin->insert(string(flights[i].origin), &flights[i]);
-            indexDestination->insert(string(flights[i].destination), &flights[i]);
-            indexPrice->insert(flights[i].price, &flights[i]);
-            indexDuration->insert(flights[i].duration, &flights[i]);
-            indexStops->insert(flights[i].stops, &flights[i]);
-            indexSeats->insert(flights[i].seats, &flights[i]);
-            indexDeparture->insert(flights[i].dep_time, &flights[i]);
-            indexArrival->insert(flights[i].arr_time, &flights[i]);
+PreparedQuery* bindTemplate(map<string, PreparedQuery*> &templates, istringstream &commandStream, int lineNumber,
+                            int &maxResults, string &sortCriteria, string &error) {
+    ostringstream message;
+    string name;
+    if (!(commandStream >> name >> maxResults >> sortCriteria)) {
+        message << "Error parsing command " << lineNumber << ".\n";
+        error = message.str();
+        return nullptr;
+    }
+    map<string, PreparedQuery*>::iterator found = templates.find(name);
+    if (found == templates.end()) {
+        message << "Error: template " << name << " not found in command " << lineNumber << ".\n";
+        error = message.str();
+        return nullptr;
+    }
+    PreparedQuery* prepared = found->second;
+    string value;
+    int bound = 0;
+    while (commandStream >> value) {
+        if (!prepared->bind(bound, value)) {
+            message << "Error: invalid value " << value << " for parameter " << bound + 1
+                    << " in command " << lineNumber << ".\n";
+            error = message.str();
+            return nullptr;
+        }
+        bound++;
+    }
+    if (bound != prepared->getParameterCount()) {
+        message << "Error: template " << name << " expects " << prepared->getParameterCount()
+                << " parameters in command " << lineNumber << ".\n";
+        error = message.str();
+        return nullptr;
+    }
+    return prepared;
+}
+
+/**
+ * @brief Escreve um valor de um campo no mesmo formato de printResults().
+ */
+void printFieldValue(IndexField field, double value) {
+    if (field == INDEX_PRICE) {
+        printf("%g\n", value);
+    } else if (field == INDEX_DEPARTURE || field == INDEX_ARRIVAL) {
+        char buffer[DATETIME_LENGTH + 1];
+        formatDateTime(static_cast<time_t>(value), buffer);
+        printf("%s\n", buffer);
+    } else {
+        printf("%d\n", static_cast<int>(value));
+    }
+}
+
+/**
+ * @brief Escreve o resultado de uma agregação em uma linha.
+ *
+ * Sem voos, min, max e avg escrevem "none" e sum escreve 0.
+ */
+void printAggregate(const AggregateResult &result) {
+    switch (result.function) {
+        case AGG_COUNT:
+            printf("%lld\n", result.count);
+            break;
+        case AGG_MIN:
+        case AGG_MAX:
+            if (result.count == 0)
+                printf("none\n");
+            else if (result.function == AGG_MIN)
+                printFieldValue(result.field, result.minValue);
+            else
+                printFieldValue(result.field, result.maxValue);
+            break;
+        case AGG_SUM:
+            printf(result.field == INDEX_PRICE ? "%.2f\n" : "%.0f\n", result.sum);
+            break;
+        case AGG_AVG:
+            if (result.count == 0)
+                printf("none\n");
+            else
+                printf("%.2f\n", result.sum / result.count);
+            break;
+    }
+}
+
+/**
+ * @brief Executa uma agregação: "count <expressão>" ou "min|max|sum|avg <campo> <expressão>".
+ *
+ * min e max aceitam os campos numéricos e as datas; sum e avg, apenas prc,
+ * dur, sto e sea. Sem expressão, todos os voos são agregados. A linha do
+ * comando é ecoada, seguida do valor.
+ */
+void executeAggregateCommand(PartitionedStore &flightStore, AggregateFunction function,
+                             istringstream &commandStream, const string &commandLine, int lineNumber,
+                             ExprArena &queryArena, FILE* explainOut) {
+    IndexField field = INDEX_COUNT;
+    if (function != AGG_COUNT) {
+        string fieldStr;
+        commandStream >> fieldStr;
+        field = fieldFromName(fieldStr.c_str(), static_cast<int>(fieldStr.size()));
+        bool summable = field == INDEX_PRICE || field == INDEX_DURATION || field == INDEX_STOPS || field == INDEX_SEATS;
+        bool ordered = summable || field == INDEX_DEPARTURE || field == INDEX_ARRIVAL;
+        if (!(function == AGG_MIN || function == AGG_MAX ? ordered : summable)) {
+            cerr << "Error: invalid aggregate field " << fieldStr << " in command " << lineNumber << ".\n";
+            return;
+        }
+    }
+
+    string expressionStr;
+    getline(commandStream, expressionStr);
+    while (!expressionStr.empty() && isspace(expressionStr[0]))
+        expressionStr.erase(expressionStr.begin());
+
+    QueryProfile profile;
+    chrono::steady_clock::time_point phaseStart = chrono::steady_clock::now();
+    queryArena.reset();
+    Expr* expression = nullptr;
+    if (!expressionStr.empty()) {
+        Parser parser(expressionStr, queryArena);
+        expression = parser.parseExpression();
+        if (!expression) {
+            cerr << "Error parsing expression of query " << lineNumber << " at position "
+                 << parser.getError().position << ": " << parser.getError().message << ".\n";
+            return;
         }
     }
-    
-    /**
-     * @brief Destrutor: libera os índices.
-     */
-    ~FlightManager() {
-        delete indexOrigin;
-        delete indexDestination;
-        delete indexPrice;
-        delete indexDuration;
-        delete indexStops;
-        delete indexSeats;
-        delete indexDeparture;
-        delete indexArrival;
+    profile.parseUs = chrono::duration<double, micro>(chrono::steady_clock::now() - phaseStart).count();
+
+    printf("%s\n", commandLine.c_str());
+    AggregateResult result(function, field);
+    flightStore.executeAggregate(expression, result, explainOut ? &profile : nullptr);
+    phaseStart = chrono::steady_clock::now();
+    printAggregate(result);
+    if (explainOut) {
+        profile.outputUs = chrono::duration<double, micro>(chrono::steady_clock::now() - phaseStart).count();
+        printQueryProfile(explainOut, lineNumber, profile);
+    }
+}
+
+/**
+ * @brief Executa uma busca de itinerários com conexões:
+ * "route <max_resultados> <critério> <origem> <destino> <conexões> <espera_mínima> <espera_máxima> [<expressão>]".
+ *
+ * Conexões vai de 0 a 2 e as esperas são em minutos; a expressão, opcional,
+ * filtra o primeiro trecho (por exemplo, a data de partida). A linha do
+ * comando é ecoada. Cada itinerário ocupa uma linha no formato de um voo, com
+ * os totais (preço somado, assentos do trecho com menos assentos, partida do
+ * primeiro trecho, chegada do último e paradas mais conexões), seguida de uma
+ * linha recuada por trecho.
+ */
+void executeRouteCommand(ItinerarySearch &itinerarySearch, istringstream &commandStream, const string &commandLine,
+                         int lineNumber, ExprArena &queryArena, FILE* explainOut,
+                         QueryMemoryTracker* memoryTracker) {
+    ItineraryQuery query;
+    string origin, destination;
+    int minLayover, maxLayover;
+    if (!(commandStream >> query.maxResults >> query.sortCriteria >> origin >> destination
+                        >> query.maxConnections >> minLayover >> maxLayover)) {
+        cerr << "Error parsing route command " << lineNumber << ".\n";
+        return;
     }
+    if (query.maxConnections < 0 || query.maxConnections >= Itinerary::MAX_LEGS
+        || minLayover < 0 || maxLayover < minLayover) {
+        cerr << "Error: invalid connections or layover in command " << lineNumber << ".\n";
+        return;
+    }
+    query.origin = encodeAirportCode(origin.c_str(), static_cast<int>(origin.size()));
+    query.destination = encodeAirportCode(destination.c_str(), static_cast<int>(destination.size()));
+    query.minLayover = minLayover * 60;
+    query.maxLayover = maxLayover * 60;
+
+    string expressionStr;
+    getline(commandStream, expressionStr);
+    while (!expressionStr.empty() && isspace(expressionStr[0]))
+        expressionStr.erase(expressionStr.begin());
+
+    QueryProfile profile;
+    chrono::steady_clock::time_point phaseStart = chrono::steady_clock::now();
+    queryArena.reset();
+    query.filter = nullptr;
+    if (!expressionStr.empty()) {
+        Parser parser(expressionStr, queryArena);
+        query.filter = parser.parseExpression();
+        if (!query.filter) {
+            cerr << "Error parsing expression of query " << lineNumber << " at position "
+                 << parser.getError().position << ": " << parser.getError().message << ".\n";
+            return;
+        }
+    }
+    profile.parseUs = chrono::duration<double, micro>(chrono::steady_clock::now() - phaseStart).count();
+
+    printf("%s\n", commandLine.c_str());
+    phaseStart = chrono::steady_clock::now();
+    int resultCount = 0;
+    Itinerary* itineraries = itinerarySearch.search(query, resultCount, &profile.candidateCount);
+    if (memoryTracker)
+        memoryTracker->addResult(resultCount, resultCount * static_cast<long long>(sizeof(Itinerary)));
+    profile.candidatesUs = chrono::duration<double, micro>(chrono::steady_clock::now() - phaseStart).count();
+
+    phaseStart = chrono::steady_clock::now();
+    for (int i = 0; i < resultCount; i++) {
+        printFlight(&itineraries[i].total, "", "%.2f");
+        for (int leg = 0; leg < itineraries[i].legCount; leg++)
+            printFlight(itineraries[i].legs[leg], "  ");
+    }
+    if (explainOut) {
+        profile.accessPath = "route(" + origin + "->" + destination + ")";
+        profile.resultCount = resultCount;
+        profile.outputUs = chrono::duration<double, micro>(chrono::steady_clock::now() - phaseStart).count();
+        printQueryProfile(explainOut, lineNumber, profile);
+    }
+    delete[] itineraries;
+}
+
+/**
+ * @brief Tipo de um comando da seção de consultas, decidido na leitura.
+ */
+enum CommandKind {
+    COMMAND_QUERY,     ///< Consulta "<max> <critério> <expressão>": analisada na leitura, executada e escrita.
+    COMMAND_TEMPLATE,  ///< "exec": valores associados e executado no executor, resultado escrito pelo escritor.
+    COMMAND_SERIAL,    ///< Demais comandos: executados e escritos de uma vez pelo executor.
+    COMMAND_FATAL,     ///< Erro que encerra a execução (mensagem em error).
+    COMMAND_END        ///< Fim dos comandos (só no pipeline).
 };
 
 /**
- * @brief Procura recursivamente um predicado indexável na árvore de expressão.
+ * @brief Um comando em trânsito entre a leitura, a execução e a escrita.
  *
- * Apenas predicados com operador diferente de NE e em campos indexáveis são considerados.
+ * Os objetos são reaproveitados: a arena e as strings mantêm a capacidade
+ * entre comandos.
+ */
+struct CommandJob {
+    CommandKind kind;        ///< Tipo do comando.
+    int lineNumber;          ///< Número do comando na seção de consultas.
+    string line;             ///< Linha do comando.
+    int maxResults;          ///< Número máximo de resultados (consultas e templates).
+    string sortCriteria;     ///< Critério de ordenação (consultas e templates).
+    string expressionStr;    ///< Texto da expressão (consultas).
+    ExprArena arena;         ///< Nós da expressão do comando.
+    Expr* expression;        ///< Expressão analisada (nullptr se houve erro de sintaxe).
+    string error;            ///< Mensagem para stderr, escrita na vez do comando.
+    Flight** results;        ///< Resultado ordenado (liberado na escrita).
+    int resultCount;         ///< Voos no resultado.
+    QueryProfile profile;    ///< Perfil da execução (com --explain).
+};
+
+/**
+ * @brief Estado compartilhado pela execução dos comandos.
+ */
+struct CommandContext {
+    PartitionedStore* flightStore;               ///< Armazenamento de voos.
+    map<string, PreparedQuery*>* templates;      ///< Templates registrados com "prep".
+    ItinerarySearch* itinerarySearch;            ///< Busca de itinerários (listas montadas sob demanda).
+    FILE* explainOut;                            ///< Destino do perfil (nullptr = desativado).
+    QueryMemoryTracker* memoryTracker;           ///< Memória por consulta (nullptr = desativado).
+    FlightFeed* feed;                            ///< Arquivo de voos acompanhado (nullptr = desativado).
+};
+
+/**
+ * @brief Lê o próximo comando e classifica-o; consultas já têm a expressão analisada.
  *
- * @param expr Ponteiro para a expressão.
- * @return Ponteiro para o PredicateExpr indexável, ou nullptr se não houver.
+ * Linhas vazias são ignoradas. Erros de leitura ou de "<max> <critério>"
+ * tornam o comando COMMAND_FATAL.
  */
-PredicateExpr* findIndexablePredicate(Expr* expr) {
-    if (!expr)
-        return nullptr;
-    PredicateExpr* predicate = dynamic_cast<PredicateExpr*>(expr);
-    if (predicate) {
-        if (predicate->op != PredicateExpr::NE &&
-            (predicate->field == "org" || predicate->field == "dst" ||
-             predicate->field == "prc" || predicate->field == "dur" || predicate->field == "sto" ||
-             predicate->field == "sea" || predicate->field == "dep" || predicate->field == "arr"))
-            return predicate;
-        return nullptr;
+void readCommand(istream &in, CommandJob &job, int lineNumber) {
+    job.lineNumber = lineNumber;
+    job.expression = nullptr;
+    job.results = nullptr;
+    job.resultCount = 0;
+    job.error.clear();
+    job.profile = QueryProfile();
+    ostringstream message;
+
+    job.line.clear();
+    while (job.line.empty()) {
+        if (!getline(in, job.line)) {
+            message << "Error reading query " << lineNumber << ".\n";
+            job.kind = COMMAND_FATAL;
+            job.error = message.str();
+            return;
+        }
     }
-    BinaryExpr* binaryExpr = dynamic_cast<BinaryExpr*>(expr);
-    if (binaryExpr) {
-        if (binaryExpr->op == '&') {
-            PredicateExpr* leftPredicate = findIndexablePredicate(binaryExpr->left);
-            if (leftPredicate)
-                return leftPredicate;
-            return findIndexablePredicate(binaryExpr->right);
-        } else {
-            return nullptr;
+
+    string command;
+    istringstream commandStream(job.line);
+    commandStream >> command;
+    AggregateFunction function;
+    if (command == "exec") {
+        job.kind = COMMAND_TEMPLATE;
+        return;
+    }
+    if (isUpdateCommand(command) || command == "prep" || command == "route" ||
+        aggregateFromName(command.c_str(), function)) {
+        job.kind = COMMAND_SERIAL;
+        return;
+    }
+
+    job.kind = COMMAND_QUERY;
+    istringstream queryStream(job.line);
+    if (!(queryStream >> job.maxResults >> job.sortCriteria)) {
+        message << "Error parsing query " << lineNumber << ".\n";
+        job.kind = COMMAND_FATAL;
+        job.error = message.str();
+        return;
+    }
+    getline(queryStream, job.expressionStr);
+    size_t first = job.expressionStr.find_first_not_of(" \t\r\n\v\f");
+    job.expressionStr.erase(0, first == string::npos ? job.expressionStr.size() : first);
+
+    chrono::steady_clock::time_point phaseStart = chrono::steady_clock::now();
+    job.arena.reset();
+    Parser parser(job.expressionStr, job.arena);
+    job.expression = parser.parseExpression();
+    job.profile.parseUs = chrono::duration<double, micro>(chrono::steady_clock::now() - phaseStart).count();
+    if (!job.expression) {
+        message << "Error parsing expression of query " << lineNumber << " at position "
+                << parser.getError().position << ": " << parser.getError().message << ".\n";
+        job.error = message.str();
+    }
+}
+
+/**
+ * @brief Executa um comando lido por readCommand().
+ *
+ * Consultas e templates guardam o resultado no comando, para writeCommand();
+ * os demais comandos são executados e escritos aqui mesmo.
+ */
+void executeCommand(CommandJob &job, CommandContext &context) {
+    QueryProfile* profile = context.explainOut ? &job.profile : nullptr;
+    if (job.kind == COMMAND_QUERY) {
+        if (job.expression)
+            job.results = context.flightStore->executeQuery(job.expression, job.sortCriteria, job.maxResults,
+                                                            job.resultCount, profile);
+        return;
+    }
+    if (job.kind != COMMAND_TEMPLATE && job.kind != COMMAND_SERIAL)
+        return;
+
+    string command;
+    istringstream commandStream(job.line);
+    commandStream >> command;
+    if (job.kind == COMMAND_TEMPLATE) {
+        PreparedQuery* prepared = bindTemplate(*context.templates, commandStream, job.lineNumber,
+                                               job.maxResults, job.sortCriteria, job.error);
+        if (prepared)
+            job.results = context.flightStore->executePrepared(*prepared, job.sortCriteria, job.maxResults,
+                                                               job.resultCount, profile);
+        return;
+    }
+
+    AggregateFunction function;
+    if (isUpdateCommand(command))
+        applyUpdateCommand(*context.flightStore, command, commandStream, job.lineNumber);
+    else if (command == "prep")
+        prepareTemplate(*context.templates, commandStream, job.lineNumber);
+    else if (command == "route")
+        executeRouteCommand(*context.itinerarySearch, commandStream, job.line, job.lineNumber, job.arena,
+                            context.explainOut, context.memoryTracker);
+    else if (aggregateFromName(command.c_str(), function))
+        executeAggregateCommand(*context.flightStore, function, commandStream, job.line, job.lineNumber,
+                                job.arena, context.explainOut);
+}
+
+/**
+ * @brief Insere no armazenamento as linhas novas do arquivo acompanhado (--follow) e escreve o lote em stderr.
+ *
+ * Chamado entre comandos, quando FlightFeed::due(): cada consulta vê os voos
+ * de todos os lotes inseridos antes dela.
+ */
+void ingestFeed(CommandContext &context) {
+    IngestBatch batch;
+    if (context.feed->poll(*context.flightStore, batch))
+        context.feed->printBatch(stderr, batch);
+}
+
+/**
+ * @brief Escreve a saída de uma consulta ou template executado por executeCommand().
+ *
+ * A consulta é sempre ecoada; o template, só se os valores foram aceitos.
+ *
+ * @return false se o comando é COMMAND_FATAL (a execução deve parar).
+ */
+bool writeCommand(CommandJob &job, FILE* explainOut, QueryMemoryTracker* memoryTracker) {
+    if (job.kind == COMMAND_FATAL) {
+        cerr << job.error;
+        return false;
+    }
+    if (job.kind != COMMAND_QUERY && job.kind != COMMAND_TEMPLATE)
+        return true;
+
+    if (job.kind == COMMAND_QUERY)
+        printf("%d %s %s\n", job.maxResults, job.sortCriteria.c_str(), job.expressionStr.c_str());
+    if (!job.error.empty()) {
+        cerr << job.error;
+        return true;
+    }
+    if (job.kind == COMMAND_TEMPLATE)
+        printf("%s\n", job.line.c_str());
+    if (memoryTracker)
+        memoryTracker->addResult(job.resultCount, job.resultCount * static_cast<long long>(sizeof(Flight*)));
+
+    chrono::steady_clock::time_point outputStart = chrono::steady_clock::now();
+    printResults(job.results, job.resultCount, job.maxResults);
+    if (explainOut) {
+        job.profile.outputUs = chrono::duration<double, micro>(chrono::steady_clock::now() - outputStart).count();
+        printQueryProfile(explainOut, job.lineNumber, job.profile);
+    }
+    delete[] job.results;
+    job.results = nullptr;
+    return true;
+}
+
+static const int PIPELINE_DEPTH = 64;  ///< Comandos em trânsito no pipeline (capacidade de cada fila).
+
+/**
+ * @brief Filas e contadores do pipeline de comandos.
+ *
+ * Cada fila tem um único produtor e um único consumidor: a leitura envia os
+ * comandos ao executor (parsed), o executor ao escritor (executed) e o
+ * escritor devolve os objetos à leitura (free).
+ */
+struct CommandPipeline {
+    SpscQueue<CommandJob*> freeJobs;      ///< Escritor -> leitura: comandos livres.
+    SpscQueue<CommandJob*> parsedJobs;    ///< Leitura -> executor.
+    SpscQueue<CommandJob*> executedJobs;  ///< Executor -> escritor.
+    std::atomic<int> writtenCount;        ///< Comandos já tratados pelo escritor.
+    bool succeeded;                       ///< false se um comando COMMAND_FATAL chegou ao escritor.
+
+    CommandPipeline()
+        : freeJobs(PIPELINE_DEPTH), parsedJobs(PIPELINE_DEPTH), executedJobs(PIPELINE_DEPTH),
+          writtenCount(0), succeeded(true) {}
+};
+
+/**
+ * @brief Estágio de leitura: lê e analisa os comandos, até o fim ou um erro fatal.
+ */
+void pipelineReader(istream* in, int queryCount, CommandPipeline* pipeline) {
+    for (int i = 0; i < queryCount; i++) {
+        CommandJob* job = pipeline->freeJobs.pop();
+        readCommand(*in, *job, i + 1);
+        pipeline->parsedJobs.push(job);
+        if (job->kind == COMMAND_FATAL)
+            return;
+    }
+    CommandJob* end = pipeline->freeJobs.pop();
+    end->kind = COMMAND_END;
+    pipeline->parsedJobs.push(end);
+}
+
+/**
+ * @brief Estágio de escrita: escreve os resultados na ordem dos comandos.
+ */
+void pipelineWriter(FILE* explainOut, CommandPipeline* pipeline) {
+    for (;;) {
+        CommandJob* job = pipeline->executedJobs.pop();
+        if (job->kind == COMMAND_END)
+            return;
+        if (!writeCommand(*job, explainOut, nullptr)) {
+            pipeline->succeeded = false;
+            return;
         }
+        pipeline->freeJobs.push(job);
+        pipeline->writtenCount.fetch_add(1, std::memory_order_release);
     }
-    return nullptr;
 }
 
 /**
- * @brief Retorna candidatos usando o índice, conforme o predicado.
+ * @brief Espera o escritor tratar todos os comandos enviados pelo executor.
+ */
+void waitForWriter(CommandPipeline &pipeline, int sentCount) {
+    for (int attempt = 0; pipeline.writtenCount.load(std::memory_order_acquire) != sentCount; attempt++)
+        SpscQueue<CommandJob*>::backoff(attempt);
+}
+
+/**
+ * @brief Executa os comandos em três estágios: leitura (com o parsing), execução e escrita.
+ *
+ * A leitura e a escrita rodam em threads próprias e o executor na thread
+ * chamadora, ligados por filas SPSC sem travas (SpscQueue); a execução de uma
+ * consulta se sobrepõe à leitura das seguintes e à escrita das anteriores.
  *
- * @param predicate Predicado indexável.
- * @param candidateCount (Saída) Número de candidatos encontrados.
- * @return Array dinamicamente alocado de ponteiros para Flight (deve ser liberado pelo chamador).
+ * Comandos COMMAND_SERIAL (atualizações, prep, route e agregações) escrevem
+ * diretamente e, no caso das atualizações, mudam voos que resultados ainda
+ * não escritos apontam; antes de executá-los o executor espera o escritor
+ * esvaziar a fila. A saída é idêntica à da execução serial.
+ *
+ * Com --follow, o executor também verifica o arquivo acompanhado entre os
+ * comandos e enquanto espera a leitura (ex.: stdin ocioso); um lote novo é
+ * inserido, como uma atualização, depois que o escritor esvazia a fila.
+ *
+ * @return false se a execução parou por um erro fatal.
  */
-Flight** getCandidatesFromIndex(PredicateExpr* predicate, int &candidateCount) {
-    if (predicate->field == "prc") {
-        double value = predicate->numValue;
-        if (predicate->op == PredicateExpr::EQ)
-            return indexPrice->rangeQuery(&value, true, &value, true, candidateCount);
-        else if (predicate->op == PredicateExpr::LT)
-            return indexPrice->rangeQuery(nullptr, true, &value, false, candidateCount);
-        else if (predicate->op == PredicateExpr::LE)
-            return indexPrice->rangeQuery(nullptr, true, &value, true, candidateCount);
-        else if (predicate->op == PredicateExpr::GT)
-            return indexPrice->rangeQuery(&value, false, nullptr, true, candidateCount);
-        else if (predicate->op == PredicateExpr::GE)
-            return indexPrice->rangeQuery(&value, true, nullptr, true, candidateCount);
-    }
-    else if (predicate->field == "dur") {
-        int value = static_cast<int>(predicate->numValue);
-        if (predicate->op == PredicateExpr::EQ)
-            return indexDuration->rangeQuery(&value, true, &value, true, candidateCount);
-        else if (predicate->op == PredicateExpr::LT)
-            return indexDuration->rangeQuery(nullptr, true, &value, false, candidateCount);
-        else if (predicate->op == PredicateExpr::LE)
-            return indexDuration->rangeQuery(nullptr, true, &value, true, candidateCount);
-        else if (predicate->op == PredicateExpr::GT)
-            return indexDuration->rangeQuery(&value, false, nullptr, true, candidateCount);
-        else if (predicate->op == PredicateExpr::GE)
-            return indexDuration->rangeQuery(&value, true, nullptr, true, candidateCount);
-    }
-    else if (predicate->field == "sto") {
-        int value = static_cast<int>(predicate->numValue);
-        if (predicate->op == PredicateExpr::EQ)
-            return indexStops->rangeQuery(&value, true, &value, true, candidateCount);
-        else if (predicate->op == PredicateExpr::LT)
-            return indexStops->rangeQuery(nullptr, true, &value, false, candidateCount);
-        else if (predicate->op == PredicateExpr::LE)
-            return indexStops->rangeQuery(nullptr, true, &value, true, candidateCount);
-        else if (predicate->op == PredicateExpr::GT)
-            return indexStops->rangeQuery(&value, false, nullptr, true, candidateCount);
-        else if (predicate->op == PredicateExpr::GE)
-            return indexStops->rangeQuery(&value, true, nullptr, true, candidateCount);
-    }
-    else if (predicate->field == "sea") {
-        int value = static_cast<int>(predicate->numValue);
-        if (predicate->op == PredicateExpr::EQ)
-            return indexSeats->rangeQuery(&value, true, &value, true, candidateCount);
-        else if (predicate->op == PredicateExpr::LT)
-            return indexSeats->rangeQuery(nullptr, true, &value, false, candidateCount);
-        else if (predicate->op == PredicateExpr::LE)
-            return indexSeats->rangeQuery(nullptr, true, &value, true, candidateCount);
-        else if (predicate->op == PredicateExpr::GT)
-            return indexSeats->rangeQuery(&value, false, nullptr, true, candidateCount);
-        else if (predicate->op == PredicateExpr::GE)
-            return indexSeats->rangeQuery(&value, true, nullptr, true, candidateCount);
-    }
-    else if (predicate->field == "dep") {
-        time_t value = static_cast<time_t>(predicate->numValue);
-        if (predicate->op == PredicateExpr::EQ)
-            return indexDeparture->rangeQuery(&value, true, &value, true, candidateCount);
-        else if (predicate->op == PredicateExpr::LT)
-            return indexDeparture->rangeQuery(nullptr, true, &value, false, candidateCount);
-        else if (predicate->op == PredicateExpr::LE)
-            return indexDeparture->rangeQuery(nullptr, true, &value, true, candidateCount);
-        else if (predicate->op == PredicateExpr::GT)
-            return indexDeparture->rangeQuery(&value, false, nullptr, true, candidateCount);
-        else if (predicate->op == PredicateExpr::GE)
-            return indexDeparture->rangeQuery(&value, true, nullptr, true, candidateCount);
-    }
-    else if (predicate->field == "arr") {
-        time_t value = static_cast<time_t>(predicate->numValue);
-        if (predicate->op == PredicateExpr::EQ)
-            return indexArrival->rangeQuery(&value, true, &value, true, candidateCount);
-        else if (predicate->op == PredicateExpr::LT)
-            return indexArrival->rangeQuery(nullptr, true, &value, false, candidateCount);
-        else if (predicate->op == PredicateExpr::LE)
-            return indexArrival->rangeQuery(nullptr, true, &value, true, candidateCount);
-        else if (predicate->op == PredicateExpr::GT)
-            return indexArrival->rangeQuery(&value, false, nullptr, true, candidateCount);
-        else if (predicate->op == PredicateExpr::GE)
-            return indexArrival->rangeQuery(&value, true, nullptr, true, candidateCount);
-    }
-    else if (predicate->field == "org") {
-        string value = predicate->strValue;
-        if (predicate->op == PredicateExpr::EQ)
-            return indexOrigin->rangeQuery(&value, true, &value, true, candidateCount);
-        else if (predicate->op == PredicateExpr::LT)
-            return indexOrigin->rangeQuery(nullptr, true, &value, false, candidateCount);
-        else if (predicate->op == PredicateExpr::LE)
-            return indexOrigin->rangeQuery(nullptr, true, &value, true, candidateCount);
-        else if (predicate->op == PredicateExpr::GT)
-            return indexOrigin->rangeQuery(&value, false, nullptr, true, candidateCount);
-        else if (predicate->op == PredicateExpr::GE)
-            return indexOrigin->rangeQuery(&value, true, nullptr, true, candidateCount);
-    }
-    else if (predicate->field == "dst") {
-        string value = predicate->strValue;
-        if (predicate->op == PredicateExpr::EQ)
-            return indexDestination->rangeQuery(&value, true, &value, true, candidateCount);
-        else if (predicate->op == PredicateExpr::LT)
-            return indexDestination->rangeQuery(nullptr, true, &value, false, candidateCount);
-        else if (predicate->op == PredicateExpr::LE)
-            return indexDestination->rangeQuery(nullptr, true, &value, true, candidateCount);
-        else if (predicate->op == PredicateExpr::GT)
-            return indexDestination->rangeQuery(&value, false, nullptr, true, candidateCount);
-        else if (predicate->op == PredicateExpr::GE)
-            return indexDestination->rangeQuery(&value, true, nullptr, true, candidateCount);
-    }
-    return nullptr;
+bool runPipeline(istream &in, int queryCount, CommandContext &context) {
+    CommandPipeline pipeline;
+    CommandJob* jobs = new CommandJob[PIPELINE_DEPTH];
+    for (int j = 0; j < PIPELINE_DEPTH; j++)
+        pipeline.freeJobs.push(&jobs[j]);
+
+    std::thread reader(pipelineReader, &in, queryCount, &pipeline);
+    std::thread writer(pipelineWriter, context.explainOut, &pipeline);
+    int sentCount = 0;  // Comandos enviados ao escritor.
+    for (;;) {
+        CommandJob* job;
+        for (int attempt = 0; !pipeline.parsedJobs.tryPop(job); attempt++) {
+            if (context.feed && context.feed->due()) {
+                waitForWriter(pipeline, sentCount);
+                ingestFeed(context);
+                attempt = 0;
+            } else {
+                SpscQueue<CommandJob*>::backoff(attempt);
+            }
+        }
+        if (context.feed && context.feed->due()) {
+            waitForWriter(pipeline, sentCount);
+            ingestFeed(context);
+        }
+        if (job->kind == COMMAND_SERIAL)
+            waitForWriter(pipeline, sentCount);
+        executeCommand(*job, context);
+        // Depois do push o comando pertence ao escritor (e pode voltar à leitura).
+        bool last = job->kind == COMMAND_END || job->kind == COMMAND_FATAL;
+        pipeline.executedJobs.push(job);
+        sentCount++;
+        if (last)
+            break;
+    }
+    reader.join();
+    writer.join();
+    delete[] jobs;
+    return pipeline.succeeded;
 }
 
 /**
@@ -266,13 +687,99 @@ Flight** getCandidatesFromIndex(PredicateExpr* predicate, int &candidateCount) {
  */
 int main(int argc, char* argv[]) {
     if (argc > 1) {
-        ifstream inputFile(argv[1]);
-        if (!inputFile) {
+        // "-" lê a entrada de stdin (ex.: um pipe de outro processo).
+        bool readStdin = string(argv[1]) == "-";
+        ifstream inputFile;
+        if (!readStdin)
+            inputFile.open(argv[1]);
+        if (!readStdin && !inputFile) {
             cerr << "Error opening file " << argv[1] << ".\n";
             return 1;
         }
 
-        cin.rdbuf(inputFile.rdbuf());
+        // --explain escreve o perfil de cada consulta em stderr; --explain=<arquivo>, no arquivo.
+        // --metrics=<arquivo> grava as métricas no fim, ao receber SIGUSR1 e, com
+        // --metrics-interval=<segundos>, periodicamente (requer make METRICS=1).
+        // --partitions=<n> divide os voos em n partições, por mês da partida ou,
+        // com --partition-by=route, pela rota.
+        // --memory escreve em stderr (--memory=<arquivo>, no arquivo) a memória de
+        // cada estrutura após a carga e, por consulta, o resultado e (com
+        // METRICS=1) o pico de heap.
+        // --pipeline lê, executa e escreve os comandos em três threads (runPipeline()).
+        // --follow=<arquivo> acompanha um arquivo de voos que só cresce e insere as
+        // linhas novas entre os comandos (FlightFeed), verificando-o a cada
+        // --follow-interval=<ms> (100) e em lotes de até --follow-batch=<n> linhas.
+        FILE* explainOut = nullptr;
+        FILE* memoryOut = nullptr;
+        string metricsFile;
+        double metricsInterval = 0;
+        int partitionCount = 1;
+        bool pipelined = false;
+        string followFile;
+        double followInterval = 100;
+        int followBatch = 10000;
+        PartitionScheme partitionScheme = PARTITION_BY_MONTH;
+        for (int i = 2; i < argc; i++) {
+            string option = argv[i];
+            if (option.compare(0, 13, "--partitions=") == 0) {
+                partitionCount = atoi(option.c_str() + 13);
+                if (partitionCount < 1 || partitionCount > PartitionedStore::MAX_PARTITIONS) {
+                    cerr << "Error: partitions must be between 1 and " << PartitionedStore::MAX_PARTITIONS << ".\n";
+                    return 1;
+                }
+            } else if (option == "--partition-by=month" || option == "--partition-by=route") {
+                partitionScheme = option == "--partition-by=route" ? PARTITION_BY_ROUTE : PARTITION_BY_MONTH;
+            } else if (option.compare(0, 10, "--metrics=") == 0) {
+                metricsFile = option.substr(10);
+            } else if (option.compare(0, 19, "--metrics-interval=") == 0) {
+                metricsInterval = atof(option.c_str() + 19);
+            } else if (option == "--pipeline") {
+                pipelined = true;
+            } else if (option.compare(0, 9, "--follow=") == 0) {
+                followFile = option.substr(9);
+            } else if (option.compare(0, 18, "--follow-interval=") == 0) {
+                followInterval = atof(option.c_str() + 18);
+            } else if (option.compare(0, 15, "--follow-batch=") == 0) {
+                followBatch = atoi(option.c_str() + 15);
+                if (followBatch < 1) {
+                    cerr << "Error: follow batch must be at least 1.\n";
+                    return 1;
+                }
+            } else if (option == "--memory") {
+                memoryOut = stderr;
+            } else if (option.compare(0, 9, "--memory=") == 0) {
+                memoryOut = fopen(option.c_str() + 9, "w");
+                if (!memoryOut) {
+                    cerr << "Error opening memory file " << option.c_str() + 9 << ".\n";
+                    return 1;
+                }
+            } else if (option == "--explain") {
+                explainOut = stderr;
+            } else if (option.compare(0, 10, "--explain=") == 0) {
+                explainOut = fopen(option.c_str() + 10, "w");
+                if (!explainOut) {
+                    cerr << "Error opening explain file " << option.c_str() + 10 << ".\n";
+                    return 1;
+                }
+            } else {
+                cerr << "Unknown option " << option << ".\n";
+                return 1;
+            }
+        }
+
+        if (!metricsFile.empty() && !startMetricsReporter(metricsFile.c_str(), metricsInterval)) {
+            cerr << "Error: metrics are not available in this build (compile with make METRICS=1).\n";
+            return 1;
+        }
+
+        FlightFeed feed(followFile, followInterval, followBatch);
+        if (!followFile.empty() && !feed.open()) {
+            cerr << "Error opening flights feed " << followFile << ".\n";
+            return 1;
+        }
+
+        if (!readStdin)
+            cin.rdbuf(inputFile.rdbuf());
 
         int flightCount;
         if (!(cin >> flightCount)) {
@@ -280,29 +787,36 @@ int main(int argc, char* argv[]) {
             return 1;
         }
 
-        Flight* flights = new Flight[flightCount];
+        PartitionedStore flightStore(partitionCount, partitionScheme);
 
         for (int i = 0; i < flightCount; i++) {
-            if (!(cin >> flights[i].origin >> flights[i].destination >> flights[i].price 
-                    >> flights[i].seats >> flights[i].departureStr >> flights[i].arrivalStr 
-                    >> flights[i].stops)) {
+            Flight flight;
+            if (!readFlight(cin, flight)) {
+                if (cin) {
+                    cerr << "Warning: invalid date in flight " << i + 1 << "; flight skipped.\n";
+                    continue;
+                }
                 cerr << "Error reading flight " << i + 1 << ".\n";
                 return 1;
             }
 
-            flights[i].dep_time = parseDateTime(flights[i].departureStr);
-            flights[i].arr_time = parseDateTime(flights[i].arrivalStr);
-            
-            if (flights[i].arr_time < flights[i].dep_time) {
+            if (flight.arr_time < flight.dep_time) {
                 cerr << "Error: arrival time is before departure for flight " << i + 1 << ".\n";
                 return 1;
             }
-            
-            flights[i].duration = static_cast<int>(flights[i].arr_time - flights[i].dep_time);
+
+            flightStore.addFlight(flight);
         }
 
-        FlightManager flightManager(flights, flightCount);
-        flightManager.buildIndices();
+        flightStore.buildIndices();
+
+        if (memoryOut) {
+            MemoryReport memoryReport;
+            flightStore.reportMemory(memoryReport);
+            memoryReport.print(memoryOut);
+        }
+        QueryMemoryTracker memoryTracker(memoryOut);
+        QueryMemoryTracker* memoryTrackerPtr = memoryOut ? &memoryTracker : nullptr;
 
         int queryCount;
         if (!(cin >> queryCount)) {
@@ -312,87 +826,52 @@ int main(int argc, char* argv[]) {
         
         cin.ignore();  // Ignora '\n'
 
-        for (int i = 0; i < queryCount; i++) {
-            string queryLine;
-            while (queryLine.empty()) {
-                if (!getline(cin, queryLine)) {
-                    cerr << "Error reading query " << i + 1 << ".\n";
-                    return 1;
-                }
-            }
-
-            istringstream queryStream(queryLine);
-            int maxResults;
-            string sortCriteria;
-
-            if (!(queryStream >> maxResults >> sortCriteria)) {
-                cerr << "Error parsing query " << i + 1 << ".\n";
+        map<string, PreparedQuery*> templates;  // Templates registrados com "prep".
+        // Listas de adjacência de "route" (montadas sob demanda), com os voos de todas as partições.
+        ItinerarySearch itinerarySearch(flightStore);
+        CommandContext context;
+        context.flightStore = &flightStore;
+        context.templates = &templates;
+        context.itinerarySearch = &itinerarySearch;
+        context.explainOut = explainOut;
+        context.memoryTracker = pipelined ? nullptr : memoryTrackerPtr;
+        context.feed = followFile.empty() ? nullptr : &feed;
+
+        if (pipelined) {
+            if (!runPipeline(cin, queryCount, context))
                 return 1;
+        } else {
+            CommandJob job;
+            for (int i = 0; i < queryCount; i++) {
+                // O arquivo acompanhado é verificado depois da leitura, que pode
+                // ficar bloqueada em stdin: o comando vê o que chegou durante a espera.
+                readCommand(cin, job, i + 1);
+                if (context.feed && context.feed->due())
+                    ingestFeed(context);
+                QueryMemoryScope memoryScope(memoryTrackerPtr, i + 1);
+                executeCommand(job, context);
+                if (!writeCommand(job, explainOut, memoryTrackerPtr))
+                    return 1;
             }
-
-            string expressionStr;
-            getline(queryStream, expressionStr);
-            while (!expressionStr.empty() && isspace(expressionStr[0]))
-                expressionStr.erase(expressionStr.begin());
-
-            printf("%d %s %s\n", maxResults, sortCriteria.c_str(), expressionStr.c_str());
-
-            Parser parser(expressionStr);
-            Expr* expression = parser.parseExpression();
-
-            PredicateExpr* candidatePredicate = findIndexablePredicate(expression);
-            Flight** candidateFlights = nullptr;
-            int candidateCount = 0;
-            bool indexUsed = false;
-
-            if (candidatePredicate) {
-                candidateFlights = getCandidatesFromIndex(candidatePredicate, candidateCount);
-                indexUsed = true;
-            } else {
-                candidateCount = flightCount;
-                candidateFlights = new Flight*[flightCount];
-                for (int j = 0; j < flightCount; j++)
-                    candidateFlights[j] = &flights[j];
-                indexUsed = false;
-            }
-
-            int resultCount = 0;
-            int resultCapacity = (candidateCount > 10) ? candidateCount : 10;
-            Flight** resultFlights = new Flight*[resultCapacity];
-
-            for (int j = 0; j < candidateCount; j++) {
-                if (expression->evaluate(*candidateFlights[j])) {
-                    if (resultCount >= resultCapacity) {
-                        int newCapacity = resultCapacity * 2;
-                        Flight** newArray = new Flight*[newCapacity];
-                        for (int k = 0; k < resultCount; k++)
-                            newArray[k] = resultFlights[k];
-                        delete[] resultFlights;
-                        resultFlights = newArray;
-                        resultCapacity = newCapacity;
-                    }
-                    resultFlights[resultCount++] = candidateFlights[j];
-                }
-            }
-
-            if (resultCount > 0)
-                quickSortFlights(resultFlights, 0, resultCount - 1, sortCriteria);
-
-            for (int j = 0; j < resultCount && j < maxResults; j++) {
-                Flight* f = resultFlights[j];
-                printf("%s %s %g %d %s %s %d\n", f->origin, f->destination, f->price, f->seats, f->departureStr, f->arrivalStr, f->stops);
-            }
-
-            delete[] resultFlights;
-            if (indexUsed)
-                delete[] candidateFlights;
-            delete expression;
         }
 
-        delete[] flights;
+        if (context.feed)
+            feed.printSummary(stderr);
+        for (map<string, PreparedQuery*>::iterator it = templates.begin(); it != templates.end(); ++it)
+            delete it->second;
+        if (explainOut && explainOut != stderr)
+            fclose(explainOut);
+        if (memoryOut) {
+            memoryTracker.printSummary();
+            if (memoryOut != stderr)
+                fclose(memoryOut);
+        }
+        stopMetricsReporter();
         return 0;
     } else {
-        cerr << "Usage: ./bin/tp3.out input.txt\n";
+        cerr << "Usage: ./bin/tp3.out input.txt|- [--explain | --explain=<file>] [--metrics=<file> [--metrics-interval=<s>]]"
+                " [--partitions=<n> [--partition-by=month|route]] [--memory | --memory=<file>] [--pipeline]"
+                " [--follow=<feed> [--follow-interval=<ms>] [--follow-batch=<n>]]\n";
         return 1;
     }
 }
\ No newline at end of file